@@ -0,0 +1,142 @@
+#pragma once
+
+#include "s1u/core.hpp"
+#include "s1u/protocol_messages.hpp"
+
+namespace s1u {
+
+// Owned fence fd. Either an eventfd created by us or an adopted sync_file /
+// eventfd from a client; both become readable (POLLIN) once signaled.
+class SyncFence {
+public:
+    SyncFence() = default;
+    ~SyncFence();
+
+    SyncFence(const SyncFence&) = delete;
+    SyncFence& operator=(const SyncFence&) = delete;
+    SyncFence(SyncFence&& other) noexcept;
+    SyncFence& operator=(SyncFence&& other) noexcept;
+
+    static SyncFence create_eventfd();
+    static SyncFence adopt(int fd);
+
+    bool is_valid() const { return fd_ >= 0; }
+    int fd() const { return fd_; }
+    int release();
+
+    bool is_signaled() const;
+    bool wait(i32 timeout_ms) const;
+    bool signal();
+
+private:
+    explicit SyncFence(int fd, bool owns_eventfd) : fd_(fd), is_eventfd_(owns_eventfd) {}
+    void reset();
+
+    int fd_ = -1;
+    bool is_eventfd_ = false;
+};
+
+// Lifecycle of a client buffer under explicit synchronization
+enum class BufferSyncState : u32 {
+    AwaitingAcquire,  // submitted, client may still be writing
+    Ready,            // acquire fence signaled, may be latched
+    Latched,          // compositor is sampling from it
+    Released          // handed back to the client
+};
+
+struct SyncedBuffer {
+    ClientId client_id = 0;
+    u32 surface_id = 0;
+    u32 buffer_id = 0;
+    u64 acquire_point = 0;
+    u64 release_point = 0;
+    u32 submit_flags = BUFFER_SUBMIT_NONE;
+    u64 submit_time_ns = 0;
+    BufferSyncState state = BufferSyncState::AwaitingAcquire;
+    SyncFence acquire_fence;
+};
+
+// Release notification queued for delivery to the owning client
+struct BufferReleaseEvent {
+    ClientId client_id = 0;
+    BufferReleasePayload payload;
+    SyncFence release_fence;
+};
+
+// A buffer latch_frame() took off a surface's queue: the one latched into
+// the frame, or an older ready one it replaced before it was ever shown
+struct BufferLatch {
+    u32 surface_id = 0;
+    u32 buffer_id = 0;
+    bool superseded = false;
+};
+
+enum class BufferSubmitResult : u8 {
+    Accepted,
+    StillQueued,     // the buffer was resubmitted before we released it
+    ForeignSurface   // the surface belongs to another client
+};
+
+struct BufferSyncStats {
+    u64 buffers_submitted = 0;
+    u64 buffers_latched = 0;
+    u64 buffers_superseded = 0;
+    u64 submits_rejected = 0;
+    u64 acquire_fence_waits_skipped = 0;
+    u64 release_fences_created = 0;
+    u64 releases_sent = 0;
+};
+
+// Tracks per-surface buffer queues. The compositor only ever latches buffers
+// whose acquire fence has already signaled, and buffers go back to clients
+// as soon as they are superseded or the frame that read them completes.
+// A surface belongs to the client that first submitted to it until that
+// client is dropped. The protocol thread submits and the compositor latches
+// from its own thread, so all entry points are serialized internally.
+class BufferSyncTracker {
+public:
+    BufferSyncTracker() = default;
+    ~BufferSyncTracker() = default;
+
+    BufferSubmitResult submit(ClientId client_id, const BufferSubmitPayload& payload, SyncFence acquire_fence);
+
+    // Polls outstanding acquire fences without blocking.
+    void poll_acquire_fences();
+
+    // Latches the newest ready buffer of every surface into the frame being
+    // composed. Older ready buffers are released immediately; each displaced
+    // latched buffer is released with a fence that end_frame() signals.
+    // Appends one entry per buffer taken, superseded ones before the latched
+    // one of their surface.
+    void latch_frame(std::vector<BufferLatch>& latches);
+
+    // Signals release fences of buffers displaced by this frame's latches.
+    void end_frame();
+
+    void drop_client(ClientId client_id);
+
+    std::vector<BufferReleaseEvent> take_release_events();
+    bool has_release_events() const;
+
+    BufferSyncStats get_statistics() const;
+
+private:
+    struct SurfaceQueue {
+        ClientId owner = 0;
+        std::vector<SyncedBuffer> pending;
+        std::optional<SyncedBuffer> latched;
+    };
+
+    void latch(u32 surface_id, SurfaceQueue& queue, std::vector<BufferLatch>& latches);
+    void release_buffer(SyncedBuffer& buffer, u32 flags);
+
+    mutable std::mutex mutex_;
+
+    std::unordered_map<u32, SurfaceQueue> surfaces_;
+    std::vector<BufferReleaseEvent> release_events_;
+    std::vector<BufferReleaseEvent> deferred_releases_;
+    std::vector<SyncFence> fences_to_signal_;
+    BufferSyncStats stats_;
+};
+
+} // namespace s1u
@@ -1,11 +1,15 @@
 #pragma once
 
 #include <memory>
+#include <functional>
 #include <vector>
 #include <string>
 #include <unordered_map>
 #include <chrono>
 #include "s1u/renderer.hpp"
+#include "s1u/buffer_sync.hpp"
+#include "s1u/presentation_feedback.hpp"
+#include "s1u/surface_damage.hpp"
 
 namespace s1u {
 
@@ -90,6 +94,23 @@ public:
     void end_composition();
     void present_frame();
 
+    // Frame-done callbacks and presentation feedback for protocol clients
+    void set_presentation_feedback(std::shared_ptr<PresentationFeedbackTracker> tracker);
+    // Client buffers, latched at the start of each composed frame
+    void set_buffer_sync(std::shared_ptr<BufferSyncTracker> tracker);
+    // Client damage, taken for each surface as its buffer latches
+    void set_surface_damage(std::shared_ptr<SurfaceDamageTracker> tracker);
+    // Screen area the buffers latched into the current frame changed
+    const DamageRegion& get_frame_damage() const { return frame_damage_; }
+
+    // Called at the end of each composed frame with the whole screen (BGRA,
+    // top row first) and the part of it that changed, e.g. to feed
+    // S1U::RemoteDisplayStream::submit_frame. Only the changed rows are read
+    // back from the GPU; window changes read back everything.
+    using FrameReadbackCallback = std::function<void(const uint8_t* pixels, uint32_t width, uint32_t height,
+                                                     uint32_t stride, const DamageRegion& damage)>;
+    void set_frame_readback(FrameReadbackCallback callback);
+
     // Effects
     void enable_effect(CompositorEffect effect, bool enable);
     void set_effect_parameters(CompositorEffect effect, const std::vector<float>& parameters);
@@ -119,6 +140,8 @@ private:
     void render_windows();
     void apply_post_effects();
     void final_composition();
+    void collect_frame_damage();
+    void read_back_frame();
 
     // Effect rendering
     void render_blur_effect();
@@ -158,6 +181,18 @@ private:
     std::chrono::high_resolution_clock::time_point last_frame_time_;
     std::chrono::high_resolution_clock::time_point frame_start_time_;
     uint64_t frame_count_;
+    std::shared_ptr<PresentationFeedbackTracker> presentation_feedback_;
+    std::shared_ptr<BufferSyncTracker> buffer_sync_;
+    std::vector<BufferLatch> buffer_latches_;
+    std::vector<uint32_t> latched_surfaces_;
+    std::unordered_map<uint32_t, bool> surface_visibility_;
+    std::shared_ptr<SurfaceDamageTracker> surface_damage_;
+    DamageRegion frame_damage_;
+    FrameReadbackCallback frame_readback_;
+    std::vector<uint8_t> readback_pixels_;
+    std::vector<uint8_t> readback_rows_;
+    DamageRegion readback_damage_;
+    bool readback_full_ = true;
     double current_fps_;
     double average_frame_time_;
     std::vector<double> frame_times_;
@@ -11,6 +11,10 @@
 #include <string>
 #include <array>
 #include <optional>
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <sstream>
 
 namespace s1u {
 
@@ -176,4 +180,73 @@ using InputManagerPtr = std::shared_ptr<InputManager>;
 using DriverManagerPtr = std::shared_ptr<DriverManager>;
 using ProtocolServerPtr = std::shared_ptr<ProtocolServer>;
 
+// Line logger for server diagnostics. Each "{...}" in the format is replaced
+// by the next argument; format specs inside the braces are ignored.
+class Logger {
+public:
+    template <typename... Args>
+    static void info(const char* format, const Args&... args) { write("info", format, args...); }
+
+    template <typename... Args>
+    static void warning(const char* format, const Args&... args) { write("warning", format, args...); }
+
+    template <typename... Args>
+    static void error(const char* format, const Args&... args) { write("error", format, args...); }
+
+private:
+    template <typename... Args>
+    static void write(const char* level, const char* format, const Args&... args) {
+        std::ostringstream line;
+        line << std::boolalpha << "[s1u " << level << "] ";
+        ((format = append_until_field(line, format), line << args), ...);
+        line << format << '\n';
+        // One write per line so lines from different threads do not interleave
+        std::cerr << line.str();
+    }
+
+    static const char* append_until_field(std::ostringstream& line, const char* format) {
+        const char* open = std::strchr(format, '{');
+        const char* close = open ? std::strchr(open, '}') : nullptr;
+        if (!close) {
+            line << format;
+            return format + std::strlen(format);
+        }
+        line.write(format, open - format);
+        return close + 1;
+    }
+};
+
+class Timer {
+public:
+    Timer() : start_(std::chrono::steady_clock::now()) {}
+
+    f64 elapsed_ns() const {
+        return std::chrono::duration<f64, std::nano>(std::chrono::steady_clock::now() - start_).count();
+    }
+
+private:
+    std::chrono::steady_clock::time_point start_;
+};
+
+}
+
+// The network, memory and remote display modules live in namespace S1U and
+// spell containers the way the rest of their code base does
+namespace S1U {
+
+using s1u::u8;
+using s1u::u16;
+using s1u::u32;
+using s1u::u64;
+using s1u::i8;
+using s1u::i16;
+using s1u::i32;
+using s1u::i64;
+using s1u::f32;
+using s1u::f64;
+
+template <typename T>
+using Vector = std::vector<T>;
+using String = std::string;
+
 }
@@ -0,0 +1,65 @@
+#pragma once
+
+#include "s1u/core.hpp"
+#include "s1u/protocol_messages.hpp"
+
+namespace s1u {
+
+// Integer pixel rectangle, half-open: [x1, x2) x [y1, y2)
+struct DamageRect {
+    i32 x1 = 0;
+    i32 y1 = 0;
+    i32 x2 = 0;
+    i32 y2 = 0;
+
+    bool is_empty() const { return x2 <= x1 || y2 <= y1; }
+    u64 area() const { return is_empty() ? 0 : u64(x2 - x1) * u64(y2 - y1); }
+};
+
+// Damage as a y-x banded region: rectangles sorted by (y1, x1), every band
+// shares y1/y2, bands do not overlap and rectangles within a band neither
+// overlap nor touch. Regions decoded from the wire already satisfy this, so
+// the compositor can walk rects() directly without re-normalizing.
+class DamageRegion {
+public:
+    DamageRegion() = default;
+
+    // Merging another region (or one rectangle) is a single sweep over the
+    // bands of both. Arbitrary rectangles go through a full normalization,
+    // so callers collect them and add them in one call.
+    void add(const DamageRect& rect);
+    void add(const std::vector<DamageRect>& rects);
+    void add(const DamageRegion& other);
+    void clear();
+
+    // Both keep the region banded. Coordinates must stay within i32.
+    void intersect(const DamageRect& clip);
+    void translate(i32 dx, i32 dy);
+
+    bool is_empty() const { return rects_.empty(); }
+    const std::vector<DamageRect>& rects() const { return rects_; }
+    DamageRect extents() const;
+    u64 area() const;
+    u32 band_count() const;
+
+    // Merges rectangles until at most max_rects remain, filling the
+    // cheapest gaps first (least extra area). The region can only grow.
+    void coalesce(u32 max_rects);
+
+    // Wire format described at BufferDamageHeader
+    void encode(u32 surface_id, std::vector<u8>& out) const;
+    bool decode(const u8* data, size_t size, u32& surface_id);
+
+private:
+    void normalize(std::vector<DamageRect>& input);
+
+    std::vector<DamageRect> rects_;
+};
+
+// Parsed BufferDamage payload
+struct BufferDamageView {
+    u32 surface_id = 0;
+    DamageRegion region;
+};
+
+} // namespace s1u
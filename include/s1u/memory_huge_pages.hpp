@@ -0,0 +1,46 @@
+#pragma once
+
+#include "s1u/core.hpp"
+#include <cstddef>
+
+namespace S1U {
+
+constexpr size_t HUGE_PAGE_SIZE = 2097152;
+
+// What a mapping asked the kernel for, best first
+enum class HugePageBacking : u32 {
+    Explicit = 0,       // MAP_HUGETLB, huge from the first fault
+    Transparent = 1,    // madvise(MADV_HUGEPAGE), huge where the kernel manages it
+    Regular = 2
+};
+
+struct HugePageStats {
+    u64 mappings = 0;
+    u64 mapped_bytes = 0;
+    u64 explicit_bytes = 0;
+    u64 transparent_bytes = 0;
+    u64 regular_bytes = 0;
+    u64 explicit_fallbacks = 0; // MAP_HUGETLB attempts the hugetlb pool could not serve
+    u64 huge_backed_bytes = 0;  // explicit bytes plus transparent bytes on huge pages right now
+
+    f64 huge_backed_ratio() const { return mapped_bytes > 0 ? static_cast<f64>(huge_backed_bytes) / mapped_bytes : 0.0; }
+};
+
+// Maps size bytes rounded up to whole huge pages, aligned to HUGE_PAGE_SIZE,
+// trying explicit huge pages, then transparent ones, then plain pages,
+// starting from best. A reserve_only mapping is committed lazily as it is
+// touched (MAP_NORESERVE) and never uses explicit huge pages, since a fault
+// on an exhausted hugetlb pool kills the process. nullptr only when even a
+// plain mapping fails.
+void* map_huge_pages(size_t size, HugePageBacking best = HugePageBacking::Explicit, bool reserve_only = false,
+                     HugePageBacking* backing = nullptr);
+
+// size as passed to map_huge_pages
+void unmap_huge_pages(void* address, size_t size);
+
+// Totals over every live mapping of the process. Reads /proc/self/smaps to
+// see how much transparent memory is really on huge pages, so it is meant
+// for statistics, not for hot paths.
+HugePageStats get_huge_page_stats();
+
+} // namespace S1U
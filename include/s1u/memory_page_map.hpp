@@ -0,0 +1,96 @@
+#pragma once
+
+#include "s1u/core.hpp"
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+
+namespace S1U {
+
+constexpr u32 NUMA_NODE_UNKNOWN = 0xFFFF;
+
+// Metadata for one live allocation, 16 bytes so slabs of small blocks can
+// keep one per block. Slab and quantum memory keep it in a side table;
+// direct allocations carry it in a header just in front of the pointer
+// handed out.
+struct AllocationRecord {
+    u64 size : 48 = 0;          // 0 while the slot is free
+    u64 flags : 16 = 0;
+    u32 timestamp = 0;          // steady clock seconds
+    u16 numa_node = NUMA_NODE_UNKNOWN;
+    u16 owner_thread = 0;       // tag of the allocating thread
+};
+
+enum class MemoryRegionKind : u32 {
+    SizeClassArena = 0,
+    Quantum = 1
+};
+
+// Contiguous range owned by the memory manager. Quantum regions are cut into
+// equal granules with one record per granule, and an allocation uses the
+// record of its first granule. Size-class arenas keep their records in the
+// slab headers instead.
+struct MemoryRegion {
+    MemoryRegionKind kind = MemoryRegionKind::SizeClassArena;
+    u8* start = nullptr;
+    size_t size = 0;
+    size_t granule = 0;
+    u32 index = 0;
+    u32 numa_node = NUMA_NODE_UNKNOWN;
+    std::unique_ptr<AllocationRecord[]> records;
+
+    bool contains(const void* address) const {
+        const u8* byte_address = static_cast<const u8*>(address);
+        return byte_address >= start && byte_address < start + size;
+    }
+    size_t granule_count() const { return size / granule; }
+    size_t granule_index(const void* address) const { return (static_cast<const u8*>(address) - start) / granule; }
+    bool is_granule_start(const void* address) const { return (static_cast<const u8*>(address) - start) % granule == 0; }
+    AllocationRecord& record_for(const void* address) { return records[granule_index(address)]; }
+};
+
+// Three-level radix tree from page number to the region that owns the page,
+// covering a 48-bit address space. Lookups are lock-free; inserting a region
+// takes a mutex only to build missing nodes. Nodes are never freed while the
+// map lives, so a reader can never walk into released memory.
+class MemoryPageMap {
+public:
+    static constexpr u32 PAGE_SHIFT = 12;
+    static constexpr u32 ADDRESS_BITS = 48;
+    static constexpr u32 LEVEL_BITS = 12;
+    static constexpr size_t LEVEL_SIZE = size_t(1) << LEVEL_BITS;
+
+    MemoryPageMap() = default;
+    ~MemoryPageMap();
+
+    MemoryPageMap(const MemoryPageMap&) = delete;
+    MemoryPageMap& operator=(const MemoryPageMap&) = delete;
+
+    bool insert(MemoryRegion* region);
+    void erase(const MemoryRegion* region);
+
+    // Region containing the address. A page partly outside a region (the
+    // region start or end is not page aligned) only matches inside the range.
+    MemoryRegion* find(const void* address) const;
+
+    // Bytes spent on tree nodes
+    size_t get_node_bytes() const { return node_bytes_.load(std::memory_order_relaxed); }
+
+private:
+    struct Leaf {
+        std::atomic<MemoryRegion*> regions[LEVEL_SIZE];
+    };
+
+    struct Interior {
+        std::atomic<Leaf*> leaves[LEVEL_SIZE];
+    };
+
+    Leaf* leaf_for(u64 page);
+
+    std::atomic<Interior*> root_[LEVEL_SIZE] = {};
+    std::mutex grow_mutex_;
+    std::atomic<size_t> node_bytes_{0};
+};
+
+} // namespace S1U
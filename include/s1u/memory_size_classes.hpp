@@ -0,0 +1,173 @@
+#pragma once
+
+#include "s1u/core.hpp"
+#include "s1u/memory_page_map.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+
+namespace S1U {
+
+// Header at the start of every slab. Slabs are aligned to their own size,
+// so masking a block address finds its slab. The allocation records of the
+// blocks follow the header and the blocks follow the records.
+struct alignas(64) SizeClassSlab {
+    u32 magic = 0;
+    u32 size_class = 0;
+    u32 block_size = 0;
+    u32 block_count = 0;
+    u32 free_count = 0;          // blocks on free_list or never handed out
+    u32 carved = 0;              // blocks handed out at least once
+    u32 numa_node = NUMA_NODE_UNKNOWN;
+    u8* blocks = nullptr;
+    void* free_list = nullptr;   // linked through the first word of each free block
+    SizeClassSlab* prev = nullptr;
+    SizeClassSlab* next = nullptr;
+
+    AllocationRecord* records() { return reinterpret_cast<AllocationRecord*>(this + 1); }
+    u32 block_index(const void* address) const { return static_cast<u32>((static_cast<const u8*>(address) - blocks) / block_size); }
+    bool is_block_start(const void* address) const {
+        const u8* byte_address = static_cast<const u8*>(address);
+        return byte_address >= blocks && byte_address < blocks + size_t(block_count) * block_size &&
+               (byte_address - blocks) % block_size == 0;
+    }
+    AllocationRecord& record_for(const void* address) { return records()[block_index(address)]; }
+};
+
+struct SizeClassStatistics {
+    size_t block_size = 0;
+    u64 slabs = 0;
+    u64 total_blocks = 0;
+    u64 free_blocks = 0;         // on the slab free lists, not in thread caches
+    u64 blocks_taken = 0;        // handed to callers or thread caches
+    u64 blocks_returned = 0;
+    f64 fragmentation_ratio = 0.0; // share of the class's slab memory lying free
+};
+
+// Segregated-fit small-object allocator. Requests up to MAX_SIZE map in O(1)
+// to one of CLASS_COUNT block sizes: every multiple of 64 up to 512 bytes,
+// then four per power of two, so rounding up wastes at most a fifth of a
+// block. Each class carves SLAB_SIZE slabs from large arenas reserved up
+// front and grown on demand; a slab belongs to one class until it is empty
+// and released back to its arena. Every class has its own lock, so only
+// requests of the same class contend. An allocator serves one NUMA node:
+// its arenas can be bound to the node and its slabs and records carry it.
+class SizeClassAllocator {
+public:
+    static constexpr u32 SLAB_SHIFT = 21;
+    static constexpr size_t SLAB_SIZE = size_t(1) << SLAB_SHIFT;
+    static constexpr size_t MIN_SIZE = 64;
+    static constexpr size_t MAX_SIZE = 262144;
+    static constexpr size_t MAX_ALIGNMENT = 4096;
+    static constexpr u32 CLASS_COUNT = 44;
+    static constexpr u32 NO_CLASS = CLASS_COUNT;
+
+    SizeClassAllocator() = default;
+    ~SizeClassAllocator();
+
+    SizeClassAllocator(const SizeClassAllocator&) = delete;
+    SizeClassAllocator& operator=(const SizeClassAllocator&) = delete;
+
+    // Reserves the first arena and registers it in page_map. Arenas of the
+    // same size are added whenever the current one is fully carved. With
+    // bind_to_node every arena prefers pages of numa_node; otherwise the node
+    // is only a label. With huge_pages arenas ask for transparent huge pages,
+    // so a slab in use sits on a single 2 MB page.
+    bool initialize(MemoryPageMap* page_map, size_t arena_size, bool lock_slabs,
+                    u32 numa_node = 0, bool bind_to_node = false, bool huge_pages = false);
+    void shutdown();
+
+    u32 get_numa_node() const { return numa_node_; }
+
+    // Smallest class whose blocks hold size bytes at the alignment, or
+    // NO_CLASS when the request is too large or too strictly aligned
+    static u32 class_for(size_t size, size_t alignment);
+    static size_t class_size(u32 size_class);
+
+    static SizeClassSlab* slab_for(const void* address) {
+        return reinterpret_cast<SizeClassSlab*>(reinterpret_cast<uintptr_t>(address) & ~(uintptr_t(SLAB_SIZE) - 1));
+    }
+
+    // Record of the block starting at address; nullptr for an interior
+    // pointer or a slab that is not carved. The address must lie in one of
+    // this allocator's arenas.
+    static AllocationRecord* record_for(const void* address);
+
+    // Moves up to count free blocks of a class out of its slabs, carving a
+    // new slab if none has any left. Returns how many were taken.
+    u32 take_blocks(u32 size_class, void** blocks, u32 count);
+    void return_blocks(u32 size_class, void* const* blocks, u32 count);
+
+    // Gives slabs with no block out back to their arena and their pages to
+    // the kernel, keeping one spare slab per class. Returns the slab count.
+    u32 release_empty_slabs();
+
+    // Calls fn(block, record) for every block whose record is live, with the
+    // class lock held
+    template <typename Fn>
+    void for_each_allocation(Fn&& fn);
+
+    Vector<SizeClassStatistics> get_class_statistics() const;
+    size_t get_reserved_bytes() const;
+    size_t get_bound_bytes() const;     // reserved bytes whose mbind succeeded
+
+private:
+    struct ClassState {
+        mutable std::mutex lock;
+        SizeClassSlab* partial = nullptr; // slabs with free blocks
+        SizeClassSlab* full = nullptr;
+        u64 slabs = 0;
+        u64 total_blocks = 0;
+        u64 free_blocks = 0;
+        u64 blocks_taken = 0;
+        u64 blocks_returned = 0;
+    };
+
+    struct Arena {
+        u8* start = nullptr;
+        size_t size = 0;
+        size_t carved = 0;
+        bool bound = false;
+        std::unique_ptr<MemoryRegion> region;
+    };
+
+    static void link(SizeClassSlab*& head, SizeClassSlab* slab);
+    static void unlink(SizeClassSlab*& head, SizeClassSlab* slab);
+
+    bool reserve_arena();
+    bool bind_arena(u8* start, size_t size);
+    SizeClassSlab* carve_slab(u32 size_class);
+
+    MemoryPageMap* page_map_ = nullptr;
+    size_t arena_size_ = 0;
+    bool lock_slabs_ = false;
+    u32 numa_node_ = 0;
+    bool bind_to_node_ = false;
+    bool huge_pages_ = false;
+
+    ClassState classes_[CLASS_COUNT];
+
+    mutable std::mutex arena_mutex_;
+    Vector<Arena> arenas_;
+    Vector<SizeClassSlab*> free_slabs_; // released, ready for any class
+};
+
+template <typename Fn>
+void SizeClassAllocator::for_each_allocation(Fn&& fn) {
+    for (ClassState& state : classes_) {
+        std::lock_guard<std::mutex> lock(state.lock);
+        for (SizeClassSlab* head : {state.partial, state.full}) {
+            for (SizeClassSlab* slab = head; slab; slab = slab->next) {
+                AllocationRecord* records = slab->records();
+                for (u32 i = 0; i < slab->block_count; i++) {
+                    if (records[i].size != 0) {
+                        fn(static_cast<void*>(slab->blocks + size_t(i) * slab->block_size), records[i]);
+                    }
+                }
+            }
+        }
+    }
+}
+
+} // namespace S1U
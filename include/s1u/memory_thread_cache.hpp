@@ -0,0 +1,143 @@
+#pragma once
+
+#include "s1u/core.hpp"
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+
+namespace S1U {
+
+class ThreadAllocationCache;
+
+struct ThreadCacheStats {
+    u64 hits = 0;
+    u64 misses = 0;
+    u64 refills = 0;            // batches taken from a central free list
+    u64 flushes = 0;            // batches returned to a central free list
+    u64 cross_thread_frees = 0; // freed by a thread other than the allocating one
+    u64 local_allocations = 0;  // served from the thread's own NUMA node
+    u64 remote_allocations = 0; // served from another node
+    u64 remote_frees = 0;       // blocks of another node, sent straight back to it
+    u64 cached_bytes = 0;
+    u64 threads = 0;
+
+    void add(const ThreadCacheStats& other);
+    f64 hit_rate() const { return hits + misses > 0 ? static_cast<f64>(hits) / (hits + misses) : 0.0; }
+    f64 node_hit_rate() const {
+        u64 total = local_allocations + remote_allocations;
+        return total > 0 ? static_cast<f64>(local_allocations) / total : 0.0;
+    }
+};
+
+// The allocator a thread's caches belong to. Both calls are made with the
+// cache registry lock held.
+class ThreadCacheOwner {
+public:
+    virtual ~ThreadCacheOwner() = default;
+
+    // Sizes the magazines of a cache the calling thread is about to use
+    virtual void configure_thread_cache(ThreadAllocationCache& cache) = 0;
+
+    // The thread is exiting: take back every cached block and its counters
+    virtual void release_thread_cache(ThreadAllocationCache& cache) = 0;
+};
+
+// One thread's magazines for one allocator, a bounded stack of free blocks
+// per size class. Only the owning thread pushes and pops. When a magazine is
+// empty the allocator refills it with a batch from its central free list,
+// and when it is full a batch goes back, so the central lock is taken once
+// per batch rather than once per call.
+class ThreadAllocationCache {
+public:
+    static constexpr u32 MAX_MAGAZINE_CAPACITY = 64;
+
+    explicit ThreadAllocationCache(ThreadCacheOwner* owner);
+
+    ThreadAllocationCache(const ThreadAllocationCache&) = delete;
+    ThreadAllocationCache& operator=(const ThreadAllocationCache&) = delete;
+
+    // Calling thread's cache for owner, created and configured on first use
+    static ThreadAllocationCache* for_current_thread(ThreadCacheOwner* owner);
+
+    // Called by an owner that is shutting down. The blocks cached for it are
+    // dropped with their backing memory; threads stop using these caches.
+    static void detach_all(ThreadCacheOwner* owner);
+
+    // Counters of every live cache of owner, or of those serving one node
+    static ThreadCacheStats collect_stats(ThreadCacheOwner* owner);
+    static ThreadCacheStats collect_node_stats(ThreadCacheOwner* owner, u32 numa_node);
+
+    // Small nonzero id of the calling thread, for telling cross-thread frees.
+    // Wraps after 65535 threads, which only blurs the cross-thread count.
+    static u16 current_thread_tag();
+
+    ThreadCacheOwner* owner() const { return owner_; }
+    bool is_detached() const { return detached_.load(std::memory_order_acquire); }
+
+    // Node the cached blocks come from. The owner empties the magazines
+    // before moving a cache to another node.
+    u32 numa_node() const { return numa_node_.load(std::memory_order_relaxed); }
+    void set_numa_node(u32 numa_node) { numa_node_.store(numa_node, std::memory_order_relaxed); }
+
+    // A capacity below 2 leaves the class uncached
+    void configure(u32 size_class, u32 capacity, size_t block_size);
+    u32 class_count() const { return static_cast<u32>(magazines_.size()); }
+    bool is_cached(u32 size_class) const { return size_class < magazines_.size() && magazines_[size_class].capacity > 1; }
+    u32 capacity(u32 size_class) const { return magazines_[size_class].capacity; }
+    u32 count(u32 size_class) const { return magazines_[size_class].count; }
+    u32 batch_size(u32 size_class) const { return std::max<u32>(magazines_[size_class].capacity / 2, 1); }
+
+    // nullptr on a miss; the caller refills and pops again
+    void* pop(u32 size_class);
+
+    // false when the magazine is full; the caller flushes and pushes again
+    bool push(u32 size_class, void* block);
+
+    // Moves up to count blocks into a central free list batch
+    u32 take(u32 size_class, void** blocks, u32 count);
+
+    // Adds a refill batch; the caller never passes more than the free room
+    void put(u32 size_class, void* const* blocks, u32 count);
+
+    void record_refill() { add(refills_, 1); }
+    void record_flush() { add(flushes_, 1); }
+    void record_cross_thread_free() { add(cross_thread_frees_, 1); }
+    void record_node_allocation(bool local) { add(local ? local_allocations_ : remote_allocations_, 1); }
+    void record_remote_free() { add(remote_frees_, 1); }
+
+    ThreadCacheStats get_stats() const;
+
+    // Hands over the node counters and zeroes them, so counts made for one
+    // node are not reported under the next
+    ThreadCacheStats take_node_stats();
+
+private:
+    struct Magazine {
+        Vector<void*> blocks;
+        u32 count = 0;
+        u32 capacity = 0;
+        size_t block_size = 0;
+    };
+
+    static void add(std::atomic<u64>& counter, u64 amount) {
+        counter.store(counter.load(std::memory_order_relaxed) + amount, std::memory_order_relaxed);
+    }
+
+    ThreadCacheOwner* owner_;
+    std::atomic<bool> detached_{false};
+    std::atomic<u32> numa_node_{0};
+    Vector<Magazine> magazines_;
+
+    // Written by the owning thread only, read by collect_stats
+    std::atomic<u64> hits_{0};
+    std::atomic<u64> misses_{0};
+    std::atomic<u64> refills_{0};
+    std::atomic<u64> flushes_{0};
+    std::atomic<u64> cross_thread_frees_{0};
+    std::atomic<u64> local_allocations_{0};
+    std::atomic<u64> remote_allocations_{0};
+    std::atomic<u64> remote_frees_{0};
+    std::atomic<u64> cached_bytes_{0};
+};
+
+} // namespace S1U
@@ -0,0 +1,143 @@
+#pragma once
+
+#include "s1u/core.hpp"
+#include <memory>
+#include <unordered_map>
+
+struct evp_cipher_ctx_st;
+
+namespace S1U {
+
+enum class AeadAlgorithm : u8 {
+    Aes256Gcm = 1,
+    ChaCha20Poly1305 = 2
+};
+
+constexpr size_t AEAD_KEY_SIZE = 32;
+constexpr size_t AEAD_NONCE_SIZE = 12;
+constexpr size_t AEAD_TAG_SIZE = 16;
+constexpr size_t AEAD_HEADER_SIZE = 16;
+constexpr size_t AEAD_OVERHEAD = AEAD_HEADER_SIZE + AEAD_TAG_SIZE;
+
+// AES-256-GCM when the CPU has AES-NI and carry-less multiply, otherwise
+// ChaCha20-Poly1305, which is faster than table-based AES in software
+AeadAlgorithm select_aead_algorithm();
+
+// "AES-256-GCM" and "ChaCha20-Poly1305" pick an algorithm; anything else,
+// including the legacy "AES-256-CBC", lets the CPU decide
+AeadAlgorithm parse_aead_algorithm(const String& name);
+const char* aead_algorithm_name(AeadAlgorithm algorithm);
+
+// Record layout:
+//   [key id, u64 LE][sequence, u64 LE][ciphertext][16-byte tag]
+// The key id is 56 random bits chosen by the sender with the algorithm in
+// the top byte. Both header fields are authenticated as associated data.
+//
+// Every sender derives its own keys from the shared master key and its key
+// id, so sequence numbers can start at zero on every connection without two
+// senders ever sharing a nonce. The nonce is the derived IV XOR the
+// sequence, and the key is re-derived every 2^24 records (one epoch) to
+// stay well inside the AES-GCM usage limits.
+class AeadSealer {
+public:
+    AeadSealer() = default;
+    ~AeadSealer();
+
+    AeadSealer(const AeadSealer&) = delete;
+    AeadSealer& operator=(const AeadSealer&) = delete;
+
+    bool initialize(AeadAlgorithm algorithm, const Vector<u8>& master_key);
+    bool is_initialized() const { return ctx_ != nullptr; }
+
+    // The key schedule stays loaded between records; only the nonce changes
+    bool seal(const u8* data, size_t size, Vector<u8>& output);
+
+    // Same record, built around a payload already at record +
+    // AEAD_HEADER_SIZE; the caller leaves room for the header in front and
+    // the tag behind it
+    bool seal_in_place(u8* record, size_t payload_size);
+
+    AeadAlgorithm get_algorithm() const { return algorithm_; }
+    u64 get_key_id() const { return key_id_; }
+
+private:
+    bool load_epoch(u64 epoch);
+    bool seal_record(const u8* data, size_t size, u8* record);
+
+    struct evp_cipher_ctx_st* ctx_ = nullptr;
+    AeadAlgorithm algorithm_ = AeadAlgorithm::Aes256Gcm;
+    Vector<u8> master_key_;
+    u8 iv_[AEAD_NONCE_SIZE] = {};
+    u64 key_id_ = 0;
+    u64 sequence_ = 0;
+    u64 epoch_ = 0;
+};
+
+// Receiving side for one sender key id. Rejects forged or corrupted records
+// and any sequence number already seen or older than the 64-record window.
+class AeadOpener {
+public:
+    AeadOpener() = default;
+    ~AeadOpener();
+
+    AeadOpener(const AeadOpener&) = delete;
+    AeadOpener& operator=(const AeadOpener&) = delete;
+
+    bool initialize(const Vector<u8>& master_key, u64 key_id);
+    bool is_initialized() const { return ctx_ != nullptr; }
+
+    bool open(const u8* data, size_t size, Vector<u8>& output);
+
+    // Decrypts in place; on success the plaintext is the size -
+    // AEAD_OVERHEAD bytes at record + AEAD_HEADER_SIZE
+    bool open_in_place(u8* record, size_t size);
+
+    u64 get_key_id() const { return key_id_; }
+
+    void swap(AeadOpener& other) noexcept;
+
+    // Key id of a record, without authenticating it
+    static bool peek_key_id(const u8* data, size_t size, u64& key_id);
+
+private:
+    bool load_epoch(u64 epoch);
+    bool open_record(const u8* data, size_t size, u8* plaintext);
+    bool is_replay(u64 sequence) const;
+    void mark_received(u64 sequence);
+
+    struct evp_cipher_ctx_st* ctx_ = nullptr;
+    Vector<u8> master_key_;
+    u8 iv_[AEAD_NONCE_SIZE] = {};
+    u64 key_id_ = 0;
+    u64 epoch_ = ~0ULL;
+
+    u64 highest_sequence_ = 0;
+    u64 replay_window_ = 0;
+    bool received_any_ = false;
+};
+
+// Both directions of one stream connection
+struct AeadSession {
+    AeadSealer sealer;
+    AeadOpener opener;
+};
+
+// Openers for datagram peers, keyed by their key id. Bounded: when full, an
+// arbitrary entry is dropped and its peer gets a fresh replay window.
+class AeadOpenerCache {
+public:
+    void configure(u32 capacity) { capacity_ = capacity; }
+
+    // Opens a record with the opener for its key id, as
+    // AeadOpener::open_in_place. An unknown key id is tried with a new
+    // opener that joins the cache only once the record authenticates, so a
+    // forged key id can neither evict a peer nor reset its replay window.
+    bool open_in_place(const Vector<u8>& master_key, u8* record, size_t size);
+    void clear() { openers_.clear(); }
+
+private:
+    std::unordered_map<u64, std::unique_ptr<AeadOpener>> openers_;
+    u32 capacity_ = 1024;
+};
+
+} // namespace S1U
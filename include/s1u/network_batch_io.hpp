@@ -0,0 +1,93 @@
+#pragma once
+
+#include "s1u/core.hpp"
+#include "s1u/network_packet_buffer.hpp"
+#include "s1u/network_shard_counter.hpp"
+#include <netinet/in.h>
+#include <sys/socket.h>
+
+namespace S1U {
+
+struct BatchIOStats {
+    u64 syscalls = 0;
+    u64 packets = 0;
+    u64 bytes = 0;
+    u64 truncated = 0;
+
+    f64 syscalls_per_packet() const { return packets ? static_cast<f64>(syscalls) / packets : 0.0; }
+};
+
+// Written by the owning reactor, read by get_performance_stats()
+struct BatchIOCounters {
+    ShardCounter syscalls;
+    ShardCounter packets;
+    ShardCounter bytes;
+    ShardCounter truncated;
+
+    BatchIOStats snapshot() const {
+        BatchIOStats stats;
+        stats.syscalls = syscalls.load();
+        stats.packets = packets.load();
+        stats.bytes = bytes.load();
+        stats.truncated = truncated.load();
+        return stats;
+    }
+};
+
+// recvmmsg/sendmmsg batching for datagram sockets. Datagrams are received
+// straight into pooled packet buffers; a slot whose buffer was taken gets a
+// fresh one before the next call. Sends reference the caller's payloads
+// directly, which must stay in place until flush() returns.
+class DatagramBatch {
+public:
+    DatagramBatch() = default;
+
+    DatagramBatch(const DatagramBatch&) = delete;
+    DatagramBatch& operator=(const DatagramBatch&) = delete;
+
+    bool initialize(u32 packets_per_syscall, u32 max_datagram_size);
+    u32 get_batch_size() const { return batch_size_; }
+
+    // One recvmmsg call. Returns the number of datagrams received, 0 if the
+    // socket has nothing pending, -1 on error. Runs on the pool's owner.
+    int receive(int socket_fd, PacketBufferPool& pool);
+    u32 received_size(u32 index) const { return receive_headers_[index].msg_len; }
+
+    // Hands over the buffer a datagram landed in, sized to the datagram
+    PacketBuffer take_received(u32 index);
+    const struct sockaddr_in& received_from(u32 index) const { return receive_addresses_[index]; }
+
+    // Queues one datagram; returns false once the batch is full
+    bool add_send(const u8* data, u32 size, u32 ipv4_address, u16 port);
+    u32 pending_sends() const { return send_count_; }
+
+    // Sends everything queued with as few sendmmsg calls as possible and
+    // returns how many datagrams left. A short count means the socket
+    // buffer filled up; unsent entries are discarded from the batch.
+    u32 flush(int socket_fd);
+
+    // Returns the receive buffers to their pool
+    void release_buffers();
+
+    BatchIOStats get_receive_stats() const { return receive_stats_.snapshot(); }
+    BatchIOStats get_send_stats() const { return send_stats_.snapshot(); }
+
+private:
+    u32 batch_size_ = 0;
+    u32 max_datagram_size_ = 0;
+
+    Vector<PacketBuffer> receive_buffers_;
+    Vector<struct mmsghdr> receive_headers_;
+    Vector<struct iovec> receive_iovecs_;
+    Vector<struct sockaddr_in> receive_addresses_;
+
+    Vector<struct mmsghdr> send_headers_;
+    Vector<struct iovec> send_iovecs_;
+    Vector<struct sockaddr_in> send_addresses_;
+    u32 send_count_ = 0;
+
+    BatchIOCounters receive_stats_;
+    BatchIOCounters send_stats_;
+};
+
+} // namespace S1U
@@ -0,0 +1,176 @@
+#pragma once
+
+#include "s1u/core.hpp"
+#include "s1u/quantum_network_protocol.hpp"
+#include <atomic>
+#include <memory>
+#include <mutex>
+
+struct ZSTD_CCtx_s;
+struct ZSTD_DCtx_s;
+struct ZSTD_CDict_s;
+struct ZSTD_DDict_s;
+
+namespace S1U {
+
+// Shannon entropy of a strided sample of the payload, in bits per byte.
+// Payloads near 8 bits/byte (already compressed or encrypted) are not
+// worth handing to the compressor.
+f32 estimate_entropy_bits(const u8* data, size_t size);
+
+CompressionClass compression_class_from_qos(const String& qos_class);
+CompressionTierPolicy default_compression_tier_policy(CompressionClass compression_class);
+CompressionType select_compression_algorithm(const CompressionTierPolicy& policy, f64 link_mbps);
+
+// LZ4 fast path. Each message is an independent block prefixed with its
+// 4-byte little-endian original size, so the receiver can size the output
+// exactly and reject anything larger than it allows. The compression state
+// is allocated once and reused. The pointer overloads write into caller
+// memory of the given capacity, such as a pooled packet buffer.
+class Lz4Compressor {
+public:
+    static size_t compress_bound(size_t size);
+    bool compress(const u8* data, size_t size, Vector<u8>& output, int acceleration);
+    bool compress(const u8* data, size_t size, u8* output, size_t capacity, size_t& output_size, int acceleration);
+
+    // Size the block decodes to, from its prefix; 0 if the block is invalid
+    static size_t decompressed_size(const u8* data, size_t size);
+    static bool decompress(const u8* data, size_t size, Vector<u8>& output, size_t max_output);
+    static bool decompress(const u8* data, size_t size, u8* output, size_t capacity, size_t& output_size);
+
+private:
+    Vector<u8> state_;
+};
+
+// Raw dictionary content plus the digested forms zstd works from. Immutable
+// once built, so sessions on any shard can share one instance.
+class CompressionDictionary {
+public:
+    ~CompressionDictionary();
+
+    CompressionDictionary(const CompressionDictionary&) = delete;
+    CompressionDictionary& operator=(const CompressionDictionary&) = delete;
+
+    static std::shared_ptr<const CompressionDictionary> create(const u8* data, size_t size, int compression_level);
+
+    u32 get_id() const { return id_; }
+    const Vector<u8>& get_content() const { return content_; }
+    const struct ZSTD_CDict_s* get_compression_dictionary() const { return cdict_; }
+    const struct ZSTD_DDict_s* get_decompression_dictionary() const { return ddict_; }
+
+private:
+    CompressionDictionary() = default;
+
+    Vector<u8> content_;
+    u32 id_ = 0;
+    struct ZSTD_CDict_s* cdict_ = nullptr;
+    struct ZSTD_DDict_s* ddict_ = nullptr;
+};
+
+// Collects small messages from the reactors and trains a dictionary from
+// them once enough have been seen. offer() is cheap and lock-free once the
+// sample budget is used up.
+class DictionaryTrainer {
+public:
+    void configure(u32 max_samples, u32 max_sample_size);
+
+    void offer(const u8* data, size_t size);
+    bool ready() const;
+
+    // Returns nullptr if zstd could not derive a useful dictionary
+    std::shared_ptr<const CompressionDictionary> train(size_t dictionary_capacity, int compression_level);
+
+private:
+    mutable std::mutex mutex_;
+    Vector<u8> samples_;
+    Vector<size_t> sample_sizes_;
+    u32 max_samples_ = 0;
+    u32 max_sample_size_ = 0;
+    std::atomic<bool> full_{false};
+};
+
+// One connection's compression state. Stream mode keeps the zstd window
+// across messages, so small messages compress against everything sent
+// before them; the peer must decode every compressed message in order.
+// Message mode produces self-contained frames for unordered transports and
+// relies on the shared dictionary alone.
+class CompressionSession {
+public:
+    CompressionSession() = default;
+    ~CompressionSession();
+
+    CompressionSession(const CompressionSession&) = delete;
+    CompressionSession& operator=(const CompressionSession&) = delete;
+
+    // Compresses with dictionary. Frames are decoded with whichever of
+    // dictionary, accepted_dictionary or none their header names, so a
+    // dictionary can be accepted from the peer before it is used here.
+    bool initialize(int compression_level, u32 window_log, std::shared_ptr<const CompressionDictionary> dictionary,
+                    std::shared_ptr<const CompressionDictionary> accepted_dictionary = nullptr);
+
+    // Applied between messages; the stream itself stays valid
+    void set_level(int compression_level);
+    int get_level() const { return level_; }
+    u32 get_dictionary_id() const { return dictionary_ ? dictionary_->get_id() : 0; }
+
+    // Early skip: high-entropy payloads and connections whose recent
+    // traffic kept failing to shrink back off exponentially
+    bool should_compress(const u8* data, size_t size, f32 entropy_limit_bits);
+
+    // Output capacity that always holds one compressed message
+    static size_t stream_compress_bound(size_t size);
+    static size_t message_compress_bound(size_t size);
+
+    bool compress_stream(const u8* data, size_t size, Vector<u8>& output);
+    bool compress_stream(const u8* data, size_t size, u8* output, size_t capacity, size_t& output_size);
+    bool decompress_stream(const u8* data, size_t size, Vector<u8>& output, size_t max_output);
+
+    // Decodes until the input is used up or the output is full, and reports
+    // how far it got. A full output may mean more is pending: call again
+    // with the remaining input and fresh room.
+    bool decompress_stream(const u8* data, size_t size, size_t& consumed, u8* output, size_t capacity, size_t& produced);
+
+    bool compress_message(const u8* data, size_t size, Vector<u8>& output);
+    bool compress_message(const u8* data, size_t size, u8* output, size_t capacity, size_t& output_size);
+    bool decompress_message(const u8* data, size_t size, Vector<u8>& output, size_t max_output);
+    bool decompress_message(const u8* data, size_t size, u8* output, size_t capacity, size_t& output_size);
+
+    // Decoded size recorded in a message frame's header
+    static bool message_content_size(const u8* data, size_t size, size_t& content_size);
+
+private:
+    // frame is the start of the frame about to be decoded
+    bool ensure_decompressor(const u8* frame, size_t size);
+    void record_result(size_t input_size, size_t output_size);
+
+    struct ZSTD_CCtx_s* cctx_ = nullptr;
+    struct ZSTD_DCtx_s* dctx_ = nullptr;
+    std::shared_ptr<const CompressionDictionary> dictionary_;
+    std::shared_ptr<const CompressionDictionary> accepted_dictionary_;
+    u32 decoder_dictionary_id_ = 0;
+    int level_ = 3;
+    u32 window_log_ = 17;
+
+    u32 poor_results_ = 0;
+    u32 skip_remaining_ = 0;
+    u32 skip_span_ = 1;
+};
+
+// Picks the compression level once a second from link utilization and
+// spare CPU: a busy link with idle cores gets more compression, a starved
+// CPU or an idle link gets less.
+class CompressionLevelController {
+public:
+    void configure(int initial_level, int min_level, int max_level);
+
+    // Returns the level to use from now on
+    int update(f64 link_utilization, f64 cpu_headroom);
+    int get_level() const { return level_.load(std::memory_order_relaxed); }
+
+private:
+    std::atomic<int> level_{3};
+    int min_level_ = 1;
+    int max_level_ = 19;
+};
+
+} // namespace S1U
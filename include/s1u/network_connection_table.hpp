@@ -0,0 +1,131 @@
+#pragma once
+
+#include "s1u/core.hpp"
+#include "s1u/quantum_network_protocol.hpp"
+#include "s1u/network_compression.hpp"
+#include "s1u/network_aead.hpp"
+#include "s1u/network_zerocopy.hpp"
+#include "s1u/network_pacing.hpp"
+#include "s1u/network_stream_records.hpp"
+#include <deque>
+#include <memory>
+
+namespace S1U {
+
+// Per-packet connection state, one cache line per fd
+struct alignas(64) ConnectionHotState {
+    int socket_fd = -1;
+    u32 generation = 0;
+    u32 congestion_window_size = 10;
+    u32 send_sequence = 0;
+    u32 receive_sequence = 0;
+    bool is_connected = false;
+    u64 bytes_sent = 0;
+    u64 bytes_received = 0;
+    u64 packets_sent = 0;
+    u64 packets_received = 0;
+    u64 last_activity_time = 0;
+};
+
+static_assert(sizeof(ConnectionHotState) == 64, "ConnectionHotState must stay within one cache line");
+
+// Metadata read on accept, close, policy passes and reporting, plus the
+// compression session, which only compressible sends touch
+struct ConnectionColdState {
+    String remote_address;
+    u32 remote_port = 0;
+    u64 connection_time = 0;
+    f64 current_rtt_ms = 0.0;
+    f64 smoothed_rtt_ms = 0.0;
+    f64 rtt_variance_ms = 0.0;
+    f64 bandwidth_mbps = 0.0;
+    u32 slow_start_threshold = 100;
+    u32 duplicate_ack_count = 0;
+    u32 retransmission_count = 0;
+    String qos_class = "BestEffort";
+    u32 priority = 0;
+    bool is_real_time = false;
+    Vector<u8> send_buffer;
+    Vector<u8> receive_buffer;
+
+    // Created on the first compressible message, freed on close
+    std::unique_ptr<CompressionSession> compression;
+    // Created on the first sealed or opened record, freed on close
+    std::unique_ptr<AeadSession> encryption;
+    // Present when the socket accepted SO_ZEROCOPY
+    std::unique_ptr<ZeroCopySendQueue> zero_copy;
+    // Present when congestion control is on. Packets held back by the pacer
+    // wait here, in order, so they do not block other connections.
+    std::unique_ptr<ConnectionPacer> pacer;
+    std::deque<DataPacket> paced_packets;
+    // Record cut out of the byte stream so far
+    StreamRecordAssembler records;
+    // On the shard's starved list: data was left in the socket for want of
+    // a receive buffer
+    bool receive_starved = false;
+};
+
+// Identifies one connection instance. The generation changes whenever the
+// fd slot is closed, so handles held across a close-and-reuse go stale.
+struct ConnectionHandle {
+    int socket_fd = -1;
+    u32 generation = 0;
+};
+
+// Connections indexed directly by fd. Lookup, insert and close are O(1);
+// a dense list of live fds keeps iteration proportional to the number of
+// open connections rather than the highest fd.
+class NetworkConnectionTable {
+public:
+    NetworkConnectionTable() = default;
+
+    void reserve(u32 max_fds);
+    void clear();
+
+    ConnectionHandle insert(const NetworkConnection& connection);
+    bool remove(int socket_fd);
+
+    ConnectionHotState* find(int socket_fd);
+    const ConnectionHotState* find(int socket_fd) const;
+    ConnectionHotState* find(ConnectionHandle handle);
+    ConnectionColdState* cold(int socket_fd);
+    const ConnectionColdState* cold(int socket_fd) const;
+
+    ConnectionHandle handle_for(int socket_fd) const;
+    NetworkConnection snapshot(int socket_fd) const;
+
+    u32 size() const { return static_cast<u32>(live_fds_.size()); }
+    bool empty() const { return live_fds_.empty(); }
+    const Vector<int>& live_fds() const { return live_fds_; }
+
+    template <typename Function>
+    void for_each(Function&& function) {
+        for (int socket_fd : live_fds_) {
+            function(hot_[socket_fd], cold_[socket_fd]);
+        }
+    }
+
+    template <typename Function>
+    void for_each(Function&& function) const {
+        for (int socket_fd : live_fds_) {
+            function(hot_[socket_fd], cold_[socket_fd]);
+        }
+    }
+
+private:
+    static constexpr u32 NOT_LIVE = 0xffffffffu;
+
+    bool is_live(int socket_fd) const {
+        return socket_fd >= 0 && static_cast<size_t>(socket_fd) < hot_.size() &&
+               live_index_[socket_fd] != NOT_LIVE;
+    }
+
+    void grow(size_t slots);
+
+    Vector<ConnectionHotState> hot_;
+    Vector<ConnectionColdState> cold_;
+    Vector<u32> live_index_;
+    Vector<int> live_fds_;
+};
+
+} // namespace S1U
@@ -0,0 +1,43 @@
+#pragma once
+
+#include "s1u/core.hpp"
+
+namespace S1U {
+
+enum class CrcVariant : u32 {
+    Crc32,   // IEEE 802.3 / zlib, polynomial 0x04C11DB7
+    Crc32C   // Castagnoli, polynomial 0x1EDC6F41
+};
+
+enum class CrcBackend : u32 {
+    Slicing8,
+    Sse42,
+    Pclmul
+};
+
+// Both functions follow the zlib convention: start from 0 and feed the
+// previous result back in to continue a streamed payload, so
+// crc32_update(crc32_update(0, a), b) == crc32_update(0, a + b).
+// The fastest backend the CPU supports is picked on first use.
+u32 crc32_update(u32 crc, const u8* data, size_t size);
+u32 crc32c_update(u32 crc, const u8* data, size_t size);
+
+u32 crc_update(CrcVariant variant, u32 crc, const u8* data, size_t size);
+CrcBackend get_crc_backend(CrcVariant variant);
+const char* crc_backend_name(CrcBackend backend);
+
+// Accumulates a checksum over a payload that arrives in pieces
+class CrcStream {
+public:
+    explicit CrcStream(CrcVariant variant = CrcVariant::Crc32) : variant_(variant) {}
+
+    void update(const u8* data, size_t size) { crc_ = crc_update(variant_, crc_, data, size); }
+    void reset() { crc_ = 0; }
+    u32 value() const { return crc_; }
+
+private:
+    CrcVariant variant_;
+    u32 crc_ = 0;
+};
+
+} // namespace S1U
@@ -0,0 +1,81 @@
+#pragma once
+
+#include "s1u/core.hpp"
+
+namespace S1U {
+
+// What the kernel's TCP state says about one connection. Read with
+// TCP_INFO, so the controller sees the stack's own RTT and ack accounting
+// instead of needing acknowledgements in the protocol.
+struct TransportSample {
+    f64 rtt_ms = 0.0;          // smoothed
+    f64 rtt_variance_ms = 0.0;
+    u64 bytes_acked = 0;       // cumulative
+    u32 total_retransmits = 0; // cumulative
+    u32 mss = 0;
+    u64 bytes_in_flight = 0;   // unacked plus not yet sent
+};
+
+bool read_transport_sample(int socket_fd, TransportSample& sample);
+
+struct PacingConfig {
+    f64 target_delay_ms = 5.0;        // queueing delay the controller aims for
+    u32 initial_window_segments = 10;
+    u32 min_window_segments = 2;
+    u32 max_window_segments = 1000;
+    f64 max_rate_mbps = 100000.0;
+};
+
+// LEDBAT-style delay-based controller driving a pacer. The base delay is
+// the lowest RTT seen over the last few minutes; anything above it is
+// queueing delay. The window grows while queueing delay is below target and
+// shrinks in proportion once it is above, halves on loss, and is sent out
+// evenly over one RTT rather than in a burst.
+class ConnectionPacer {
+public:
+    void initialize(const PacingConfig& config, u64 now_ns);
+
+    // Whether the next send may go out now. Up to one pacing quantum of
+    // unused time is credited, so a reactor waking every millisecond still
+    // keeps the rate.
+    bool can_send(u64 now_ns) const { return now_ns >= next_send_ns_; }
+    u64 get_next_send_ns() const { return next_send_ns_; }
+    void on_send(u64 bytes, u64 now_ns);
+
+    // Samples are wanted about once per RTT
+    bool sample_due(u64 now_ns) const { return now_ns >= next_sample_ns_; }
+    void on_transport_sample(const TransportSample& sample, u64 now_ns);
+
+    f64 get_rate_mbps() const { return rate_bytes_per_ns_ * 8000.0; }
+    f64 get_window_bytes() const { return window_bytes_; }
+    f64 get_base_delay_ms() const;
+    f64 get_queuing_delay_ms() const { return queuing_delay_ms_; }
+    f64 get_rtt_ms() const { return rtt_ms_; }
+
+private:
+    void update_rate();
+    void record_base_delay(f64 rtt_ms, u64 now_ns);
+
+    // Minimum RTT per minute, oldest overwritten first
+    static constexpr u32 BASE_HISTORY = 10;
+
+    PacingConfig config_;
+    f64 window_bytes_ = 0.0;
+    f64 mss_ = 1448.0;
+    f64 rate_bytes_per_ns_ = 0.0;
+    f64 rtt_ms_ = 0.0;
+    f64 queuing_delay_ms_ = 0.0;
+
+    f64 base_delays_ms_[BASE_HISTORY] = {};
+    u32 base_index_ = 0;
+    u64 base_bucket_start_ns_ = 0;
+
+    u64 next_send_ns_ = 0;
+    u64 next_sample_ns_ = 0;
+    u64 last_bytes_acked_ = 0;
+    u32 last_retransmits_ = 0;
+    u64 last_reduction_ns_ = 0;
+    bool have_sample_ = false;
+};
+
+} // namespace S1U
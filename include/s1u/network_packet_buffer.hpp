@@ -0,0 +1,159 @@
+#pragma once
+
+#include "s1u/core.hpp"
+#include <atomic>
+#include <cstddef>
+#include <thread>
+
+namespace S1U {
+
+class PacketBufferPool;
+
+// Block header, in the first cache line of every pooled buffer. The payload
+// area follows it directly.
+struct alignas(64) PacketBufferHeader {
+    std::atomic<u32> references{0};
+    u32 size_class = 0;
+    u32 capacity = 0;             // bytes after the header
+    PacketBufferPool* pool = nullptr;
+    PacketBufferHeader* next = nullptr; // free list link while not in use
+};
+
+// Reference to a window of a pooled buffer. Copies share the buffer and the
+// last reference returns it to the pool it came from, from any thread.
+// Headroom and tailroom let a layer add its header and trailer in place
+// (the AEAD record framing) instead of copying the payload to a new buffer.
+class PacketBuffer {
+public:
+    PacketBuffer() = default;
+    ~PacketBuffer() { reset(); }
+
+    PacketBuffer(const PacketBuffer& other);
+    PacketBuffer& operator=(const PacketBuffer& other);
+    PacketBuffer(PacketBuffer&& other) noexcept;
+    PacketBuffer& operator=(PacketBuffer&& other) noexcept;
+
+    void swap(PacketBuffer& other) noexcept;
+
+    // Drops this reference
+    void reset();
+
+    bool valid() const { return header_ != nullptr; }
+    u8* data() { return base() + offset_; }
+    const u8* data() const { return base() + offset_; }
+    size_t size() const { return size_; }
+    bool empty() const { return size_ == 0; }
+    u8& operator[](size_t index) { return data()[index]; }
+    const u8& operator[](size_t index) const { return data()[index]; }
+
+    size_t headroom() const { return offset_; }
+    size_t tailroom() const { return header_ ? header_->capacity - offset_ - size_ : 0; }
+
+    // Another reference exists; writing would change what it sees
+    bool is_shared() const { return header_ && header_->references.load(std::memory_order_acquire) > 1; }
+
+    // Grow or shrink the window at either end. Growing requires the room.
+    u8* push_front(size_t bytes);
+    u8* push_back(size_t bytes);
+    void trim_front(size_t bytes);
+    void trim_back(size_t bytes);
+    void resize(size_t bytes) { size_ = static_cast<u32>(bytes); }
+
+private:
+    friend class PacketBufferPool;
+
+    u8* base() const { return reinterpret_cast<u8*>(header_ + 1); }
+
+    PacketBufferHeader* header_ = nullptr;
+    u32 offset_ = 0;
+    u32 size_ = 0;
+};
+
+struct PacketBufferPoolStats {
+    u64 slabs = 0;
+    u64 reserved_bytes = 0;     // slab memory mapped so far
+    u64 huge_page_bytes = 0;    // slab memory mapped with huge pages requested
+    u64 allocations = 0;
+    u64 buffers_in_use = 0;
+    u64 remote_frees = 0;       // returned from another thread
+    u64 oversize_allocations = 0;
+    u64 allocation_failures = 0;
+};
+
+// Slab allocator for one reactor's packet buffers. Blocks come in power of
+// two size classes from 4 KB to 2 MB, carved from 2 MB slabs that are never
+// unmapped before the pool is destroyed. A slab is one huge page where the
+// system has them, so a burst of receives costs one TLB entry per slab. The owning thread allocates and
+// frees through per-class free lists with no atomics; buffers released on
+// any other thread go onto a lock-free stack that the owner takes over the
+// next time a free list runs dry. Payloads larger than the biggest class
+// get a mapping of their own.
+class PacketBufferPool {
+public:
+    static constexpr u32 HEADROOM = 64;
+    static constexpr u32 TAILROOM = 64;
+    static constexpr u32 MIN_CLASS_SHIFT = 12;
+    static constexpr u32 MAX_CLASS_SHIFT = 21;
+    static constexpr u32 SIZE_CLASS_COUNT = MAX_CLASS_SHIFT - MIN_CLASS_SHIFT + 1;
+    static constexpr size_t SLAB_SIZE = size_t(1) << MAX_CLASS_SHIFT;
+
+    PacketBufferPool() = default;
+    ~PacketBufferPool();
+
+    PacketBufferPool(const PacketBufferPool&) = delete;
+    PacketBufferPool& operator=(const PacketBufferPool&) = delete;
+
+    // Makes the calling thread the owner. Buffers it releases go straight
+    // back onto the free lists.
+    void bind_to_current_thread();
+
+    // Owning thread only. The buffer holds size bytes, with HEADROOM in
+    // front and at least TAILROOM behind; an invalid buffer if memory ran
+    // out.
+    PacketBuffer allocate(size_t size);
+
+    // Owning thread only. Ensures buffer is the only reference to its block
+    // and has the requested room on both sides, moving the payload to a
+    // fresh buffer if not.
+    bool make_writable(PacketBuffer& buffer, size_t headroom, size_t tailroom);
+
+    // Largest payload a class block can hold, after header and room
+    static constexpr size_t class_payload_capacity(u32 size_class) {
+        return (size_t(1) << (MIN_CLASS_SHIFT + size_class)) - sizeof(PacketBufferHeader) - HEADROOM - TAILROOM;
+    }
+
+    PacketBufferPoolStats get_stats() const;
+
+private:
+    friend class PacketBuffer;
+
+    static constexpr u32 OVERSIZE_CLASS = SIZE_CLASS_COUNT;
+
+    static u32 class_for(size_t block_size);
+    PacketBuffer allocate_with_room(size_t size, size_t headroom, size_t tailroom);
+    PacketBufferHeader* allocate_oversize(size_t block_size);
+    bool carve_slab(u32 size_class);
+    void take_remote_frees();
+    void release(PacketBufferHeader* header);
+
+    static void add(std::atomic<u64>& counter, u64 amount) {
+        counter.store(counter.load(std::memory_order_relaxed) + amount, std::memory_order_relaxed);
+    }
+
+    std::thread::id owner_;
+    PacketBufferHeader* free_lists_[SIZE_CLASS_COUNT] = {};
+    Vector<void*> slabs_;
+    alignas(64) std::atomic<PacketBufferHeader*> remote_frees_{nullptr};
+
+    // Written by the owner only, except remote_frees
+    alignas(64) std::atomic<u64> slab_count_{0};
+    std::atomic<u64> reserved_bytes_{0};
+    std::atomic<u64> huge_page_bytes_{0};
+    std::atomic<u64> allocations_{0};
+    std::atomic<u64> local_frees_{0};
+    std::atomic<u64> oversize_allocations_{0};
+    std::atomic<u64> allocation_failures_{0};
+    alignas(64) std::atomic<u64> remote_free_count_{0};
+};
+
+} // namespace S1U
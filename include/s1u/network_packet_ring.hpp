@@ -0,0 +1,46 @@
+#pragma once
+
+#include "s1u/core.hpp"
+#include "s1u/quantum_network_protocol.hpp"
+
+namespace S1U {
+
+// Fixed-capacity FIFO of packets for the reactor thread. Slots are allocated
+// once and never move; push() swaps the packet into its slot and leaves the
+// caller's packet with no payload. Payloads are pooled packet buffers, so
+// neither end allocates. Enqueue and dequeue are O(1).
+class PacketRing {
+public:
+    PacketRing() = default;
+    explicit PacketRing(u32 capacity) { reset(capacity); }
+
+    // Capacity is rounded up to a power of two
+    void reset(u32 capacity);
+
+    // When full, either drops the oldest packet (drop_oldest) or refuses the
+    // new one. Returns false if the packet was not queued.
+    bool push(DataPacket& packet, bool drop_oldest);
+
+    DataPacket& front() { return slots_[head_ & mask_]; }
+    const DataPacket& front() const { return slots_[head_ & mask_]; }
+    void pop_front();
+
+    // index counts from the front; index < size()
+    DataPacket& at(u32 index) { return slots_[(head_ + index) & mask_]; }
+
+    u32 size() const { return static_cast<u32>(tail_ - head_); }
+    u32 capacity() const { return static_cast<u32>(slots_.size()); }
+    bool empty() const { return tail_ == head_; }
+    bool full() const { return size() == capacity(); }
+
+    u64 get_dropped_count() const { return dropped_; }
+
+private:
+    Vector<DataPacket> slots_;
+    u64 mask_ = 0;
+    u64 head_ = 0;
+    u64 tail_ = 0;
+    u64 dropped_ = 0;
+};
+
+} // namespace S1U
@@ -0,0 +1,135 @@
+#pragma once
+
+#include "s1u/core.hpp"
+#include "s1u/quantum_network_protocol.hpp"
+#include "s1u/network_packet_buffer.hpp"
+#include "s1u/network_connection_table.hpp"
+#include "s1u/network_packet_ring.hpp"
+#include "s1u/network_batch_io.hpp"
+#include "s1u/network_compression.hpp"
+#include "s1u/network_aead.hpp"
+#include "s1u/network_zerocopy.hpp"
+#include "s1u/network_statistics.hpp"
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <thread>
+
+namespace S1U {
+
+// Bounded multi-producer, single-consumer queue that hands packets to a
+// reactor shard from any other thread. Producers claim slots with one CAS on
+// the enqueue position; the owning shard drains without atomics beyond the
+// per-slot sequence. post() and take() swap packets; a payload from another
+// shard's pool goes back to that pool when this shard releases it.
+class ShardMailbox {
+public:
+    ShardMailbox() = default;
+    ~ShardMailbox();
+
+    ShardMailbox(const ShardMailbox&) = delete;
+    ShardMailbox& operator=(const ShardMailbox&) = delete;
+
+    // Capacity is rounded up to a power of two. Also creates the eventfd the
+    // shard's epoll set watches for wakeups.
+    bool initialize(u32 capacity);
+
+    // Any thread. Returns false when the mailbox is full.
+    bool post(DataPacket& packet);
+
+    // Owning shard only. Returns false when the mailbox is empty.
+    bool take(DataPacket& packet);
+
+    int get_wake_fd() const { return wake_fd_; }
+
+    // Owning shard, before draining: rearms the wakeup so a post that races
+    // with the drain signals again
+    void acknowledge_wake();
+
+    u64 get_rejected_count() const { return rejected_.load(std::memory_order_relaxed); }
+
+private:
+    struct alignas(64) Cell {
+        std::atomic<u64> sequence{0};
+        DataPacket packet;
+    };
+
+    std::unique_ptr<Cell[]> cells_;
+    u64 mask_ = 0;
+
+    alignas(64) std::atomic<u64> enqueue_position_{0};
+    alignas(64) u64 dequeue_position_ = 0;
+    alignas(64) std::atomic<bool> wake_pending_{false};
+    std::atomic<u64> rejected_{0};
+
+    int wake_fd_ = -1;
+};
+
+// Everything one reactor thread owns. Nothing in here is touched by another
+// reactor; the only cross-shard entry point is the mailbox.
+struct ReactorShard {
+    u32 shard_id = 0;
+    int cpu = -1;
+
+    int epoll_fd = -1;
+    int server_socket = -1;
+    int datagram_socket = -1;
+
+    // Every payload this shard receives or produces. Declared first so it
+    // outlives the members below that hold its buffers.
+    PacketBufferPool buffers;
+
+    // Stream reads land here; see NetworkConfig::receive_copy_break
+    PacketBuffer receive_buffer;
+
+    NetworkConnectionTable connections;
+    PacketRing packet_buffer;
+    DatagramBatch datagram_batch;
+    ShardMailbox mailbox;
+
+    // Self-contained frames for datagrams; stream connections carry their
+    // own session in the connection table
+    CompressionSession message_compression;
+    Lz4Compressor lz4;
+    u32 message_dictionary_generation = ~0U;
+    u32 dictionary_sample_counter = 0;
+
+    // Datagrams are sealed under one shard key id; peers are told apart by
+    // theirs
+    AeadSealer datagram_sealer;
+    AeadOpenerCache datagram_openers;
+
+    // Stream sends, zero-copy above the size threshold; connections hold
+    // their own pinned payloads
+    ZeroCopySender zero_copy;
+
+    // Connections with packets waiting on their pacer
+    Vector<int> paced_sockets;
+    // Connections that stopped reading because the pool was exhausted.
+    // Their data is already signalled, so edge-triggered epoll will not
+    // report it again; the reactor retries them after each send pass.
+    Vector<ConnectionHandle> starved_sockets;
+    ShardCounter paced_deferrals;
+
+    BatchIOCounters stream_receive_stats;
+    BatchIOCounters stream_send_stats;
+    ShardStatistics statistics;
+
+    // Published once a second for the aggregate latency statistics
+    std::atomic<f64> rtt_sum_ms{0.0};
+    std::atomic<u32> rtt_samples{0};
+    std::atomic<f64> queuing_delay_sum_ms{0.0};
+    std::atomic<f64> pacing_rate_sum_mbps{0.0};
+    std::atomic<u32> paced_connections{0};
+    std::chrono::steady_clock::time_point last_statistics_publish{};
+
+    std::thread thread;
+};
+
+// CPUs this process may run on, in ascending order
+Vector<u32> get_available_cpus();
+
+// Pins the calling thread to one CPU
+bool pin_current_thread_to_cpu(u32 cpu);
+
+} // namespace S1U
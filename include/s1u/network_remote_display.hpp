@@ -0,0 +1,251 @@
+#pragma once
+
+#include "s1u/core.hpp"
+#include "s1u/damage_region.hpp"
+#include "s1u/quantum_network_protocol.hpp"
+#include "s1u/network_compression.hpp"
+#include <list>
+#include <unordered_map>
+
+namespace S1U {
+
+// Remote display stream. One message per frame, carried in order over a
+// reliable transport:
+//
+//   RemoteFrameHeader, then tile_count records of
+//   RemoteTileHeader followed by payload_size bytes
+//
+// Pixels are 32-bit (BGRA as the compositor produces them) and the screen
+// is cut into square tiles, row-major, the last row and column clipped.
+// A tile is sent as Data (pixels, possibly compressed) or, when the client
+// already holds a tile with the same content hash, as a Cached reference.
+// Both ends run the same LRU over the same sequence of hashes, so the
+// encoder knows exactly what the client holds without a back channel.
+
+constexpr u32 REMOTE_DISPLAY_MAGIC = 0x44523153; // "S1RD"
+constexpr u32 REMOTE_FRAME_RESET = 1U << 0;      // client drops its cache and screen
+
+enum class RemoteTileKind : u8 {
+    Data = 0,
+    Cached = 1
+};
+
+struct RemoteFrameHeader {
+    u32 magic = REMOTE_DISPLAY_MAGIC;
+    u32 frame_number = 0;
+    u32 flags = 0;
+    u16 width = 0;
+    u16 height = 0;
+    u16 tile_size = 0;
+    u16 reserved = 0;
+    u32 tile_count = 0;
+    u32 cache_capacity = 0;
+};
+
+struct RemoteTileHeader {
+    u32 tile_index = 0;
+    u8 kind = 0;        // RemoteTileKind
+    u8 compression = 0; // CompressionType: None, LZ4 or ZSTD
+    u16 reserved = 0;
+    u64 hash = 0;
+    u32 payload_size = 0;
+    u32 reserved2 = 0;
+};
+
+static_assert(sizeof(RemoteFrameHeader) == 28, "RemoteFrameHeader is part of the wire format");
+static_assert(sizeof(RemoteTileHeader) == 24, "RemoteTileHeader is part of the wire format");
+
+constexpr u32 REMOTE_MAX_DIMENSION = 16384;
+constexpr u32 REMOTE_MIN_TILE_SIZE = 16;
+constexpr u32 REMOTE_MAX_TILE_SIZE = 256;
+
+// 64-bit content hash of a tile read in place from the framebuffer. Four
+// independent lanes keep the multiplies pipelined.
+u64 hash_tile(const u8* pixels, u32 stride, u32 row_bytes, u32 rows);
+
+// LRU of tile hashes mapped to cache slots. Slots are handed out in order
+// and reused from the evicted entry, so two instances fed the same calls
+// assign the same slots.
+class RemoteTileCache {
+public:
+    void reset(u32 capacity);
+
+    // Marks the hash most recently used. Returns false if it is not cached.
+    bool touch(u64 hash, u32& slot);
+
+    // Caller has checked the hash is absent
+    u32 insert(u64 hash);
+
+    u32 capacity() const { return capacity_; }
+    u32 size() const { return static_cast<u32>(entries_.size()); }
+
+private:
+    struct Entry {
+        u64 hash;
+        u32 slot;
+    };
+
+    std::list<Entry> order_;
+    std::unordered_map<u64, std::list<Entry>::iterator> entries_;
+    u32 capacity_ = 0;
+    u32 next_slot_ = 0;
+};
+
+struct RemoteDisplayConfig {
+    u32 tile_size = 64;
+    u32 cache_capacity = 4096;        // tiles; 64 MB of client memory at 64x64
+    f64 link_mbps = 10.0;
+    CompressionTierPolicy compression = default_compression_tier_policy(CompressionClass::Interactive);
+    int zstd_level = 3;
+    u32 lz4_acceleration = 1;
+};
+
+struct RemoteDisplayStats {
+    u64 frames = 0;
+    u64 tiles_damaged = 0;
+    u64 tiles_unchanged = 0; // damaged but identical to what the client shows
+    u64 tiles_cached = 0;    // sent as a cache reference
+    u64 tiles_sent = 0;
+    u64 tiles_compressed = 0;
+    u64 raw_bytes = 0;       // pixel bytes of every tile sent as data
+    u64 encoded_bytes = 0;   // whole frame messages
+    f64 encode_time_ms = 0.0;
+};
+
+// Turns damaged framebuffer regions into frame messages. The caller owns
+// both the pixels and the damage; RemoteDisplayStream feeds it the
+// compositor's readback.
+class RemoteDisplayEncoder {
+public:
+    bool initialize(const RemoteDisplayConfig& config);
+
+    // Link speed feeds the compression tier choice from the next frame on
+    void set_link_speed(f64 link_mbps) { config_.link_mbps = link_mbps; }
+
+    // Forces the next frame to reset the client and resend every tile
+    void request_reset() { reset_pending_ = true; }
+
+    // pixels is the full screen, width x height 32-bit pixels, stride in
+    // bytes. A size change implies a reset. Returns false only if the
+    // frame could not be encoded; an empty damage region still produces a
+    // (tile-less) frame message.
+    bool encode_frame(const u8* pixels, u32 width, u32 height, u32 stride,
+                      const s1u::DamageRegion& damage, Vector<u8>& output);
+
+    const RemoteDisplayStats& get_statistics() const { return stats_; }
+
+private:
+    void collect_damaged_tiles(const s1u::DamageRegion& damage);
+    bool append_tile(const u8* pixels, u32 stride, u32 tile_index, u64 hash, Vector<u8>& output);
+
+    RemoteDisplayConfig config_;
+    u32 width_ = 0;
+    u32 height_ = 0;
+    u32 tiles_x_ = 0;
+    u32 tiles_y_ = 0;
+    u32 frame_number_ = 0;
+    bool reset_pending_ = true;
+
+    RemoteTileCache cache_;
+    Vector<u64> shown_hashes_;
+    Vector<u32> tile_marks_;
+    u32 mark_generation_ = 0;
+    Vector<u32> damaged_tiles_;
+
+    Vector<u8> tile_pixels_;
+    Vector<u8> compressed_;
+    Lz4Compressor lz4_;
+    CompressionSession zstd_;
+
+    RemoteDisplayStats stats_;
+};
+
+struct RemoteDisplayStreamConfig {
+    RemoteDisplayConfig encoder;
+    u16 port = 0;                      // 0 picks an ephemeral port
+    bool loopback_only = true;
+    u32 max_queued_bytes = 32U << 20;  // per viewer backlog that gets it dropped
+};
+
+// Serves the remote display to viewers over TCP. Each frame message goes
+// out as a u32 length followed by the message. submit_frame takes the
+// compositor's readback (Compositor::set_frame_readback) and does all of
+// the work on the calling thread: it accepts new viewers, encodes only
+// while someone is watching, and sends without blocking, so what a socket
+// does not take goes out on later calls. A viewer still more than
+// max_queued_bytes behind when the next frame is ready is dropped and sees
+// a reset when it reconnects.
+class RemoteDisplayStream {
+public:
+    RemoteDisplayStream() = default;
+    ~RemoteDisplayStream();
+
+    RemoteDisplayStream(const RemoteDisplayStream&) = delete;
+    RemoteDisplayStream& operator=(const RemoteDisplayStream&) = delete;
+
+    bool initialize(const RemoteDisplayStreamConfig& config);
+    void shutdown();
+
+    // pixels must hold the whole screen; damage is what changed since the
+    // previous call. A new viewer is sent the whole screen.
+    void submit_frame(const u8* pixels, u32 width, u32 height, u32 stride, const s1u::DamageRegion& damage);
+
+    u16 get_port() const { return port_; }
+    u32 get_viewer_count() const { return static_cast<u32>(viewers_.size()); }
+    u64 get_viewers_dropped() const { return viewers_dropped_; }
+    const RemoteDisplayStats& get_statistics() const { return encoder_.get_statistics(); }
+
+private:
+    struct Viewer {
+        int socket_fd = -1;
+        Vector<u8> pending;
+        size_t sent = 0;
+    };
+
+    bool accept_viewers();
+    bool flush_viewer(Viewer& viewer);
+    void drop_viewer(size_t index);
+
+    RemoteDisplayStreamConfig config_;
+    int listen_fd_ = -1;
+    u16 port_ = 0;
+    Vector<Viewer> viewers_;
+    u64 viewers_dropped_ = 0;
+
+    RemoteDisplayEncoder encoder_;
+    Vector<u8> message_;
+};
+
+// Client side: applies frame messages to a local framebuffer
+class RemoteDisplayDecoder {
+public:
+    // Returns false on a malformed or inconsistent message; the screen may
+    // then be partially updated and the stream should be reset
+    bool decode_frame(const u8* data, size_t size);
+
+    const Vector<u8>& get_framebuffer() const { return framebuffer_; }
+    u32 get_width() const { return width_; }
+    u32 get_height() const { return height_; }
+    u32 get_stride() const { return width_ * 4; }
+    u32 get_frame_number() const { return frame_number_; }
+
+private:
+    bool apply_tile(const RemoteTileHeader& tile, const u8* payload);
+    void tile_rect(u32 tile_index, u32& x, u32& y, u32& w, u32& h) const;
+    void blit_tile(const u8* tile_pixels, u32 tile_index);
+
+    u32 width_ = 0;
+    u32 height_ = 0;
+    u32 tile_size_ = 0;
+    u32 tiles_x_ = 0;
+    u32 tiles_y_ = 0;
+    u32 frame_number_ = 0;
+    Vector<u8> framebuffer_;
+
+    RemoteTileCache cache_;
+    Vector<Vector<u8>> cache_slots_;
+    Vector<u8> tile_pixels_;
+    CompressionSession zstd_;
+};
+
+} // namespace S1U
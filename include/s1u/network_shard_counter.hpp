@@ -0,0 +1,22 @@
+#pragma once
+
+#include "s1u/core.hpp"
+#include <atomic>
+
+namespace S1U {
+
+// Counter with a single writer. The owning reactor adds with a relaxed load
+// and store, which compiles to a plain add with no locked instruction; any
+// thread may read it.
+class ShardCounter {
+public:
+    void add(u64 amount) { value_.store(value_.load(std::memory_order_relaxed) + amount, std::memory_order_relaxed); }
+    void subtract(u64 amount) { value_.store(value_.load(std::memory_order_relaxed) - amount, std::memory_order_relaxed); }
+    void increment() { add(1); }
+    u64 load() const { return value_.load(std::memory_order_relaxed); }
+
+private:
+    std::atomic<u64> value_{0};
+};
+
+} // namespace S1U
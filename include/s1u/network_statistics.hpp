@@ -0,0 +1,106 @@
+#pragma once
+
+#include "s1u/core.hpp"
+#include "s1u/quantum_network_protocol.hpp"
+#include "s1u/network_shard_counter.hpp"
+#include <atomic>
+
+namespace S1U {
+
+// Log-linear histogram of nanosecond durations: 16 buckets per power of
+// two, so any percentile read back is within about 3% of the true value.
+// Durations from 68 s up share the last bucket.
+class LatencyHistogram {
+public:
+    static constexpr u32 SUB_BUCKETS = 16;
+    static constexpr u32 MAX_EXPONENT = 35;
+    static constexpr u32 BUCKET_COUNT = (MAX_EXPONENT - 2) * SUB_BUCKETS;
+
+    static u32 bucket_for(u64 nanoseconds);
+    static u64 bucket_value(u32 bucket);
+
+    void record(u64 nanoseconds) { buckets_[bucket_for(nanoseconds)].increment(); }
+    u64 bucket_count(u32 bucket) const { return buckets_[bucket].load(); }
+
+private:
+    ShardCounter buckets_[BUCKET_COUNT];
+};
+
+// Everything one reactor counts on its hot path. Only the owning shard
+// writes; the aggregator and get_performance_stats() read. Aligned so no
+// other shard's data shares its first or last cache line.
+struct alignas(64) ShardStatistics {
+    ShardCounter packets_sent;
+    ShardCounter bytes_sent;
+    ShardCounter packets_received;
+    ShardCounter bytes_received;
+
+    ShardCounter encryption_operations;
+    ShardCounter encryption_time_ns;
+    ShardCounter authentication_failures;
+
+    ShardCounter compression_operations;
+    ShardCounter compression_skipped;
+    ShardCounter compression_input_bytes;
+    ShardCounter compression_output_bytes;
+
+    struct CompressionClassCounters {
+        ShardCounter messages;
+        ShardCounter skipped;
+        ShardCounter lz4_messages;
+        ShardCounter zstd_messages;
+        ShardCounter input_bytes;
+        ShardCounter output_bytes;
+        ShardCounter time_ns;
+    };
+    CompressionClassCounters compression_by_class[COMPRESSION_CLASS_COUNT];
+
+    // Receive-to-delivered time of each stream packet
+    LatencyHistogram processing_latency;
+};
+
+// Plain sum of every shard's counters at one moment
+struct StatisticsTotals {
+    u64 packets_sent = 0;
+    u64 bytes_sent = 0;
+    u64 packets_received = 0;
+    u64 bytes_received = 0;
+
+    u64 encryption_operations = 0;
+    u64 encryption_time_ns = 0;
+    u64 authentication_failures = 0;
+
+    u64 compression_operations = 0;
+    u64 compression_skipped = 0;
+    u64 compression_input_bytes = 0;
+    u64 compression_output_bytes = 0;
+
+    struct CompressionClassTotals {
+        u64 messages = 0;
+        u64 skipped = 0;
+        u64 lz4_messages = 0;
+        u64 zstd_messages = 0;
+        u64 input_bytes = 0;
+        u64 output_bytes = 0;
+        u64 time_ns = 0;
+    };
+    CompressionClassTotals compression_by_class[COMPRESSION_CLASS_COUNT];
+
+    void add(const ShardStatistics& shard);
+};
+
+// Cumulative bucket counts folded from every shard. The difference of two
+// snapshots gives the distribution over the interval between them.
+struct LatencySnapshot {
+    u64 buckets[LatencyHistogram::BUCKET_COUNT] = {};
+    u64 total = 0;
+
+    void add(const LatencyHistogram& histogram);
+    void subtract(const LatencySnapshot& earlier);
+
+    // quantile in [0, 1]; 0 when nothing was recorded
+    u64 percentile_ns(f64 quantile) const;
+    u64 mean_ns() const;
+};
+
+} // namespace S1U
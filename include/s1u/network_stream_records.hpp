@@ -0,0 +1,47 @@
+#pragma once
+
+#include "s1u/core.hpp"
+#include "s1u/network_packet_buffer.hpp"
+
+namespace S1U {
+
+// Stream connections carry a sequence of records, each behind its length
+// as a u32 LE, so AEAD records and compression frames reach the layers
+// above whole however the kernel split or merged the bytes in between.
+constexpr size_t STREAM_RECORD_PREFIX_SIZE = 4;
+
+enum class StreamRecordStatus : u32 {
+    Complete = 0,   // one whole record was taken
+    NeedMore = 1,   // the input ran out; the partial record is kept
+    Failed = 2      // a length out of range, or no memory for the record
+};
+
+void write_stream_record_prefix(u8* prefix, u32 record_size);
+
+// One connection's record in progress. A failed stream cannot be brought
+// back in step and must be closed.
+class StreamRecordAssembler {
+public:
+    // Takes bytes from the front of input, advancing it, until a record is
+    // complete or the input runs out. Each record is copied into a pooled
+    // buffer its own size.
+    StreamRecordStatus take(const u8*& input, size_t& remaining, u32 max_record_size,
+                            PacketBufferPool& pool, PacketBuffer& record);
+
+    // No record is partly received
+    bool is_idle() const { return prefix_bytes_ == 0; }
+    void reset();
+
+    // data is exactly one prefix and the record it announces, so the caller
+    // can keep the buffer it landed in rather than copy it
+    static bool is_single_record(const u8* data, size_t size, u32 max_record_size);
+
+private:
+    u8 prefix_[STREAM_RECORD_PREFIX_SIZE] = {};
+    u32 prefix_bytes_ = 0;
+    u32 record_size_ = 0;       // known once the prefix is complete
+    u32 record_bytes_ = 0;
+    PacketBuffer record_;
+};
+
+} // namespace S1U
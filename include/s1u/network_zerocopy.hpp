@@ -0,0 +1,100 @@
+#pragma once
+
+#include "s1u/core.hpp"
+#include "s1u/network_packet_buffer.hpp"
+#include "s1u/network_shard_counter.hpp"
+#include <sys/types.h>
+#include <deque>
+
+namespace S1U {
+
+// MSG_ZEROCOPY sends pin the caller's pages until the kernel reports, on the
+// socket's error queue, that it no longer needs them. The kernel numbers each
+// zero-copy send on a socket with a 32-bit counter and reports completions as
+// inclusive ranges of those numbers, so a socket's pinned payloads are kept
+// in send order and released from the front. A pinned payload is one more
+// reference to its pooled packet buffer, so nothing is copied to keep it.
+
+struct ZeroCopyStats {
+    u64 sends = 0;            // MSG_ZEROCOPY sends the kernel accepted
+    u64 completions = 0;      // of those, sends the kernel has released
+    u64 copied = 0;           // released sends the kernel copied after all
+    u64 copy_sends = 0;       // sends that went through the copy path
+    u64 notifications = 0;    // error queue messages read
+    u64 pending_bytes = 0;    // accepted payload bytes pinned right now
+};
+
+// Sets SO_ZEROCOPY. Fails on kernels or sockets without support, in which
+// case the socket should only ever take the copy path.
+bool enable_socket_zero_copy(int socket_fd);
+
+// One socket's pinned payloads, owned by its connection
+class ZeroCopySendQueue {
+public:
+    u32 pending_count() const { return static_cast<u32>(pending_.size()); }
+    u64 pending_bytes() const { return pending_bytes_; }
+
+private:
+    friend class ZeroCopySender;
+
+    struct PendingSend {
+        PacketBuffer payload;
+        bool completed = false;
+    };
+
+    std::deque<PendingSend> pending_;
+    u32 first_id_ = 0;          // kernel id of pending_.front(), or of the next send
+    u64 pending_bytes_ = 0;
+    u32 copy_sends_remaining_ = 0;
+};
+
+// Per-shard send path. Chooses zero-copy or copy for each payload and reads
+// completion notifications.
+class ZeroCopySender {
+public:
+    ZeroCopySender() = default;
+
+    ZeroCopySender(const ZeroCopySender&) = delete;
+    ZeroCopySender& operator=(const ZeroCopySender&) = delete;
+
+    // Payloads below min_size are copied: pinning pages and reading the
+    // notification costs more than the copy saves. A socket with more than
+    // max_pending_bytes pinned is copied to until completions catch up.
+    void initialize(u32 min_size, u64 max_pending_bytes);
+
+    // Sends payload from offset on, with the same result as send(2). When
+    // bytes go out zero-copy the queue keeps a reference to the window the
+    // kernel accepted until it releases the pages; a partial send resumes
+    // with a later call at the advanced offset.
+    ssize_t send(int socket_fd, ZeroCopySendQueue& queue, const PacketBuffer& payload, size_t offset = 0);
+
+    // Reads every notification queued on the socket and releases the
+    // payloads they complete. Called on EPOLLERR and when a queue fills up.
+    void drain_completions(int socket_fd, ZeroCopySendQueue& queue);
+
+    // The socket is closing and no more notifications will come. The kernel
+    // holds its own page references, so handing the buffers back can at
+    // worst change bytes still queued for the dead connection.
+    void discard(ZeroCopySendQueue& queue);
+
+    // Any thread may read; only the owning reactor sends
+    ZeroCopyStats get_stats() const;
+
+private:
+    u32 complete_range(ZeroCopySendQueue& queue, u32 first, u32 last);
+
+    u32 min_size_ = 16384;
+    u64 max_pending_bytes_ = 0;
+
+    struct Counters {
+        ShardCounter sends;
+        ShardCounter completions;
+        ShardCounter copied;
+        ShardCounter copy_sends;
+        ShardCounter notifications;
+        ShardCounter pending_bytes;
+    };
+    Counters stats_;
+};
+
+} // namespace S1U
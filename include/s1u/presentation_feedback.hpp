@@ -0,0 +1,123 @@
+#pragma once
+
+#include "s1u/core.hpp"
+#include "s1u/protocol_messages.hpp"
+
+namespace s1u {
+
+// Timing of one presented frame, as reported by the compositor
+struct PresentationTiming {
+    u64 present_time_ns = 0;      // CLOCK_MONOTONIC time the frame hit the screen
+    u64 refresh_interval_ns = 0;  // 0 if the output has no fixed refresh
+    u64 sequence = 0;             // monotonically increasing frame counter
+    u32 flags = PRESENTATION_NONE;
+};
+
+// A queued server -> client message
+struct PresentationEvent {
+    ClientId client_id = 0;
+    MessageType type = MessageType::FrameDone;
+    PresentationFeedbackPayload feedback;
+    FrameDonePayload frame_done;
+};
+
+// Outstanding requests one surface may hold, per kind
+constexpr u32 MAX_SURFACE_REQUESTS = 16;
+
+struct PresentationFeedbackStats {
+    u64 frames_presented = 0;
+    u64 feedback_presented = 0;
+    u64 feedback_discarded = 0;
+    u64 frame_callbacks_sent = 0;
+    u64 frame_callbacks_throttled = 0;
+    u64 requests_rejected = 0;
+};
+
+// Turns compositor frame completions into per-surface presentation feedback
+// and frame-done callbacks. Callbacks fire at most once per presented frame,
+// and only for visible surfaces; hidden surfaces are held back and released
+// at hidden_callback_interval_ns so clients stop rendering unseen frames
+// without stalling forever. Feedback follows the buffer committed after it
+// was requested: it waits on the frame that latches that buffer, or is
+// discarded if a newer commit replaces the buffer first. The compositor
+// reports frames from its own thread, so all entry points are serialized
+// internally.
+//
+// A surface belongs to the first client that asks about it. Requests on
+// another client's surface, beyond MAX_SURFACE_REQUESTS outstanding, or on
+// more than MAX_CLIENT_SURFACES surfaces are rejected; surfaces with nothing
+// outstanding are forgotten after the next presented frame.
+class PresentationFeedbackTracker {
+public:
+    PresentationFeedbackTracker() = default;
+    ~PresentationFeedbackTracker() = default;
+
+    bool request_frame_callback(ClientId client_id, u32 surface_id, u32 callback_id);
+    // A full queue reports its oldest request as discarded to make room
+    bool request_feedback(ClientId client_id, u32 surface_id, u32 feedback_id);
+
+    void set_surface_visible(u32 surface_id, bool visible);
+    void remove_surface(u32 surface_id);
+    void drop_client(ClientId client_id);
+
+    // The client committed buffer_id; feedback it requested since its last
+    // commit now follows that buffer
+    void on_surface_committed(ClientId client_id, u32 surface_id, u32 buffer_id);
+
+    // buffer_id was latched into the frame being composed. Feedback still
+    // waiting on an earlier, never-presented latch is reported as discarded.
+    void on_surface_latched(u32 surface_id, u32 buffer_id);
+
+    // buffer_id was replaced by a newer commit before it was ever latched;
+    // its feedback is reported as discarded
+    void on_frame_discarded(u32 surface_id, u32 buffer_id);
+
+    void on_frame_presented(const PresentationTiming& timing);
+
+    std::vector<PresentationEvent> take_events();
+    bool has_events() const;
+
+    void set_hidden_callback_interval(u64 interval_ns);
+    PresentationFeedbackStats get_statistics() const;
+
+private:
+    struct FeedbackRequest {
+        ClientId client_id = 0;
+        u32 feedback_id = 0;
+        u32 buffer_id = 0;
+        bool committed = false;
+    };
+
+    struct FrameCallback {
+        ClientId client_id = 0;
+        u32 callback_id = 0;
+    };
+
+    struct SurfaceState {
+        ClientId owner = 0;
+        bool visible = true;
+        u64 last_hidden_callback_ns = 0;
+        std::vector<FeedbackRequest> pending_feedback;
+        std::vector<FeedbackRequest> latched_feedback;
+        std::vector<FrameCallback> frame_callbacks;
+    };
+
+    SurfaceState* claim_surface(ClientId client_id, u32 surface_id);
+    void erase_surface(std::unordered_map<u32, SurfaceState>::iterator it);
+    // Moves the requests committed with buffer_id to the back, keeping their
+    // order, and returns the first of them
+    static std::vector<FeedbackRequest>::iterator partition_commit(std::vector<FeedbackRequest>& requests, u32 buffer_id);
+
+    void emit_feedback(u32 surface_id, const FeedbackRequest& request, const PresentationTiming& timing);
+    void emit_discarded(u32 surface_id, const FeedbackRequest& request);
+    void emit_frame_callbacks(u32 surface_id, SurfaceState& surface, u64 timestamp_ns);
+
+    mutable std::mutex mutex_;
+    std::unordered_map<u32, SurfaceState> surfaces_;
+    std::unordered_map<ClientId, u32> client_surface_counts_;
+    std::vector<PresentationEvent> events_;
+    u64 hidden_callback_interval_ns_ = 1000000000ULL;
+    PresentationFeedbackStats stats_;
+};
+
+} // namespace s1u
@@ -0,0 +1,134 @@
+#pragma once
+
+#include "s1u/core.hpp"
+#include "s1u/damage_region.hpp"
+#include "s1u/protocol_messages.hpp"
+#include <cstring>
+#include <type_traits>
+
+namespace s1u {
+
+template <MessageType Type>
+struct MessageTag {};
+
+// Per-type payload view, generated from S1U_MESSAGE_SCHEMA
+template <MessageType Type>
+struct MessageTraits;
+
+#define S1U_MESSAGE_TRAITS(message, id, view)                \
+    template <>                                             \
+    struct MessageTraits<MessageType::message> {            \
+        using View = view;                                  \
+        static constexpr const char* name = #message;       \
+    };
+S1U_MESSAGE_SCHEMA(S1U_MESSAGE_TRAITS)
+#undef S1U_MESSAGE_TRAITS
+
+inline const char* message_type_name(u32 type) {
+    switch (type) {
+#define S1U_MESSAGE_NAME(message, id, view) case id: return #message;
+        S1U_MESSAGE_SCHEMA(S1U_MESSAGE_NAME)
+#undef S1U_MESSAGE_NAME
+    default:
+        return "Unknown";
+    }
+}
+
+// Payload parsers, one per view kind
+inline bool parse_payload(const u8* data, u32 size, RawPayload& view) {
+    view.data = data;
+    view.size = size;
+    return true;
+}
+
+inline bool parse_payload(const u8* data, u32 size, BufferDamageView& view) {
+    return view.region.decode(data, size, view.surface_id);
+}
+
+template <typename View>
+    requires std::is_trivially_copyable_v<View>
+bool parse_payload(const u8* data, u32 size, View& view) {
+    if (size < sizeof(View)) return false;
+    std::memcpy(&view, data, sizeof(View));
+    return true;
+}
+
+// Who sent a message, plus any fds that arrived with it (SCM_RIGHTS). The
+// receive loop closes every fd a handler did not take once dispatch returns.
+// Only local clients, connected over the Unix socket, can exchange fds.
+struct MessageOrigin {
+    ClientId client_id = 0;
+    int* fds = nullptr;
+    u32 fd_count = 0;
+    bool local = false;
+
+    // Hands ownership of one fd to the handler; -1 if there is none
+    int take_fd(u32 index) const {
+        if (index >= fd_count || fds[index] < 0) return -1;
+        int fd = fds[index];
+        fds[index] = -1;
+        return fd;
+    }
+};
+
+enum class DispatchResult : u8 {
+    Handled,
+    Unhandled,   // unknown type, or no handler in this context
+    Malformed    // payload failed to parse; the handler was not called
+};
+
+// Dense, compile-time dispatch table indexed by wire type. Context handles a
+// message type by providing
+//
+//     void handle_message(MessageTag<MessageType::X>, const MessageOrigin&, const View&);
+//
+// for the View listed in the schema; types without a handler are rejected
+// without parsing. Handlers may be private if Context befriends
+// MessageDispatcher<Context>.
+template <typename Context>
+class MessageDispatcher {
+public:
+    static DispatchResult dispatch(Context& context, const MessageOrigin& origin, u32 type, const u8* data, u32 size) {
+        if (type >= MESSAGE_TYPE_LIMIT) return DispatchResult::Unhandled;
+        return table_[type](context, origin, data, size);
+    }
+
+    template <MessageType Type>
+    static constexpr bool handles() {
+        using View = typename MessageTraits<Type>::View;
+        return requires(Context& context, const View& view) {
+            context.handle_message(MessageTag<Type>{}, MessageOrigin{}, view);
+        };
+    }
+
+private:
+    using Entry = DispatchResult (*)(Context&, const MessageOrigin&, const u8*, u32);
+
+    template <MessageType Type>
+    static DispatchResult invoke(Context& context, const MessageOrigin& origin, const u8* data, u32 size) {
+        typename MessageTraits<Type>::View view;
+        if (!parse_payload(data, size, view)) return DispatchResult::Malformed;
+        context.handle_message(MessageTag<Type>{}, origin, view);
+        return DispatchResult::Handled;
+    }
+
+    static DispatchResult unhandled(Context&, const MessageOrigin&, const u8*, u32) {
+        return DispatchResult::Unhandled;
+    }
+
+    static constexpr std::array<Entry, MESSAGE_TYPE_LIMIT> build_table() {
+        std::array<Entry, MESSAGE_TYPE_LIMIT> table{};
+        table.fill(&unhandled);
+#define S1U_MESSAGE_ENTRY(message, id, view)                                 \
+        if constexpr (handles<MessageType::message>()) {                     \
+            table[id] = &invoke<MessageType::message>;                       \
+        }
+        S1U_MESSAGE_SCHEMA(S1U_MESSAGE_ENTRY)
+#undef S1U_MESSAGE_ENTRY
+        return table;
+    }
+
+    static constexpr std::array<Entry, MESSAGE_TYPE_LIMIT> table_ = build_table();
+};
+
+} // namespace s1u
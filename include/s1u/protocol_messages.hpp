@@ -0,0 +1,162 @@
+#pragma once
+
+#include "s1u/core.hpp"
+
+namespace s1u {
+
+using ClientId = u32;
+
+// Protocol message schema: name, wire id and the payload view handlers
+// receive (see protocol_dispatch.hpp). Wire ids are stable; append only.
+#define S1U_MESSAGE_SCHEMA(X)                                                  \
+    X(WindowCreate, 1, RawPayload)                                             \
+    X(WindowDestroy, 2, RawPayload)                                            \
+    X(WindowUpdate, 3, RawPayload)                                             \
+    X(BufferSubmit, 4, BufferSubmitPayload)                                    \
+    X(BufferDamage, 5, BufferDamageView)                                       \
+    X(InputEvent, 6, RawPayload)                                               \
+    X(QuantumSync, 7, RawPayload)                                              \
+    X(PredictiveCache, 8, RawPayload)                                          \
+    X(BufferRelease, 9, BufferReleasePayload)                                  \
+    X(ShmTransportRequest, 10, RawPayload)                                     \
+    X(ShmTransportSetup, 11, ShmTransportSetupPayload)                         \
+    X(FrameCallbackRequest, 12, SurfaceCallbackRequestPayload)                 \
+    X(PresentationFeedbackRequest, 13, SurfaceCallbackRequestPayload)          \
+    X(FrameDone, 14, FrameDonePayload)                                         \
+    X(PresentationFeedback, 15, PresentationFeedbackPayload)
+
+// Protocol message types
+enum class MessageType : u32 {
+#define S1U_MESSAGE_ENUM(name, id, view) name = id,
+    S1U_MESSAGE_SCHEMA(S1U_MESSAGE_ENUM)
+#undef S1U_MESSAGE_ENUM
+};
+
+// One past the highest wire id; sizes the dispatch table
+constexpr u32 MESSAGE_TYPE_LIMIT = [] {
+    u32 limit = 0;
+#define S1U_MESSAGE_LIMIT(name, id, view) limit = (id) + 1 > limit ? (id) + 1 : limit;
+    S1U_MESSAGE_SCHEMA(S1U_MESSAGE_LIMIT)
+#undef S1U_MESSAGE_LIMIT
+    return limit;
+}();
+
+// Payload view for messages without a fixed layout
+struct RawPayload {
+    const u8* data = nullptr;
+    u32 size = 0;
+};
+
+// Wire header preceding every protocol message payload
+struct MessageHeader {
+    u32 type = 0;
+    u32 payload_size = 0;
+    u32 sequence = 0;
+    u32 flags = 0;
+};
+
+static_assert(sizeof(MessageHeader) == 16, "MessageHeader is part of the wire format");
+
+constexpr u32 MAX_MESSAGE_PAYLOAD_SIZE = 1u << 20;
+constexpr u32 MAX_MESSAGE_FDS = 4;
+
+// Buffer submission flags
+enum BufferSubmitFlags : u32 {
+    BUFFER_SUBMIT_NONE = 0,
+    BUFFER_SUBMIT_HAS_ACQUIRE_FENCE = 1 << 0,  // acquire fence fd attached via SCM_RIGHTS
+    BUFFER_SUBMIT_WANTS_RELEASE_FENCE = 1 << 1 // client accepts a release fence instead of a plain release
+};
+
+// Buffer release flags
+enum BufferReleaseFlags : u32 {
+    BUFFER_RELEASE_NONE = 0,
+    BUFFER_RELEASE_HAS_FENCE = 1 << 0,   // release fence fd attached, reuse once it signals
+    BUFFER_RELEASE_SUPERSEDED = 1 << 1   // buffer was never latched, reuse immediately
+};
+
+// BufferSubmit payload. The acquire fence (eventfd or sync_file) travels as
+// ancillary data; the server never latches the buffer before it signals.
+struct BufferSubmitPayload {
+    u32 surface_id = 0;
+    u32 buffer_id = 0;
+    u64 acquire_point = 0;
+    u64 release_point = 0;
+    u32 flags = BUFFER_SUBMIT_NONE;
+    u32 reserved = 0;
+};
+
+// BufferRelease payload, sent server -> client
+struct BufferReleasePayload {
+    u32 surface_id = 0;
+    u32 buffer_id = 0;
+    u64 release_point = 0;
+    u32 flags = BUFFER_RELEASE_NONE;
+    u32 reserved = 0;
+};
+
+// ShmTransportSetup payload, sent server -> client together with the ring
+// memfd and the client->server / server->client doorbell eventfds
+struct ShmTransportSetupPayload {
+    u32 ring_capacity = 0;
+    u32 version = 0;
+};
+
+// BufferDamage payload header. It is followed by band_count bands, each
+// encoded as LEB128 varints: the gap from the previous band's bottom edge
+// (zigzag for the first band), the band height, the rectangle count, then
+// per rectangle the gap from the previous rectangle's right edge (zigzag
+// for the first one) and its width. Rectangles within a band never touch,
+// so every gap after the first is at least one pixel.
+struct BufferDamageHeader {
+    u32 surface_id = 0;
+    u32 band_count = 0;
+};
+
+constexpr u32 MAX_DAMAGE_RECTS = 1024;
+
+// Surfaces one client may hold per-surface server state on (damage,
+// feedback requests)
+constexpr u32 MAX_CLIENT_SURFACES = 256;
+
+// FrameCallbackRequest / PresentationFeedbackRequest payload: asks for a
+// callback tied to the surface's next commit
+struct SurfaceCallbackRequestPayload {
+    u32 surface_id = 0;
+    u32 callback_id = 0;
+};
+
+// FrameDone payload: a good time for the client to start its next frame
+struct FrameDonePayload {
+    u32 surface_id = 0;
+    u32 callback_id = 0;
+    u64 timestamp_ns = 0;
+};
+
+// Presentation feedback flags
+enum PresentationFlags : u32 {
+    PRESENTATION_NONE = 0,
+    PRESENTATION_VSYNC = 1 << 0,          // presentation was synchronized to vblank
+    PRESENTATION_HW_CLOCK = 1 << 1,       // timestamp comes from the display hardware
+    PRESENTATION_HW_COMPLETION = 1 << 2,  // completion was signaled by hardware
+    PRESENTATION_ZERO_COPY = 1 << 3,      // client buffer was scanned out directly
+    PRESENTATION_DISCARDED = 1 << 4       // content never reached the screen
+};
+
+// PresentationFeedback payload
+struct PresentationFeedbackPayload {
+    u32 surface_id = 0;
+    u32 feedback_id = 0;
+    u64 present_time_ns = 0;
+    u64 refresh_interval_ns = 0;
+    u64 sequence = 0;
+    u32 flags = PRESENTATION_NONE;
+    u32 reserved = 0;
+};
+
+static_assert(sizeof(BufferSubmitPayload) == 32, "BufferSubmitPayload is part of the wire format");
+static_assert(sizeof(BufferReleasePayload) == 24, "BufferReleasePayload is part of the wire format");
+static_assert(sizeof(BufferDamageHeader) == 8, "BufferDamageHeader is part of the wire format");
+static_assert(sizeof(FrameDonePayload) == 16, "FrameDonePayload is part of the wire format");
+static_assert(sizeof(PresentationFeedbackPayload) == 40, "PresentationFeedbackPayload is part of the wire format");
+
+} // namespace s1u
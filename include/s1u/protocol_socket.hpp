@@ -0,0 +1,66 @@
+#pragma once
+
+#include "s1u/core.hpp"
+#include "s1u/protocol_messages.hpp"
+#include <deque>
+
+namespace s1u {
+
+// A decoded message together with any file descriptors that arrived with it
+struct ReceivedMessage {
+    MessageHeader header;
+    std::vector<u8> payload;
+    std::array<int, MAX_MESSAGE_FDS> fds{{-1, -1, -1, -1}};
+    u32 fd_count = 0;
+};
+
+// Sends header + payload on a Unix socket, attaching fds as SCM_RIGHTS.
+bool send_message_with_fds(int socket_fd, MessageType type, u32 sequence,
+                           const void* payload, u32 payload_size,
+                           const int* fds = nullptr, u32 fd_count = 0);
+
+// Receives one complete message, blocking until all of it is in. Returns
+// false on EOF, error or a malformed header; received fds are owned by the
+// caller.
+bool receive_message_with_fds(int socket_fd, ReceivedMessage& message);
+
+void close_received_fds(ReceivedMessage& message);
+
+// Per-client reassembly for servers that poll many sockets. Each read takes
+// only what the socket already holds, so a client that stops mid-message
+// never blocks the reader. Fds arrive with the read that carries the first
+// byte of their message and are handed out with that message.
+class MessageReceiveBuffer {
+public:
+    MessageReceiveBuffer() = default;
+    ~MessageReceiveBuffer();
+
+    MessageReceiveBuffer(const MessageReceiveBuffer&) = delete;
+    MessageReceiveBuffer& operator=(const MessageReceiveBuffer&) = delete;
+
+    // One non-blocking read. Returns false on EOF or a socket error.
+    bool read_available(int socket_fd);
+
+    // Pops the next complete message; its fds are owned by the caller
+    bool next_message(ReceivedMessage& message);
+
+    // A header announced a payload over MAX_MESSAGE_PAYLOAD_SIZE
+    bool is_broken() const { return broken_; }
+
+private:
+    struct PendingFds {
+        u64 first_byte = 0;  // stream offsets of the read the fds came with
+        u64 end_byte = 0;
+        std::array<int, MAX_MESSAGE_FDS> fds{{-1, -1, -1, -1}};
+        u32 fd_count = 0;
+    };
+
+    std::vector<u8> data_;
+    size_t begin_ = 0;       // first unparsed byte
+    size_t end_ = 0;         // end of the received bytes
+    u64 stream_offset_ = 0;  // stream offset of data_[0]
+    std::deque<PendingFds> pending_fds_;
+    bool broken_ = false;
+};
+
+} // namespace s1u
@@ -11,6 +11,9 @@
 
 namespace S1U {
 
+struct AllocationRecord;
+class ThreadAllocationCache;
+
 struct MemoryConfig {
     bool enable_quantum_effects = true;
     bool enable_numa_optimization = true;
@@ -36,6 +39,7 @@ struct MemoryConfig {
     u32 compaction_interval_seconds = 5;
     u32 numa_balancing_interval_seconds = 10;
     u32 prefetch_distance = 8;
+    u32 fake_numa_node_count = 0; // pools act as if CPUs were spread over this many nodes; no binding
 };
 
 enum MemoryFlags : u32 {
@@ -171,6 +175,7 @@ struct MemoryPattern {
     f64 spatial_locality = 0.0;
     Vector<u64> access_timestamps;
     bool is_predictable = false;
+    bool is_hot = false;
     f32 prediction_confidence = 0.0f;
 };
 
@@ -187,6 +192,8 @@ struct HotSpot {
 };
 
 struct MemoryPoolStatistics {
+    size_t block_size = 0;
+    u64 slab_count = 0;
     size_t total_size = 0;
     size_t allocated_size = 0;
     size_t free_size = 0;
@@ -199,6 +206,17 @@ struct MemoryPoolStatistics {
     f64 deallocation_rate = 0.0;
 };
 
+struct NUMANodeStatistics {
+    u32 node_id = 0;
+    size_t reserved_size = 0;
+    size_t bound_size = 0;
+    size_t slab_size = 0;
+    u64 local_allocations = 0;
+    u64 remote_allocations = 0;
+    u64 remote_frees = 0;
+    f64 hit_rate = 0.0;
+};
+
 struct MemorySystemStatistics {
     size_t total_system_memory = 0;
     size_t available_memory = 0;
@@ -213,28 +231,35 @@ struct MemorySystemStatistics {
 };
 
 struct MemoryStatistics {
-    std::atomic<size_t> total_allocated{0};
-    std::atomic<size_t> total_freed{0};
-    std::atomic<size_t> peak_usage{0};
-    std::atomic<size_t> current_usage{0};
-    std::atomic<u64> allocation_count{0};
-    std::atomic<u64> deallocation_count{0};
-    std::atomic<f64> fragmentation_ratio{0.0};
-    std::atomic<f64> cache_hit_rate{0.0};
-    std::atomic<u64> page_fault_count{0};
-    std::atomic<f32> quantum_coherence_ratio{0.0};
-    std::atomic<f64> numa_efficiency{0.0};
-    std::atomic<f64> compression_ratio{0.0};
-    std::atomic<f64> access_locality_score{0.0};
-    std::atomic<f64> memory_bandwidth_utilization{0.0};
-    std::atomic<u64> quantum_entanglements{0};
-    std::atomic<u64> quantum_measurements{0};
-    std::atomic<f64> average_allocation_time{0.0};
-    std::atomic<f64> average_deallocation_time{0.0};
-    std::atomic<u32> active_pools{0};
-    std::atomic<u32> numa_nodes{0};
-    std::atomic<u64> cache_line_splits{0};
-    std::atomic<u64> false_sharing_events{0};
+    size_t total_allocated = 0;
+    size_t total_freed = 0;
+    size_t peak_usage = 0;
+    size_t current_usage = 0;
+    u64 allocation_count = 0;
+    u64 deallocation_count = 0;
+    f64 fragmentation_ratio = 0.0;
+    f64 cache_hit_rate = 0.0;
+    u64 page_fault_count = 0;
+    f32 quantum_coherence_ratio = 0.0f;
+    f64 numa_efficiency = 0.0;
+    f64 compression_ratio = 0.0;
+    f64 access_locality_score = 0.0;
+    f64 memory_bandwidth_utilization = 0.0;
+    u64 quantum_entanglements = 0;
+    u64 quantum_measurements = 0;
+    f64 average_allocation_time = 0.0;
+    f64 average_deallocation_time = 0.0;
+    u32 active_pools = 0;
+    u32 numa_nodes = 0;
+    u64 cache_line_splits = 0;
+    u64 false_sharing_events = 0;
+    u64 thread_cache_hits = 0;
+    u64 thread_cache_misses = 0;
+    f64 thread_cache_hit_rate = 0.0;
+    u64 thread_cache_refills = 0;
+    u64 thread_cache_flushes = 0;
+    size_t thread_cached_bytes = 0;
+    u64 cross_thread_frees = 0;
 };
 
 class QuantumMemoryManager {
@@ -304,6 +329,7 @@ public:
     
     MemoryStatistics get_memory_statistics() const;
     Vector<MemoryPoolStatistics> get_pool_statistics() const;
+    Vector<NUMANodeStatistics> get_numa_node_statistics() const;
     MemorySystemStatistics get_system_statistics() const;
     void reset_statistics();
     
@@ -353,6 +379,11 @@ private:
     
     void* allocate_from_pool(size_t size, size_t alignment);
     void deallocate_from_pool(void* ptr, size_t size);
+    void* allocate_from_thread_cache(u32 size_class);
+    bool deallocate_to_thread_cache(ThreadAllocationCache* cache, void* ptr, u32 size_class);
+    void* allocate_direct(size_t size, size_t alignment, MemoryFlags flags);
+    void deallocate_direct(void* ptr);
+    AllocationRecord* find_allocation_record(void* ptr);
     
     size_t align_size(size_t size, size_t alignment);
     u32 get_current_numa_node();
@@ -360,7 +391,6 @@ private:
     void record_allocation(void* ptr, size_t size, MemoryFlags flags);
     
     void perform_memory_compaction();
-    void compact_memory_pool(MemoryPool& pool);
     void update_fragmentation_metrics();
     void perform_emergency_cleanup();
     
@@ -372,7 +402,6 @@ private:
     void apply_intelligent_prefetching();
     void update_hotspot_detection();
     
-    void balance_numa_allocation();
     void migrate_hot_pages();
     u32 find_optimal_numa_node();
     void update_numa_statistics();
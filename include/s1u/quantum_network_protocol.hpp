@@ -1,22 +1,30 @@
 #pragma once
 
 #include "s1u/core.hpp"
+#include "s1u/network_packet_buffer.hpp"
 #include <memory>
 #include <atomic>
 #include <thread>
 #include <functional>
+#include <map>
 
 struct ibv_context;
 struct ibv_pd;
 struct ibv_cq_ex;
 struct ibv_qp;
 struct ibv_mr;
-struct EVP_CIPHER_CTX;
 struct ZSTD_CCtx_s;
 struct ZSTD_DCtx_s;
 
 namespace S1U {
 
+struct ConnectionHotState;
+struct ConnectionColdState;
+struct ReactorShard;
+class CompressionSession;
+struct AeadSession;
+struct StatisticsTotals;
+
 struct NetworkConfig {
     bool enable_zero_copy = true;
     bool enable_rdma = true;
@@ -30,8 +38,15 @@ struct NetworkConfig {
     bool enable_encryption = true;
     bool enable_tcp_nodelay = true;
     bool enable_tcp_quickack = true;
+    bool enable_datagram_transport = false;
+    bool pin_reactor_threads = true;
     
     u32 port = 8080;
+    u32 datagram_port = 8081;
+    u32 packets_per_syscall = 32;
+    u32 max_datagram_size = 2048;
+    u32 reactor_shards = 0; // 0 = one per available CPU
+    u32 reactor_mailbox_size = 4096;
     u32 max_connections = 10000;
     u32 socket_buffer_size = 2097152; // 2MB
     u32 packet_buffer_size = 100000;
@@ -39,20 +54,34 @@ struct NetworkConfig {
     u32 compression_buffer_size = 1048576; // 1MB
     u32 encryption_buffer_size = 1048576; // 1MB
     u32 burst_buffer_size = 65536; // 64KB
+    u32 zero_copy_min_size = 16384; // smaller stream sends are copied
+    u32 zero_copy_max_pending = 16777216; // 16MB pinned per connection
+    u32 receive_copy_break = 1024; // smaller stream reads move to a right-sized buffer
+    u32 max_stream_record_size = 1048576; // 1MB; larger stream records are refused on both ends
     
     u32 quantum_channel_count = 32;
     u32 compression_level = 9;
+    u32 min_compression_level = 1;
+    u32 max_compression_level = 19;
+    u32 lz4_acceleration = 1;
+    u32 compression_window_log = 17; // 128KB of history per connection
+    u32 dictionary_sample_count = 2000;
+    u32 dictionary_message_size = 1024; // messages up to this size train the dictionary
+    u32 dictionary_size = 65536;
     u32 initial_congestion_window = 10;
     u32 max_congestion_window = 1000;
     u32 slow_start_threshold = 100;
+    u32 max_paced_packets = 1024; // per connection, before the send queue backs up
+    u32 statistics_interval_ms = 1000;
     
     f64 max_bandwidth_mbps = 100000.0; // 100 Gbps
     f64 target_latency_ms = 0.1;
     f64 max_jitter_ms = 0.01;
     f64 quantum_decoherence_rate = 0.001;
+    f32 incompressible_entropy_bits = 7.5f;
     
     String interface_name = "eth0";
-    String encryption_algorithm = "AES-256-CBC";
+    String encryption_algorithm = "auto"; // AES-256-GCM, ChaCha20-Poly1305 or auto
     String compression_algorithm = "ZSTD";
 };
 
@@ -82,6 +111,32 @@ enum class CompressionType : u32 {
     Quantum = 5
 };
 
+// With compression enabled, every message starts with one byte naming the
+// CompressionType it was compressed with, None included, inside the AEAD
+// record when there is one
+constexpr size_t COMPRESSION_TAG_SIZE = 1;
+
+// Latency tiers for compression decisions, derived from the QoS class
+enum class CompressionClass : u32 {
+    RealTime = 0,     // input, cursor
+    Interactive = 1,  // small damage tiles, surface updates
+    BestEffort = 2,   // bulk transfers
+    Count = 3
+};
+
+constexpr u32 COMPRESSION_CLASS_COUNT = static_cast<u32>(CompressionClass::Count);
+
+// Algorithm per link speed for one class. On fast links compression time is
+// the bottleneck; on slow links the bytes on the wire cost more.
+struct CompressionTierPolicy {
+    CompressionType fast_link = CompressionType::None;
+    CompressionType normal_link = CompressionType::LZ4;
+    CompressionType slow_link = CompressionType::ZSTD;
+    f64 fast_link_mbps = 1000.0;
+    f64 slow_link_mbps = 50.0;
+    u32 min_size = 64;
+};
+
 enum class EncryptionType : u32 {
     None = 0,
     AES128 = 1,
@@ -141,14 +196,21 @@ struct QuantumChannel {
 };
 
 struct DataPacket {
-    Vector<u8> data;
+    PacketBuffer data;    // pooled; copies of the packet share the payload
     int source_socket = -1;
+    u32 source_generation = 0;
+    bool is_datagram = false;
+    u32 remote_ipv4 = 0;   // network byte order, datagram packets only
+    u16 remote_port = 0;
     u64 timestamp = 0;
     u32 size = 0;
+    u32 bytes_sent = 0;    // stream bytes the kernel took; a partial send resumes here
     u32 sequence_number = 0;
     u32 acknowledgment_number = 0;
     bool is_compressed = false;
     bool is_encrypted = false;
+    bool is_compression_tagged = false; // compression byte already in front
+    bool is_framed = false;    // stream record length already in front
     bool is_retransmission = false;
     bool is_fragmented = false;
     u32 priority = 0;
@@ -156,9 +218,18 @@ struct DataPacket {
     u32 checksum = 0;
     bool is_valid = true;
     String qos_class = "BestEffort";
+    CompressionType compression = CompressionType::None;
     f64 transmission_time_ms = 0.0;
 };
 
+// Outcome of one attempt to send a queued packet. A packet that can never
+// go out is dropped so it does not hold up the packets queued behind it.
+enum class SendResult : u32 {
+    Sent = 0,
+    Retry = 1,      // socket full or partial send; try again when it drains
+    Dropped = 2     // connection gone or reused, socket failed, or sealing failed
+};
+
 struct CompressionEngine {
     struct ZSTD_CCtx_s* compression_ctx = nullptr;
     struct ZSTD_DCtx_s* decompression_ctx = nullptr;
@@ -172,19 +243,6 @@ struct CompressionEngine {
     Vector<u8> dictionary;
 };
 
-struct EncryptionContext {
-    struct EVP_CIPHER_CTX* cipher_ctx = nullptr;
-    Vector<u8> key;
-    Vector<u8> iv;
-    Vector<u8> input_buffer;
-    Vector<u8> output_buffer;
-    std::atomic<bool> is_busy{false};
-    f32 encryption_time_ms = 0.0f;
-    EncryptionType algorithm = EncryptionType::AES256;
-    u32 key_size = 32;
-    u32 block_size = 16;
-};
-
 struct NeuralNetwork {
     u32 layer_count = 3;
     u32 neurons_per_layer = 128;
@@ -376,28 +434,66 @@ struct RedundancyScheme {
     u32 failover_count = 0;
 };
 
+struct CompressionClassStats {
+    u64 messages = 0;
+    u64 skipped = 0;
+    u64 lz4_messages = 0;
+    u64 zstd_messages = 0;
+    u64 input_bytes = 0;
+    u64 output_bytes = 0;
+    f64 compression_ratio = 1.0;
+    f64 average_time_us = 0.0;
+};
+
+// Snapshot returned by get_performance_stats()
 struct NetworkProtocolStats {
-    std::atomic<u64> packets_sent{0};
-    std::atomic<u64> packets_received{0};
-    std::atomic<u64> bytes_sent{0};
-    std::atomic<u64> bytes_received{0};
-    std::atomic<u32> active_connections{0};
-    std::atomic<u32> peak_connections{0};
-    std::atomic<f64> throughput_mbps{0.0};
-    std::atomic<f64> latency_ms{0.0};
-    std::atomic<f64> packet_loss_rate{0.0};
-    std::atomic<f64> compression_ratio{1.0};
-    std::atomic<f64> quantum_coherence{1.0};
-    std::atomic<u64> quantum_entanglements{0};
-    std::atomic<f64> bandwidth_utilization{0.0};
-    std::atomic<f64> round_trip_time_ms{0.0};
-    std::atomic<f64> jitter_ms{0.0};
-    std::atomic<u32> retransmissions{0};
-    std::atomic<u64> encryption_operations{0};
-    std::atomic<u64> compression_operations{0};
-    std::atomic<f64> neural_processing_time_ms{0.0};
-    std::atomic<u64> rdma_operations{0};
-    std::atomic<u64> zero_copy_transfers{0};
+    u64 packets_sent = 0;
+    u64 packets_received = 0;
+    u64 bytes_sent = 0;
+    u64 bytes_received = 0;
+    u32 active_connections = 0;
+    u32 peak_connections = 0;
+    f64 throughput_mbps = 0.0;
+    f64 latency_ms = 0.0; // mean over the last statistics interval
+    f64 latency_p50_ms = 0.0;
+    f64 latency_p99_ms = 0.0;
+    f64 latency_p999_ms = 0.0;
+    f64 packet_loss_rate = 0.0;
+    f64 compression_ratio = 1.0;
+    f64 quantum_coherence = 1.0;
+    u64 quantum_entanglements = 0;
+    f64 bandwidth_utilization = 0.0;
+    f64 round_trip_time_ms = 0.0;
+    f64 queuing_delay_ms = 0.0;
+    f64 pacing_rate_mbps = 0.0; // mean over paced connections
+    u64 paced_deferrals = 0;
+    f64 jitter_ms = 0.0;
+    u32 retransmissions = 0;
+    u64 encryption_operations = 0;
+    u64 authentication_failures = 0;
+    f64 encryption_time_us = 0.0;
+    u64 compression_operations = 0;
+    u64 compression_skipped = 0;
+    u32 compression_level = 0;
+    u32 compression_dictionary_id = 0;
+    CompressionClassStats compression_by_class[COMPRESSION_CLASS_COUNT];
+    f64 neural_processing_time_ms = 0.0;
+    u64 rdma_operations = 0;
+    u64 zero_copy_transfers = 0;
+    u64 zero_copy_completions = 0;
+    u64 zero_copy_copied = 0; // completed, but the kernel copied anyway
+    u64 zero_copy_copy_sends = 0;
+    u64 zero_copy_pending_bytes = 0;
+    u64 packet_buffer_slabs = 0;
+    u64 packet_buffer_reserved_bytes = 0;
+    u64 packet_buffer_huge_page_bytes = 0;
+    u64 packet_buffers_in_use = 0;
+    u64 packet_buffer_remote_frees = 0;
+    u64 packet_buffer_allocation_failures = 0;
+    u64 receive_syscalls = 0;
+    u64 send_syscalls = 0;
+    f64 receive_syscalls_per_packet = 0.0;
+    f64 send_syscalls_per_packet = 0.0;
 };
 
 class QuantumNetworkProtocol {
@@ -424,7 +520,18 @@ public:
     void enable_congestion_control(bool enabled);
     
     void set_compression_level(u32 level);
+    bool load_compression_dictionary(const Vector<u8>& dictionary);
+    // Call before initialize(); the reactors read the policies unlocked
+    void set_compression_tier_policy(CompressionClass compression_class, const CompressionTierPolicy& policy);
+    // The trained dictionary while it awaits acknowledgement, else the
+    // one in use. The peer loads it with load_compression_dictionary();
+    // once it confirms, pass its id here to start compressing with it.
+    Vector<u8> export_compression_dictionary() const;
+    bool acknowledge_compression_dictionary(u32 dictionary_id);
+    u32 get_pending_compression_dictionary_id() const;
     void set_encryption_algorithm(const String& algorithm);
+    // 32-byte key shared with the peer out of band; call before initialize()
+    bool set_encryption_key(const Vector<u8>& key);
     void set_quantum_decoherence_rate(f64 rate);
     void set_target_latency(f64 latency_ms);
     void set_target_throughput(f64 throughput_mbps);
@@ -509,47 +616,62 @@ private:
     
     void start_processing_threads();
     void stop_processing_threads();
-    void network_processing_loop();
+    void network_processing_loop(ReactorShard& shard);
     void quantum_processing_loop();
     void compression_processing_loop();
     void encryption_processing_loop();
     void optimization_processing_loop();
     
-    void accept_new_connections();
-    void handle_client_data(int client_socket);
-    void process_incoming_packet(DataPacket& packet);
-    void decrypt_packet(DataPacket& packet);
-    void decompress_packet(DataPacket& packet);
+    bool initialize_reactor_shard(ReactorShard& shard);
+    void prepare_shard_buffers(ReactorShard& shard);
+    void accept_new_connections(ReactorShard& shard);
+    void handle_client_data(ReactorShard& shard, int client_socket);
+    void retry_starved_receives(ReactorShard& shard);
+    void deliver_stream_record(ReactorShard& shard, ConnectionHotState& conn, int client_socket, DataPacket& packet);
+    bool initialize_datagram_socket(ReactorShard& shard);
+    void handle_datagram_data(ReactorShard& shard);
+    bool flush_datagram_packets(ReactorShard& shard);
+    void drain_shard_mailbox(ReactorShard& shard);
+    bool route_outgoing_packet(ReactorShard& shard, DataPacket& packet);
+    void process_incoming_packet(ReactorShard& shard, DataPacket& packet);
+    bool decrypt_packet(ReactorShard& shard, DataPacket& packet);
+    bool read_compression_tag(DataPacket& packet);
+    bool decompress_packet(ReactorShard& shard, DataPacket& packet);
+    bool decompress_stream_packet(ReactorShard& shard, CompressionSession& session, const u8* input, size_t input_size,
+                                  size_t max_output, PacketBuffer& output, size_t& output_size);
     void apply_quantum_decoherence(DataPacket& packet);
     void apply_error_correction(DataPacket& packet);
     void apply_hamming_code_correction(DataPacket& packet, const ErrorCorrection& ecc);
     u32 correct_single_bit_error(u32 data);
     void validate_packet_integrity(DataPacket& packet);
-    u32 calculate_crc32(const Vector<u8>& data);
-    
-    void process_outgoing_packets();
-    bool send_packet(DataPacket& packet);
-    void compress_packet(DataPacket& packet);
-    void apply_neural_compression(CompressionEngine* engine);
+    u32 calculate_crc32(const u8* data, size_t size);
+    
+    void process_outgoing_packets(ReactorShard& shard);
+    bool defer_paced_packet(ReactorShard& shard, ConnectionColdState& info, DataPacket& packet);
+    void send_paced_packets(ReactorShard& shard, u64 now_ns);
+    void update_connection_pacing(ConnectionColdState& info, int client_socket, u64 now_ns);
+    SendResult send_packet(ReactorShard& shard, DataPacket& packet);
+    void compress_packet(ReactorShard& shard, DataPacket& packet, ConnectionColdState* connection);
+    bool tag_compression(ReactorShard& shard, DataPacket& packet);
+    CompressionSession* get_compression_session(ReactorShard& shard, ConnectionColdState* connection);
     Vector<f32> forward_pass_neural_network(const NeuralNetwork& network, const Vector<f32>& input);
-    void encrypt_packet(DataPacket& packet);
-    void apply_quantum_key_enhancement(EncryptionContext* context);
-    void rotate_quantum_key();
-    
-    bool send_packet_zero_copy(const DataPacket& packet);
-    bool send_packet_rdma(const DataPacket& packet);
-    bool send_packet_sendfile(const DataPacket& packet);
-    bool send_packet_traditional(const DataPacket& packet);
-    
-    CompressionEngine* find_available_compression_engine();
-    EncryptionContext* find_available_encryption_context();
-    
-    void close_connection(int client_socket);
+    bool encrypt_packet(ReactorShard& shard, DataPacket& packet, ConnectionColdState* connection);
+    bool frame_stream_record(ReactorShard& shard, DataPacket& packet);
+    
+    SendResult send_packet_zero_copy(ReactorShard& shard, DataPacket& packet);
+    bool send_packet_rdma(ReactorShard& shard, const DataPacket& packet);
+    void drain_zero_copy_completions(ReactorShard& shard, int client_socket);
+    SendResult send_packet_traditional(ReactorShard& shard, DataPacket& packet);
+    SendResult advance_stream_send(ReactorShard& shard, DataPacket& packet, ssize_t bytes_sent);
+    
+    void close_connection(ReactorShard& shard, int client_socket);
+    void publish_shard_statistics(ReactorShard& shard);
+    void statistics_processing_loop();
+    StatisticsTotals collect_statistics() const;
     void update_network_statistics();
     void update_bandwidth_utilization();
     void update_latency_statistics();
     void update_quantum_coherence_metrics();
-    void update_latency_metrics(f64 processing_time_ms);
     
     void update_quantum_entanglement();
     void maintain_quantum_coherence();
@@ -560,10 +682,9 @@ private:
     
     void update_compression_statistics();
     void optimize_compression_parameters();
+    void train_compression_dictionary();
     void train_neural_compressor();
     
-    void update_encryption_keys();
-    void monitor_encryption_performance();
     void detect_security_threats();
     
     void optimize_network_parameters();
@@ -575,7 +696,7 @@ private:
     void enable_multipath_routing();
     void enforce_qos_policies();
     void apply_qos_policy(const QoSPolicy& policy);
-    void allocate_bandwidth(NetworkConnection& conn, f64 bandwidth_mbps);
+    void allocate_bandwidth(ConnectionHotState& conn, ConnectionColdState& info, f64 bandwidth_mbps);
     
     void cleanup_networking();
     void cleanup_rdma();
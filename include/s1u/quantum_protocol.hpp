@@ -1,33 +1,285 @@
 #pragma once
 
-#include <vector>
-#include <string>
+#include "s1u/core.hpp"
+#include "s1u/protocol_dispatch.hpp"
+#include "s1u/protocol_messages.hpp"
+#include "s1u/protocol_socket.hpp"
+#include <atomic>
 #include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+struct rdma_cm_id;
 
 namespace s1u {
 
+class BufferSyncTracker;
+class PresentationFeedbackTracker;
+class SurfaceDamageTracker;
+class ShmChannel;
+class NeuralCompressor;
+class QuantumCoherenceSystem;
+class StreamingPredictionEngine;
+
+struct ProtocolConfig {
+    bool enable_rdma = true;
+    bool enable_quantum_entanglement = true;
+    bool enable_neural_compression = true;
+    bool enable_predictive_streaming = true;
+    bool enable_shm_transport = true;
+
+    u16 port = 7400;
+    // Unix socket for local clients, the only transport that carries fences
+    // and shared-memory fds. Empty: $XDG_RUNTIME_DIR/s1u-0, or /tmp/s1u-0.
+    std::string local_socket_path;
+    u32 max_damage_rects = 64;          // per surface, once the compositor takes its damage
+    u32 shm_ring_capacity = 1u << 20;   // per direction; a power of two of at least 4 KB
+};
+
+// A message as handed to send_message. The payload is borrowed for the
+// duration of the call.
+struct Message {
+    ClientId client_id = 0;
+    MessageType type = MessageType::WindowUpdate;
+    u64 timestamp = 0;
+    const u8* data = nullptr;
+    u32 size = 0;
+};
+
+// The same message after the optional compression and entanglement stages.
+// data either borrows the caller's payload or points into storage.
+struct CompressedMessage {
+    MessageType type = MessageType::WindowUpdate;
+    u64 timestamp = 0;
+    const u8* data = nullptr;
+    u32 size = 0;
+    bool compressed = false;
+    std::vector<u8> storage;
+};
+
+struct ClientInfo {
+    int socket_fd = -1;
+    bool local = false;     // connected over the Unix socket
+    bool supports_rdma = false;
+    bool supports_quantum = false;
+    bool supports_zero_copy = false;
+};
+
+struct ProtocolStats {
+    u64 messages_sent = 0;
+    u64 messages_received = 0;
+    u64 bytes_sent = 0;
+    u64 bytes_received = 0;
+    u64 send_failures = 0;
+    u64 clients_accepted = 0;
+    u64 clients_rejected = 0;
+    u32 active_clients = 0;
+    f64 average_send_time_ns = 0.0;
+    f64 average_receive_time_ns = 0.0;
+};
+
+// Client-facing protocol server. One protocol thread accepts clients, reads
+// their sockets and shared-memory rings and dispatches every message through
+// MessageDispatcher; the buffer-sync, presentation-feedback and damage
+// trackers it fills are shared with the compositor.
 class QuantumProtocol {
 public:
-    QuantumProtocol() = default;
-    ~QuantumProtocol() = default;
+    QuantumProtocol();
+    ~QuantumProtocol();
+
+    QuantumProtocol(const QuantumProtocol&) = delete;
+    QuantumProtocol& operator=(const QuantumProtocol&) = delete;
 
-    bool initialize() {
-        return true;
-    }
+    bool initialize(const ProtocolConfig& config);
+    void shutdown();
 
-    void shutdown() {}
+    bool send_message(ClientId client_id, const Message& message);
+    bool receive_message(ClientId client_id, Message& message);
+    bool broadcast_message(const Message& message);
 
-    bool send_message(const std::string& message) {
-        return true;
-    }
+    // Takes ownership of info.socket_fd
+    void add_client(ClientId client_id, const ClientInfo& info);
+    void remove_client(ClientId client_id);
 
-    std::string receive_message() {
-        return "";
-    }
+    ProtocolStats get_statistics() const;
+
+    void optimize_for_latency();
+    void optimize_for_bandwidth();
+
+    std::shared_ptr<BufferSyncTracker> get_buffer_sync() const;
+    std::shared_ptr<PresentationFeedbackTracker> get_presentation_feedback() const;
+    std::shared_ptr<SurfaceDamageTracker> get_surface_damage() const;
 
 private:
-};
+    friend class MessageDispatcher<QuantumProtocol>;
 
-} // namespace s1u
+    // Setup and teardown
+    bool initialize_socket();
+    bool initialize_local_socket();
+    bool initialize_io_uring();
+    bool initialize_memory_pool();
+    bool initialize_rdma();
+    bool initialize_quantum_entanglement();
+    bool initialize_neural_compression();
+    bool initialize_predictive_streaming();
+    void initialize_buffer_management();
+    void initialize_quantum_pairs();
+    void initialize_client_quantum_state(ClientId client_id);
+    void initialize_client_prediction_model(ClientId client_id);
+    void setup_rdma_connection(ClientId client_id, const ClientInfo& info);
+
+    void cleanup_socket();
+    void cleanup_io_uring();
+    void cleanup_memory_pool();
+    void cleanup_rdma();
+    void cleanup_quantum_entanglement();
+    void cleanup_neural_compression();
+    void cleanup_predictive_streaming();
+    void cleanup_client_resources(ClientId client_id);
 
+    void start_protocol_threads();
+    void stop_protocol_threads();
 
+    // Threads
+    void protocol_main_loop();
+    void rdma_handling_loop();
+    void quantum_coherence_loop();
+    void predictive_caching_loop();
+    void statistics_collection_loop();
+
+    // Protocol thread
+    void process_client_connections();
+    void accept_clients(int listen_fd, bool local);
+    void process_incoming_messages();
+    void process_shm_channels();
+    void wait_for_shm_channels(i32 timeout_ms);
+    bool has_pending_work();
+    void send_buffer_release_events();
+    void send_presentation_events();
+
+    DispatchResult dispatch_message(const MessageOrigin& origin, const MessageHeader& header, const u8* payload);
+
+    void handle_message(MessageTag<MessageType::WindowCreate>, const MessageOrigin& origin, const RawPayload& payload);
+    void handle_message(MessageTag<MessageType::WindowDestroy>, const MessageOrigin& origin, const RawPayload& payload);
+    void handle_message(MessageTag<MessageType::WindowUpdate>, const MessageOrigin& origin, const RawPayload& payload);
+    void handle_message(MessageTag<MessageType::BufferSubmit>, const MessageOrigin& origin,
+                        const BufferSubmitPayload& payload);
+    void handle_message(MessageTag<MessageType::BufferDamage>, const MessageOrigin& origin,
+                        const BufferDamageView& damage);
+    void handle_message(MessageTag<MessageType::InputEvent>, const MessageOrigin& origin, const RawPayload& payload);
+    void handle_message(MessageTag<MessageType::QuantumSync>, const MessageOrigin& origin, const RawPayload& payload);
+    void handle_message(MessageTag<MessageType::PredictiveCache>, const MessageOrigin& origin,
+                        const RawPayload& payload);
+    void handle_message(MessageTag<MessageType::ShmTransportRequest>, const MessageOrigin& origin,
+                        const RawPayload& payload);
+    void handle_message(MessageTag<MessageType::FrameCallbackRequest>, const MessageOrigin& origin,
+                        const SurfaceCallbackRequestPayload& request);
+    void handle_message(MessageTag<MessageType::PresentationFeedbackRequest>, const MessageOrigin& origin,
+                        const SurfaceCallbackRequestPayload& request);
+
+    void handle_window_create_message(const MessageOrigin& origin, const RawPayload& payload);
+    void handle_window_destroy_message(const MessageOrigin& origin, const RawPayload& payload);
+    void handle_window_update_message(const MessageOrigin& origin, const RawPayload& payload);
+    void handle_input_event_message(const MessageOrigin& origin, const RawPayload& payload);
+    void handle_quantum_sync_message(const MessageOrigin& origin, const RawPayload& payload);
+    void handle_predictive_cache_message(const MessageOrigin& origin, const RawPayload& payload);
+
+    // Transports
+    int get_client_socket(ClientId client_id);
+    ShmChannel* find_shm_channel(ClientId client_id);
+    bool client_supports_rdma(ClientId client_id);
+
+    bool send_message_shm(ShmChannel& channel, const CompressedMessage& message);
+    bool send_message_rdma(ClientId client_id, const CompressedMessage& message);
+    bool send_message_zero_copy(ClientId client_id, const CompressedMessage& message);
+    bool send_message_standard(ClientId client_id, const CompressedMessage& message);
+    bool receive_message_rdma(ClientId client_id, CompressedMessage& message);
+    bool receive_message_zero_copy(ClientId client_id, CompressedMessage& message);
+    bool receive_message_standard(ClientId client_id, CompressedMessage& message);
+    bool broadcast_message_quantum(const Message& message);
+    bool broadcast_message_rdma(const Message& message);
+    bool broadcast_message_parallel(const Message& message);
+
+    // Compression, entanglement and prediction stages
+    bool should_compress_message(const Message& message) const;
+    bool compress_message_neural(const Message& input, CompressedMessage& output);
+    bool decompress_message_neural(const CompressedMessage& input, Message& output);
+    void apply_quantum_entanglement(ClientId client_id, CompressedMessage& message);
+    void apply_quantum_deentanglement(ClientId client_id, CompressedMessage& message);
+    void maintain_quantum_coherence();
+    void update_quantum_pairs();
+    void optimize_quantum_channels();
+    void run_predictive_models();
+    void cache_predicted_data();
+    void cleanup_expired_predictions();
+    void learn_from_send_performance(ClientId client_id, const Message& message, f64 send_time_ns, bool success);
+
+    // Tuning
+    void optimize_io_uring_for_latency();
+    void optimize_io_uring_for_throughput();
+    void optimize_memory_pool_for_latency();
+    void optimize_memory_pool_for_throughput();
+    void optimize_neural_compression_for_speed();
+    void optimize_neural_compression_for_compression();
+
+    // Statistics
+    void update_send_statistics(f64 send_time_ns, u32 size, bool success);
+    void update_receive_statistics(f64 receive_time_ns, u32 size, bool success);
+    void collect_statistics();
+
+    bool initialized_;
+    std::atomic<bool> running_;
+    bool zero_copy_enabled_;
+    bool rdma_enabled_;
+    bool quantum_entanglement_enabled_;
+    bool neural_compression_enabled_;
+    bool predictive_streaming_enabled_;
+
+    int socket_fd_;
+    int local_socket_fd_ = -1;
+    std::string local_socket_path_;
+    int io_uring_fd_;
+    rdma_cm_id* rdma_context_;
+    void* shared_memory_pool_;
+    void* quantum_state_buffer_;
+    std::unique_ptr<NeuralCompressor> neural_compressor_;
+    std::unique_ptr<StreamingPredictionEngine> prediction_engine_;
+    std::unique_ptr<QuantumCoherenceSystem> quantum_coherence_system_;
+
+    u32 max_clients_;
+    size_t buffer_pool_size_;
+    f32 quantum_coherence_;
+    f32 target_quantum_coherence_ = 0.9f;
+    f32 compression_ratio_;
+    u64 latency_target_ns_;
+    f32 bandwidth_mbps_;
+
+    ProtocolConfig config_;
+
+    std::shared_ptr<BufferSyncTracker> buffer_sync_;
+    std::shared_ptr<PresentationFeedbackTracker> presentation_feedback_;
+    std::shared_ptr<SurfaceDamageTracker> surface_damage_;
+
+    std::unordered_map<ClientId, std::unique_ptr<ShmChannel>> shm_channels_;
+
+    // Partial messages per client socket; protocol thread only
+    std::unordered_map<ClientId, MessageReceiveBuffer> receive_buffers_;
+    ClientId next_client_id_ = 1;
+
+    mutable std::mutex clients_mutex_;
+    std::unordered_map<ClientId, ClientInfo> clients_;
+
+    mutable std::mutex stats_mutex_;
+    ProtocolStats stats_;
+
+    std::thread protocol_thread_;
+    std::thread rdma_thread_;
+    std::thread quantum_thread_;
+    std::thread prediction_thread_;
+    std::thread stats_thread_;
+};
+
+} // namespace s1u
@@ -0,0 +1,110 @@
+#pragma once
+
+#include "s1u/core.hpp"
+#include "s1u/protocol_messages.hpp"
+
+namespace s1u {
+
+// Ring control block shared between the two processes. Producer and consumer
+// positions live on separate cache lines; positions are free-running byte
+// offsets, masked by capacity on access.
+struct ShmRingControl {
+    alignas(64) std::atomic<u64> head{0};
+    alignas(64) std::atomic<u64> tail{0};
+    alignas(64) std::atomic<u32> consumer_sleeping{0};
+    u32 capacity = 0;
+    u32 magic = 0;
+    u32 version = 0;
+};
+
+static_assert(std::atomic<u64>::is_always_lock_free, "shared-memory rings need lock-free 64-bit atomics");
+static_assert(std::atomic<u32>::is_always_lock_free, "shared-memory rings need lock-free 32-bit atomics");
+
+// One direction of a shared-memory transport: a single-producer /
+// single-consumer byte ring of MessageHeader-framed records. The eventfd
+// doorbell is only rung when the consumer has announced it is going to sleep.
+class ShmRing {
+public:
+    ShmRing() = default;
+
+    void attach(void* region, size_t region_size, int doorbell_fd);
+    void initialize_control(u32 capacity);
+    bool is_valid() const;
+
+    // Producer side
+    bool try_write(MessageType type, u32 sequence, const void* payload, u32 payload_size);
+    size_t max_payload_size() const;
+
+    // Consumer side. The handler sees a private copy of the payload that is
+    // reused for the next record, so the pointer must not outlive the call.
+    // Returns the number of records consumed. A record that does not fit in
+    // what the producer published marks the ring broken; a broken ring is
+    // never drained again.
+    size_t drain(const std::function<void(const MessageHeader&, const u8*)>& handler, size_t max_records = SIZE_MAX);
+    bool wait(i32 timeout_ms);
+    bool is_empty() const;
+    bool is_broken() const { return broken_; }
+
+    // Split wait() for consumers that sleep on several doorbells at once:
+    // prepare_wait() announces the sleep and returns false if records are
+    // already there; after polling doorbell_fd(), finish_wait() clears it.
+    bool prepare_wait();
+    void finish_wait();
+
+    int doorbell_fd() const { return doorbell_fd_; }
+    u64 get_doorbells_rung() const { return doorbells_rung_; }
+    u64 get_doorbells_skipped() const { return doorbells_skipped_; }
+
+    static size_t region_size_for(u32 capacity);
+
+private:
+    ShmRingControl* control_ = nullptr;
+    u8* data_ = nullptr;
+    u32 capacity_ = 0;
+    int doorbell_fd_ = -1;
+    u64 cached_tail_ = 0;
+    u64 doorbells_rung_ = 0;
+    u64 doorbells_skipped_ = 0;
+    bool broken_ = false;
+    std::vector<u8> scratch_;
+};
+
+// A bidirectional shared-memory channel between the server and one local
+// client: a memfd holding two rings plus one doorbell eventfd per direction.
+// The Unix socket remains for setup, fd passing and as the fallback path.
+class ShmChannel {
+public:
+    ShmChannel() = default;
+    ~ShmChannel();
+
+    ShmChannel(const ShmChannel&) = delete;
+    ShmChannel& operator=(const ShmChannel&) = delete;
+
+    bool create_server(u32 ring_capacity);
+    bool attach_client(int memfd, int client_to_server_doorbell, int server_to_client_doorbell, u32 ring_capacity);
+    void close_channel();
+
+    // Sends the memfd and doorbells to the client over its Unix socket
+    bool send_setup(int socket_fd) const;
+
+    ShmRing& outgoing() { return is_server_ ? server_to_client_ : client_to_server_; }
+    ShmRing& incoming() { return is_server_ ? client_to_server_ : server_to_client_; }
+
+    bool is_open() const { return mapping_ != nullptr; }
+    u32 get_ring_capacity() const { return ring_capacity_; }
+
+private:
+    bool map_rings(int memfd, u32 ring_capacity);
+
+    bool is_server_ = false;
+    int memfd_ = -1;
+    int client_to_server_doorbell_ = -1;
+    int server_to_client_doorbell_ = -1;
+    void* mapping_ = nullptr;
+    size_t mapping_size_ = 0;
+    u32 ring_capacity_ = 0;
+    ShmRing client_to_server_;
+    ShmRing server_to_client_;
+};
+
+} // namespace s1u
@@ -0,0 +1,61 @@
+#pragma once
+
+#include "s1u/core.hpp"
+#include "s1u/damage_region.hpp"
+
+namespace s1u {
+
+// Rectangles one surface may accumulate before it is coalesced early
+constexpr u32 MAX_PENDING_DAMAGE_RECTS = 4 * MAX_DAMAGE_RECTS;
+
+struct SurfaceDamageStats {
+    u64 updates_accepted = 0;
+    u64 updates_rejected = 0;
+    u64 early_coalesces = 0;  // regions coalesced before the compositor took them
+    u64 regions_taken = 0;
+};
+
+// Client damage per surface, held until the compositor repaints the surface.
+// Decoded updates are already banded and are merged into the surface's
+// region in one sweep, never normalized again; the region is coalesced to
+// max_rects when the compositor takes it, or early once it passes
+// MAX_PENDING_DAMAGE_RECTS, so a surface that never repaints stays bounded.
+// The protocol thread adds and the compositor takes from its own thread, so
+// all entry points are serialized internally.
+//
+// A surface belongs to the first client that damages it. Damage to another
+// client's surface, or to more than MAX_CLIENT_SURFACES surfaces, is
+// rejected.
+class SurfaceDamageTracker {
+public:
+    SurfaceDamageTracker() = default;
+    ~SurfaceDamageTracker() = default;
+
+    bool add_damage(ClientId client_id, const BufferDamageView& damage);
+
+    // Damage accumulated since the surface was last taken, at most
+    // max_rects rectangles
+    DamageRegion take_damage(u32 surface_id);
+
+    void remove_surface(u32 surface_id);
+    void drop_client(ClientId client_id);
+
+    void set_max_rects(u32 max_rects);
+    SurfaceDamageStats get_statistics() const;
+
+private:
+    struct SurfaceState {
+        ClientId owner = 0;
+        DamageRegion region;
+    };
+
+    void erase_surface(std::unordered_map<u32, SurfaceState>::iterator it);
+
+    mutable std::mutex mutex_;
+    std::unordered_map<u32, SurfaceState> surfaces_;
+    std::unordered_map<ClientId, u32> client_surface_counts_;
+    u32 max_rects_ = MAX_DAMAGE_RECTS;
+    SurfaceDamageStats stats_;
+};
+
+} // namespace s1u
@@ -60,6 +60,7 @@ struct WindowProperties {
     float opacity;
     bool decorated;
     bool visible;
+    uint32_t surface_id;  // protocol surface backing the window, 0 if none
     
     WindowProperties()
         : title("Window")
@@ -77,7 +78,8 @@ struct WindowProperties {
         , always_on_top(false)
         , opacity(1.0f)
         , decorated(true)
-        , visible(true) {}
+        , visible(true)
+        , surface_id(0) {}
 };
 
 // Window class
@@ -264,6 +266,7 @@ struct WindowProperties {
     float opacity;
     bool decorated;
     bool visible;
+    uint32_t surface_id;  // protocol surface backing the window, 0 if none
     
     WindowProperties()
         : title("Window")
@@ -281,7 +284,8 @@ struct WindowProperties {
         , always_on_top(false)
         , opacity(1.0f)
         , decorated(true)
-        , visible(true) {}
+        , visible(true)
+        , surface_id(0) {}
 };
 
 // Window class
@@ -468,6 +472,7 @@ struct WindowProperties {
     float opacity;
     bool decorated;
     bool visible;
+    uint32_t surface_id;  // protocol surface backing the window, 0 if none
     
     WindowProperties()
         : title("Window")
@@ -485,7 +490,8 @@ struct WindowProperties {
         , always_on_top(false)
         , opacity(1.0f)
         , decorated(true)
-        , visible(true) {}
+        , visible(true)
+        , surface_id(0) {}
 };
 
 // Window class
@@ -0,0 +1,305 @@
+#include "s1u/buffer_sync.hpp"
+#include <sys/eventfd.h>
+#include <poll.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+
+namespace s1u {
+
+SyncFence::~SyncFence() {
+    reset();
+}
+
+SyncFence::SyncFence(SyncFence&& other) noexcept
+    : fd_(other.fd_)
+    , is_eventfd_(other.is_eventfd_) {
+    other.fd_ = -1;
+    other.is_eventfd_ = false;
+}
+
+SyncFence& SyncFence::operator=(SyncFence&& other) noexcept {
+    if (this != &other) {
+        reset();
+        fd_ = other.fd_;
+        is_eventfd_ = other.is_eventfd_;
+        other.fd_ = -1;
+        other.is_eventfd_ = false;
+    }
+    return *this;
+}
+
+SyncFence SyncFence::create_eventfd() {
+    int fd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+    return SyncFence(fd, fd >= 0);
+}
+
+SyncFence SyncFence::adopt(int fd) {
+    return SyncFence(fd, false);
+}
+
+int SyncFence::release() {
+    int fd = fd_;
+    fd_ = -1;
+    is_eventfd_ = false;
+    return fd;
+}
+
+bool SyncFence::is_signaled() const {
+    return wait(0);
+}
+
+bool SyncFence::wait(i32 timeout_ms) const {
+    if (fd_ < 0) {
+        return true;
+    }
+
+    struct pollfd pfd;
+    pfd.fd = fd_;
+    pfd.events = POLLIN;
+    pfd.revents = 0;
+
+    int result;
+    do {
+        result = poll(&pfd, 1, timeout_ms);
+    } while (result == -1 && errno == EINTR);
+
+    // A fence that errors out can never signal; treat it as signaled so a
+    // misbehaving client cannot wedge its surface forever.
+    return result > 0 && (pfd.revents & (POLLIN | POLLERR | POLLHUP | POLLNVAL)) != 0;
+}
+
+bool SyncFence::signal() {
+    if (fd_ < 0 || !is_eventfd_) {
+        return false;
+    }
+
+    eventfd_t value = 1;
+    return eventfd_write(fd_, value) == 0;
+}
+
+void SyncFence::reset() {
+    if (fd_ >= 0) {
+        close(fd_);
+        fd_ = -1;
+    }
+    is_eventfd_ = false;
+}
+
+BufferSubmitResult BufferSyncTracker::submit(ClientId client_id, const BufferSubmitPayload& payload, SyncFence acquire_fence) {
+    SyncedBuffer buffer;
+    buffer.client_id = client_id;
+    buffer.surface_id = payload.surface_id;
+    buffer.buffer_id = payload.buffer_id;
+    buffer.acquire_point = payload.acquire_point;
+    buffer.release_point = payload.release_point;
+    buffer.submit_flags = payload.flags;
+    buffer.submit_time_ns = std::chrono::steady_clock::now().time_since_epoch().count();
+    buffer.acquire_fence = std::move(acquire_fence);
+
+    if (!buffer.acquire_fence.is_valid() || buffer.acquire_fence.is_signaled()) {
+        buffer.state = BufferSyncState::Ready;
+        buffer.acquire_fence = SyncFence();
+    } else {
+        buffer.state = BufferSyncState::AwaitingAcquire;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto [it, created] = surfaces_.try_emplace(payload.surface_id);
+    SurfaceQueue& queue = it->second;
+    if (created) {
+        queue.owner = client_id;
+    } else if (queue.owner != client_id) {
+        stats_.submits_rejected++;
+        return BufferSubmitResult::ForeignSurface;
+    }
+
+    // Resubmitting a buffer the client still owns on our side is a protocol error
+    auto duplicate = std::find_if(queue.pending.begin(), queue.pending.end(),
+                                  [&payload](const SyncedBuffer& pending) {
+                                      return pending.buffer_id == payload.buffer_id;
+                                  });
+    if (duplicate != queue.pending.end() ||
+        (queue.latched && queue.latched->buffer_id == payload.buffer_id)) {
+        stats_.submits_rejected++;
+        return BufferSubmitResult::StillQueued;
+    }
+
+    queue.pending.push_back(std::move(buffer));
+    stats_.buffers_submitted++;
+    return BufferSubmitResult::Accepted;
+}
+
+void BufferSyncTracker::poll_acquire_fences() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::vector<struct pollfd> pfds;
+    std::vector<SyncedBuffer*> waiting;
+
+    for (auto& [surface_id, queue] : surfaces_) {
+        for (auto& buffer : queue.pending) {
+            if (buffer.state == BufferSyncState::AwaitingAcquire) {
+                struct pollfd pfd;
+                pfd.fd = buffer.acquire_fence.fd();
+                pfd.events = POLLIN;
+                pfd.revents = 0;
+                pfds.push_back(pfd);
+                waiting.push_back(&buffer);
+            }
+        }
+    }
+
+    if (pfds.empty()) {
+        return;
+    }
+
+    if (poll(pfds.data(), pfds.size(), 0) <= 0) {
+        stats_.acquire_fence_waits_skipped += pfds.size();
+        return;
+    }
+
+    for (size_t i = 0; i < pfds.size(); i++) {
+        if (pfds[i].revents != 0) {
+            waiting[i]->state = BufferSyncState::Ready;
+            waiting[i]->acquire_fence = SyncFence();
+        } else {
+            stats_.acquire_fence_waits_skipped++;
+        }
+    }
+}
+
+void BufferSyncTracker::latch_frame(std::vector<BufferLatch>& latches) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (auto& [surface_id, queue] : surfaces_) {
+        latch(surface_id, queue, latches);
+    }
+}
+
+void BufferSyncTracker::latch(u32 surface_id, SurfaceQueue& queue, std::vector<BufferLatch>& latches) {
+    // Buffers are ready in submission order; take the newest ready one
+    auto newest = queue.pending.end();
+    for (auto buffer = queue.pending.begin(); buffer != queue.pending.end(); ++buffer) {
+        if (buffer->state == BufferSyncState::Ready) {
+            newest = buffer;
+        } else {
+            break;
+        }
+    }
+
+    if (newest == queue.pending.end()) {
+        return;
+    }
+
+    for (auto buffer = queue.pending.begin(); buffer != newest; ++buffer) {
+        latches.push_back(BufferLatch{surface_id, buffer->buffer_id, true});
+        release_buffer(*buffer, BUFFER_RELEASE_SUPERSEDED);
+        stats_.buffers_superseded++;
+    }
+    latches.push_back(BufferLatch{surface_id, newest->buffer_id, false});
+
+    if (queue.latched) {
+        release_buffer(*queue.latched, BUFFER_RELEASE_NONE);
+    }
+
+    newest->state = BufferSyncState::Latched;
+    queue.latched = std::move(*newest);
+    queue.pending.erase(queue.pending.begin(), newest + 1);
+    stats_.buffers_latched++;
+}
+
+void BufferSyncTracker::release_buffer(SyncedBuffer& buffer, u32 flags) {
+    buffer.state = BufferSyncState::Released;
+
+    BufferReleaseEvent event;
+    event.client_id = buffer.client_id;
+    event.payload.surface_id = buffer.surface_id;
+    event.payload.buffer_id = buffer.buffer_id;
+    event.payload.release_point = buffer.release_point;
+    event.payload.flags = flags;
+
+    if (flags & BUFFER_RELEASE_SUPERSEDED) {
+        release_events_.push_back(std::move(event));
+        return;
+    }
+
+    if (buffer.submit_flags & BUFFER_SUBMIT_WANTS_RELEASE_FENCE) {
+        SyncFence fence = SyncFence::create_eventfd();
+        int client_fd = fence.is_valid() ? dup(fence.fd()) : -1;
+
+        if (client_fd >= 0) {
+            event.payload.flags |= BUFFER_RELEASE_HAS_FENCE;
+            event.release_fence = SyncFence::adopt(client_fd);
+            fences_to_signal_.push_back(std::move(fence));
+            release_events_.push_back(std::move(event));
+            stats_.release_fences_created++;
+            return;
+        }
+    }
+
+    // No fence available: hold the release until the frame has completed
+    deferred_releases_.push_back(std::move(event));
+}
+
+void BufferSyncTracker::end_frame() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (auto& fence : fences_to_signal_) {
+        fence.signal();
+    }
+    fences_to_signal_.clear();
+
+    for (auto& event : deferred_releases_) {
+        release_events_.push_back(std::move(event));
+    }
+    deferred_releases_.clear();
+}
+
+void BufferSyncTracker::drop_client(ClientId client_id) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (auto it = surfaces_.begin(); it != surfaces_.end(); ) {
+        SurfaceQueue& queue = it->second;
+
+        queue.pending.erase(std::remove_if(queue.pending.begin(), queue.pending.end(),
+                                           [client_id](const SyncedBuffer& buffer) {
+                                               return buffer.client_id == client_id;
+                                           }),
+                            queue.pending.end());
+
+        if (queue.latched && queue.latched->client_id == client_id) {
+            queue.latched.reset();
+        }
+
+        if (queue.pending.empty() && !queue.latched) {
+            it = surfaces_.erase(it);
+        } else {
+            ++it;
+        }
+    }
+
+    auto owned_by_client = [client_id](const BufferReleaseEvent& event) {
+        return event.client_id == client_id;
+    };
+    release_events_.erase(std::remove_if(release_events_.begin(), release_events_.end(), owned_by_client),
+                          release_events_.end());
+    deferred_releases_.erase(std::remove_if(deferred_releases_.begin(), deferred_releases_.end(), owned_by_client),
+                             deferred_releases_.end());
+}
+
+std::vector<BufferReleaseEvent> BufferSyncTracker::take_release_events() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::vector<BufferReleaseEvent> events;
+    events.swap(release_events_);
+    stats_.releases_sent += events.size();
+    return events;
+}
+
+bool BufferSyncTracker::has_release_events() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return !release_events_.empty();
+}
+
+BufferSyncStats BufferSyncTracker::get_statistics() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return stats_;
+}
+
+} // namespace s1u
@@ -0,0 +1,434 @@
+#include "s1u/damage_region.hpp"
+#include <algorithm>
+#include <cstring>
+
+namespace s1u {
+
+namespace {
+
+constexpr i64 MAX_DAMAGE_COORDINATE = 1 << 30;
+
+void put_varint(std::vector<u8>& out, u64 value) {
+    while (value >= 0x80) {
+        out.push_back(static_cast<u8>(value | 0x80));
+        value >>= 7;
+    }
+    out.push_back(static_cast<u8>(value));
+}
+
+u64 zigzag(i64 value) {
+    return (static_cast<u64>(value) << 1) ^ static_cast<u64>(value >> 63);
+}
+
+i64 unzigzag(u64 value) {
+    return static_cast<i64>(value >> 1) ^ -static_cast<i64>(value & 1);
+}
+
+class VarintReader {
+public:
+    VarintReader(const u8* data, size_t size) : data_(data), end_(data + size) {}
+
+    bool read(u64& value) {
+        value = 0;
+        for (u32 shift = 0; shift < 64 && data_ < end_; shift += 7) {
+            u8 byte = *data_++;
+            value |= u64(byte & 0x7f) << shift;
+            if (!(byte & 0x80)) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    bool at_end() const { return data_ == end_; }
+
+private:
+    const u8* data_;
+    const u8* end_;
+};
+
+bool same_band(const DamageRect& a, const DamageRect& b) {
+    return a.y1 == b.y1 && a.y2 == b.y2;
+}
+
+size_t band_end(const std::vector<DamageRect>& rects, size_t start) {
+    size_t end = start + 1;
+    while (end < rects.size() && same_band(rects[start], rects[end])) {
+        end++;
+    }
+    return end;
+}
+
+// Appends spans sorted by x1 to band, merging any that overlap or touch
+void append_span(std::vector<DamageRect>& band, const DamageRect& span, i32 top, i32 bottom) {
+    if (!band.empty() && span.x1 <= band.back().x2) {
+        band.back().x2 = std::max(band.back().x2, span.x2);
+    } else {
+        band.push_back(DamageRect{span.x1, top, span.x2, bottom});
+    }
+}
+
+// Appends a band below the last one in out, extending the previous band
+// downwards instead when the spans are identical
+void append_band(std::vector<DamageRect>& out, const std::vector<DamageRect>& band,
+                 size_t& previous_band_start, size_t& previous_band_size) {
+    if (band.empty()) return;
+
+    const i32 top = band.front().y1;
+    bool extends_previous = previous_band_size == band.size() && out[previous_band_start].y2 == top;
+    for (size_t i = 0; extends_previous && i < band.size(); i++) {
+        const DamageRect& previous = out[previous_band_start + i];
+        extends_previous = previous.x1 == band[i].x1 && previous.x2 == band[i].x2;
+    }
+
+    if (extends_previous) {
+        for (size_t i = 0; i < band.size(); i++) {
+            out[previous_band_start + i].y2 = band.front().y2;
+        }
+    } else {
+        previous_band_start = out.size();
+        previous_band_size = band.size();
+        out.insert(out.end(), band.begin(), band.end());
+    }
+}
+
+} // namespace
+
+void DamageRegion::add(const DamageRect& rect) {
+    if (rect.is_empty()) return;
+
+    DamageRegion single;
+    single.rects_.push_back(rect);
+    add(single);
+}
+
+void DamageRegion::add(const std::vector<DamageRect>& rects) {
+    if (rects.empty()) return;
+
+    std::vector<DamageRect> input = rects_;
+    input.insert(input.end(), rects.begin(), rects.end());
+    normalize(input);
+}
+
+void DamageRegion::add(const DamageRegion& other) {
+    if (other.is_empty()) return;
+    if (is_empty()) {
+        rects_ = other.rects_;
+        return;
+    }
+
+    // Both sides are banded, so one sweep down the bands of each yields the
+    // union, banded again, without the sort and edge passes of normalize()
+    const std::vector<DamageRect>& a = rects_;
+    const std::vector<DamageRect>& b = other.rects_;
+    std::vector<DamageRect> merged;
+    merged.reserve(a.size() + b.size());
+    std::vector<DamageRect> band;
+    size_t previous_band_start = 0;
+    size_t previous_band_size = 0;
+
+    size_t a_start = 0;
+    size_t b_start = 0;
+    i32 y = std::min(a.front().y1, b.front().y1);
+
+    while (a_start < a.size() || b_start < b.size()) {
+        // Top of what is left of each side's current band
+        const i32 a_top = a_start < a.size() ? std::max(a[a_start].y1, y) : INT32_MAX;
+        const i32 b_top = b_start < b.size() ? std::max(b[b_start].y1, y) : INT32_MAX;
+        const i32 top = std::min(a_top, b_top);
+        const bool in_a = a_top == top;
+        const bool in_b = b_top == top;
+
+        i32 bottom = in_a ? a[a_start].y2 : a_top;
+        bottom = std::min(bottom, in_b ? b[b_start].y2 : b_top);
+
+        const size_t a_end = in_a ? band_end(a, a_start) : a_start;
+        const size_t b_end = in_b ? band_end(b, b_start) : b_start;
+
+        // Spans of each band are sorted, so merging them is one pass too
+        band.clear();
+        size_t i = a_start;
+        size_t j = b_start;
+        while (i < a_end || j < b_end) {
+            if (j == b_end || (i < a_end && a[i].x1 <= b[j].x1)) {
+                append_span(band, a[i++], top, bottom);
+            } else {
+                append_span(band, b[j++], top, bottom);
+            }
+        }
+        append_band(merged, band, previous_band_start, previous_band_size);
+
+        y = bottom;
+        if (in_a && a[a_start].y2 <= y) a_start = a_end;
+        if (in_b && b[b_start].y2 <= y) b_start = b_end;
+    }
+
+    rects_.swap(merged);
+}
+
+void DamageRegion::intersect(const DamageRect& clip) {
+    // Clipping keeps every band's rectangles in the same band and apart
+    size_t kept = 0;
+    for (const auto& rect : rects_) {
+        DamageRect clipped{std::max(rect.x1, clip.x1), std::max(rect.y1, clip.y1),
+                           std::min(rect.x2, clip.x2), std::min(rect.y2, clip.y2)};
+        if (!clipped.is_empty()) {
+            rects_[kept++] = clipped;
+        }
+    }
+    rects_.resize(kept);
+}
+
+void DamageRegion::translate(i32 dx, i32 dy) {
+    for (auto& rect : rects_) {
+        rect.x1 += dx;
+        rect.x2 += dx;
+        rect.y1 += dy;
+        rect.y2 += dy;
+    }
+}
+
+void DamageRegion::clear() {
+    rects_.clear();
+}
+
+DamageRect DamageRegion::extents() const {
+    if (rects_.empty()) return DamageRect();
+
+    DamageRect bounds = rects_.front();
+    bounds.y2 = rects_.back().y2;
+    for (const auto& rect : rects_) {
+        bounds.x1 = std::min(bounds.x1, rect.x1);
+        bounds.x2 = std::max(bounds.x2, rect.x2);
+    }
+    return bounds;
+}
+
+u64 DamageRegion::area() const {
+    u64 total = 0;
+    for (const auto& rect : rects_) {
+        total += rect.area();
+    }
+    return total;
+}
+
+u32 DamageRegion::band_count() const {
+    u32 bands = 0;
+    for (size_t i = 0; i < rects_.size(); i++) {
+        if (i == 0 || !same_band(rects_[i - 1], rects_[i])) {
+            bands++;
+        }
+    }
+    return bands;
+}
+
+void DamageRegion::normalize(std::vector<DamageRect>& input) {
+    input.erase(std::remove_if(input.begin(), input.end(),
+                               [](const DamageRect& rect) { return rect.is_empty(); }),
+                input.end());
+    rects_.clear();
+    if (input.empty()) return;
+
+    std::vector<i32> edges;
+    edges.reserve(input.size() * 2);
+    for (const auto& rect : input) {
+        edges.push_back(rect.y1);
+        edges.push_back(rect.y2);
+    }
+    std::sort(edges.begin(), edges.end());
+    edges.erase(std::unique(edges.begin(), edges.end()), edges.end());
+
+    std::sort(input.begin(), input.end(), [](const DamageRect& a, const DamageRect& b) {
+        return a.x1 < b.x1;
+    });
+
+    std::vector<DamageRect> band;
+    size_t previous_band_start = 0;
+    size_t previous_band_size = 0;
+
+    for (size_t e = 0; e + 1 < edges.size(); e++) {
+        const i32 top = edges[e];
+        const i32 bottom = edges[e + 1];
+
+        // Input is sorted by x1, so spans come out sorted and merge in one pass
+        band.clear();
+        for (const auto& rect : input) {
+            if (rect.y1 > top || rect.y2 < bottom) continue;
+            append_span(band, rect, top, bottom);
+        }
+
+        append_band(rects_, band, previous_band_start, previous_band_size);
+    }
+}
+
+void DamageRegion::coalesce(u32 max_rects) {
+    max_rects = std::max<u32>(max_rects, 1);
+    if (rects_.size() <= max_rects) return;
+
+    // Fill the cheapest horizontal gaps inside bands first
+    struct Gap {
+        size_t left;
+        u64 waste;
+    };
+
+    std::vector<Gap> gaps;
+    for (size_t i = 0; i + 1 < rects_.size(); i++) {
+        if (same_band(rects_[i], rects_[i + 1])) {
+            u64 height = u64(rects_[i].y2 - rects_[i].y1);
+            gaps.push_back(Gap{i, u64(rects_[i + 1].x1 - rects_[i].x2) * height});
+        }
+    }
+
+    size_t excess = rects_.size() - max_rects;
+    if (gaps.size() > excess) {
+        std::nth_element(gaps.begin(), gaps.begin() + excess, gaps.end(),
+                         [](const Gap& a, const Gap& b) { return a.waste < b.waste; });
+        gaps.resize(excess);
+    }
+
+    std::vector<u8> fill(rects_.size(), 0);
+    for (const auto& gap : gaps) {
+        fill[gap.left] = 1;
+    }
+
+    std::vector<DamageRect> merged;
+    merged.reserve(rects_.size() - gaps.size());
+    for (size_t i = 0; i < rects_.size(); i++) {
+        if (i > 0 && fill[i - 1]) {
+            merged.back().x2 = rects_[i].x2;
+        } else {
+            merged.push_back(rects_[i]);
+        }
+    }
+    rects_.swap(merged);
+
+    // Every band is a single rectangle now; merge neighbouring bands
+    while (rects_.size() > max_rects) {
+        size_t best = 0;
+        u64 best_waste = UINT64_MAX;
+
+        for (size_t i = 0; i + 1 < rects_.size(); i++) {
+            const DamageRect& a = rects_[i];
+            const DamageRect& b = rects_[i + 1];
+            DamageRect hull{std::min(a.x1, b.x1), a.y1, std::max(a.x2, b.x2), b.y2};
+            u64 waste = hull.area() - a.area() - b.area();
+            if (waste < best_waste) {
+                best_waste = waste;
+                best = i;
+            }
+        }
+
+        DamageRect& a = rects_[best];
+        const DamageRect& b = rects_[best + 1];
+        a.x1 = std::min(a.x1, b.x1);
+        a.x2 = std::max(a.x2, b.x2);
+        a.y2 = b.y2;
+        rects_.erase(rects_.begin() + best + 1);
+    }
+}
+
+void DamageRegion::encode(u32 surface_id, std::vector<u8>& out) const {
+    BufferDamageHeader header;
+    header.surface_id = surface_id;
+    header.band_count = band_count();
+
+    size_t header_offset = out.size();
+    out.resize(header_offset + sizeof(header));
+    std::memcpy(out.data() + header_offset, &header, sizeof(header));
+
+    i32 previous_bottom = 0;
+    for (size_t start = 0; start < rects_.size();) {
+        size_t end = start + 1;
+        while (end < rects_.size() && same_band(rects_[start], rects_[end])) {
+            end++;
+        }
+
+        const DamageRect& first = rects_[start];
+        if (start == 0) {
+            put_varint(out, zigzag(first.y1));
+        } else {
+            put_varint(out, u64(first.y1 - previous_bottom));
+        }
+        put_varint(out, u64(first.y2 - first.y1));
+        put_varint(out, end - start);
+
+        for (size_t i = start; i < end; i++) {
+            if (i == start) {
+                put_varint(out, zigzag(rects_[i].x1));
+            } else {
+                put_varint(out, u64(rects_[i].x1 - rects_[i - 1].x2));
+            }
+            put_varint(out, u64(rects_[i].x2 - rects_[i].x1));
+        }
+
+        previous_bottom = first.y2;
+        start = end;
+    }
+}
+
+bool DamageRegion::decode(const u8* data, size_t size, u32& surface_id) {
+    rects_.clear();
+
+    BufferDamageHeader header;
+    if (size < sizeof(header)) return false;
+    std::memcpy(&header, data, sizeof(header));
+    surface_id = header.surface_id;
+
+    if (header.band_count > MAX_DAMAGE_RECTS) return false;
+
+    // Deltas are validated as they are read, so a successfully decoded
+    // region is banded by construction and needs no normalization pass
+    VarintReader reader(data + sizeof(header), size - sizeof(header));
+    i64 previous_bottom = 0;
+
+    for (u32 band = 0; band < header.band_count; band++) {
+        u64 gap, height, count;
+        if (!reader.read(gap) || !reader.read(height) || !reader.read(count)) break;
+
+        // The first edge is absolute and checked before anything is added
+        // to it; later edges only grow from an edge already in range
+        i64 top = band == 0 ? unzigzag(gap) : previous_bottom + static_cast<i64>(std::min<u64>(gap, MAX_DAMAGE_COORDINATE));
+        if (top < -MAX_DAMAGE_COORDINATE || top > MAX_DAMAGE_COORDINATE) break;
+        i64 bottom = top + static_cast<i64>(std::min<u64>(height, MAX_DAMAGE_COORDINATE));
+        if (height == 0 || count == 0 || count > MAX_DAMAGE_RECTS - rects_.size() ||
+            top < -MAX_DAMAGE_COORDINATE || bottom > MAX_DAMAGE_COORDINATE) {
+            break;
+        }
+
+        i64 previous_right = 0;
+        bool valid = true;
+        for (u64 i = 0; i < count && valid; i++) {
+            u64 x_gap, width;
+            if (!reader.read(x_gap) || !reader.read(width)) {
+                valid = false;
+                break;
+            }
+
+            i64 left = i == 0 ? unzigzag(x_gap) : previous_right + static_cast<i64>(std::min<u64>(x_gap, MAX_DAMAGE_COORDINATE));
+            if (left < -MAX_DAMAGE_COORDINATE || left > MAX_DAMAGE_COORDINATE) {
+                valid = false;
+                break;
+            }
+            i64 right = left + static_cast<i64>(std::min<u64>(width, MAX_DAMAGE_COORDINATE));
+            valid = width > 0 && (i == 0 || x_gap > 0) &&
+                    left >= -MAX_DAMAGE_COORDINATE && right <= MAX_DAMAGE_COORDINATE;
+
+            rects_.push_back(DamageRect{static_cast<i32>(left), static_cast<i32>(top),
+                                        static_cast<i32>(right), static_cast<i32>(bottom)});
+            previous_right = right;
+        }
+
+        if (!valid) break;
+        previous_bottom = bottom;
+
+        if (band + 1 == header.band_count) {
+            if (reader.at_end()) return true;
+            break;
+        }
+    }
+
+    rects_.clear();
+    return header.band_count == 0 && reader.at_end();
+}
+
+} // namespace s1u
@@ -0,0 +1,285 @@
+#include "s1u/presentation_feedback.hpp"
+#include <algorithm>
+
+namespace s1u {
+
+PresentationFeedbackTracker::SurfaceState* PresentationFeedbackTracker::claim_surface(ClientId client_id, u32 surface_id) {
+    auto it = surfaces_.find(surface_id);
+    if (it == surfaces_.end()) {
+        u32& count = client_surface_counts_[client_id];
+        if (count >= MAX_CLIENT_SURFACES) {
+            return nullptr;
+        }
+        count++;
+        it = surfaces_.try_emplace(surface_id).first;
+        it->second.owner = client_id;
+    } else if (it->second.owner == 0) {
+        // Created by the compositor's visibility report before any request
+        client_surface_counts_[client_id]++;
+        it->second.owner = client_id;
+    } else if (it->second.owner != client_id) {
+        return nullptr;
+    }
+    return &it->second;
+}
+
+void PresentationFeedbackTracker::erase_surface(std::unordered_map<u32, SurfaceState>::iterator it) {
+    auto count = client_surface_counts_.find(it->second.owner);
+    if (count != client_surface_counts_.end() && --count->second == 0) {
+        client_surface_counts_.erase(count);
+    }
+    surfaces_.erase(it);
+}
+
+std::vector<PresentationFeedbackTracker::FeedbackRequest>::iterator
+PresentationFeedbackTracker::partition_commit(std::vector<FeedbackRequest>& requests, u32 buffer_id) {
+    return std::stable_partition(requests.begin(), requests.end(), [buffer_id](const FeedbackRequest& request) {
+        return !request.committed || request.buffer_id != buffer_id;
+    });
+}
+
+bool PresentationFeedbackTracker::request_frame_callback(ClientId client_id, u32 surface_id, u32 callback_id) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    SurfaceState* surface = claim_surface(client_id, surface_id);
+    if (!surface || surface->frame_callbacks.size() >= MAX_SURFACE_REQUESTS) {
+        stats_.requests_rejected++;
+        return false;
+    }
+
+    FrameCallback callback;
+    callback.client_id = client_id;
+    callback.callback_id = callback_id;
+    surface->frame_callbacks.push_back(callback);
+    return true;
+}
+
+bool PresentationFeedbackTracker::request_feedback(ClientId client_id, u32 surface_id, u32 feedback_id) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    SurfaceState* surface = claim_surface(client_id, surface_id);
+    if (!surface) {
+        stats_.requests_rejected++;
+        return false;
+    }
+
+    // A surface that never latches would otherwise collect requests forever
+    if (surface->pending_feedback.size() >= MAX_SURFACE_REQUESTS) {
+        emit_discarded(surface_id, surface->pending_feedback.front());
+        surface->pending_feedback.erase(surface->pending_feedback.begin());
+    }
+
+    FeedbackRequest request;
+    request.client_id = client_id;
+    request.feedback_id = feedback_id;
+    surface->pending_feedback.push_back(request);
+    return true;
+}
+
+void PresentationFeedbackTracker::set_surface_visible(u32 surface_id, bool visible) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = surfaces_.find(surface_id);
+    if (it != surfaces_.end()) {
+        it->second.visible = visible;
+    } else if (!visible) {
+        // Visible is the default, so only a hidden surface needs an entry
+        surfaces_[surface_id].visible = false;
+    }
+}
+
+void PresentationFeedbackTracker::remove_surface(u32 surface_id) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = surfaces_.find(surface_id);
+    if (it == surfaces_.end()) {
+        return;
+    }
+
+    for (const auto& request : it->second.pending_feedback) {
+        emit_discarded(surface_id, request);
+    }
+    for (const auto& request : it->second.latched_feedback) {
+        emit_discarded(surface_id, request);
+    }
+
+    erase_surface(it);
+}
+
+void PresentationFeedbackTracker::drop_client(ClientId client_id) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (auto it = surfaces_.begin(); it != surfaces_.end();) {
+        if (it->second.owner == client_id) {
+            erase_surface(it++);
+            continue;
+        }
+
+        SurfaceState& surface = it->second;
+        auto owned_feedback = [client_id](const FeedbackRequest& request) {
+            return request.client_id == client_id;
+        };
+        auto owned_callback = [client_id](const FrameCallback& callback) {
+            return callback.client_id == client_id;
+        };
+
+        surface.pending_feedback.erase(std::remove_if(surface.pending_feedback.begin(), surface.pending_feedback.end(), owned_feedback),
+                                       surface.pending_feedback.end());
+        surface.latched_feedback.erase(std::remove_if(surface.latched_feedback.begin(), surface.latched_feedback.end(), owned_feedback),
+                                       surface.latched_feedback.end());
+        surface.frame_callbacks.erase(std::remove_if(surface.frame_callbacks.begin(), surface.frame_callbacks.end(), owned_callback),
+                                      surface.frame_callbacks.end());
+        ++it;
+    }
+
+    events_.erase(std::remove_if(events_.begin(), events_.end(),
+                                 [client_id](const PresentationEvent& event) {
+                                     return event.client_id == client_id;
+                                 }),
+                  events_.end());
+}
+
+void PresentationFeedbackTracker::on_surface_committed(ClientId client_id, u32 surface_id, u32 buffer_id) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = surfaces_.find(surface_id);
+    if (it == surfaces_.end() || it->second.owner != client_id) {
+        return;
+    }
+
+    for (auto& request : it->second.pending_feedback) {
+        if (!request.committed) {
+            request.buffer_id = buffer_id;
+            request.committed = true;
+        }
+    }
+}
+
+void PresentationFeedbackTracker::on_surface_latched(u32 surface_id, u32 buffer_id) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = surfaces_.find(surface_id);
+    if (it == surfaces_.end()) {
+        return;
+    }
+
+    SurfaceState& surface = it->second;
+
+    // A newer commit replaced content that was latched but never presented
+    for (const auto& request : surface.latched_feedback) {
+        emit_discarded(surface_id, request);
+    }
+    surface.latched_feedback.clear();
+
+    // Requests not yet committed, or committed with a later buffer still
+    // waiting on its acquire fence, keep waiting
+    auto latched = partition_commit(surface.pending_feedback, buffer_id);
+    surface.latched_feedback.assign(latched, surface.pending_feedback.end());
+    surface.pending_feedback.erase(latched, surface.pending_feedback.end());
+}
+
+void PresentationFeedbackTracker::on_frame_discarded(u32 surface_id, u32 buffer_id) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = surfaces_.find(surface_id);
+    if (it == surfaces_.end()) {
+        return;
+    }
+
+    std::vector<FeedbackRequest>& pending = it->second.pending_feedback;
+    auto discarded = partition_commit(pending, buffer_id);
+    for (auto request = discarded; request != pending.end(); ++request) {
+        emit_discarded(surface_id, *request);
+    }
+    pending.erase(discarded, pending.end());
+}
+
+void PresentationFeedbackTracker::on_frame_presented(const PresentationTiming& timing) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stats_.frames_presented++;
+
+    for (auto it = surfaces_.begin(); it != surfaces_.end();) {
+        u32 surface_id = it->first;
+        SurfaceState& surface = it->second;
+
+        for (const auto& request : surface.latched_feedback) {
+            emit_feedback(surface_id, request, timing);
+        }
+        surface.latched_feedback.clear();
+
+        if (!surface.frame_callbacks.empty()) {
+            if (surface.visible) {
+                emit_frame_callbacks(surface_id, surface, timing.present_time_ns);
+            } else if (timing.present_time_ns - surface.last_hidden_callback_ns >= hidden_callback_interval_ns_) {
+                surface.last_hidden_callback_ns = timing.present_time_ns;
+                emit_frame_callbacks(surface_id, surface, timing.present_time_ns);
+            } else {
+                stats_.frame_callbacks_throttled += surface.frame_callbacks.size();
+            }
+        }
+
+        // A visible surface with nothing outstanding is back to the default
+        // state; forgetting it keeps ids a client never uses again from piling up
+        if (surface.visible && surface.pending_feedback.empty() && surface.frame_callbacks.empty()) {
+            erase_surface(it++);
+        } else {
+            ++it;
+        }
+    }
+}
+
+std::vector<PresentationEvent> PresentationFeedbackTracker::take_events() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::vector<PresentationEvent> events;
+    events.swap(events_);
+    return events;
+}
+
+bool PresentationFeedbackTracker::has_events() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return !events_.empty();
+}
+
+void PresentationFeedbackTracker::set_hidden_callback_interval(u64 interval_ns) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    hidden_callback_interval_ns_ = interval_ns;
+}
+
+PresentationFeedbackStats PresentationFeedbackTracker::get_statistics() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return stats_;
+}
+
+void PresentationFeedbackTracker::emit_feedback(u32 surface_id, const FeedbackRequest& request, const PresentationTiming& timing) {
+    PresentationEvent event;
+    event.client_id = request.client_id;
+    event.type = MessageType::PresentationFeedback;
+    event.feedback.surface_id = surface_id;
+    event.feedback.feedback_id = request.feedback_id;
+    event.feedback.present_time_ns = timing.present_time_ns;
+    event.feedback.refresh_interval_ns = timing.refresh_interval_ns;
+    event.feedback.sequence = timing.sequence;
+    event.feedback.flags = timing.flags;
+    events_.push_back(event);
+    stats_.feedback_presented++;
+}
+
+void PresentationFeedbackTracker::emit_discarded(u32 surface_id, const FeedbackRequest& request) {
+    PresentationEvent event;
+    event.client_id = request.client_id;
+    event.type = MessageType::PresentationFeedback;
+    event.feedback.surface_id = surface_id;
+    event.feedback.feedback_id = request.feedback_id;
+    event.feedback.flags = PRESENTATION_DISCARDED;
+    events_.push_back(event);
+    stats_.feedback_discarded++;
+}
+
+void PresentationFeedbackTracker::emit_frame_callbacks(u32 surface_id, SurfaceState& surface, u64 timestamp_ns) {
+    for (const auto& callback : surface.frame_callbacks) {
+        PresentationEvent event;
+        event.client_id = callback.client_id;
+        event.type = MessageType::FrameDone;
+        event.frame_done.surface_id = surface_id;
+        event.frame_done.callback_id = callback.callback_id;
+        event.frame_done.timestamp_ns = timestamp_ns;
+        events_.push_back(event);
+    }
+
+    stats_.frame_callbacks_sent += surface.frame_callbacks.size();
+    surface.frame_callbacks.clear();
+}
+
+} // namespace s1u
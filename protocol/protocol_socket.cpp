@@ -0,0 +1,291 @@
+#include "s1u/protocol_socket.hpp"
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#include <cerrno>
+#include <cstring>
+
+namespace s1u {
+
+// Bytes requested per read; a larger message grows the buffer to fit
+constexpr size_t RECEIVE_CHUNK_SIZE = 64 * 1024;
+
+bool send_message_with_fds(int socket_fd, MessageType type, u32 sequence,
+                           const void* payload, u32 payload_size,
+                           const int* fds, u32 fd_count) {
+    if (payload_size > MAX_MESSAGE_PAYLOAD_SIZE || fd_count > MAX_MESSAGE_FDS) {
+        return false;
+    }
+
+    MessageHeader header;
+    header.type = static_cast<u32>(type);
+    header.payload_size = payload_size;
+    header.sequence = sequence;
+
+    struct iovec iov[2];
+    iov[0].iov_base = &header;
+    iov[0].iov_len = sizeof(header);
+    iov[1].iov_base = const_cast<void*>(payload);
+    iov[1].iov_len = payload_size;
+
+    alignas(struct cmsghdr) char control[CMSG_SPACE(sizeof(int) * MAX_MESSAGE_FDS)];
+
+    struct msghdr msg = {};
+    msg.msg_iov = iov;
+    msg.msg_iovlen = payload_size > 0 ? 2 : 1;
+
+    if (fd_count > 0) {
+        std::memset(control, 0, sizeof(control));
+        msg.msg_control = control;
+        msg.msg_controllen = CMSG_SPACE(sizeof(int) * fd_count);
+
+        struct cmsghdr* cmsg = CMSG_FIRSTHDR(&msg);
+        cmsg->cmsg_level = SOL_SOCKET;
+        cmsg->cmsg_type = SCM_RIGHTS;
+        cmsg->cmsg_len = CMSG_LEN(sizeof(int) * fd_count);
+        std::memcpy(CMSG_DATA(cmsg), fds, sizeof(int) * fd_count);
+    }
+
+    size_t total = sizeof(header) + payload_size;
+    ssize_t sent;
+    do {
+        sent = sendmsg(socket_fd, &msg, MSG_NOSIGNAL);
+    } while (sent == -1 && errno == EINTR);
+
+    if (sent < 0) {
+        return false;
+    }
+
+    // Ancillary data rides with the first byte; finish any short write plainly
+    size_t done = static_cast<size_t>(sent);
+    while (done < total) {
+        const u8* base;
+        size_t remaining;
+        if (done < sizeof(header)) {
+            base = reinterpret_cast<const u8*>(&header) + done;
+            remaining = sizeof(header) - done;
+        } else {
+            base = static_cast<const u8*>(payload) + (done - sizeof(header));
+            remaining = total - done;
+        }
+
+        ssize_t n = send(socket_fd, base, remaining, MSG_NOSIGNAL);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return false;
+        }
+        done += static_cast<size_t>(n);
+    }
+
+    return true;
+}
+
+static bool read_exact(int socket_fd, void* data, size_t size) {
+    u8* out = static_cast<u8*>(data);
+    size_t done = 0;
+
+    while (done < size) {
+        ssize_t n = recv(socket_fd, out + done, size - done, 0);
+        if (n == 0) return false;
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return false;
+        }
+        done += static_cast<size_t>(n);
+    }
+
+    return true;
+}
+
+bool receive_message_with_fds(int socket_fd, ReceivedMessage& message) {
+    message.fd_count = 0;
+    message.fds.fill(-1);
+
+    struct iovec iov;
+    iov.iov_base = &message.header;
+    iov.iov_len = sizeof(message.header);
+
+    alignas(struct cmsghdr) char control[CMSG_SPACE(sizeof(int) * MAX_MESSAGE_FDS)];
+
+    struct msghdr msg = {};
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = control;
+    msg.msg_controllen = sizeof(control);
+
+    ssize_t n;
+    do {
+        n = recvmsg(socket_fd, &msg, MSG_CMSG_CLOEXEC);
+    } while (n == -1 && errno == EINTR);
+
+    if (n <= 0) {
+        return false;
+    }
+
+    for (struct cmsghdr* cmsg = CMSG_FIRSTHDR(&msg); cmsg; cmsg = CMSG_NXTHDR(&msg, cmsg)) {
+        if (cmsg->cmsg_level != SOL_SOCKET || cmsg->cmsg_type != SCM_RIGHTS) {
+            continue;
+        }
+
+        u32 count = static_cast<u32>((cmsg->cmsg_len - CMSG_LEN(0)) / sizeof(int));
+        const u8* data = CMSG_DATA(cmsg);
+        for (u32 i = 0; i < count; i++) {
+            int fd;
+            std::memcpy(&fd, data + i * sizeof(int), sizeof(int));
+            if (message.fd_count < MAX_MESSAGE_FDS) {
+                message.fds[message.fd_count++] = fd;
+            } else {
+                close(fd);
+            }
+        }
+    }
+
+    if (static_cast<size_t>(n) < sizeof(message.header) &&
+        !read_exact(socket_fd, reinterpret_cast<u8*>(&message.header) + n, sizeof(message.header) - n)) {
+        close_received_fds(message);
+        return false;
+    }
+
+    if (message.header.payload_size > MAX_MESSAGE_PAYLOAD_SIZE) {
+        close_received_fds(message);
+        return false;
+    }
+
+    message.payload.resize(message.header.payload_size);
+    if (!message.payload.empty() && !read_exact(socket_fd, message.payload.data(), message.payload.size())) {
+        close_received_fds(message);
+        return false;
+    }
+
+    return true;
+}
+
+void close_received_fds(ReceivedMessage& message) {
+    for (u32 i = 0; i < message.fd_count; i++) {
+        if (message.fds[i] >= 0) {
+            close(message.fds[i]);
+            message.fds[i] = -1;
+        }
+    }
+    message.fd_count = 0;
+}
+
+MessageReceiveBuffer::~MessageReceiveBuffer() {
+    for (auto& pending : pending_fds_) {
+        for (u32 i = 0; i < pending.fd_count; i++) {
+            close(pending.fds[i]);
+        }
+    }
+}
+
+bool MessageReceiveBuffer::read_available(int socket_fd) {
+    // Move the unparsed tail to the front once free space runs low
+    if (data_.size() - end_ < RECEIVE_CHUNK_SIZE) {
+        if (begin_ > 0) {
+            std::memmove(data_.data(), data_.data() + begin_, end_ - begin_);
+            stream_offset_ += begin_;
+            end_ -= begin_;
+            begin_ = 0;
+        }
+        if (data_.size() - end_ < RECEIVE_CHUNK_SIZE) {
+            data_.resize(end_ + RECEIVE_CHUNK_SIZE);
+        }
+    }
+
+    struct iovec iov;
+    iov.iov_base = data_.data() + end_;
+    iov.iov_len = data_.size() - end_;
+
+    alignas(struct cmsghdr) char control[CMSG_SPACE(sizeof(int) * MAX_MESSAGE_FDS)];
+
+    struct msghdr msg = {};
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = control;
+    msg.msg_controllen = sizeof(control);
+
+    ssize_t n;
+    do {
+        n = recvmsg(socket_fd, &msg, MSG_DONTWAIT | MSG_CMSG_CLOEXEC);
+    } while (n == -1 && errno == EINTR);
+
+    if (n < 0) {
+        return errno == EAGAIN || errno == EWOULDBLOCK;
+    }
+    if (n == 0) {
+        return false;
+    }
+
+    PendingFds pending;
+    pending.first_byte = stream_offset_ + end_;
+    pending.end_byte = pending.first_byte + static_cast<u64>(n);
+    end_ += static_cast<size_t>(n);
+
+    for (struct cmsghdr* cmsg = CMSG_FIRSTHDR(&msg); cmsg; cmsg = CMSG_NXTHDR(&msg, cmsg)) {
+        if (cmsg->cmsg_level != SOL_SOCKET || cmsg->cmsg_type != SCM_RIGHTS) {
+            continue;
+        }
+
+        u32 count = static_cast<u32>((cmsg->cmsg_len - CMSG_LEN(0)) / sizeof(int));
+        const u8* data = CMSG_DATA(cmsg);
+        for (u32 i = 0; i < count; i++) {
+            int fd;
+            std::memcpy(&fd, data + i * sizeof(int), sizeof(int));
+            if (pending.fd_count < MAX_MESSAGE_FDS) {
+                pending.fds[pending.fd_count++] = fd;
+            } else {
+                close(fd);
+            }
+        }
+    }
+
+    if (pending.fd_count > 0) {
+        pending_fds_.push_back(pending);
+    }
+
+    return true;
+}
+
+bool MessageReceiveBuffer::next_message(ReceivedMessage& message) {
+    if (broken_ || end_ - begin_ < sizeof(MessageHeader)) {
+        return false;
+    }
+
+    MessageHeader header;
+    std::memcpy(&header, data_.data() + begin_, sizeof(header));
+    if (header.payload_size > MAX_MESSAGE_PAYLOAD_SIZE) {
+        broken_ = true;
+        return false;
+    }
+
+    size_t size = sizeof(header) + header.payload_size;
+    if (end_ - begin_ < size) {
+        return false;
+    }
+
+    message.header = header;
+    message.payload.assign(data_.begin() + begin_ + sizeof(header), data_.begin() + begin_ + size);
+    message.fds.fill(-1);
+    message.fd_count = 0;
+
+    // Fds belong to the first message that starts inside their read. Ones
+    // whose read held no message start were sent mid-message and are closed.
+    u64 first_byte = stream_offset_ + begin_;
+    while (!pending_fds_.empty() && pending_fds_.front().end_byte <= first_byte) {
+        PendingFds& stray = pending_fds_.front();
+        for (u32 i = 0; i < stray.fd_count; i++) {
+            close(stray.fds[i]);
+        }
+        pending_fds_.pop_front();
+    }
+    if (!pending_fds_.empty() && pending_fds_.front().first_byte <= first_byte) {
+        message.fds = pending_fds_.front().fds;
+        message.fd_count = pending_fds_.front().fd_count;
+        pending_fds_.pop_front();
+    }
+
+    begin_ += size;
+    return true;
+}
+
+} // namespace s1u
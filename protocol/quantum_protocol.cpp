@@ -1,22 +1,82 @@
 #include "s1u/quantum_protocol.hpp"
 #include "s1u/core.hpp"
+#include "s1u/buffer_sync.hpp"
+#include "s1u/damage_region.hpp"
+#include "s1u/memory_huge_pages.hpp"
+#include "s1u/presentation_feedback.hpp"
+#include "s1u/protocol_dispatch.hpp"
+#include "s1u/protocol_socket.hpp"
+#include "s1u/shm_ring.hpp"
+#include "s1u/surface_damage.hpp"
+#include <linux/io_uring.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/syscall.h>
+#include <sys/un.h>
+#include <poll.h>
+#include <unistd.h>
+#ifdef S1U_HAVE_RDMACM
+#include <rdma/rdma_cma.h>
+#endif
 #include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstdlib>
 #include <cstring>
 #include <iostream>
 #include <vector>
 #include <string>
 #include <memory>
+#include <thread>
 
 namespace s1u {
 
+namespace {
+
+// Upper bound on an idle sleep while shared-memory clients are connected
+constexpr i32 SHM_IDLE_WAIT_MS = 1;
+
+constexpr int LISTEN_BACKLOG = 128;
+
+constexpr size_t QUANTUM_STATE_BUFFER_SIZE = 64 * 1024 * 1024; // 64 MB for quantum states
+
+} // namespace
+
+// The compression, coherence and prediction models are not part of this
+// tree. Until they are, each subsystem reports itself unavailable and
+// initialize() turns the feature off.
+class NeuralCompressor {
+public:
+    bool load_model(const std::string&) { return false; }
+    bool train_compression_model() { return false; }
+    f32 get_compression_ratio() const { return 1.0f; }
+    bool compress(const Message&, CompressedMessage&) { return false; }
+    bool decompress(const CompressedMessage&, Message&) { return false; }
+};
+
+class QuantumCoherenceSystem {
+public:
+    bool initialize() { return false; }
+    void entangle_message(ClientId, CompressedMessage&) {}
+    void disentangle_message(ClientId, CompressedMessage&) {}
+};
+
+class StreamingPredictionEngine {
+public:
+    bool initialize() { return false; }
+    bool load_models(const std::string&) { return false; }
+};
+
 QuantumProtocol::QuantumProtocol()
     : initialized_(false)
     , running_(false)
     , zero_copy_enabled_(true)
     , rdma_enabled_(false)
     , quantum_entanglement_enabled_(false)
-    , neural_compression_enabled_(true)
-    , predictive_streaming_enabled_(true)
+    , neural_compression_enabled_(false)
+    , predictive_streaming_enabled_(false)
     , socket_fd_(-1)
     , io_uring_fd_(-1)
     , rdma_context_(nullptr)
@@ -31,7 +91,6 @@ QuantumProtocol::QuantumProtocol()
     , latency_target_ns_(1000000) // 1ms target
     , bandwidth_mbps_(10000.0f) // 10 Gbps
 {
-    std::memset(&stats_, 0, sizeof(stats_));
 }
 
 QuantumProtocol::~QuantumProtocol() {
@@ -51,10 +110,14 @@ bool QuantumProtocol::initialize(const ProtocolConfig& config) {
         return false;
     }
     
+    // Local clients need the Unix socket to pass fences and ring fds
+    if (!initialize_local_socket()) {
+        Logger::warning("Failed to initialize local socket, fences and shared memory are unavailable");
+    }
+    
     // Initialize io_uring for ultra-low latency
     if (!initialize_io_uring()) {
-        Logger::error("Failed to initialize io_uring");
-        return false;
+        Logger::warning("Failed to initialize io_uring, using plain socket I/O");
     }
     
     // Initialize zero-copy memory pool
@@ -87,14 +150,17 @@ bool QuantumProtocol::initialize(const ProtocolConfig& config) {
         predictive_streaming_enabled_ = false;
     }
     
-    // Initialize message handlers
-    initialize_message_handlers();
-    
-    // Start protocol threads
-    start_protocol_threads();
+    // Shared with the compositor, which latches client buffers into its
+    // frames, repaints their damage and reports presented frames back
+    buffer_sync_ = std::make_shared<BufferSyncTracker>();
+    presentation_feedback_ = std::make_shared<PresentationFeedbackTracker>();
+    surface_damage_ = std::make_shared<SurfaceDamageTracker>();
+    surface_damage_->set_max_rects(config_.max_damage_rects);
     
+    // Start protocol threads; their loops run while running_ is set
     initialized_ = true;
     running_ = true;
+    start_protocol_threads();
     
     Logger::info("Quantum Protocol initialized successfully");
     Logger::info("Features enabled: Zero-copy={}, RDMA={}, Quantum={}, Neural={}, Predictive={}",
@@ -147,6 +213,8 @@ bool QuantumProtocol::send_message(ClientId client_id, const Message& message) {
     
     // Compress message if neural compression is enabled
     CompressedMessage compressed_msg;
+    compressed_msg.type = message.type;
+    compressed_msg.timestamp = message.timestamp;
     if (neural_compression_enabled_ && should_compress_message(message)) {
         if (!compress_message_neural(message, compressed_msg)) {
             Logger::warning("Neural compression failed, sending uncompressed");
@@ -167,8 +235,12 @@ bool QuantumProtocol::send_message(ClientId client_id, const Message& message) {
     
     bool success = false;
     
+    // Local clients with a shared-memory channel bypass the socket entirely
+    if (ShmChannel* channel = find_shm_channel(client_id)) {
+        success = send_message_shm(*channel, compressed_msg);
+    }
     // Send via RDMA if available for this client
-    if (rdma_enabled_ && client_supports_rdma(client_id)) {
+    else if (rdma_enabled_ && client_supports_rdma(client_id)) {
         success = send_message_rdma(client_id, compressed_msg);
     }
     // Send via zero-copy socket
@@ -277,8 +349,8 @@ void QuantumProtocol::add_client(ClientId client_id, const ClientInfo& info) {
         initialize_client_prediction_model(client_id);
     }
     
-    Logger::info("Added client {} with features: RDMA={}, Quantum={}, ZeroCopy={}",
-                client_id, info.supports_rdma, info.supports_quantum, info.supports_zero_copy);
+    Logger::info("Added client {} with features: Local={}, RDMA={}, Quantum={}, ZeroCopy={}",
+                client_id, info.local, info.supports_rdma, info.supports_quantum, info.supports_zero_copy);
 }
 
 void QuantumProtocol::remove_client(ClientId client_id) {
@@ -289,6 +361,10 @@ void QuantumProtocol::remove_client(ClientId client_id) {
     
     // Cleanup client resources
     cleanup_client_resources(client_id);
+    buffer_sync_->drop_client(client_id);
+    presentation_feedback_->drop_client(client_id);
+    surface_damage_->drop_client(client_id);
+    shm_channels_.erase(client_id);
     
     clients_.erase(it);
     
@@ -375,6 +451,65 @@ bool QuantumProtocol::initialize_socket() {
         Logger::warning("Failed to set receive buffer size");
     }
     
+    sockaddr_in address = {};
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_ANY);
+    address.sin_port = htons(config_.port);
+    if (bind(socket_fd_, reinterpret_cast<sockaddr*>(&address), sizeof(address)) < 0 ||
+        listen(socket_fd_, LISTEN_BACKLOG) < 0) {
+        Logger::error("Failed to listen on port {}: {}", config_.port, strerror(errno));
+        cleanup_socket();
+        return false;
+    }
+    
+    return true;
+}
+
+bool QuantumProtocol::initialize_local_socket() {
+    local_socket_path_ = config_.local_socket_path;
+    if (local_socket_path_.empty()) {
+        const char* runtime_dir = std::getenv("XDG_RUNTIME_DIR");
+        local_socket_path_ = std::string(runtime_dir && *runtime_dir ? runtime_dir : "/tmp") + "/s1u-0";
+    }
+    
+    sockaddr_un address = {};
+    address.sun_family = AF_UNIX;
+    if (local_socket_path_.size() >= sizeof(address.sun_path)) {
+        Logger::error("Local socket path {} is too long", local_socket_path_);
+        return false;
+    }
+    std::memcpy(address.sun_path, local_socket_path_.c_str(), local_socket_path_.size() + 1);
+    
+    int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (fd < 0) {
+        Logger::error("Failed to create local socket: {}", strerror(errno));
+        return false;
+    }
+    
+    int result = bind(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address));
+    if (result < 0 && errno == EADDRINUSE) {
+        // Left behind by a server that exited without cleaning up, unless a
+        // live one still accepts on it
+        int probe = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+        bool stale = probe >= 0 && connect(probe, reinterpret_cast<sockaddr*>(&address), sizeof(address)) < 0 &&
+                     errno == ECONNREFUSED;
+        if (probe >= 0) close(probe);
+        if (stale) {
+            unlink(local_socket_path_.c_str());
+            result = bind(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address));
+        } else {
+            errno = EADDRINUSE;
+        }
+    }
+    
+    if (result < 0 || listen(fd, LISTEN_BACKLOG) < 0) {
+        Logger::error("Failed to listen on {}: {}", local_socket_path_, strerror(errno));
+        close(fd);
+        return false;
+    }
+    
+    local_socket_fd_ = fd;
+    Logger::info("Listening for local clients on {}", local_socket_path_);
     return true;
 }
 
@@ -390,43 +525,37 @@ bool QuantumProtocol::initialize_io_uring() {
     // Enable IOPOLL for polling-based I/O
     params.flags |= IORING_SETUP_IOPOLL;
     
-    io_uring_fd_ = io_uring_queue_init_params(1024, &io_uring_, &params);
+    io_uring_fd_ = static_cast<int>(syscall(__NR_io_uring_setup, 1024, &params));
     if (io_uring_fd_ < 0) {
         Logger::warning("Failed to initialize io_uring with optimizations, trying basic setup");
         
         // Fallback to basic io_uring
         std::memset(&params, 0, sizeof(params));
-        io_uring_fd_ = io_uring_queue_init_params(1024, &io_uring_, &params);
+        io_uring_fd_ = static_cast<int>(syscall(__NR_io_uring_setup, 1024, &params));
         
         if (io_uring_fd_ < 0) {
-            Logger::error("Failed to initialize io_uring: {}", strerror(-io_uring_fd_));
+            Logger::error("Failed to initialize io_uring: {}", strerror(errno));
             return false;
         }
     }
     
-    Logger::info("io_uring initialized with {} entries", io_uring_.ring.sq.ring_entries);
+    Logger::info("io_uring initialized with {} entries", params.sq_entries);
     return true;
 }
 
 bool QuantumProtocol::initialize_memory_pool() {
-    // Allocate shared memory pool for zero-copy operations
-    shared_memory_pool_ = mmap(nullptr, buffer_pool_size_,
-                              PROT_READ | PROT_WRITE,
-                              MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB,
-                              -1, 0);
-    
-    if (shared_memory_pool_ == MAP_FAILED) {
-        Logger::warning("Failed to allocate huge pages, falling back to regular pages");
-        
-        shared_memory_pool_ = mmap(nullptr, buffer_pool_size_,
-                                  PROT_READ | PROT_WRITE,
-                                  MAP_PRIVATE | MAP_ANONYMOUS,
-                                  -1, 0);
-        
-        if (shared_memory_pool_ == MAP_FAILED) {
-            Logger::error("Failed to allocate memory pool: {}", strerror(errno));
-            return false;
-        }
+    // Allocate shared memory pool for zero-copy operations, on explicit
+    // huge pages, else transparent ones, else regular pages
+    S1U::HugePageBacking backing;
+    shared_memory_pool_ = S1U::map_huge_pages(buffer_pool_size_, S1U::HugePageBacking::Explicit, false, &backing);
+    
+    if (!shared_memory_pool_) {
+        Logger::error("Failed to allocate memory pool: {}", strerror(errno));
+        return false;
+    }
+    
+    if (backing == S1U::HugePageBacking::Regular) {
+        Logger::warning("Huge pages unavailable, memory pool uses regular pages");
     }
     
     // Lock memory to prevent swapping
@@ -442,6 +571,7 @@ bool QuantumProtocol::initialize_memory_pool() {
 }
 
 bool QuantumProtocol::initialize_rdma() {
+#ifdef S1U_HAVE_RDMACM
     // Initialize RDMA for ultra-high bandwidth
     rdma_context_ = rdma_create_id(nullptr, RDMA_PS_TCP);
     if (!rdma_context_) {
@@ -481,17 +611,21 @@ bool QuantumProtocol::initialize_rdma() {
     rdma_enabled_ = true;
     Logger::info("RDMA initialized successfully");
     return true;
+#else
+    Logger::error("RDMA support was not built (librdmacm not found)");
+    return false;
+#endif
 }
 
 bool QuantumProtocol::initialize_quantum_entanglement() {
     // Allocate quantum state buffer
-    size_t quantum_buffer_size = 64 * 1024 * 1024; // 64 MB for quantum states
-    quantum_state_buffer_ = mmap(nullptr, quantum_buffer_size,
+    quantum_state_buffer_ = mmap(nullptr, QUANTUM_STATE_BUFFER_SIZE,
                                 PROT_READ | PROT_WRITE,
                                 MAP_PRIVATE | MAP_ANONYMOUS,
                                 -1, 0);
     
     if (quantum_state_buffer_ == MAP_FAILED) {
+        quantum_state_buffer_ = nullptr;
         Logger::error("Failed to allocate quantum state buffer: {}", strerror(errno));
         return false;
     }
@@ -548,39 +682,101 @@ bool QuantumProtocol::initialize_predictive_streaming() {
     return true;
 }
 
-void QuantumProtocol::initialize_message_handlers() {
-    // Register message type handlers
-    message_handlers_[MessageType::WindowCreate] = [this](const Message& msg) {
-        handle_window_create_message(msg);
-    };
-    
-    message_handlers_[MessageType::WindowDestroy] = [this](const Message& msg) {
-        handle_window_destroy_message(msg);
-    };
-    
-    message_handlers_[MessageType::WindowUpdate] = [this](const Message& msg) {
-        handle_window_update_message(msg);
-    };
-    
-    message_handlers_[MessageType::BufferSubmit] = [this](const Message& msg) {
-        handle_buffer_submit_message(msg);
-    };
-    
-    message_handlers_[MessageType::BufferDamage] = [this](const Message& msg) {
-        handle_buffer_damage_message(msg);
-    };
+// Handlers are bound at compile time: MessageDispatcher builds a dense table
+// indexed by wire type from S1U_MESSAGE_SCHEMA and the handle_message
+// overloads, and parses each payload into its typed view before the call.
+DispatchResult QuantumProtocol::dispatch_message(const MessageOrigin& origin, const MessageHeader& header, const u8* payload) {
+    DispatchResult result = MessageDispatcher<QuantumProtocol>::dispatch(*this, origin, header.type, payload, header.payload_size);
+    
+    if (result == DispatchResult::Malformed) {
+        Logger::warning("Dropping malformed {} message from client {}",
+                       message_type_name(header.type), origin.client_id);
+    }
     
-    message_handlers_[MessageType::InputEvent] = [this](const Message& msg) {
-        handle_input_event_message(msg);
-    };
+    return result;
+}
+
+void QuantumProtocol::process_incoming_messages() {
+    std::vector<ClientId> client_ids;
+    std::vector<bool> local_clients;
+    std::vector<pollfd> fds;
+    {
+        std::lock_guard<std::mutex> lock(clients_mutex_);
+        client_ids.reserve(clients_.size());
+        local_clients.reserve(clients_.size());
+        fds.reserve(clients_.size());
+        for (const auto& [client_id, info] : clients_) {
+            client_ids.push_back(client_id);
+            local_clients.push_back(info.local);
+            fds.push_back({info.socket_fd, POLLIN, 0});
+        }
+        
+        // Buffers of clients removed since the last pass
+        if (receive_buffers_.size() > clients_.size()) {
+            std::erase_if(receive_buffers_, [this](const auto& entry) { return !clients_.count(entry.first); });
+        }
+    }
     
-    message_handlers_[MessageType::QuantumSync] = [this](const Message& msg) {
-        handle_quantum_sync_message(msg);
-    };
+    if (fds.empty() || poll(fds.data(), fds.size(), 0) <= 0) return;
     
-    message_handlers_[MessageType::PredictiveCache] = [this](const Message& msg) {
-        handle_predictive_cache_message(msg);
-    };
+    ReceivedMessage received;
+    for (size_t i = 0; i < fds.size(); i++) {
+        if (!(fds[i].revents & (POLLIN | POLLHUP | POLLERR))) continue;
+        
+        // One read of what the socket holds; a message still arriving waits
+        // in the client's buffer for a later pass. Local clients pass fences
+        // and buffers as SCM_RIGHTS, and every fd reaches its handler.
+        MessageReceiveBuffer& buffer = receive_buffers_[client_ids[i]];
+        bool open = buffer.read_available(fds[i].fd);
+        
+        while (buffer.next_message(received)) {
+            MessageOrigin origin;
+            origin.client_id = client_ids[i];
+            origin.fds = received.fds.data();
+            origin.fd_count = received.fd_count;
+            origin.local = local_clients[i];
+            dispatch_message(origin, received.header, received.payload.data());
+            
+            // Fds no handler took, including any sent with a message that
+            // carries none, would otherwise stay open for the server's lifetime
+            close_received_fds(received);
+        }
+        
+        if (!open || buffer.is_broken()) {
+            receive_buffers_.erase(client_ids[i]);
+            remove_client(client_ids[i]);
+        }
+    }
+}
+
+void QuantumProtocol::handle_message(MessageTag<MessageType::WindowCreate>, const MessageOrigin& origin,
+                                     const RawPayload& payload) {
+    handle_window_create_message(origin, payload);
+}
+
+void QuantumProtocol::handle_message(MessageTag<MessageType::WindowDestroy>, const MessageOrigin& origin,
+                                     const RawPayload& payload) {
+    handle_window_destroy_message(origin, payload);
+}
+
+void QuantumProtocol::handle_message(MessageTag<MessageType::WindowUpdate>, const MessageOrigin& origin,
+                                     const RawPayload& payload) {
+    handle_window_update_message(origin, payload);
+}
+
+void QuantumProtocol::handle_message(MessageTag<MessageType::InputEvent>, const MessageOrigin& origin,
+                                     const RawPayload& payload) {
+    handle_input_event_message(origin, payload);
+}
+
+void QuantumProtocol::handle_message(MessageTag<MessageType::QuantumSync>, const MessageOrigin& origin,
+                                     const RawPayload& payload) {
+    handle_quantum_sync_message(origin, payload);
+}
+
+void QuantumProtocol::handle_message(MessageTag<MessageType::PredictiveCache>, const MessageOrigin& origin,
+                                     const RawPayload& payload) {
+    handle_predictive_cache_message(origin, payload);
 }
 
 void QuantumProtocol::start_protocol_threads() {
@@ -647,21 +843,29 @@ void QuantumProtocol::protocol_main_loop() {
     Logger::info("Protocol main loop started");
     
     while (running_) {
-        // Process io_uring completions
-        process_io_uring_completions();
-        
         // Process client connections
         process_client_connections();
         
         // Process incoming messages
         process_incoming_messages();
         
-        // Process outgoing messages
-        process_outgoing_messages();
+        // Drain shared-memory rings of local clients
+        process_shm_channels();
+        
+        // Promote buffers whose acquire fences signaled and hand back released ones
+        buffer_sync_->poll_acquire_fences();
+        send_buffer_release_events();
         
-        // Yield if no work
+        // Deliver frame-done callbacks and presentation feedback
+        send_presentation_events();
+        
+        // Yield if no work; local clients wake us through their doorbells
         if (!has_pending_work()) {
-            std::this_thread::yield();
+            if (shm_channels_.empty()) {
+                std::this_thread::yield();
+            } else {
+                wait_for_shm_channels(SHM_IDLE_WAIT_MS);
+            }
         }
     }
     
@@ -713,15 +917,153 @@ void QuantumProtocol::statistics_collection_loop() {
     }
 }
 
-// Implementation stubs for complex functions
+void QuantumProtocol::rdma_handling_loop() {
+    // Connections are set up synchronously and no data path runs over
+    // them yet (see send_message_rdma); the thread only waits for shutdown
+    while (running_) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+}
+
+// Client connections
+
+void QuantumProtocol::process_client_connections() {
+    if (socket_fd_ >= 0) {
+        accept_clients(socket_fd_, false);
+    }
+    if (local_socket_fd_ >= 0) {
+        accept_clients(local_socket_fd_, true);
+    }
+}
+
+void QuantumProtocol::accept_clients(int listen_fd, bool local) {
+    while (true) {
+        int client_fd = accept4(listen_fd, nullptr, nullptr, SOCK_CLOEXEC);
+        if (client_fd < 0) {
+            if (errno == EINTR || errno == ECONNABORTED) continue;
+            if (errno != EAGAIN && errno != EWOULDBLOCK) {
+                Logger::warning("Failed to accept client: {}", strerror(errno));
+            }
+            return;
+        }
+        
+        size_t client_count;
+        {
+            std::lock_guard<std::mutex> lock(clients_mutex_);
+            client_count = clients_.size();
+        }
+        if (client_count >= max_clients_) {
+            close(client_fd);
+            std::lock_guard<std::mutex> lock(stats_mutex_);
+            stats_.clients_rejected++;
+            continue;
+        }
+        
+        ClientInfo info;
+        info.socket_fd = client_fd;
+        info.local = local;
+        info.supports_zero_copy = zero_copy_enabled_;
+        add_client(next_client_id_++, info);
+        
+        std::lock_guard<std::mutex> lock(stats_mutex_);
+        stats_.clients_accepted++;
+    }
+}
+
+int QuantumProtocol::get_client_socket(ClientId client_id) {
+    std::lock_guard<std::mutex> lock(clients_mutex_);
+    auto it = clients_.find(client_id);
+    return it != clients_.end() ? it->second.socket_fd : -1;
+}
+
+bool QuantumProtocol::client_supports_rdma(ClientId client_id) {
+    // No RDMA data path yet, so no client is reached over it
+    (void)client_id;
+    return false;
+}
+
+void QuantumProtocol::setup_rdma_connection(ClientId, const ClientInfo&) {
+}
+
+bool QuantumProtocol::has_pending_work() {
+    for (auto& [client_id, channel] : shm_channels_) {
+        if (!channel->incoming().is_empty()) return true;
+    }
+    return false;
+}
+
+void QuantumProtocol::cleanup_client_resources(ClientId client_id) {
+    // clients_mutex_ is held by the caller
+    auto it = clients_.find(client_id);
+    if (it != clients_.end() && it->second.socket_fd >= 0) {
+        close(it->second.socket_fd);
+        it->second.socket_fd = -1;
+    }
+}
+
+// Sending
+
+bool QuantumProtocol::send_message_standard(ClientId client_id, const CompressedMessage& message) {
+    int socket_fd = get_client_socket(client_id);
+    if (socket_fd < 0) return false;
+    
+    return send_message_with_fds(socket_fd, message.type, 0, message.data, message.size);
+}
+
 bool QuantumProtocol::send_message_zero_copy(ClientId client_id, const CompressedMessage& message) {
-    // Implementation would use io_uring with zero-copy send
-    return true;
+    // Nothing is submitted to the io_uring yet, so this is a plain send
+    return send_message_standard(client_id, message);
 }
 
 bool QuantumProtocol::send_message_rdma(ClientId client_id, const CompressedMessage& message) {
-    // Implementation would use RDMA write operations
-    return true;
+    (void)client_id;
+    (void)message;
+    return false;
+}
+
+// Client sockets and rings are read only by the protocol thread, which
+// dispatches every message to its handler; nothing is queued for callers
+bool QuantumProtocol::receive_message_standard(ClientId, CompressedMessage&) {
+    return false;
+}
+
+bool QuantumProtocol::receive_message_zero_copy(ClientId client_id, CompressedMessage& message) {
+    return receive_message_standard(client_id, message);
+}
+
+bool QuantumProtocol::receive_message_rdma(ClientId, CompressedMessage&) {
+    return false;
+}
+
+bool QuantumProtocol::broadcast_message_parallel(const Message& message) {
+    std::vector<ClientId> client_ids;
+    {
+        std::lock_guard<std::mutex> lock(clients_mutex_);
+        client_ids.reserve(clients_.size());
+        for (const auto& [client_id, info] : clients_) {
+            client_ids.push_back(client_id);
+        }
+    }
+    
+    bool success = true;
+    for (ClientId client_id : client_ids) {
+        success = send_message(client_id, message) && success;
+    }
+    return success;
+}
+
+bool QuantumProtocol::broadcast_message_quantum(const Message& message) {
+    return broadcast_message_parallel(message);
+}
+
+bool QuantumProtocol::broadcast_message_rdma(const Message& message) {
+    return broadcast_message_parallel(message);
+}
+
+// Compression, entanglement and prediction
+
+bool QuantumProtocol::should_compress_message(const Message& message) const {
+    return message.size >= 1024;
 }
 
 bool QuantumProtocol::compress_message_neural(const Message& input, CompressedMessage& output) {
@@ -729,11 +1071,355 @@ bool QuantumProtocol::compress_message_neural(const Message& input, CompressedMe
     return neural_compressor_->compress(input, output);
 }
 
+bool QuantumProtocol::decompress_message_neural(const CompressedMessage& input, Message& output) {
+    if (!neural_compressor_) return false;
+    return neural_compressor_->decompress(input, output);
+}
+
 void QuantumProtocol::apply_quantum_entanglement(ClientId client_id, CompressedMessage& message) {
     if (!quantum_coherence_system_) return;
     quantum_coherence_system_->entangle_message(client_id, message);
 }
 
+void QuantumProtocol::apply_quantum_deentanglement(ClientId client_id, CompressedMessage& message) {
+    if (!quantum_coherence_system_) return;
+    quantum_coherence_system_->disentangle_message(client_id, message);
+}
+
+// The coherence and prediction systems never initialize (see the top of
+// this file), so their threads never start and these hooks have no state
+// to work on
+void QuantumProtocol::initialize_quantum_pairs() {}
+void QuantumProtocol::initialize_client_quantum_state(ClientId) {}
+void QuantumProtocol::maintain_quantum_coherence() {}
+void QuantumProtocol::update_quantum_pairs() {}
+void QuantumProtocol::optimize_quantum_channels() {}
+void QuantumProtocol::initialize_client_prediction_model(ClientId) {}
+void QuantumProtocol::run_predictive_models() {}
+void QuantumProtocol::cache_predicted_data() {}
+void QuantumProtocol::cleanup_expired_predictions() {}
+void QuantumProtocol::learn_from_send_performance(ClientId, const Message&, f64, bool) {}
+void QuantumProtocol::optimize_neural_compression_for_speed() {}
+void QuantumProtocol::optimize_neural_compression_for_compression() {}
+
+// The ring is not used for I/O yet and the pool is handed out whole, so
+// there is nothing to retune
+void QuantumProtocol::initialize_buffer_management() {}
+void QuantumProtocol::optimize_io_uring_for_latency() {}
+void QuantumProtocol::optimize_io_uring_for_throughput() {}
+void QuantumProtocol::optimize_memory_pool_for_latency() {}
+void QuantumProtocol::optimize_memory_pool_for_throughput() {}
+
+// Window and input requests have no consumer in this server yet
+void QuantumProtocol::handle_window_create_message(const MessageOrigin&, const RawPayload&) {}
+void QuantumProtocol::handle_window_destroy_message(const MessageOrigin&, const RawPayload&) {}
+void QuantumProtocol::handle_window_update_message(const MessageOrigin&, const RawPayload&) {}
+void QuantumProtocol::handle_input_event_message(const MessageOrigin&, const RawPayload&) {}
+void QuantumProtocol::handle_quantum_sync_message(const MessageOrigin&, const RawPayload&) {}
+void QuantumProtocol::handle_predictive_cache_message(const MessageOrigin&, const RawPayload&) {}
+
+// Statistics
+
+void QuantumProtocol::update_send_statistics(f64 send_time_ns, u32 size, bool success) {
+    std::lock_guard<std::mutex> lock(stats_mutex_);
+    if (!success) {
+        stats_.send_failures++;
+        return;
+    }
+    
+    stats_.messages_sent++;
+    stats_.bytes_sent += size;
+    stats_.average_send_time_ns += (send_time_ns - stats_.average_send_time_ns) / stats_.messages_sent;
+}
+
+void QuantumProtocol::update_receive_statistics(f64 receive_time_ns, u32 size, bool success) {
+    if (!success) return;
+    
+    std::lock_guard<std::mutex> lock(stats_mutex_);
+    stats_.messages_received++;
+    stats_.bytes_received += size;
+    stats_.average_receive_time_ns +=
+        (receive_time_ns - stats_.average_receive_time_ns) / stats_.messages_received;
+}
+
+void QuantumProtocol::collect_statistics() {
+    u32 active_clients;
+    {
+        std::lock_guard<std::mutex> lock(clients_mutex_);
+        active_clients = static_cast<u32>(clients_.size());
+    }
+    
+    std::lock_guard<std::mutex> lock(stats_mutex_);
+    stats_.active_clients = active_clients;
+}
+
+// Cleanup
+
+void QuantumProtocol::cleanup_socket() {
+    if (socket_fd_ >= 0) {
+        close(socket_fd_);
+        socket_fd_ = -1;
+    }
+    
+    if (local_socket_fd_ >= 0) {
+        close(local_socket_fd_);
+        local_socket_fd_ = -1;
+        unlink(local_socket_path_.c_str());
+    }
+    
+    std::lock_guard<std::mutex> lock(clients_mutex_);
+    for (auto& [client_id, info] : clients_) {
+        if (info.socket_fd >= 0) {
+            close(info.socket_fd);
+        }
+    }
+    clients_.clear();
+    shm_channels_.clear();
+}
+
+void QuantumProtocol::cleanup_io_uring() {
+    if (io_uring_fd_ >= 0) {
+        close(io_uring_fd_);
+        io_uring_fd_ = -1;
+    }
+}
+
+void QuantumProtocol::cleanup_memory_pool() {
+    if (shared_memory_pool_) {
+        munlock(shared_memory_pool_, buffer_pool_size_);
+        S1U::unmap_huge_pages(shared_memory_pool_, buffer_pool_size_);
+        shared_memory_pool_ = nullptr;
+    }
+}
+
+void QuantumProtocol::cleanup_rdma() {
+#ifdef S1U_HAVE_RDMACM
+    if (rdma_context_) {
+        rdma_destroy_id(rdma_context_);
+        rdma_context_ = nullptr;
+    }
+#endif
+    rdma_enabled_ = false;
+}
+
+void QuantumProtocol::cleanup_quantum_entanglement() {
+    quantum_coherence_system_.reset();
+    if (quantum_state_buffer_) {
+        munmap(quantum_state_buffer_, QUANTUM_STATE_BUFFER_SIZE);
+        quantum_state_buffer_ = nullptr;
+    }
+    quantum_entanglement_enabled_ = false;
+}
+
+void QuantumProtocol::cleanup_neural_compression() {
+    neural_compressor_.reset();
+    neural_compression_enabled_ = false;
+}
+
+void QuantumProtocol::cleanup_predictive_streaming() {
+    prediction_engine_.reset();
+    predictive_streaming_enabled_ = false;
+}
+
+void QuantumProtocol::handle_message(MessageTag<MessageType::BufferSubmit>, const MessageOrigin& origin,
+                                     const BufferSubmitPayload& payload) {
+    // The acquire fence arrives as SCM_RIGHTS ancillary data with the
+    // message; any other fd is closed by the receive loop. Latching without
+    // it could scan out a buffer the client is still rendering, so a flagged
+    // fence that did not arrive (always the case over TCP) rejects the buffer.
+    SyncFence acquire_fence;
+    if (payload.flags & BUFFER_SUBMIT_HAS_ACQUIRE_FENCE) {
+        int fence_fd = origin.take_fd(0);
+        if (fence_fd < 0) {
+            Logger::warning("Client {} flagged an acquire fence for buffer {} but sent none",
+                           origin.client_id, payload.buffer_id);
+            return;
+        }
+        acquire_fence = SyncFence::adopt(fence_fd);
+    }
+    
+    // A release fence could not reach a remote client; it gets the plain
+    // release every client accepts
+    BufferSubmitPayload submit = payload;
+    if (!origin.local) {
+        submit.flags &= ~BUFFER_SUBMIT_WANTS_RELEASE_FENCE;
+    }
+    
+    switch (buffer_sync_->submit(origin.client_id, submit, std::move(acquire_fence))) {
+        case BufferSubmitResult::Accepted:
+            // Feedback requested before this commit now follows this buffer
+            presentation_feedback_->on_surface_committed(origin.client_id, payload.surface_id, payload.buffer_id);
+            break;
+        case BufferSubmitResult::StillQueued:
+            Logger::warning("Client {} resubmitted buffer {} before it was released",
+                           origin.client_id, payload.buffer_id);
+            break;
+        case BufferSubmitResult::ForeignSurface:
+            Logger::warning("Client {} submitted buffer {} to surface {} it does not own",
+                           origin.client_id, payload.buffer_id, payload.surface_id);
+            break;
+    }
+}
+
+void QuantumProtocol::handle_message(MessageTag<MessageType::BufferDamage>, const MessageOrigin& origin,
+                                     const BufferDamageView& damage) {
+    // Held until the compositor repaints the surface, which coalesces it to
+    // config_.max_damage_rects
+    if (!surface_damage_->add_damage(origin.client_id, damage)) {
+        Logger::warning("Rejected damage from client {} for surface {}", origin.client_id, damage.surface_id);
+    }
+}
+
+std::shared_ptr<BufferSyncTracker> QuantumProtocol::get_buffer_sync() const {
+    return buffer_sync_;
+}
+
+std::shared_ptr<PresentationFeedbackTracker> QuantumProtocol::get_presentation_feedback() const {
+    return presentation_feedback_;
+}
+
+std::shared_ptr<SurfaceDamageTracker> QuantumProtocol::get_surface_damage() const {
+    return surface_damage_;
+}
+
+void QuantumProtocol::send_buffer_release_events() {
+    if (!buffer_sync_->has_release_events()) return;
+    
+    for (auto& event : buffer_sync_->take_release_events()) {
+        int fence_fd = event.release_fence.fd();
+        send_message_with_fds(get_client_socket(event.client_id), MessageType::BufferRelease, 0,
+                              &event.payload, sizeof(event.payload),
+                              fence_fd >= 0 ? &fence_fd : nullptr, fence_fd >= 0 ? 1 : 0);
+    }
+}
+
+void QuantumProtocol::handle_message(MessageTag<MessageType::FrameCallbackRequest>, const MessageOrigin& origin,
+                                     const SurfaceCallbackRequestPayload& request) {
+    if (!presentation_feedback_->request_frame_callback(origin.client_id, request.surface_id, request.callback_id)) {
+        Logger::warning("Rejected frame callback from client {} for surface {}", origin.client_id, request.surface_id);
+    }
+}
+
+void QuantumProtocol::handle_message(MessageTag<MessageType::PresentationFeedbackRequest>, const MessageOrigin& origin,
+                                     const SurfaceCallbackRequestPayload& request) {
+    if (!presentation_feedback_->request_feedback(origin.client_id, request.surface_id, request.callback_id)) {
+        Logger::warning("Rejected presentation feedback request from client {} for surface {}",
+                       origin.client_id, request.surface_id);
+    }
+}
+
+void QuantumProtocol::send_presentation_events() {
+    if (!presentation_feedback_->has_events()) return;
+    
+    for (const auto& event : presentation_feedback_->take_events()) {
+        Message message;
+        message.client_id = event.client_id;
+        message.type = event.type;
+        if (event.type == MessageType::FrameDone) {
+            message.data = reinterpret_cast<const u8*>(&event.frame_done);
+            message.size = sizeof(event.frame_done);
+        } else {
+            message.data = reinterpret_cast<const u8*>(&event.feedback);
+            message.size = sizeof(event.feedback);
+        }
+        send_message(event.client_id, message);
+    }
+}
+
+void QuantumProtocol::handle_message(MessageTag<MessageType::ShmTransportRequest>, const MessageOrigin& origin,
+                                     const RawPayload&) {
+    if (!config_.enable_shm_transport || shm_channels_.count(origin.client_id)) {
+        return;
+    }
+    
+    // The ring memfd and doorbells are passed as fds
+    if (!origin.local) {
+        Logger::warning("Client {} requested shared memory over TCP", origin.client_id);
+        return;
+    }
+    
+    auto channel = std::make_unique<ShmChannel>();
+    if (!channel->create_server(config_.shm_ring_capacity)) {
+        Logger::warning("Failed to create shared-memory channel for client {}", origin.client_id);
+        return;
+    }
+    
+    // The socket stays open for setup, fd passing and as the fallback path
+    if (!channel->send_setup(get_client_socket(origin.client_id))) {
+        Logger::warning("Failed to send shared-memory setup to client {}", origin.client_id);
+        return;
+    }
+    
+    shm_channels_[origin.client_id] = std::move(channel);
+    Logger::info("Client {} switched to shared-memory transport ({} KB rings)",
+                origin.client_id, config_.shm_ring_capacity / 1024);
+}
+
+ShmChannel* QuantumProtocol::find_shm_channel(ClientId client_id) {
+    auto it = shm_channels_.find(client_id);
+    return it != shm_channels_.end() ? it->second.get() : nullptr;
+}
+
+bool QuantumProtocol::send_message_shm(ShmChannel& channel, const CompressedMessage& message) {
+    // A full ring means the client is not keeping up; let the caller retry
+    return channel.outgoing().try_write(message.type, 0, message.data, message.size);
+}
+
+void QuantumProtocol::process_shm_channels() {
+    for (auto it = shm_channels_.begin(); it != shm_channels_.end();) {
+        // Rings are only set up over the Unix socket
+        MessageOrigin origin;
+        origin.client_id = it->first;
+        origin.local = true;
+        
+        ShmRing& incoming = it->second->incoming();
+        incoming.drain([this, &origin](const MessageHeader& header, const u8* payload) {
+            dispatch_message(origin, header, payload);
+        });
+        
+        // A client that corrupts its ring keeps only the socket path
+        if (incoming.is_broken()) {
+            Logger::warning("Client {} corrupted its shared-memory ring, closing the channel", it->first);
+            it = shm_channels_.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+void QuantumProtocol::wait_for_shm_channels(i32 timeout_ms) {
+    // Announce sleep on every ring so producers ring the doorbell, and block
+    // on the doorbells plus the listening sockets. The timeout bounds how long
+    // work arriving by other paths waits.
+    std::vector<pollfd> fds;
+    fds.reserve(shm_channels_.size() + 2);
+    bool ready = false;
+    
+    for (auto& [client_id, channel] : shm_channels_) {
+        if (!channel->incoming().prepare_wait()) {
+            ready = true;
+        }
+        fds.push_back({channel->incoming().doorbell_fd(), POLLIN, 0});
+    }
+    if (socket_fd_ >= 0) {
+        fds.push_back({socket_fd_, POLLIN, 0});
+    }
+    if (local_socket_fd_ >= 0) {
+        fds.push_back({local_socket_fd_, POLLIN, 0});
+    }
+    
+    if (!ready) {
+        int result;
+        do {
+            result = poll(fds.data(), fds.size(), timeout_ms);
+        } while (result == -1 && errno == EINTR);
+    }
+    
+    for (auto& [client_id, channel] : shm_channels_) {
+        channel->incoming().finish_wait();
+    }
+}
+
 // Additional implementation stubs would go here...
 
 } // namespace s1u
@@ -0,0 +1,324 @@
+#include "s1u/shm_ring.hpp"
+#include "s1u/protocol_socket.hpp"
+#include <sys/eventfd.h>
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <immintrin.h>
+#include <unistd.h>
+#include <cerrno>
+#include <cstring>
+#include <new>
+
+namespace s1u {
+
+namespace {
+
+constexpr u32 SHM_RING_MAGIC = 0x53315552; // "S1UR"
+constexpr u32 SHM_RING_VERSION = 1;
+constexpr u32 SHM_RECORD_WRAP = 0;          // marker type: skip to ring start
+constexpr u32 SHM_RECORD_ALIGNMENT = 16;
+constexpr u32 SHM_MIN_RING_CAPACITY = 4096;
+constexpr u32 SHM_SPIN_ITERATIONS = 256;     // brief spin before announcing sleep
+
+constexpr size_t control_size() {
+    return (sizeof(ShmRingControl) + 63) & ~size_t(63);
+}
+
+constexpr u64 record_size(u32 payload_size) {
+    return (sizeof(MessageHeader) + payload_size + SHM_RECORD_ALIGNMENT - 1) & ~u64(SHM_RECORD_ALIGNMENT - 1);
+}
+
+bool is_valid_capacity(u32 capacity) {
+    return capacity >= SHM_MIN_RING_CAPACITY && (capacity & (capacity - 1)) == 0;
+}
+
+} // namespace
+
+size_t ShmRing::region_size_for(u32 capacity) {
+    return control_size() + capacity;
+}
+
+void ShmRing::attach(void* region, size_t region_size, int doorbell_fd) {
+    control_ = static_cast<ShmRingControl*>(region);
+    data_ = static_cast<u8*>(region) + control_size();
+    capacity_ = region_size > control_size() ? static_cast<u32>(region_size - control_size()) : 0;
+    doorbell_fd_ = doorbell_fd;
+    cached_tail_ = 0;
+    broken_ = false;
+}
+
+void ShmRing::initialize_control(u32 capacity) {
+    new (control_) ShmRingControl();
+    control_->capacity = capacity;
+    control_->version = SHM_RING_VERSION;
+    control_->magic = SHM_RING_MAGIC;
+    capacity_ = capacity;
+}
+
+bool ShmRing::is_valid() const {
+    return control_ && control_->magic == SHM_RING_MAGIC && control_->version == SHM_RING_VERSION &&
+           control_->capacity == capacity_ && is_valid_capacity(capacity_);
+}
+
+size_t ShmRing::max_payload_size() const {
+    return capacity_ / 2 - sizeof(MessageHeader);
+}
+
+bool ShmRing::try_write(MessageType type, u32 sequence, const void* payload, u32 payload_size) {
+    if (payload_size > max_payload_size()) {
+        return false;
+    }
+
+    const u64 record = record_size(payload_size);
+    u64 head = control_->head.load(std::memory_order_relaxed);
+    u32 offset = static_cast<u32>(head & (capacity_ - 1));
+    u32 contiguous = capacity_ - offset;
+    u64 needed = record + (contiguous < record ? contiguous : 0);
+
+    if (capacity_ - (head - cached_tail_) < needed) {
+        cached_tail_ = control_->tail.load(std::memory_order_acquire);
+        if (capacity_ - (head - cached_tail_) < needed) {
+            return false;
+        }
+    }
+
+    if (contiguous < record) {
+        MessageHeader wrap;
+        wrap.type = SHM_RECORD_WRAP;
+        std::memcpy(data_ + offset, &wrap, sizeof(wrap));
+        head += contiguous;
+        offset = 0;
+    }
+
+    MessageHeader header;
+    header.type = static_cast<u32>(type);
+    header.payload_size = payload_size;
+    header.sequence = sequence;
+    std::memcpy(data_ + offset, &header, sizeof(header));
+    if (payload_size > 0) {
+        std::memcpy(data_ + offset + sizeof(header), payload, payload_size);
+    }
+
+    control_->head.store(head + record, std::memory_order_release);
+
+    // Pairs with the fence in wait(): either the consumer sees the new head
+    // before sleeping, or we see its sleeping flag and ring the doorbell.
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (control_->consumer_sleeping.load(std::memory_order_relaxed)) {
+        eventfd_write(doorbell_fd_, 1);
+        doorbells_rung_++;
+    } else {
+        doorbells_skipped_++;
+    }
+
+    return true;
+}
+
+size_t ShmRing::drain(const std::function<void(const MessageHeader&, const u8*)>& handler, size_t max_records) {
+    if (broken_) {
+        return 0;
+    }
+
+    u64 tail = control_->tail.load(std::memory_order_relaxed);
+    const u64 head = control_->head.load(std::memory_order_acquire);
+    size_t consumed = 0;
+
+    // head is written by the peer; nothing in the ring can be trusted once
+    // it claims more than a full ring
+    if (head - tail > capacity_) {
+        broken_ = true;
+        return 0;
+    }
+
+    if (scratch_.empty()) {
+        scratch_.resize(max_payload_size());
+    }
+
+    while (tail != head && consumed < max_records) {
+        u32 offset = static_cast<u32>(tail & (capacity_ - 1));
+        if (head - tail < sizeof(MessageHeader)) {
+            broken_ = true;
+            break;
+        }
+
+        MessageHeader header;
+        std::memcpy(&header, data_ + offset, sizeof(header));
+
+        if (header.type == SHM_RECORD_WRAP) {
+            u64 skip = capacity_ - offset;
+            if (skip > head - tail) {
+                broken_ = true;
+                break;
+            }
+            tail += skip;
+            continue;
+        }
+
+        u64 record = record_size(header.payload_size);
+        if (header.payload_size > max_payload_size() || record > head - tail || offset + record > capacity_) {
+            broken_ = true;
+            break;
+        }
+
+        // The peer can rewrite the ring at any time, so handlers parse a
+        // private copy rather than shared memory
+        std::memcpy(scratch_.data(), data_ + offset + sizeof(header), header.payload_size);
+        handler(header, scratch_.data());
+        tail += record;
+        consumed++;
+    }
+
+    control_->tail.store(tail, std::memory_order_release);
+    return consumed;
+}
+
+bool ShmRing::is_empty() const {
+    return control_->head.load(std::memory_order_acquire) == control_->tail.load(std::memory_order_relaxed);
+}
+
+bool ShmRing::prepare_wait() {
+    control_->consumer_sleeping.store(1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+
+    if (!is_empty()) {
+        control_->consumer_sleeping.store(0, std::memory_order_relaxed);
+        return false;
+    }
+    return true;
+}
+
+void ShmRing::finish_wait() {
+    eventfd_t value;
+    eventfd_read(doorbell_fd_, &value);
+    control_->consumer_sleeping.store(0, std::memory_order_relaxed);
+}
+
+bool ShmRing::wait(i32 timeout_ms) {
+    for (u32 i = 0; i < SHM_SPIN_ITERATIONS; i++) {
+        if (!is_empty()) {
+            return true;
+        }
+        _mm_pause();
+    }
+
+    if (!prepare_wait()) {
+        return true;
+    }
+
+    struct pollfd pfd;
+    pfd.fd = doorbell_fd_;
+    pfd.events = POLLIN;
+    pfd.revents = 0;
+
+    int result;
+    do {
+        result = poll(&pfd, 1, timeout_ms);
+    } while (result == -1 && errno == EINTR);
+
+    finish_wait();
+    return !is_empty();
+}
+
+ShmChannel::~ShmChannel() {
+    close_channel();
+}
+
+bool ShmChannel::map_rings(int memfd, u32 ring_capacity) {
+    size_t ring_region = ShmRing::region_size_for(ring_capacity);
+    mapping_size_ = ring_region * 2;
+
+    void* mapping = mmap(nullptr, mapping_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, memfd, 0);
+    if (mapping == MAP_FAILED) {
+        mapping_size_ = 0;
+        return false;
+    }
+
+    mapping_ = mapping;
+    ring_capacity_ = ring_capacity;
+
+    client_to_server_.attach(mapping_, ring_region, client_to_server_doorbell_);
+    server_to_client_.attach(static_cast<u8*>(mapping_) + ring_region, ring_region, server_to_client_doorbell_);
+    return true;
+}
+
+bool ShmChannel::create_server(u32 ring_capacity) {
+    if (!is_valid_capacity(ring_capacity)) {
+        return false;
+    }
+
+    is_server_ = true;
+    memfd_ = memfd_create("s1u-shm-transport", MFD_CLOEXEC | MFD_ALLOW_SEALING);
+    if (memfd_ < 0) {
+        return false;
+    }
+
+    if (ftruncate(memfd_, static_cast<off_t>(ShmRing::region_size_for(ring_capacity) * 2)) != 0) {
+        close_channel();
+        return false;
+    }
+
+    // The client must never be able to shrink the file under our mapping;
+    // without the seals a truncate would turn our reads into SIGBUS
+    if (fcntl(memfd_, F_ADD_SEALS, F_SEAL_SHRINK | F_SEAL_GROW | F_SEAL_SEAL) != 0) {
+        close_channel();
+        return false;
+    }
+
+    client_to_server_doorbell_ = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+    server_to_client_doorbell_ = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+    if (client_to_server_doorbell_ < 0 || server_to_client_doorbell_ < 0 || !map_rings(memfd_, ring_capacity)) {
+        close_channel();
+        return false;
+    }
+
+    client_to_server_.initialize_control(ring_capacity);
+    server_to_client_.initialize_control(ring_capacity);
+    return true;
+}
+
+bool ShmChannel::attach_client(int memfd, int client_to_server_doorbell, int server_to_client_doorbell, u32 ring_capacity) {
+    is_server_ = false;
+    memfd_ = memfd;
+    client_to_server_doorbell_ = client_to_server_doorbell;
+    server_to_client_doorbell_ = server_to_client_doorbell;
+
+    if (!is_valid_capacity(ring_capacity) || !map_rings(memfd_, ring_capacity) ||
+        !client_to_server_.is_valid() || !server_to_client_.is_valid()) {
+        close_channel();
+        return false;
+    }
+
+    return true;
+}
+
+bool ShmChannel::send_setup(int socket_fd) const {
+    ShmTransportSetupPayload payload;
+    payload.ring_capacity = ring_capacity_;
+    payload.version = SHM_RING_VERSION;
+
+    const int fds[3] = {memfd_, client_to_server_doorbell_, server_to_client_doorbell_};
+    return send_message_with_fds(socket_fd, MessageType::ShmTransportSetup, 0,
+                                 &payload, sizeof(payload), fds, 3);
+}
+
+void ShmChannel::close_channel() {
+    if (mapping_) {
+        munmap(mapping_, mapping_size_);
+        mapping_ = nullptr;
+        mapping_size_ = 0;
+    }
+
+    for (int* fd : {&memfd_, &client_to_server_doorbell_, &server_to_client_doorbell_}) {
+        if (*fd >= 0) {
+            close(*fd);
+            *fd = -1;
+        }
+    }
+
+    client_to_server_ = ShmRing();
+    server_to_client_ = ShmRing();
+    ring_capacity_ = 0;
+}
+
+} // namespace s1u
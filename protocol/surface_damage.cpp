@@ -0,0 +1,92 @@
+#include "s1u/surface_damage.hpp"
+#include <algorithm>
+
+namespace s1u {
+
+bool SurfaceDamageTracker::add_damage(ClientId client_id, const BufferDamageView& damage) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = surfaces_.find(damage.surface_id);
+    if (it == surfaces_.end()) {
+        u32& count = client_surface_counts_[client_id];
+        if (count >= MAX_CLIENT_SURFACES) {
+            stats_.updates_rejected++;
+            return false;
+        }
+        count++;
+        it = surfaces_.try_emplace(damage.surface_id).first;
+        it->second.owner = client_id;
+    } else if (it->second.owner != client_id) {
+        stats_.updates_rejected++;
+        return false;
+    }
+
+    SurfaceState& surface = it->second;
+    surface.region.add(damage.region);
+    if (surface.region.rects().size() > MAX_PENDING_DAMAGE_RECTS) {
+        surface.region.coalesce(max_rects_);
+        stats_.early_coalesces++;
+    }
+
+    stats_.updates_accepted++;
+    return true;
+}
+
+DamageRegion SurfaceDamageTracker::take_damage(u32 surface_id) {
+    DamageRegion damage;
+    u32 max_rects;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = surfaces_.find(surface_id);
+        if (it == surfaces_.end()) {
+            return damage;
+        }
+
+        damage = std::move(it->second.region);
+        erase_surface(it);
+        stats_.regions_taken++;
+        max_rects = max_rects_;
+    }
+
+    // Coalesced outside the lock so the protocol thread is not held up
+    damage.coalesce(max_rects);
+    return damage;
+}
+
+void SurfaceDamageTracker::erase_surface(std::unordered_map<u32, SurfaceState>::iterator it) {
+    auto count = client_surface_counts_.find(it->second.owner);
+    if (count != client_surface_counts_.end() && --count->second == 0) {
+        client_surface_counts_.erase(count);
+    }
+    surfaces_.erase(it);
+}
+
+void SurfaceDamageTracker::remove_surface(u32 surface_id) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = surfaces_.find(surface_id);
+    if (it != surfaces_.end()) {
+        erase_surface(it);
+    }
+}
+
+void SurfaceDamageTracker::drop_client(ClientId client_id) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (auto it = surfaces_.begin(); it != surfaces_.end();) {
+        if (it->second.owner == client_id) {
+            erase_surface(it++);
+        } else {
+            ++it;
+        }
+    }
+}
+
+void SurfaceDamageTracker::set_max_rects(u32 max_rects) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    max_rects_ = std::clamp<u32>(max_rects, 1, MAX_DAMAGE_RECTS);
+}
+
+SurfaceDamageStats SurfaceDamageTracker::get_statistics() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return stats_;
+}
+
+} // namespace s1u
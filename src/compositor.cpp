@@ -3,6 +3,7 @@
 #include <iostream>
 #include <algorithm>
 #include <chrono>
+#include <cstring>
 #include <thread>
 
 #ifndef M_PI
@@ -104,6 +105,7 @@ const CompositorSettings& Compositor::get_settings() const {
 void Compositor::add_window(std::shared_ptr<Window> window) {
     if (window) {
         windows_.push_back(window);
+        readback_full_ = true;
     }
 }
 
@@ -111,12 +113,30 @@ void Compositor::remove_window(std::shared_ptr<Window> window) {
     auto it = std::find(windows_.begin(), windows_.end(), window);
     if (it != windows_.end()) {
         windows_.erase(it);
+        readback_full_ = true;
+    }
+    
+    // Feedback still pending on the window's surface is reported as
+    // discarded, and damage it never repainted is dropped
+    uint32_t surface_id = window ? window->get_properties().surface_id : 0;
+    if (surface_id != 0) {
+        surface_visibility_.erase(surface_id);
+        if (presentation_feedback_) {
+            presentation_feedback_->remove_surface(surface_id);
+        }
+        if (surface_damage_) {
+            surface_damage_->remove_surface(surface_id);
+        }
     }
 }
 
 void Compositor::update_window(std::shared_ptr<Window> window) {
     // Update window state if needed
     // This is called when window properties change
+    
+    // Moves, resizes and restacking change the screen without any client
+    // damage, so the next readback takes all of it
+    readback_full_ = true;
 }
 
 void Compositor::render_window(std::shared_ptr<Window> window) {
@@ -139,6 +159,28 @@ void Compositor::begin_composition() {
 void Compositor::compose_frame() {
     if (!initialized_ || !renderer_) return;
     
+    // Take the newest client buffers whose acquire fences have signaled
+    if (buffer_sync_) {
+        buffer_latches_.clear();
+        buffer_sync_->latch_frame(buffer_latches_);
+        
+        // Feedback requested for the latched commits now waits on this frame;
+        // commits replaced before they were ever shown report theirs discarded
+        latched_surfaces_.clear();
+        for (const BufferLatch& latch : buffer_latches_) {
+            if (!latch.superseded) {
+                latched_surfaces_.push_back(latch.surface_id);
+                if (presentation_feedback_) {
+                    presentation_feedback_->on_surface_latched(latch.surface_id, latch.buffer_id);
+                }
+            } else if (presentation_feedback_) {
+                presentation_feedback_->on_frame_discarded(latch.surface_id, latch.buffer_id);
+            }
+        }
+    
+        collect_frame_damage();
+    }
+    
     // Render background
     render_background();
     
@@ -152,6 +194,9 @@ void Compositor::compose_frame() {
 void Compositor::end_composition() {
     if (!initialized_ || !renderer_) return;
     
+    // Remote display copies the composed frame before it leaves the target
+    read_back_frame();
+    
     // Unbind framebuffer
     glBindFramebuffer(GL_FRAMEBUFFER, 0);
     
@@ -165,10 +210,43 @@ void Compositor::present_frame() {
     // Present the composed frame
     renderer_->present();
     
+    // Buffers displaced by this frame's latches go back to their clients
+    if (buffer_sync_) {
+        buffer_sync_->end_frame();
+    }
+    
     // Update frame timing
     update_frame_timing();
     
     frame_count_++;
+    
+    // Tell clients when their content reached the screen
+    if (presentation_feedback_) {
+        PresentationTiming timing;
+        timing.present_time_ns = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count());
+        timing.refresh_interval_ns = settings_.max_fps > 0 ? 1000000000ULL / settings_.max_fps : 0;
+        timing.sequence = frame_count_;
+        timing.flags = settings_.enable_vsync ? PRESENTATION_VSYNC : PRESENTATION_NONE;
+        presentation_feedback_->on_frame_presented(timing);
+    }
+}
+
+void Compositor::set_presentation_feedback(std::shared_ptr<PresentationFeedbackTracker> tracker) {
+    presentation_feedback_ = std::move(tracker);
+}
+
+void Compositor::set_buffer_sync(std::shared_ptr<BufferSyncTracker> tracker) {
+    buffer_sync_ = std::move(tracker);
+}
+
+void Compositor::set_surface_damage(std::shared_ptr<SurfaceDamageTracker> tracker) {
+    surface_damage_ = std::move(tracker);
+}
+
+void Compositor::set_frame_readback(FrameReadbackCallback callback) {
+    frame_readback_ = std::move(callback);
+    readback_full_ = true;
 }
 
 void Compositor::enable_effect(CompositorEffect effect, bool enable) {
@@ -424,12 +502,92 @@ void Compositor::render_windows() {
     
     // Render all windows
     for (auto& window : windows_) {
-        if (window && window->is_visible()) {
+        if (!window) continue;
+        
+        bool visible = window->is_visible();
+        uint32_t surface_id = window->get_properties().surface_id;
+        
+        // Clients behind hidden windows get throttled frame callbacks
+        if (surface_id != 0 && presentation_feedback_) {
+            auto [state, inserted] = surface_visibility_.try_emplace(surface_id, visible);
+            if (inserted || state->second != visible) {
+                state->second = visible;
+                presentation_feedback_->set_surface_visible(surface_id, visible);
+            }
+        }
+        
+        if (visible) {
             window->render(renderer_);
         }
     }
 }
 
+void Compositor::collect_frame_damage() {
+    frame_damage_.clear();
+    if (!surface_damage_) return;
+    
+    // Each surface's damage arrives banded; clipping to the window and moving
+    // it to screen space keep it banded, so it merges into the frame's
+    // region in one sweep per surface
+    for (uint32_t surface_id : latched_surfaces_) {
+        DamageRegion damage = surface_damage_->take_damage(surface_id);
+        if (damage.is_empty()) continue;
+        
+        auto window = std::find_if(windows_.begin(), windows_.end(), [surface_id](const std::shared_ptr<Window>& candidate) {
+            return candidate && candidate->get_properties().surface_id == surface_id;
+        });
+        if (window == windows_.end()) continue;
+        
+        const WindowProperties& properties = (*window)->get_properties();
+        damage.intersect(DamageRect{0, 0, static_cast<int32_t>(properties.width), static_cast<int32_t>(properties.height)});
+        damage.translate(properties.x, properties.y);
+        frame_damage_.add(damage);
+    }
+}
+
+void Compositor::read_back_frame() {
+    if (!frame_readback_ || main_target_.fbo == 0) return;
+    
+    uint32_t width = main_target_.width;
+    uint32_t height = main_target_.height;
+    uint32_t stride = width * 4;
+    if (readback_pixels_.size() != size_t(stride) * height) {
+        readback_pixels_.assign(size_t(stride) * height, 0);
+        readback_full_ = true;
+    }
+    
+    DamageRect screen{0, 0, static_cast<int32_t>(width), static_cast<int32_t>(height)};
+    if (readback_full_) {
+        readback_damage_.clear();
+        readback_damage_.add(screen);
+        readback_full_ = false;
+    } else {
+        readback_damage_ = frame_damage_;
+        readback_damage_.intersect(screen);
+    }
+    
+    // Only the rows the damage spans come back from the GPU. GL returns them
+    // bottom-up, so they are flipped into the top-down copy of the screen.
+    if (!readback_damage_.is_empty()) {
+        DamageRect extents = readback_damage_.extents();
+        uint32_t rows = static_cast<uint32_t>(extents.y2 - extents.y1);
+        uint32_t row_bytes = static_cast<uint32_t>(extents.x2 - extents.x1) * 4;
+        readback_rows_.resize(size_t(row_bytes) * rows);
+        
+        glBindFramebuffer(GL_READ_FRAMEBUFFER, main_target_.fbo);
+        glPixelStorei(GL_PACK_ALIGNMENT, 4);
+        glReadPixels(extents.x1, static_cast<int32_t>(height) - extents.y2, extents.x2 - extents.x1, rows,
+                     GL_BGRA, GL_UNSIGNED_BYTE, readback_rows_.data());
+        
+        for (uint32_t row = 0; row < rows; row++) {
+            size_t offset = size_t(extents.y2 - 1 - row) * stride + size_t(extents.x1) * 4;
+            std::memcpy(&readback_pixels_[offset], &readback_rows_[size_t(row) * row_bytes], row_bytes);
+        }
+    }
+    
+    frame_readback_(readback_pixels_.data(), width, height, stride, readback_damage_);
+}
+
 void Compositor::apply_post_effects() {
     if (!renderer_) return;
     
@@ -557,6 +715,7 @@ void Compositor::apply_su1_effects(std::shared_ptr<Window> window) {
 #include <iostream>
 #include <algorithm>
 #include <chrono>
+#include <cstring>
 #include <thread>
 
 #ifndef M_PI
@@ -658,6 +817,7 @@ const CompositorSettings& Compositor::get_settings() const {
 void Compositor::add_window(std::shared_ptr<Window> window) {
     if (window) {
         windows_.push_back(window);
+        readback_full_ = true;
     }
 }
 
@@ -665,12 +825,30 @@ void Compositor::remove_window(std::shared_ptr<Window> window) {
     auto it = std::find(windows_.begin(), windows_.end(), window);
     if (it != windows_.end()) {
         windows_.erase(it);
+        readback_full_ = true;
+    }
+    
+    // Feedback still pending on the window's surface is reported as
+    // discarded, and damage it never repainted is dropped
+    uint32_t surface_id = window ? window->get_properties().surface_id : 0;
+    if (surface_id != 0) {
+        surface_visibility_.erase(surface_id);
+        if (presentation_feedback_) {
+            presentation_feedback_->remove_surface(surface_id);
+        }
+        if (surface_damage_) {
+            surface_damage_->remove_surface(surface_id);
+        }
     }
 }
 
 void Compositor::update_window(std::shared_ptr<Window> window) {
     // Update window state if needed
     // This is called when window properties change
+    
+    // Moves, resizes and restacking change the screen without any client
+    // damage, so the next readback takes all of it
+    readback_full_ = true;
 }
 
 void Compositor::render_window(std::shared_ptr<Window> window) {
@@ -693,6 +871,28 @@ void Compositor::begin_composition() {
 void Compositor::compose_frame() {
     if (!initialized_ || !renderer_) return;
     
+    // Take the newest client buffers whose acquire fences have signaled
+    if (buffer_sync_) {
+        buffer_latches_.clear();
+        buffer_sync_->latch_frame(buffer_latches_);
+        
+        // Feedback requested for the latched commits now waits on this frame;
+        // commits replaced before they were ever shown report theirs discarded
+        latched_surfaces_.clear();
+        for (const BufferLatch& latch : buffer_latches_) {
+            if (!latch.superseded) {
+                latched_surfaces_.push_back(latch.surface_id);
+                if (presentation_feedback_) {
+                    presentation_feedback_->on_surface_latched(latch.surface_id, latch.buffer_id);
+                }
+            } else if (presentation_feedback_) {
+                presentation_feedback_->on_frame_discarded(latch.surface_id, latch.buffer_id);
+            }
+        }
+    
+        collect_frame_damage();
+    }
+    
     // Render background
     render_background();
     
@@ -706,6 +906,9 @@ void Compositor::compose_frame() {
 void Compositor::end_composition() {
     if (!initialized_ || !renderer_) return;
     
+    // Remote display copies the composed frame before it leaves the target
+    read_back_frame();
+    
     // Unbind framebuffer
     glBindFramebuffer(GL_FRAMEBUFFER, 0);
     
@@ -719,10 +922,43 @@ void Compositor::present_frame() {
     // Present the composed frame
     renderer_->present();
     
+    // Buffers displaced by this frame's latches go back to their clients
+    if (buffer_sync_) {
+        buffer_sync_->end_frame();
+    }
+    
     // Update frame timing
     update_frame_timing();
     
     frame_count_++;
+    
+    // Tell clients when their content reached the screen
+    if (presentation_feedback_) {
+        PresentationTiming timing;
+        timing.present_time_ns = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count());
+        timing.refresh_interval_ns = settings_.max_fps > 0 ? 1000000000ULL / settings_.max_fps : 0;
+        timing.sequence = frame_count_;
+        timing.flags = settings_.enable_vsync ? PRESENTATION_VSYNC : PRESENTATION_NONE;
+        presentation_feedback_->on_frame_presented(timing);
+    }
+}
+
+void Compositor::set_presentation_feedback(std::shared_ptr<PresentationFeedbackTracker> tracker) {
+    presentation_feedback_ = std::move(tracker);
+}
+
+void Compositor::set_buffer_sync(std::shared_ptr<BufferSyncTracker> tracker) {
+    buffer_sync_ = std::move(tracker);
+}
+
+void Compositor::set_surface_damage(std::shared_ptr<SurfaceDamageTracker> tracker) {
+    surface_damage_ = std::move(tracker);
+}
+
+void Compositor::set_frame_readback(FrameReadbackCallback callback) {
+    frame_readback_ = std::move(callback);
+    readback_full_ = true;
 }
 
 void Compositor::enable_effect(CompositorEffect effect, bool enable) {
@@ -978,12 +1214,92 @@ void Compositor::render_windows() {
     
     // Render all windows
     for (auto& window : windows_) {
-        if (window && window->is_visible()) {
+        if (!window) continue;
+        
+        bool visible = window->is_visible();
+        uint32_t surface_id = window->get_properties().surface_id;
+        
+        // Clients behind hidden windows get throttled frame callbacks
+        if (surface_id != 0 && presentation_feedback_) {
+            auto [state, inserted] = surface_visibility_.try_emplace(surface_id, visible);
+            if (inserted || state->second != visible) {
+                state->second = visible;
+                presentation_feedback_->set_surface_visible(surface_id, visible);
+            }
+        }
+        
+        if (visible) {
             window->render(renderer_);
         }
     }
 }
 
+void Compositor::collect_frame_damage() {
+    frame_damage_.clear();
+    if (!surface_damage_) return;
+    
+    // Each surface's damage arrives banded; clipping to the window and moving
+    // it to screen space keep it banded, so it merges into the frame's
+    // region in one sweep per surface
+    for (uint32_t surface_id : latched_surfaces_) {
+        DamageRegion damage = surface_damage_->take_damage(surface_id);
+        if (damage.is_empty()) continue;
+        
+        auto window = std::find_if(windows_.begin(), windows_.end(), [surface_id](const std::shared_ptr<Window>& candidate) {
+            return candidate && candidate->get_properties().surface_id == surface_id;
+        });
+        if (window == windows_.end()) continue;
+        
+        const WindowProperties& properties = (*window)->get_properties();
+        damage.intersect(DamageRect{0, 0, static_cast<int32_t>(properties.width), static_cast<int32_t>(properties.height)});
+        damage.translate(properties.x, properties.y);
+        frame_damage_.add(damage);
+    }
+}
+
+void Compositor::read_back_frame() {
+    if (!frame_readback_ || main_target_.fbo == 0) return;
+    
+    uint32_t width = main_target_.width;
+    uint32_t height = main_target_.height;
+    uint32_t stride = width * 4;
+    if (readback_pixels_.size() != size_t(stride) * height) {
+        readback_pixels_.assign(size_t(stride) * height, 0);
+        readback_full_ = true;
+    }
+    
+    DamageRect screen{0, 0, static_cast<int32_t>(width), static_cast<int32_t>(height)};
+    if (readback_full_) {
+        readback_damage_.clear();
+        readback_damage_.add(screen);
+        readback_full_ = false;
+    } else {
+        readback_damage_ = frame_damage_;
+        readback_damage_.intersect(screen);
+    }
+    
+    // Only the rows the damage spans come back from the GPU. GL returns them
+    // bottom-up, so they are flipped into the top-down copy of the screen.
+    if (!readback_damage_.is_empty()) {
+        DamageRect extents = readback_damage_.extents();
+        uint32_t rows = static_cast<uint32_t>(extents.y2 - extents.y1);
+        uint32_t row_bytes = static_cast<uint32_t>(extents.x2 - extents.x1) * 4;
+        readback_rows_.resize(size_t(row_bytes) * rows);
+        
+        glBindFramebuffer(GL_READ_FRAMEBUFFER, main_target_.fbo);
+        glPixelStorei(GL_PACK_ALIGNMENT, 4);
+        glReadPixels(extents.x1, static_cast<int32_t>(height) - extents.y2, extents.x2 - extents.x1, rows,
+                     GL_BGRA, GL_UNSIGNED_BYTE, readback_rows_.data());
+        
+        for (uint32_t row = 0; row < rows; row++) {
+            size_t offset = size_t(extents.y2 - 1 - row) * stride + size_t(extents.x1) * 4;
+            std::memcpy(&readback_pixels_[offset], &readback_rows_[size_t(row) * row_bytes], row_bytes);
+        }
+    }
+    
+    frame_readback_(readback_pixels_.data(), width, height, stride, readback_damage_);
+}
+
 void Compositor::apply_post_effects() {
     if (!renderer_) return;
     
@@ -1111,6 +1427,7 @@ void Compositor::apply_su1_effects(std::shared_ptr<Window> window) {
 #include <iostream>
 #include <algorithm>
 #include <chrono>
+#include <cstring>
 #include <thread>
 
 #ifndef M_PI
@@ -1212,6 +1529,7 @@ const CompositorSettings& Compositor::get_settings() const {
 void Compositor::add_window(std::shared_ptr<Window> window) {
     if (window) {
         windows_.push_back(window);
+        readback_full_ = true;
     }
 }
 
@@ -1219,12 +1537,30 @@ void Compositor::remove_window(std::shared_ptr<Window> window) {
     auto it = std::find(windows_.begin(), windows_.end(), window);
     if (it != windows_.end()) {
         windows_.erase(it);
+        readback_full_ = true;
+    }
+    
+    // Feedback still pending on the window's surface is reported as
+    // discarded, and damage it never repainted is dropped
+    uint32_t surface_id = window ? window->get_properties().surface_id : 0;
+    if (surface_id != 0) {
+        surface_visibility_.erase(surface_id);
+        if (presentation_feedback_) {
+            presentation_feedback_->remove_surface(surface_id);
+        }
+        if (surface_damage_) {
+            surface_damage_->remove_surface(surface_id);
+        }
     }
 }
 
 void Compositor::update_window(std::shared_ptr<Window> window) {
     // Update window state if needed
     // This is called when window properties change
+    
+    // Moves, resizes and restacking change the screen without any client
+    // damage, so the next readback takes all of it
+    readback_full_ = true;
 }
 
 void Compositor::render_window(std::shared_ptr<Window> window) {
@@ -1247,6 +1583,28 @@ void Compositor::begin_composition() {
 void Compositor::compose_frame() {
     if (!initialized_ || !renderer_) return;
     
+    // Take the newest client buffers whose acquire fences have signaled
+    if (buffer_sync_) {
+        buffer_latches_.clear();
+        buffer_sync_->latch_frame(buffer_latches_);
+        
+        // Feedback requested for the latched commits now waits on this frame;
+        // commits replaced before they were ever shown report theirs discarded
+        latched_surfaces_.clear();
+        for (const BufferLatch& latch : buffer_latches_) {
+            if (!latch.superseded) {
+                latched_surfaces_.push_back(latch.surface_id);
+                if (presentation_feedback_) {
+                    presentation_feedback_->on_surface_latched(latch.surface_id, latch.buffer_id);
+                }
+            } else if (presentation_feedback_) {
+                presentation_feedback_->on_frame_discarded(latch.surface_id, latch.buffer_id);
+            }
+        }
+    
+        collect_frame_damage();
+    }
+    
     // Render background
     render_background();
     
@@ -1260,6 +1618,9 @@ void Compositor::compose_frame() {
 void Compositor::end_composition() {
     if (!initialized_ || !renderer_) return;
     
+    // Remote display copies the composed frame before it leaves the target
+    read_back_frame();
+    
     // Unbind framebuffer
     glBindFramebuffer(GL_FRAMEBUFFER, 0);
     
@@ -1273,10 +1634,43 @@ void Compositor::present_frame() {
     // Present the composed frame
     renderer_->present();
     
+    // Buffers displaced by this frame's latches go back to their clients
+    if (buffer_sync_) {
+        buffer_sync_->end_frame();
+    }
+    
     // Update frame timing
     update_frame_timing();
     
     frame_count_++;
+    
+    // Tell clients when their content reached the screen
+    if (presentation_feedback_) {
+        PresentationTiming timing;
+        timing.present_time_ns = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count());
+        timing.refresh_interval_ns = settings_.max_fps > 0 ? 1000000000ULL / settings_.max_fps : 0;
+        timing.sequence = frame_count_;
+        timing.flags = settings_.enable_vsync ? PRESENTATION_VSYNC : PRESENTATION_NONE;
+        presentation_feedback_->on_frame_presented(timing);
+    }
+}
+
+void Compositor::set_presentation_feedback(std::shared_ptr<PresentationFeedbackTracker> tracker) {
+    presentation_feedback_ = std::move(tracker);
+}
+
+void Compositor::set_buffer_sync(std::shared_ptr<BufferSyncTracker> tracker) {
+    buffer_sync_ = std::move(tracker);
+}
+
+void Compositor::set_surface_damage(std::shared_ptr<SurfaceDamageTracker> tracker) {
+    surface_damage_ = std::move(tracker);
+}
+
+void Compositor::set_frame_readback(FrameReadbackCallback callback) {
+    frame_readback_ = std::move(callback);
+    readback_full_ = true;
 }
 
 void Compositor::enable_effect(CompositorEffect effect, bool enable) {
@@ -1532,12 +1926,92 @@ void Compositor::render_windows() {
     
     // Render all windows
     for (auto& window : windows_) {
-        if (window && window->is_visible()) {
+        if (!window) continue;
+        
+        bool visible = window->is_visible();
+        uint32_t surface_id = window->get_properties().surface_id;
+        
+        // Clients behind hidden windows get throttled frame callbacks
+        if (surface_id != 0 && presentation_feedback_) {
+            auto [state, inserted] = surface_visibility_.try_emplace(surface_id, visible);
+            if (inserted || state->second != visible) {
+                state->second = visible;
+                presentation_feedback_->set_surface_visible(surface_id, visible);
+            }
+        }
+        
+        if (visible) {
             window->render(renderer_);
         }
     }
 }
 
+void Compositor::collect_frame_damage() {
+    frame_damage_.clear();
+    if (!surface_damage_) return;
+    
+    // Each surface's damage arrives banded; clipping to the window and moving
+    // it to screen space keep it banded, so it merges into the frame's
+    // region in one sweep per surface
+    for (uint32_t surface_id : latched_surfaces_) {
+        DamageRegion damage = surface_damage_->take_damage(surface_id);
+        if (damage.is_empty()) continue;
+        
+        auto window = std::find_if(windows_.begin(), windows_.end(), [surface_id](const std::shared_ptr<Window>& candidate) {
+            return candidate && candidate->get_properties().surface_id == surface_id;
+        });
+        if (window == windows_.end()) continue;
+        
+        const WindowProperties& properties = (*window)->get_properties();
+        damage.intersect(DamageRect{0, 0, static_cast<int32_t>(properties.width), static_cast<int32_t>(properties.height)});
+        damage.translate(properties.x, properties.y);
+        frame_damage_.add(damage);
+    }
+}
+
+void Compositor::read_back_frame() {
+    if (!frame_readback_ || main_target_.fbo == 0) return;
+    
+    uint32_t width = main_target_.width;
+    uint32_t height = main_target_.height;
+    uint32_t stride = width * 4;
+    if (readback_pixels_.size() != size_t(stride) * height) {
+        readback_pixels_.assign(size_t(stride) * height, 0);
+        readback_full_ = true;
+    }
+    
+    DamageRect screen{0, 0, static_cast<int32_t>(width), static_cast<int32_t>(height)};
+    if (readback_full_) {
+        readback_damage_.clear();
+        readback_damage_.add(screen);
+        readback_full_ = false;
+    } else {
+        readback_damage_ = frame_damage_;
+        readback_damage_.intersect(screen);
+    }
+    
+    // Only the rows the damage spans come back from the GPU. GL returns them
+    // bottom-up, so they are flipped into the top-down copy of the screen.
+    if (!readback_damage_.is_empty()) {
+        DamageRect extents = readback_damage_.extents();
+        uint32_t rows = static_cast<uint32_t>(extents.y2 - extents.y1);
+        uint32_t row_bytes = static_cast<uint32_t>(extents.x2 - extents.x1) * 4;
+        readback_rows_.resize(size_t(row_bytes) * rows);
+        
+        glBindFramebuffer(GL_READ_FRAMEBUFFER, main_target_.fbo);
+        glPixelStorei(GL_PACK_ALIGNMENT, 4);
+        glReadPixels(extents.x1, static_cast<int32_t>(height) - extents.y2, extents.x2 - extents.x1, rows,
+                     GL_BGRA, GL_UNSIGNED_BYTE, readback_rows_.data());
+        
+        for (uint32_t row = 0; row < rows; row++) {
+            size_t offset = size_t(extents.y2 - 1 - row) * stride + size_t(extents.x1) * 4;
+            std::memcpy(&readback_pixels_[offset], &readback_rows_[size_t(row) * row_bytes], row_bytes);
+        }
+    }
+    
+    frame_readback_(readback_pixels_.data(), width, height, stride, readback_damage_);
+}
+
 void Compositor::apply_post_effects() {
     if (!renderer_) return;
     
@@ -0,0 +1,203 @@
+#include "s1u/memory_huge_pages.hpp"
+#include <linux/mman.h>
+#include <sys/mman.h>
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <fstream>
+#include <map>
+#include <mutex>
+#include <string>
+
+namespace S1U {
+
+namespace {
+
+struct HugePageMapping {
+    size_t size = 0;
+    HugePageBacking backing = HugePageBacking::Regular;
+};
+
+struct HugePageRegistry {
+    std::mutex mutex;
+    std::map<uintptr_t, HugePageMapping> mappings;
+    u64 explicit_fallbacks = 0;
+};
+
+HugePageRegistry& registry() {
+    static HugePageRegistry instance;
+    return instance;
+}
+
+// Set when the hugetlb pool ran dry and cleared when an explicit mapping
+// is returned to it, so an empty pool costs one failed mmap rather than one
+// per mapping
+std::atomic<bool> explicit_pool_exhausted{false};
+
+size_t round_to_huge_pages(size_t size) {
+    return (std::max(size, size_t(1)) + HUGE_PAGE_SIZE - 1) & ~(HUGE_PAGE_SIZE - 1);
+}
+
+void* map_explicit(size_t size) {
+    if (explicit_pool_exhausted.load(std::memory_order_relaxed)) {
+        return nullptr;
+    }
+
+    void* mapping = mmap(nullptr, size, PROT_READ | PROT_WRITE,
+                         MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB | MAP_HUGE_2MB, -1, 0);
+    if (mapping == MAP_FAILED) {
+        explicit_pool_exhausted.store(true, std::memory_order_relaxed);
+        std::lock_guard<std::mutex> lock(registry().mutex);
+        registry().explicit_fallbacks++;
+        return nullptr;
+    }
+    return mapping;
+}
+
+// Over-maps by a huge page and trims, so the result is huge page aligned
+// and the kernel can back every 2 MB of it with one page
+void* map_aligned(size_t size, bool reserve_only) {
+    size_t mapping_size = size + HUGE_PAGE_SIZE;
+    int flags = MAP_PRIVATE | MAP_ANONYMOUS | (reserve_only ? MAP_NORESERVE : 0);
+    void* mapping = mmap(nullptr, mapping_size, PROT_READ | PROT_WRITE, flags, -1, 0);
+    if (mapping == MAP_FAILED) {
+        return nullptr;
+    }
+
+    uintptr_t raw = reinterpret_cast<uintptr_t>(mapping);
+    uintptr_t aligned = (raw + HUGE_PAGE_SIZE - 1) & ~(uintptr_t(HUGE_PAGE_SIZE) - 1);
+    if (aligned > raw) {
+        munmap(mapping, aligned - raw);
+    }
+    size_t tail = raw + mapping_size - (aligned + size);
+    if (tail > 0) {
+        munmap(reinterpret_cast<void*>(aligned + size), tail);
+    }
+    return reinterpret_cast<void*>(aligned);
+}
+
+// Sum of AnonHugePages over the VMAs that start inside a transparent
+// mapping. madvise splits a VMA at the advised range, so such a VMA holds
+// only memory of that mapping or of neighbouring ones.
+u64 transparent_huge_bytes(const std::map<uintptr_t, HugePageMapping>& mappings) {
+    std::ifstream smaps("/proc/self/smaps");
+    if (!smaps) {
+        return 0;
+    }
+
+    u64 total = 0;
+    bool counting = false;
+    std::string line;
+
+    while (std::getline(smaps, line)) {
+        if (line.empty()) {
+            continue;
+        }
+
+        // VMA lines start with a lowercase hex address, field lines with a
+        // capitalised name
+        char first = line[0];
+        if ((first >= '0' && first <= '9') || (first >= 'a' && first <= 'f')) {
+            unsigned long long start = 0;
+            counting = false;
+            if (std::sscanf(line.c_str(), "%llx-", &start) == 1) {
+                auto it = mappings.upper_bound(static_cast<uintptr_t>(start));
+                if (it != mappings.begin()) {
+                    --it;
+                    counting = it->second.backing == HugePageBacking::Transparent &&
+                               start < it->first + it->second.size;
+                }
+            }
+        } else if (counting && line.compare(0, 14, "AnonHugePages:") == 0) {
+            unsigned long long kilobytes = 0;
+            if (std::sscanf(line.c_str() + 14, "%llu", &kilobytes) == 1) {
+                total += kilobytes * 1024;
+            }
+        }
+    }
+
+    return total;
+}
+
+} // namespace
+
+void* map_huge_pages(size_t size, HugePageBacking best, bool reserve_only, HugePageBacking* backing) {
+    size = round_to_huge_pages(size);
+    HugePageBacking result = HugePageBacking::Regular;
+
+    void* mapping = nullptr;
+    if (best == HugePageBacking::Explicit && !reserve_only) {
+        mapping = map_explicit(size);
+        result = HugePageBacking::Explicit;
+    }
+
+    if (!mapping) {
+        mapping = map_aligned(size, reserve_only);
+        if (!mapping) {
+            return nullptr;
+        }
+
+        // Fails where the kernel has no transparent huge page support
+        result = best != HugePageBacking::Regular && madvise(mapping, size, MADV_HUGEPAGE) == 0
+                     ? HugePageBacking::Transparent
+                     : HugePageBacking::Regular;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(registry().mutex);
+        registry().mappings[reinterpret_cast<uintptr_t>(mapping)] = HugePageMapping{size, result};
+    }
+
+    if (backing) {
+        *backing = result;
+    }
+    return mapping;
+}
+
+void unmap_huge_pages(void* address, size_t size) {
+    if (!address) {
+        return;
+    }
+
+    size = round_to_huge_pages(size);
+    bool was_explicit = false;
+    {
+        std::lock_guard<std::mutex> lock(registry().mutex);
+        auto it = registry().mappings.find(reinterpret_cast<uintptr_t>(address));
+        if (it != registry().mappings.end()) {
+            was_explicit = it->second.backing == HugePageBacking::Explicit;
+            registry().mappings.erase(it);
+        }
+    }
+
+    munmap(address, size);
+    if (was_explicit) {
+        explicit_pool_exhausted.store(false, std::memory_order_relaxed);
+    }
+}
+
+HugePageStats get_huge_page_stats() {
+    HugePageStats stats;
+    std::map<uintptr_t, HugePageMapping> mappings;
+    {
+        std::lock_guard<std::mutex> lock(registry().mutex);
+        mappings = registry().mappings;
+        stats.explicit_fallbacks = registry().explicit_fallbacks;
+    }
+
+    for (const auto& [address, mapping] : mappings) {
+        stats.mappings++;
+        stats.mapped_bytes += mapping.size;
+        switch (mapping.backing) {
+            case HugePageBacking::Explicit: stats.explicit_bytes += mapping.size; break;
+            case HugePageBacking::Transparent: stats.transparent_bytes += mapping.size; break;
+            case HugePageBacking::Regular: stats.regular_bytes += mapping.size; break;
+        }
+    }
+
+    stats.huge_backed_bytes = stats.explicit_bytes +
+                              std::min<u64>(transparent_huge_bytes(mappings), stats.transparent_bytes);
+    return stats;
+}
+
+} // namespace S1U
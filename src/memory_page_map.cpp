@@ -0,0 +1,104 @@
+#include "s1u/memory_page_map.hpp"
+
+namespace S1U {
+
+namespace {
+
+constexpr u64 LEVEL_MASK = MemoryPageMap::LEVEL_SIZE - 1;
+constexpr u32 PAGE_NUMBER_BITS = MemoryPageMap::ADDRESS_BITS - MemoryPageMap::PAGE_SHIFT;
+
+u64 page_of(const void* address) {
+    return reinterpret_cast<uintptr_t>(address) >> MemoryPageMap::PAGE_SHIFT;
+}
+
+} // namespace
+
+MemoryPageMap::~MemoryPageMap() {
+    for (auto& slot : root_) {
+        Interior* interior = slot.load(std::memory_order_relaxed);
+        if (!interior) {
+            continue;
+        }
+        for (auto& leaf : interior->leaves) {
+            delete leaf.load(std::memory_order_relaxed);
+        }
+        delete interior;
+    }
+}
+
+MemoryPageMap::Leaf* MemoryPageMap::leaf_for(u64 page) {
+    std::atomic<Interior*>& root_slot = root_[page >> (2 * LEVEL_BITS)];
+    Interior* interior = root_slot.load(std::memory_order_relaxed);
+    if (!interior) {
+        interior = new Interior();
+        node_bytes_.fetch_add(sizeof(Interior), std::memory_order_relaxed);
+        root_slot.store(interior, std::memory_order_release);
+    }
+
+    std::atomic<Leaf*>& interior_slot = interior->leaves[(page >> LEVEL_BITS) & LEVEL_MASK];
+    Leaf* leaf = interior_slot.load(std::memory_order_relaxed);
+    if (!leaf) {
+        leaf = new Leaf();
+        node_bytes_.fetch_add(sizeof(Leaf), std::memory_order_relaxed);
+        interior_slot.store(leaf, std::memory_order_release);
+    }
+    return leaf;
+}
+
+bool MemoryPageMap::insert(MemoryRegion* region) {
+    if (!region || region->size == 0) {
+        return false;
+    }
+
+    u64 first = page_of(region->start);
+    u64 last = page_of(region->start + region->size - 1);
+    if (last >> PAGE_NUMBER_BITS) {
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(grow_mutex_);
+    for (u64 page = first; page <= last; page++) {
+        leaf_for(page)->regions[page & LEVEL_MASK].store(region, std::memory_order_release);
+    }
+    return true;
+}
+
+void MemoryPageMap::erase(const MemoryRegion* region) {
+    if (!region || region->size == 0) {
+        return;
+    }
+
+    u64 first = page_of(region->start);
+    u64 last = page_of(region->start + region->size - 1);
+
+    std::lock_guard<std::mutex> lock(grow_mutex_);
+    for (u64 page = first; page <= last && !(page >> PAGE_NUMBER_BITS); page++) {
+        Interior* interior = root_[page >> (2 * LEVEL_BITS)].load(std::memory_order_relaxed);
+        Leaf* leaf = interior ? interior->leaves[(page >> LEVEL_BITS) & LEVEL_MASK].load(std::memory_order_relaxed) : nullptr;
+        if (leaf && leaf->regions[page & LEVEL_MASK].load(std::memory_order_relaxed) == region) {
+            leaf->regions[page & LEVEL_MASK].store(nullptr, std::memory_order_release);
+        }
+    }
+}
+
+MemoryRegion* MemoryPageMap::find(const void* address) const {
+    u64 page = page_of(address);
+    if (page >> PAGE_NUMBER_BITS) {
+        return nullptr;
+    }
+
+    Interior* interior = root_[page >> (2 * LEVEL_BITS)].load(std::memory_order_acquire);
+    if (!interior) {
+        return nullptr;
+    }
+
+    Leaf* leaf = interior->leaves[(page >> LEVEL_BITS) & LEVEL_MASK].load(std::memory_order_acquire);
+    if (!leaf) {
+        return nullptr;
+    }
+
+    MemoryRegion* region = leaf->regions[page & LEVEL_MASK].load(std::memory_order_acquire);
+    return region && region->contains(address) ? region : nullptr;
+}
+
+} // namespace S1U
@@ -0,0 +1,390 @@
+#include "s1u/memory_size_classes.hpp"
+#include "s1u/memory_huge_pages.hpp"
+#include <sys/mman.h>
+#include <numaif.h>
+#include <algorithm>
+#include <cstring>
+#include <new>
+
+namespace S1U {
+
+namespace {
+
+constexpr u32 SLAB_MAGIC = 0x5C1AB000;
+constexpr u32 LOOKUP_SHIFT = 6;
+constexpr size_t LOOKUP_SIZE = (SizeClassAllocator::MAX_SIZE >> LOOKUP_SHIFT) + 1;
+
+struct ClassInfo {
+    size_t size = 0;
+    size_t alignment = 0;        // guaranteed for every block of the class
+    u32 block_count = 0;
+    size_t first_block = 0;      // offset of block 0 from the slab start
+};
+
+// Built once: class sizes, the slab layout of each class, and a lookup from
+// size in 64-byte steps to the smallest class that fits
+struct SizeClassTable {
+    ClassInfo classes[SizeClassAllocator::CLASS_COUNT];
+    u8 lookup[LOOKUP_SIZE];
+
+    SizeClassTable() {
+        u32 count = 0;
+        for (size_t size = SizeClassAllocator::MIN_SIZE; size <= 512; size += SizeClassAllocator::MIN_SIZE) {
+            classes[count++].size = size;
+        }
+        for (size_t base = 512; base < SizeClassAllocator::MAX_SIZE; base *= 2) {
+            for (size_t step = 1; step <= 4; step++) {
+                classes[count++].size = base + step * base / 4;
+            }
+        }
+
+        for (ClassInfo& info : classes) {
+            info.alignment = std::min(info.size & (~info.size + 1), SizeClassAllocator::MAX_ALIGNMENT);
+
+            size_t records_start = sizeof(SizeClassSlab);
+            u32 blocks = static_cast<u32>((SizeClassAllocator::SLAB_SIZE - records_start) /
+                                          (info.size + sizeof(AllocationRecord)));
+            for (;; blocks--) {
+                size_t first = records_start + size_t(blocks) * sizeof(AllocationRecord);
+                first = (first + info.alignment - 1) & ~(info.alignment - 1);
+                if (first + size_t(blocks) * info.size <= SizeClassAllocator::SLAB_SIZE) {
+                    info.block_count = blocks;
+                    info.first_block = first;
+                    break;
+                }
+            }
+        }
+
+        u32 size_class = 0;
+        for (size_t i = 0; i < LOOKUP_SIZE; i++) {
+            while (classes[size_class].size < (i << LOOKUP_SHIFT)) {
+                size_class++;
+            }
+            lookup[i] = static_cast<u8>(size_class);
+        }
+    }
+};
+
+const SizeClassTable& class_table() {
+    static const SizeClassTable table;
+    return table;
+}
+
+} // namespace
+
+SizeClassAllocator::~SizeClassAllocator() {
+    shutdown();
+}
+
+bool SizeClassAllocator::initialize(MemoryPageMap* page_map, size_t arena_size, bool lock_slabs,
+                                    u32 numa_node, bool bind_to_node, bool huge_pages) {
+    page_map_ = page_map;
+    arena_size_ = std::max((arena_size + SLAB_SIZE - 1) & ~(SLAB_SIZE - 1), SLAB_SIZE);
+    lock_slabs_ = lock_slabs;
+    numa_node_ = numa_node;
+    bind_to_node_ = bind_to_node;
+    huge_pages_ = huge_pages;
+
+    std::lock_guard<std::mutex> lock(arena_mutex_);
+    return reserve_arena();
+}
+
+void SizeClassAllocator::shutdown() {
+    for (ClassState& state : classes_) {
+        std::lock_guard<std::mutex> lock(state.lock);
+        state.partial = nullptr;
+        state.full = nullptr;
+        state.slabs = 0;
+        state.total_blocks = 0;
+        state.free_blocks = 0;
+    }
+
+    std::lock_guard<std::mutex> lock(arena_mutex_);
+    for (Arena& arena : arenas_) {
+        page_map_->erase(arena.region.get());
+        if (lock_slabs_) {
+            munlock(arena.start, arena.size);
+        }
+        unmap_huge_pages(arena.start, arena.size);
+    }
+    arenas_.clear();
+    free_slabs_.clear();
+}
+
+u32 SizeClassAllocator::class_for(size_t size, size_t alignment) {
+    if (size > MAX_SIZE || alignment > MAX_ALIGNMENT) {
+        return NO_CLASS;
+    }
+
+    const SizeClassTable& table = class_table();
+    u32 size_class = table.lookup[(size + MIN_SIZE - 1) >> LOOKUP_SHIFT];
+
+    // At most a few steps: the next power-of-two class is aligned to its size
+    while (size_class < CLASS_COUNT && table.classes[size_class].alignment < alignment) {
+        size_class++;
+    }
+    return size_class;
+}
+
+size_t SizeClassAllocator::class_size(u32 size_class) {
+    return class_table().classes[size_class].size;
+}
+
+AllocationRecord* SizeClassAllocator::record_for(const void* address) {
+    SizeClassSlab* slab = slab_for(address);
+    if (slab->magic != SLAB_MAGIC || !slab->is_block_start(address)) {
+        return nullptr;
+    }
+    return &slab->record_for(address);
+}
+
+void SizeClassAllocator::link(SizeClassSlab*& head, SizeClassSlab* slab) {
+    slab->prev = nullptr;
+    slab->next = head;
+    if (head) {
+        head->prev = slab;
+    }
+    head = slab;
+}
+
+void SizeClassAllocator::unlink(SizeClassSlab*& head, SizeClassSlab* slab) {
+    if (slab->prev) {
+        slab->prev->next = slab->next;
+    } else {
+        head = slab->next;
+    }
+    if (slab->next) {
+        slab->next->prev = slab->prev;
+    }
+    slab->prev = nullptr;
+    slab->next = nullptr;
+}
+
+bool SizeClassAllocator::reserve_arena() {
+    // Slabs are exactly one huge page, so huge page alignment is slab
+    // alignment. Nothing is committed until a slab is carved and touched.
+    static_assert(SLAB_SIZE == HUGE_PAGE_SIZE);
+    void* mapping = map_huge_pages(arena_size_, huge_pages_ ? HugePageBacking::Transparent : HugePageBacking::Regular, true);
+    if (!mapping) {
+        return false;
+    }
+
+    Arena arena;
+    arena.start = static_cast<u8*>(mapping);
+    arena.size = arena_size_;
+    arena.bound = bind_to_node_ && bind_arena(arena.start, arena.size);
+    arena.region = std::make_unique<MemoryRegion>();
+    arena.region->kind = MemoryRegionKind::SizeClassArena;
+    arena.region->start = arena.start;
+    arena.region->size = arena.size;
+    arena.region->granule = SLAB_SIZE;
+    arena.region->index = static_cast<u32>(arenas_.size());
+    arena.region->numa_node = numa_node_;
+
+    if (!page_map_->insert(arena.region.get())) {
+        unmap_huge_pages(arena.start, arena.size);
+        return false;
+    }
+
+    arenas_.push_back(std::move(arena));
+    return true;
+}
+
+bool SizeClassAllocator::bind_arena(u8* start, size_t size) {
+    // Preferred rather than strict: once the node runs out of free pages the
+    // kernel falls back to another node instead of failing the page fault.
+    // Must happen before any page of the arena is touched.
+    constexpr size_t MASK_BITS = sizeof(unsigned long) * 8;
+    Vector<unsigned long> node_mask(numa_node_ / MASK_BITS + 2, 0);
+    node_mask[numa_node_ / MASK_BITS] = 1UL << (numa_node_ % MASK_BITS);
+
+    return mbind(start, size, MPOL_PREFERRED, node_mask.data(), node_mask.size() * MASK_BITS, 0) == 0;
+}
+
+SizeClassSlab* SizeClassAllocator::carve_slab(u32 size_class) {
+    const ClassInfo& info = class_table().classes[size_class];
+    u8* memory;
+
+    {
+        std::lock_guard<std::mutex> lock(arena_mutex_);
+        if (!free_slabs_.empty()) {
+            memory = reinterpret_cast<u8*>(free_slabs_.back());
+            free_slabs_.pop_back();
+            // The pages were dropped on release; clear the header and
+            // records anyway in case the kernel kept them
+            std::memset(memory, 0, info.first_block);
+        } else {
+            if (arenas_.empty() || arenas_.back().carved == arenas_.back().size) {
+                if (!reserve_arena()) {
+                    return nullptr;
+                }
+            }
+            Arena& arena = arenas_.back();
+            memory = arena.start + arena.carved;
+            arena.carved += SLAB_SIZE;
+        }
+    }
+
+    if (lock_slabs_) {
+        mlock(memory, SLAB_SIZE);
+    }
+
+    // Records start zeroed, which reads as free. Blocks are handed out
+    // in address order before the free list is used, so pages of a fresh
+    // slab are only touched as they are needed.
+    SizeClassSlab* slab = new (memory) SizeClassSlab();
+    slab->magic = SLAB_MAGIC;
+    slab->size_class = size_class;
+    slab->block_size = static_cast<u32>(info.size);
+    slab->block_count = info.block_count;
+    slab->free_count = info.block_count;
+    slab->numa_node = numa_node_;
+    slab->blocks = memory + info.first_block;
+    return slab;
+}
+
+u32 SizeClassAllocator::take_blocks(u32 size_class, void** blocks, u32 count) {
+    ClassState& state = classes_[size_class];
+    std::lock_guard<std::mutex> lock(state.lock);
+
+    u32 taken = 0;
+    while (taken < count) {
+        SizeClassSlab* slab = state.partial;
+        if (!slab) {
+            slab = carve_slab(size_class);
+            if (!slab) {
+                break;
+            }
+            link(state.partial, slab);
+            state.slabs++;
+            state.total_blocks += slab->block_count;
+            state.free_blocks += slab->block_count;
+        }
+
+        while (taken < count && slab->free_count > 0) {
+            void* block;
+            if (slab->free_list) {
+                block = slab->free_list;
+                slab->free_list = *static_cast<void**>(block);
+            } else {
+                block = slab->blocks + size_t(slab->carved++) * slab->block_size;
+            }
+            slab->free_count--;
+            slab->record_for(block).numa_node = static_cast<u16>(slab->numa_node);
+            blocks[taken++] = block;
+        }
+
+        if (slab->free_count == 0) {
+            unlink(state.partial, slab);
+            link(state.full, slab);
+        }
+    }
+
+    state.free_blocks -= taken;
+    state.blocks_taken += taken;
+    return taken;
+}
+
+void SizeClassAllocator::return_blocks(u32 size_class, void* const* blocks, u32 count) {
+    ClassState& state = classes_[size_class];
+    std::lock_guard<std::mutex> lock(state.lock);
+
+    for (u32 i = 0; i < count; i++) {
+        SizeClassSlab* slab = slab_for(blocks[i]);
+        if (slab->free_count == 0) {
+            unlink(state.full, slab);
+            link(state.partial, slab);
+        }
+        *static_cast<void**>(blocks[i]) = slab->free_list;
+        slab->free_list = blocks[i];
+        slab->free_count++;
+    }
+
+    state.free_blocks += count;
+    state.blocks_returned += count;
+}
+
+u32 SizeClassAllocator::release_empty_slabs() {
+    u32 released = 0;
+
+    for (ClassState& state : classes_) {
+        Vector<SizeClassSlab*> empty;
+        {
+            std::lock_guard<std::mutex> lock(state.lock);
+            bool kept_spare = false;
+            for (SizeClassSlab* slab = state.partial; slab;) {
+                SizeClassSlab* next = slab->next;
+                if (slab->free_count == slab->block_count) {
+                    if (kept_spare) {
+                        unlink(state.partial, slab);
+                        state.slabs--;
+                        state.total_blocks -= slab->block_count;
+                        state.free_blocks -= slab->block_count;
+                        empty.push_back(slab);
+                    }
+                    kept_spare = true;
+                }
+                slab = next;
+            }
+        }
+
+        for (SizeClassSlab* slab : empty) {
+            slab->magic = 0;
+            if (lock_slabs_) {
+                munlock(slab, SLAB_SIZE);
+            }
+            madvise(slab, SLAB_SIZE, MADV_DONTNEED);
+
+            std::lock_guard<std::mutex> lock(arena_mutex_);
+            free_slabs_.push_back(slab);
+            released++;
+        }
+    }
+
+    return released;
+}
+
+Vector<SizeClassStatistics> SizeClassAllocator::get_class_statistics() const {
+    Vector<SizeClassStatistics> statistics(CLASS_COUNT);
+
+    for (u32 i = 0; i < CLASS_COUNT; i++) {
+        const ClassState& state = classes_[i];
+        SizeClassStatistics& stats = statistics[i];
+        stats.block_size = class_size(i);
+
+        std::lock_guard<std::mutex> lock(state.lock);
+        stats.slabs = state.slabs;
+        stats.total_blocks = state.total_blocks;
+        stats.free_blocks = state.free_blocks;
+        stats.blocks_taken = state.blocks_taken;
+        stats.blocks_returned = state.blocks_returned;
+        if (state.slabs > 0) {
+            stats.fragmentation_ratio = static_cast<f64>(state.free_blocks * stats.block_size) /
+                                        static_cast<f64>(state.slabs * SLAB_SIZE);
+        }
+    }
+
+    return statistics;
+}
+
+size_t SizeClassAllocator::get_reserved_bytes() const {
+    std::lock_guard<std::mutex> lock(arena_mutex_);
+    size_t reserved = 0;
+    for (const Arena& arena : arenas_) {
+        reserved += arena.size;
+    }
+    return reserved;
+}
+
+size_t SizeClassAllocator::get_bound_bytes() const {
+    std::lock_guard<std::mutex> lock(arena_mutex_);
+    size_t bound = 0;
+    for (const Arena& arena : arenas_) {
+        if (arena.bound) {
+            bound += arena.size;
+        }
+    }
+    return bound;
+}
+
+} // namespace S1U
@@ -0,0 +1,224 @@
+#include "s1u/memory_thread_cache.hpp"
+#include <memory>
+#include <mutex>
+
+namespace S1U {
+
+namespace {
+
+// Every live cache of every owner. Held while an owner detaches or a thread
+// exits, so a cache is released to its owner at most once and never after
+// the owner is gone.
+std::mutex& registry_mutex() {
+    static std::mutex mutex;
+    return mutex;
+}
+
+Vector<ThreadAllocationCache*>& registry() {
+    static Vector<ThreadAllocationCache*> caches;
+    return caches;
+}
+
+void unregister(ThreadAllocationCache* cache) {
+    auto& caches = registry();
+    for (size_t i = 0; i < caches.size(); i++) {
+        if (caches[i] == cache) {
+            caches[i] = caches.back();
+            caches.pop_back();
+            return;
+        }
+    }
+}
+
+struct ThreadCacheList {
+    Vector<std::unique_ptr<ThreadAllocationCache>> caches;
+    ThreadAllocationCache* last = nullptr;
+
+    ~ThreadCacheList() {
+        std::lock_guard<std::mutex> lock(registry_mutex());
+        for (auto& cache : caches) {
+            if (!cache->is_detached()) {
+                cache->owner()->release_thread_cache(*cache);
+                unregister(cache.get());
+            }
+        }
+    }
+};
+
+thread_local ThreadCacheList thread_caches;
+
+} // namespace
+
+void ThreadCacheStats::add(const ThreadCacheStats& other) {
+    hits += other.hits;
+    misses += other.misses;
+    refills += other.refills;
+    flushes += other.flushes;
+    cross_thread_frees += other.cross_thread_frees;
+    local_allocations += other.local_allocations;
+    remote_allocations += other.remote_allocations;
+    remote_frees += other.remote_frees;
+    cached_bytes += other.cached_bytes;
+    threads += other.threads;
+}
+
+u16 ThreadAllocationCache::current_thread_tag() {
+    static std::atomic<u32> next_tag{0};
+    thread_local u16 tag = static_cast<u16>(next_tag.fetch_add(1, std::memory_order_relaxed) % 0xFFFF + 1);
+    return tag;
+}
+
+ThreadAllocationCache::ThreadAllocationCache(ThreadCacheOwner* owner) : owner_(owner) {
+}
+
+ThreadAllocationCache* ThreadAllocationCache::for_current_thread(ThreadCacheOwner* owner) {
+    ThreadCacheList& list = thread_caches;
+    if (list.last && list.last->owner_ == owner && !list.last->is_detached()) {
+        return list.last;
+    }
+
+    // Detached caches are dropped here; an owner at a reused address must
+    // not pick up its predecessor's cache
+    for (size_t i = 0; i < list.caches.size();) {
+        if (list.caches[i]->is_detached()) {
+            if (list.last == list.caches[i].get()) {
+                list.last = nullptr;
+            }
+            list.caches[i] = std::move(list.caches.back());
+            list.caches.pop_back();
+        } else if (list.caches[i]->owner_ == owner) {
+            list.last = list.caches[i].get();
+            return list.last;
+        } else {
+            i++;
+        }
+    }
+
+    auto cache = std::make_unique<ThreadAllocationCache>(owner);
+    std::lock_guard<std::mutex> lock(registry_mutex());
+    owner->configure_thread_cache(*cache);
+    registry().push_back(cache.get());
+    list.last = cache.get();
+    list.caches.push_back(std::move(cache));
+    return list.last;
+}
+
+void ThreadAllocationCache::detach_all(ThreadCacheOwner* owner) {
+    std::lock_guard<std::mutex> lock(registry_mutex());
+    auto& caches = registry();
+    for (size_t i = 0; i < caches.size();) {
+        if (caches[i]->owner_ == owner) {
+            caches[i]->detached_.store(true, std::memory_order_release);
+            caches[i] = caches.back();
+            caches.pop_back();
+        } else {
+            i++;
+        }
+    }
+}
+
+ThreadCacheStats ThreadAllocationCache::collect_stats(ThreadCacheOwner* owner) {
+    ThreadCacheStats stats;
+    std::lock_guard<std::mutex> lock(registry_mutex());
+    for (ThreadAllocationCache* cache : registry()) {
+        if (cache->owner_ == owner) {
+            stats.add(cache->get_stats());
+        }
+    }
+    return stats;
+}
+
+ThreadCacheStats ThreadAllocationCache::collect_node_stats(ThreadCacheOwner* owner, u32 numa_node) {
+    ThreadCacheStats stats;
+    std::lock_guard<std::mutex> lock(registry_mutex());
+    for (ThreadAllocationCache* cache : registry()) {
+        if (cache->owner_ == owner && cache->numa_node() == numa_node) {
+            stats.add(cache->get_stats());
+        }
+    }
+    return stats;
+}
+
+void ThreadAllocationCache::configure(u32 size_class, u32 capacity, size_t block_size) {
+    if (size_class >= magazines_.size()) {
+        magazines_.resize(size_class + 1);
+    }
+
+    Magazine& magazine = magazines_[size_class];
+    magazine.capacity = capacity > 1 ? std::min(capacity, MAX_MAGAZINE_CAPACITY) : 0;
+    magazine.block_size = block_size;
+    magazine.blocks.resize(magazine.capacity);
+}
+
+void* ThreadAllocationCache::pop(u32 size_class) {
+    Magazine& magazine = magazines_[size_class];
+    if (magazine.count == 0) {
+        add(misses_, 1);
+        return nullptr;
+    }
+
+    add(hits_, 1);
+    cached_bytes_.store(cached_bytes_.load(std::memory_order_relaxed) - magazine.block_size, std::memory_order_relaxed);
+    return magazine.blocks[--magazine.count];
+}
+
+bool ThreadAllocationCache::push(u32 size_class, void* block) {
+    Magazine& magazine = magazines_[size_class];
+    if (magazine.count == magazine.capacity) {
+        return false;
+    }
+
+    magazine.blocks[magazine.count++] = block;
+    add(cached_bytes_, magazine.block_size);
+    return true;
+}
+
+u32 ThreadAllocationCache::take(u32 size_class, void** blocks, u32 count) {
+    Magazine& magazine = magazines_[size_class];
+    count = std::min(count, magazine.count);
+
+    // Oldest blocks first; the most recently freed ones are the warm ones
+    for (u32 i = 0; i < count; i++) {
+        blocks[i] = magazine.blocks[i];
+    }
+    for (u32 i = count; i < magazine.count; i++) {
+        magazine.blocks[i - count] = magazine.blocks[i];
+    }
+    magazine.count -= count;
+
+    cached_bytes_.store(cached_bytes_.load(std::memory_order_relaxed) - count * magazine.block_size, std::memory_order_relaxed);
+    return count;
+}
+
+void ThreadAllocationCache::put(u32 size_class, void* const* blocks, u32 count) {
+    Magazine& magazine = magazines_[size_class];
+    for (u32 i = 0; i < count; i++) {
+        magazine.blocks[magazine.count++] = blocks[i];
+    }
+    add(cached_bytes_, count * magazine.block_size);
+}
+
+ThreadCacheStats ThreadAllocationCache::get_stats() const {
+    ThreadCacheStats stats;
+    stats.hits = hits_.load(std::memory_order_relaxed);
+    stats.misses = misses_.load(std::memory_order_relaxed);
+    stats.refills = refills_.load(std::memory_order_relaxed);
+    stats.flushes = flushes_.load(std::memory_order_relaxed);
+    stats.cross_thread_frees = cross_thread_frees_.load(std::memory_order_relaxed);
+    stats.local_allocations = local_allocations_.load(std::memory_order_relaxed);
+    stats.remote_allocations = remote_allocations_.load(std::memory_order_relaxed);
+    stats.remote_frees = remote_frees_.load(std::memory_order_relaxed);
+    stats.cached_bytes = cached_bytes_.load(std::memory_order_relaxed);
+    stats.threads = 1;
+    return stats;
+}
+
+ThreadCacheStats ThreadAllocationCache::take_node_stats() {
+    ThreadCacheStats stats;
+    stats.local_allocations = local_allocations_.exchange(0, std::memory_order_relaxed);
+    stats.remote_allocations = remote_allocations_.exchange(0, std::memory_order_relaxed);
+    stats.remote_frees = remote_frees_.exchange(0, std::memory_order_relaxed);
+    return stats;
+}
+
+} // namespace S1U
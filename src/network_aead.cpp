@@ -0,0 +1,400 @@
+#include "s1u/network_aead.hpp"
+#include <openssl/crypto.h>
+#include <openssl/evp.h>
+#include <openssl/kdf.h>
+#include <openssl/rand.h>
+#include <cstring>
+
+#if defined(__aarch64__)
+#include <sys/auxv.h>
+#include <asm/hwcap.h>
+#endif
+
+namespace S1U {
+
+namespace {
+
+constexpr u32 EPOCH_BITS = 24;
+constexpr u64 KEY_ID_RANDOM_MASK = (1ULL << 56) - 1;
+constexpr const char* KDF_LABEL = "s1u aead v1";
+
+void store_le64(u8* out, u64 value) {
+    for (int i = 0; i < 8; i++) {
+        out[i] = static_cast<u8>(value >> (8 * i));
+    }
+}
+
+u64 load_le64(const u8* in) {
+    u64 value = 0;
+    for (int i = 7; i >= 0; i--) {
+        value = (value << 8) | in[i];
+    }
+    return value;
+}
+
+const EVP_CIPHER* get_cipher(AeadAlgorithm algorithm) {
+    switch (algorithm) {
+        case AeadAlgorithm::Aes256Gcm: return EVP_aes_256_gcm();
+        case AeadAlgorithm::ChaCha20Poly1305: return EVP_chacha20_poly1305();
+    }
+    return nullptr;
+}
+
+AeadAlgorithm get_key_id_algorithm(u64 key_id) {
+    return static_cast<AeadAlgorithm>(key_id >> 56);
+}
+
+// HKDF-SHA256(master, salt = key id, info = label || epoch) -> key || iv
+bool derive_epoch_keys(const Vector<u8>& master_key, u64 key_id, u64 epoch, u8* key, u8* iv) {
+    u8 salt[8];
+    store_le64(salt, key_id);
+
+    u8 info[32];
+    size_t label_size = std::strlen(KDF_LABEL);
+    std::memcpy(info, KDF_LABEL, label_size);
+    store_le64(info + label_size, epoch);
+
+    u8 derived[AEAD_KEY_SIZE + AEAD_NONCE_SIZE];
+    size_t derived_size = sizeof(derived);
+
+    EVP_PKEY_CTX* pctx = EVP_PKEY_CTX_new_id(EVP_PKEY_HKDF, nullptr);
+    if (!pctx) {
+        return false;
+    }
+
+    bool derived_ok = EVP_PKEY_derive_init(pctx) > 0 &&
+                      EVP_PKEY_CTX_set_hkdf_md(pctx, EVP_sha256()) > 0 &&
+                      EVP_PKEY_CTX_set1_hkdf_salt(pctx, salt, sizeof(salt)) > 0 &&
+                      EVP_PKEY_CTX_set1_hkdf_key(pctx, master_key.data(), static_cast<int>(master_key.size())) > 0 &&
+                      EVP_PKEY_CTX_add1_hkdf_info(pctx, info, static_cast<int>(label_size + 8)) > 0 &&
+                      EVP_PKEY_derive(pctx, derived, &derived_size) > 0 &&
+                      derived_size == sizeof(derived);
+    EVP_PKEY_CTX_free(pctx);
+
+    if (derived_ok) {
+        std::memcpy(key, derived, AEAD_KEY_SIZE);
+        std::memcpy(iv, derived + AEAD_KEY_SIZE, AEAD_NONCE_SIZE);
+    }
+    OPENSSL_cleanse(derived, sizeof(derived));
+    return derived_ok;
+}
+
+// TLS 1.3 style: the sequence number, big-endian, XORed into the IV tail
+void make_nonce(const u8* iv, u64 sequence, u8* nonce) {
+    std::memcpy(nonce, iv, AEAD_NONCE_SIZE);
+    for (int i = 0; i < 8; i++) {
+        nonce[AEAD_NONCE_SIZE - 1 - i] ^= static_cast<u8>(sequence >> (8 * i));
+    }
+}
+
+} // namespace
+
+AeadAlgorithm select_aead_algorithm() {
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("aes") && __builtin_cpu_supports("pclmul")) {
+        return AeadAlgorithm::Aes256Gcm;
+    }
+#elif defined(__aarch64__)
+    unsigned long hwcap = getauxval(AT_HWCAP);
+    if ((hwcap & HWCAP_AES) && (hwcap & HWCAP_PMULL)) {
+        return AeadAlgorithm::Aes256Gcm;
+    }
+#endif
+    return AeadAlgorithm::ChaCha20Poly1305;
+}
+
+AeadAlgorithm parse_aead_algorithm(const String& name) {
+    if (name == "AES-256-GCM") {
+        return AeadAlgorithm::Aes256Gcm;
+    }
+    if (name == "ChaCha20-Poly1305") {
+        return AeadAlgorithm::ChaCha20Poly1305;
+    }
+    return select_aead_algorithm();
+}
+
+const char* aead_algorithm_name(AeadAlgorithm algorithm) {
+    switch (algorithm) {
+        case AeadAlgorithm::Aes256Gcm: return "AES-256-GCM";
+        case AeadAlgorithm::ChaCha20Poly1305: return "ChaCha20-Poly1305";
+    }
+    return "unknown";
+}
+
+AeadSealer::~AeadSealer() {
+    EVP_CIPHER_CTX_free(ctx_);
+    if (!master_key_.empty()) {
+        OPENSSL_cleanse(master_key_.data(), master_key_.size());
+    }
+    OPENSSL_cleanse(iv_, sizeof(iv_));
+}
+
+bool AeadSealer::initialize(AeadAlgorithm algorithm, const Vector<u8>& master_key) {
+    if (master_key.size() < AEAD_KEY_SIZE || !get_cipher(algorithm)) {
+        return false;
+    }
+
+    u64 random_id;
+    if (RAND_bytes(reinterpret_cast<u8*>(&random_id), sizeof(random_id)) != 1) {
+        return false;
+    }
+
+    if (!ctx_) {
+        ctx_ = EVP_CIPHER_CTX_new();
+        if (!ctx_) {
+            return false;
+        }
+    }
+
+    algorithm_ = algorithm;
+    master_key_ = master_key;
+    key_id_ = (static_cast<u64>(algorithm) << 56) | (random_id & KEY_ID_RANDOM_MASK);
+    sequence_ = 0;
+    return load_epoch(0);
+}
+
+bool AeadSealer::load_epoch(u64 epoch) {
+    u8 key[AEAD_KEY_SIZE];
+    bool loaded = derive_epoch_keys(master_key_, key_id_, epoch, key, iv_) &&
+                  EVP_EncryptInit_ex(ctx_, get_cipher(algorithm_), nullptr, key, nullptr) == 1;
+    OPENSSL_cleanse(key, sizeof(key));
+
+    if (loaded) {
+        epoch_ = epoch;
+    }
+    return loaded;
+}
+
+bool AeadSealer::seal(const u8* data, size_t size, Vector<u8>& output) {
+    if (size > 0x7FFFFFFF) {
+        return false;
+    }
+    output.resize(AEAD_HEADER_SIZE + size + AEAD_TAG_SIZE);
+    return seal_record(data, size, output.data());
+}
+
+bool AeadSealer::seal_in_place(u8* record, size_t payload_size) {
+    return seal_record(record + AEAD_HEADER_SIZE, payload_size, record);
+}
+
+bool AeadSealer::seal_record(const u8* data, size_t size, u8* record) {
+    if (!ctx_ || size > 0x7FFFFFFF || sequence_ == ~0ULL) {
+        return false;
+    }
+
+    u64 sequence = sequence_;
+    if ((sequence >> EPOCH_BITS) != epoch_ && !load_epoch(sequence >> EPOCH_BITS)) {
+        return false;
+    }
+
+    store_le64(record, key_id_);
+    store_le64(record + 8, sequence);
+
+    u8 nonce[AEAD_NONCE_SIZE];
+    make_nonce(iv_, sequence, nonce);
+
+    int len = 0;
+    int ciphertext_len = 0;
+    if (EVP_EncryptInit_ex(ctx_, nullptr, nullptr, nullptr, nonce) != 1 ||
+        EVP_EncryptUpdate(ctx_, nullptr, &len, record, AEAD_HEADER_SIZE) != 1) {
+        return false;
+    }
+
+    // EVP ciphers accept input and output at the same address, which is how
+    // seal_in_place encrypts without a second buffer
+    u8* ciphertext = record + AEAD_HEADER_SIZE;
+    if (size > 0) {
+        if (EVP_EncryptUpdate(ctx_, ciphertext, &len, data, static_cast<int>(size)) != 1) {
+            return false;
+        }
+        ciphertext_len = len;
+    }
+
+    if (EVP_EncryptFinal_ex(ctx_, ciphertext + ciphertext_len, &len) != 1 ||
+        EVP_CIPHER_CTX_ctrl(ctx_, EVP_CTRL_AEAD_GET_TAG, AEAD_TAG_SIZE, ciphertext + size) != 1) {
+        return false;
+    }
+
+    // The sequence is consumed even if the caller drops the record; a nonce
+    // must never be used twice
+    sequence_++;
+    return true;
+}
+
+AeadOpener::~AeadOpener() {
+    EVP_CIPHER_CTX_free(ctx_);
+    if (!master_key_.empty()) {
+        OPENSSL_cleanse(master_key_.data(), master_key_.size());
+    }
+    OPENSSL_cleanse(iv_, sizeof(iv_));
+}
+
+void AeadOpener::swap(AeadOpener& other) noexcept {
+    std::swap(ctx_, other.ctx_);
+    master_key_.swap(other.master_key_);
+    std::swap(iv_, other.iv_);
+    std::swap(key_id_, other.key_id_);
+    std::swap(epoch_, other.epoch_);
+    std::swap(highest_sequence_, other.highest_sequence_);
+    std::swap(replay_window_, other.replay_window_);
+    std::swap(received_any_, other.received_any_);
+}
+
+bool AeadOpener::initialize(const Vector<u8>& master_key, u64 key_id) {
+    if (master_key.size() < AEAD_KEY_SIZE || !get_cipher(get_key_id_algorithm(key_id))) {
+        return false;
+    }
+
+    if (!ctx_) {
+        ctx_ = EVP_CIPHER_CTX_new();
+        if (!ctx_) {
+            return false;
+        }
+    }
+
+    master_key_ = master_key;
+    key_id_ = key_id;
+    epoch_ = ~0ULL;
+    highest_sequence_ = 0;
+    replay_window_ = 0;
+    received_any_ = false;
+    return true;
+}
+
+bool AeadOpener::peek_key_id(const u8* data, size_t size, u64& key_id) {
+    if (size < AEAD_OVERHEAD) {
+        return false;
+    }
+    key_id = load_le64(data);
+    return true;
+}
+
+bool AeadOpener::load_epoch(u64 epoch) {
+    u8 key[AEAD_KEY_SIZE];
+    bool loaded = derive_epoch_keys(master_key_, key_id_, epoch, key, iv_) &&
+                  EVP_DecryptInit_ex(ctx_, get_cipher(get_key_id_algorithm(key_id_)), nullptr, key, nullptr) == 1;
+    OPENSSL_cleanse(key, sizeof(key));
+
+    epoch_ = loaded ? epoch : ~0ULL;
+    return loaded;
+}
+
+bool AeadOpener::is_replay(u64 sequence) const {
+    if (!received_any_ || sequence > highest_sequence_) {
+        return false;
+    }
+    u64 age = highest_sequence_ - sequence;
+    return age >= 64 || (replay_window_ & (1ULL << age));
+}
+
+void AeadOpener::mark_received(u64 sequence) {
+    if (!received_any_) {
+        highest_sequence_ = sequence;
+        replay_window_ = 1;
+        received_any_ = true;
+        return;
+    }
+
+    if (sequence > highest_sequence_) {
+        u64 shift = sequence - highest_sequence_;
+        replay_window_ = shift >= 64 ? 1 : (replay_window_ << shift) | 1;
+        highest_sequence_ = sequence;
+    } else {
+        replay_window_ |= 1ULL << (highest_sequence_ - sequence);
+    }
+}
+
+bool AeadOpener::open(const u8* data, size_t size, Vector<u8>& output) {
+    if (size < AEAD_OVERHEAD || size - AEAD_OVERHEAD > 0x7FFFFFFF) {
+        return false;
+    }
+
+    output.resize(size - AEAD_OVERHEAD);
+    if (!open_record(data, size, output.data())) {
+        output.clear();
+        return false;
+    }
+    return true;
+}
+
+bool AeadOpener::open_in_place(u8* record, size_t size) {
+    return open_record(record, size, record + AEAD_HEADER_SIZE);
+}
+
+bool AeadOpener::open_record(const u8* data, size_t size, u8* plaintext) {
+    if (!ctx_ || size < AEAD_OVERHEAD || size - AEAD_OVERHEAD > 0x7FFFFFFF) {
+        return false;
+    }
+
+    if (load_le64(data) != key_id_) {
+        return false;
+    }
+
+    u64 sequence = load_le64(data + 8);
+    if (is_replay(sequence)) {
+        return false;
+    }
+
+    if ((sequence >> EPOCH_BITS) != epoch_ && !load_epoch(sequence >> EPOCH_BITS)) {
+        return false;
+    }
+
+    u8 nonce[AEAD_NONCE_SIZE];
+    make_nonce(iv_, sequence, nonce);
+
+    // The tag is copied out first; decrypting in place may overwrite it
+    size_t plaintext_size = size - AEAD_OVERHEAD;
+    const u8* ciphertext = data + AEAD_HEADER_SIZE;
+    u8 tag[AEAD_TAG_SIZE];
+    std::memcpy(tag, ciphertext + plaintext_size, AEAD_TAG_SIZE);
+
+    int len = 0;
+    int plaintext_len = 0;
+    if (EVP_DecryptInit_ex(ctx_, nullptr, nullptr, nullptr, nonce) != 1 ||
+        EVP_DecryptUpdate(ctx_, nullptr, &len, data, AEAD_HEADER_SIZE) != 1) {
+        return false;
+    }
+
+    if (plaintext_size > 0) {
+        if (EVP_DecryptUpdate(ctx_, plaintext, &len, ciphertext, static_cast<int>(plaintext_size)) != 1) {
+            return false;
+        }
+        plaintext_len = len;
+    }
+
+    if (EVP_CIPHER_CTX_ctrl(ctx_, EVP_CTRL_AEAD_SET_TAG, AEAD_TAG_SIZE, tag) != 1 ||
+        EVP_DecryptFinal_ex(ctx_, plaintext + plaintext_len, &len) <= 0) {
+        // Never hand out plaintext from a record that failed authentication
+        OPENSSL_cleanse(plaintext, plaintext_size);
+        return false;
+    }
+
+    mark_received(sequence);
+    return true;
+}
+
+bool AeadOpenerCache::open_in_place(const Vector<u8>& master_key, u8* record, size_t size) {
+    u64 key_id;
+    if (!AeadOpener::peek_key_id(record, size, key_id)) {
+        return false;
+    }
+
+    auto it = openers_.find(key_id);
+    if (it != openers_.end()) {
+        return it->second->open_in_place(record, size);
+    }
+
+    auto opener = std::make_unique<AeadOpener>();
+    if (!opener->initialize(master_key, key_id) || !opener->open_in_place(record, size)) {
+        return false;
+    }
+
+    if (openers_.size() >= capacity_ && !openers_.empty()) {
+        openers_.erase(openers_.begin());
+    }
+    openers_.emplace(key_id, std::move(opener));
+    return true;
+}
+
+} // namespace S1U
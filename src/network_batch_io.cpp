@@ -0,0 +1,146 @@
+#include "s1u/network_batch_io.hpp"
+#include <sys/uio.h>
+#include <cerrno>
+#include <cstring>
+
+namespace S1U {
+
+bool DatagramBatch::initialize(u32 packets_per_syscall, u32 max_datagram_size) {
+    if (packets_per_syscall == 0 || max_datagram_size == 0) {
+        return false;
+    }
+
+    // UIO_MAXIOV is the kernel's cap on messages per mmsg call
+    batch_size_ = packets_per_syscall > UIO_MAXIOV ? UIO_MAXIOV : packets_per_syscall;
+    max_datagram_size_ = max_datagram_size;
+
+    receive_buffers_.clear();
+    receive_buffers_.resize(batch_size_);
+    receive_headers_.assign(batch_size_, mmsghdr{});
+    receive_iovecs_.assign(batch_size_, iovec{});
+    receive_addresses_.assign(batch_size_, sockaddr_in{});
+
+    send_headers_.assign(batch_size_, mmsghdr{});
+    send_iovecs_.assign(batch_size_, iovec{});
+    send_addresses_.assign(batch_size_, sockaddr_in{});
+    send_count_ = 0;
+    return true;
+}
+
+int DatagramBatch::receive(int socket_fd, PacketBufferPool& pool) {
+    // Only slots handed out by the last call need a new buffer. A pool that
+    // is out of memory shortens the batch rather than failing it.
+    u32 armed = 0;
+    for (; armed < batch_size_; armed++) {
+        PacketBuffer& buffer = receive_buffers_[armed];
+        if (!buffer.valid()) {
+            buffer = pool.allocate(max_datagram_size_);
+            if (!buffer.valid()) {
+                break;
+            }
+        }
+        receive_iovecs_[armed].iov_base = buffer.data();
+        receive_iovecs_[armed].iov_len = max_datagram_size_;
+    }
+
+    if (armed == 0) {
+        return -1;
+    }
+
+    // recvmmsg overwrites msg_namelen and msg_flags, so rearm every header
+    for (u32 i = 0; i < armed; i++) {
+        struct msghdr& header = receive_headers_[i].msg_hdr;
+        header.msg_name = &receive_addresses_[i];
+        header.msg_namelen = sizeof(receive_addresses_[i]);
+        header.msg_iov = &receive_iovecs_[i];
+        header.msg_iovlen = 1;
+        header.msg_control = nullptr;
+        header.msg_controllen = 0;
+        header.msg_flags = 0;
+    }
+
+    int received;
+    do {
+        received = recvmmsg(socket_fd, receive_headers_.data(), armed, MSG_DONTWAIT, nullptr);
+    } while (received == -1 && errno == EINTR);
+
+    receive_stats_.syscalls.increment();
+
+    if (received < 0) {
+        return (errno == EAGAIN || errno == EWOULDBLOCK) ? 0 : -1;
+    }
+
+    for (int i = 0; i < received; i++) {
+        receive_stats_.bytes.add(receive_headers_[i].msg_len);
+        if (receive_headers_[i].msg_hdr.msg_flags & MSG_TRUNC) {
+            receive_stats_.truncated.increment();
+        }
+    }
+    receive_stats_.packets.add(static_cast<u64>(received));
+    return received;
+}
+
+PacketBuffer DatagramBatch::take_received(u32 index) {
+    PacketBuffer buffer = std::move(receive_buffers_[index]);
+    buffer.resize(receive_headers_[index].msg_len);
+    return buffer;
+}
+
+void DatagramBatch::release_buffers() {
+    for (PacketBuffer& buffer : receive_buffers_) {
+        buffer.reset();
+    }
+}
+
+bool DatagramBatch::add_send(const u8* data, u32 size, u32 ipv4_address, u16 port) {
+    if (send_count_ >= batch_size_) {
+        return false;
+    }
+
+    struct sockaddr_in& address = send_addresses_[send_count_];
+    address = sockaddr_in{};
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = ipv4_address;
+    address.sin_port = htons(port);
+
+    struct iovec& iov = send_iovecs_[send_count_];
+    iov.iov_base = const_cast<u8*>(data);
+    iov.iov_len = size;
+
+    struct msghdr& header = send_headers_[send_count_].msg_hdr;
+    header = msghdr{};
+    header.msg_name = &address;
+    header.msg_namelen = sizeof(address);
+    header.msg_iov = &iov;
+    header.msg_iovlen = 1;
+
+    send_count_++;
+    return true;
+}
+
+u32 DatagramBatch::flush(int socket_fd) {
+    u32 sent_total = 0;
+
+    while (sent_total < send_count_) {
+        int sent = sendmmsg(socket_fd, send_headers_.data() + sent_total, send_count_ - sent_total, MSG_DONTWAIT);
+        if (sent < 0 && errno == EINTR) {
+            continue;
+        }
+
+        send_stats_.syscalls.increment();
+        if (sent <= 0) {
+            break;
+        }
+
+        for (int i = 0; i < sent; i++) {
+            send_stats_.bytes.add(send_iovecs_[sent_total + i].iov_len);
+        }
+        send_stats_.packets.add(static_cast<u64>(sent));
+        sent_total += static_cast<u32>(sent);
+    }
+
+    send_count_ = 0;
+    return sent_total;
+}
+
+} // namespace S1U
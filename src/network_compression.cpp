@@ -0,0 +1,552 @@
+#include "s1u/network_compression.hpp"
+#include <zstd.h>
+#include <zdict.h>
+#include <lz4.h>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace S1U {
+
+f32 estimate_entropy_bits(const u8* data, size_t size) {
+    if (!data || size == 0) {
+        return 0.0f;
+    }
+
+    // 512 evenly spaced bytes are enough to tell text-like traffic from
+    // ciphertext or already-compressed media
+    const size_t max_samples = 512;
+    size_t stride = size > max_samples ? size / max_samples : 1;
+    size_t samples = 0;
+    u32 histogram[256] = {};
+
+    for (size_t i = 0; i < size && samples < max_samples; i += stride, samples++) {
+        histogram[data[i]]++;
+    }
+
+    f32 entropy = 0.0f;
+    f32 inverse_samples = 1.0f / static_cast<f32>(samples);
+    for (u32 count : histogram) {
+        if (count) {
+            f32 probability = count * inverse_samples;
+            entropy -= probability * std::log2(probability);
+        }
+    }
+    return entropy;
+}
+
+CompressionClass compression_class_from_qos(const String& qos_class) {
+    if (qos_class == "RealTime") {
+        return CompressionClass::RealTime;
+    }
+    if (qos_class == "Interactive") {
+        return CompressionClass::Interactive;
+    }
+    return CompressionClass::BestEffort;
+}
+
+CompressionTierPolicy default_compression_tier_policy(CompressionClass compression_class) {
+    CompressionTierPolicy policy;
+
+    switch (compression_class) {
+        case CompressionClass::RealTime:
+            // Input and cursor events are tiny and every microsecond shows;
+            // only a slow link makes LZ4 worth its time
+            policy.fast_link = CompressionType::None;
+            policy.normal_link = CompressionType::None;
+            policy.slow_link = CompressionType::LZ4;
+            policy.min_size = 256;
+            break;
+        case CompressionClass::Interactive:
+            policy.fast_link = CompressionType::LZ4;
+            policy.normal_link = CompressionType::LZ4;
+            policy.slow_link = CompressionType::ZSTD;
+            policy.min_size = 128;
+            break;
+        default:
+            policy.fast_link = CompressionType::LZ4;
+            policy.normal_link = CompressionType::ZSTD;
+            policy.slow_link = CompressionType::ZSTD;
+            policy.min_size = 64;
+            break;
+    }
+    return policy;
+}
+
+CompressionType select_compression_algorithm(const CompressionTierPolicy& policy, f64 link_mbps) {
+    if (link_mbps >= policy.fast_link_mbps) {
+        return policy.fast_link;
+    }
+    if (link_mbps < policy.slow_link_mbps) {
+        return policy.slow_link;
+    }
+    return policy.normal_link;
+}
+
+size_t Lz4Compressor::compress_bound(size_t size) {
+    return size > LZ4_MAX_INPUT_SIZE ? 0 : sizeof(u32) + LZ4_compressBound(static_cast<int>(size));
+}
+
+bool Lz4Compressor::compress(const u8* data, size_t size, Vector<u8>& output, int acceleration) {
+    output.resize(compress_bound(size));
+    size_t output_size = 0;
+    if (!compress(data, size, output.data(), output.size(), output_size, acceleration)) {
+        return false;
+    }
+
+    output.resize(output_size);
+    return true;
+}
+
+bool Lz4Compressor::compress(const u8* data, size_t size, u8* output, size_t capacity, size_t& output_size, int acceleration) {
+    if (size == 0 || size > LZ4_MAX_INPUT_SIZE || capacity <= sizeof(u32)) {
+        return false;
+    }
+
+    if (state_.empty()) {
+        state_.resize(LZ4_sizeofState());
+    }
+
+    u32 original_size = static_cast<u32>(size);
+    std::memcpy(output, &original_size, sizeof(original_size));
+
+    int limit = static_cast<int>(std::min<size_t>(capacity - sizeof(u32), LZ4_compressBound(static_cast<int>(size))));
+    int compressed_size = LZ4_compress_fast_extState(state_.data(),
+                                                     reinterpret_cast<const char*>(data),
+                                                     reinterpret_cast<char*>(output + sizeof(u32)),
+                                                     static_cast<int>(size), limit, acceleration);
+    if (compressed_size <= 0) {
+        return false;
+    }
+
+    output_size = sizeof(u32) + compressed_size;
+    return true;
+}
+
+size_t Lz4Compressor::decompressed_size(const u8* data, size_t size) {
+    if (size <= sizeof(u32)) {
+        return 0;
+    }
+
+    u32 original_size;
+    std::memcpy(&original_size, data, sizeof(original_size));
+    return original_size > LZ4_MAX_INPUT_SIZE ? 0 : original_size;
+}
+
+bool Lz4Compressor::decompress(const u8* data, size_t size, Vector<u8>& output, size_t max_output) {
+    size_t original_size = decompressed_size(data, size);
+    if (original_size == 0 || original_size > max_output) {
+        return false;
+    }
+
+    output.resize(original_size);
+    size_t output_size = 0;
+    return decompress(data, size, output.data(), output.size(), output_size);
+}
+
+bool Lz4Compressor::decompress(const u8* data, size_t size, u8* output, size_t capacity, size_t& output_size) {
+    size_t original_size = decompressed_size(data, size);
+    if (original_size == 0 || original_size > capacity) {
+        return false;
+    }
+
+    int decompressed_size = LZ4_decompress_safe(reinterpret_cast<const char*>(data + sizeof(u32)),
+                                                reinterpret_cast<char*>(output),
+                                                static_cast<int>(size - sizeof(u32)),
+                                                static_cast<int>(original_size));
+    if (decompressed_size != static_cast<int>(original_size)) {
+        return false;
+    }
+
+    output_size = original_size;
+    return true;
+}
+
+CompressionDictionary::~CompressionDictionary() {
+    ZSTD_freeCDict(cdict_);
+    ZSTD_freeDDict(ddict_);
+}
+
+std::shared_ptr<const CompressionDictionary> CompressionDictionary::create(const u8* data, size_t size, int compression_level) {
+    if (!data || size == 0) {
+        return nullptr;
+    }
+
+    std::shared_ptr<CompressionDictionary> dictionary(new CompressionDictionary());
+    dictionary->content_.assign(data, data + size);
+    dictionary->id_ = ZDICT_getDictID(data, size);
+    dictionary->cdict_ = ZSTD_createCDict(dictionary->content_.data(), size, compression_level);
+    dictionary->ddict_ = ZSTD_createDDict(dictionary->content_.data(), size);
+
+    if (!dictionary->cdict_ || !dictionary->ddict_) {
+        return nullptr;
+    }
+    return dictionary;
+}
+
+void DictionaryTrainer::configure(u32 max_samples, u32 max_sample_size) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    max_samples_ = max_samples;
+    max_sample_size_ = max_sample_size;
+    samples_.clear();
+    sample_sizes_.clear();
+    samples_.reserve(size_t(max_samples) * max_sample_size / 4);
+    sample_sizes_.reserve(max_samples);
+    full_.store(max_samples == 0, std::memory_order_release);
+}
+
+void DictionaryTrainer::offer(const u8* data, size_t size) {
+    if (full_.load(std::memory_order_acquire) || size == 0 || size > max_sample_size_) {
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (sample_sizes_.size() >= max_samples_) {
+        return;
+    }
+
+    samples_.insert(samples_.end(), data, data + size);
+    sample_sizes_.push_back(size);
+
+    if (sample_sizes_.size() >= max_samples_) {
+        full_.store(true, std::memory_order_release);
+    }
+}
+
+bool DictionaryTrainer::ready() const {
+    return full_.load(std::memory_order_acquire) && max_samples_ > 0;
+}
+
+std::shared_ptr<const CompressionDictionary> DictionaryTrainer::train(size_t dictionary_capacity, int compression_level) {
+    Vector<u8> samples;
+    Vector<size_t> sample_sizes;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        samples.swap(samples_);
+        sample_sizes.swap(sample_sizes_);
+    }
+
+    // zstd wants a reasonable spread of samples to find repeated content
+    if (sample_sizes.size() < 16 || dictionary_capacity == 0) {
+        return nullptr;
+    }
+
+    Vector<u8> dictionary(dictionary_capacity);
+    size_t dictionary_size = ZDICT_trainFromBuffer(dictionary.data(), dictionary.size(),
+                                                   samples.data(), sample_sizes.data(),
+                                                   static_cast<unsigned>(sample_sizes.size()));
+    if (ZDICT_isError(dictionary_size)) {
+        return nullptr;
+    }
+
+    return CompressionDictionary::create(dictionary.data(), dictionary_size, compression_level);
+}
+
+CompressionSession::~CompressionSession() {
+    ZSTD_freeCCtx(cctx_);
+    ZSTD_freeDCtx(dctx_);
+}
+
+bool CompressionSession::initialize(int compression_level, u32 window_log, std::shared_ptr<const CompressionDictionary> dictionary,
+                                    std::shared_ptr<const CompressionDictionary> accepted_dictionary) {
+    if (!cctx_) {
+        cctx_ = ZSTD_createCCtx();
+        if (!cctx_) {
+            return false;
+        }
+    }
+
+    ZSTD_CCtx_reset(cctx_, ZSTD_reset_session_and_parameters);
+
+    // The decompressor is rebuilt lazily against the new dictionary
+    ZSTD_freeDCtx(dctx_);
+    dctx_ = nullptr;
+
+    level_ = compression_level;
+    window_log_ = window_log;
+    dictionary_ = std::move(dictionary);
+    accepted_dictionary_ = std::move(accepted_dictionary);
+    poor_results_ = 0;
+    skip_remaining_ = 0;
+    skip_span_ = 1;
+
+    // A small window bounds per-connection memory; history beyond it is
+    // what the dictionary is for
+    ZSTD_CCtx_setParameter(cctx_, ZSTD_c_compressionLevel, level_);
+    ZSTD_CCtx_setParameter(cctx_, ZSTD_c_windowLog, static_cast<int>(window_log_));
+    ZSTD_CCtx_setParameter(cctx_, ZSTD_c_checksumFlag, 0);
+
+    if (dictionary_) {
+        ZSTD_CCtx_refCDict(cctx_, dictionary_->get_compression_dictionary());
+    }
+    return true;
+}
+
+void CompressionSession::set_level(int compression_level) {
+    if (cctx_ && compression_level != level_) {
+        // compressionLevel is one of the parameters zstd accepts mid-frame
+        ZSTD_CCtx_setParameter(cctx_, ZSTD_c_compressionLevel, compression_level);
+        level_ = compression_level;
+    }
+}
+
+bool CompressionSession::should_compress(const u8* data, size_t size, f32 entropy_limit_bits) {
+    if (skip_remaining_ > 0) {
+        skip_remaining_--;
+        return false;
+    }
+
+    if (estimate_entropy_bits(data, size) > entropy_limit_bits) {
+        return false;
+    }
+    return true;
+}
+
+void CompressionSession::record_result(size_t input_size, size_t output_size) {
+    // Saving under 3% does not pay for the CPU or the peer's decode
+    if (output_size * 100 >= input_size * 97) {
+        if (++poor_results_ >= 4) {
+            skip_remaining_ = skip_span_;
+            skip_span_ = std::min<u32>(skip_span_ * 2, 256);
+            poor_results_ = 0;
+        }
+    } else {
+        poor_results_ = 0;
+        skip_span_ = 1;
+    }
+}
+
+size_t CompressionSession::stream_compress_bound(size_t size) {
+    // ZSTD_compressBound already allows for a frame header and one block
+    // header per 128 KB, which is all a flushed message adds
+    return ZSTD_compressBound(size);
+}
+
+bool CompressionSession::compress_stream(const u8* data, size_t size, Vector<u8>& output) {
+    if (!cctx_) {
+        return false;
+    }
+
+    output.resize(ZSTD_compressBound(size) + ZSTD_CStreamOutSize());
+
+    ZSTD_inBuffer input = {data, size, 0};
+    ZSTD_outBuffer out = {output.data(), output.size(), 0};
+
+    // ZSTD_e_flush ends the message on a block boundary so the peer can
+    // decode it without waiting for more data, while keeping the window
+    while (true) {
+        size_t remaining = ZSTD_compressStream2(cctx_, &out, &input, ZSTD_e_flush);
+        if (ZSTD_isError(remaining)) {
+            return false;
+        }
+        if (remaining == 0 && input.pos == input.size) {
+            break;
+        }
+
+        output.resize(output.size() * 2);
+        out.dst = output.data();
+        out.size = output.size();
+    }
+
+    output.resize(out.pos);
+    record_result(size, out.pos);
+    return true;
+}
+
+bool CompressionSession::compress_stream(const u8* data, size_t size, u8* output, size_t capacity, size_t& output_size) {
+    if (!cctx_) {
+        return false;
+    }
+
+    ZSTD_inBuffer input = {data, size, 0};
+    ZSTD_outBuffer out = {output, capacity, 0};
+
+    // Output that does not fit leaves part of the message in the encoder,
+    // so the stream is unusable after a false return
+    size_t remaining = ZSTD_compressStream2(cctx_, &out, &input, ZSTD_e_flush);
+    if (ZSTD_isError(remaining) || remaining != 0 || input.pos != input.size) {
+        return false;
+    }
+
+    output_size = out.pos;
+    record_result(size, out.pos);
+    return true;
+}
+
+bool CompressionSession::ensure_decompressor(const u8* frame, size_t size) {
+    if (!dctx_) {
+        dctx_ = ZSTD_createDCtx();
+        if (!dctx_) {
+            return false;
+        }
+        ZSTD_DCtx_setParameter(dctx_, ZSTD_d_windowLogMax, static_cast<int>(window_log_));
+        decoder_dictionary_id_ = 0;
+    }
+
+    // 0 for frames without a dictionary, and for headers too short to read
+    u32 frame_dictionary_id = ZSTD_getDictID_fromFrame(frame, size);
+    if (frame_dictionary_id == decoder_dictionary_id_) {
+        return true;
+    }
+
+    const CompressionDictionary* dictionary = nullptr;
+    for (const auto* candidate : {dictionary_.get(), accepted_dictionary_.get()}) {
+        if (candidate && candidate->get_id() == frame_dictionary_id) {
+            dictionary = candidate;
+        }
+    }
+    if (frame_dictionary_id != 0 && !dictionary) {
+        return false;
+    }
+
+    ZSTD_DCtx_refDDict(dctx_, dictionary ? dictionary->get_decompression_dictionary() : nullptr);
+    decoder_dictionary_id_ = frame_dictionary_id;
+    return true;
+}
+
+bool CompressionSession::decompress_stream(const u8* data, size_t size, Vector<u8>& output, size_t max_output) {
+    output.resize(std::min(std::max(size * 4, ZSTD_DStreamOutSize()), max_output));
+
+    size_t consumed = 0;
+    size_t produced = 0;
+    while (true) {
+        size_t step_consumed = 0;
+        size_t step_produced = 0;
+        if (!decompress_stream(data + consumed, size - consumed, step_consumed,
+                               output.data() + produced, output.size() - produced, step_produced)) {
+            return false;
+        }
+        consumed += step_consumed;
+        produced += step_produced;
+
+        if (produced < output.size()) {
+            break;
+        }
+        if (output.size() >= max_output) {
+            return false;
+        }
+        output.resize(std::min(output.size() * 2, max_output));
+    }
+
+    output.resize(produced);
+    return true;
+}
+
+bool CompressionSession::decompress_stream(const u8* data, size_t size, size_t& consumed,
+                                           u8* output, size_t capacity, size_t& produced) {
+    // A stream is one frame, so its first message names the dictionary
+    // for the rest of the connection
+    if (!dctx_ && !ensure_decompressor(data, size)) {
+        return false;
+    }
+
+    ZSTD_inBuffer input = {data, size, 0};
+    ZSTD_outBuffer out = {output, capacity, 0};
+
+    // Done once the input is consumed and the decoder did not fill the
+    // output, which would mean it still holds flushed data
+    do {
+        size_t result = ZSTD_decompressStream(dctx_, &out, &input);
+        if (ZSTD_isError(result)) {
+            return false;
+        }
+    } while (input.pos < input.size && out.pos < out.size);
+
+    consumed = input.pos;
+    produced = out.pos;
+    return true;
+}
+
+size_t CompressionSession::message_compress_bound(size_t size) {
+    return ZSTD_compressBound(size);
+}
+
+bool CompressionSession::compress_message(const u8* data, size_t size, Vector<u8>& output) {
+    output.resize(ZSTD_compressBound(size));
+    size_t compressed_size = 0;
+    if (!compress_message(data, size, output.data(), output.size(), compressed_size)) {
+        return false;
+    }
+
+    output.resize(compressed_size);
+    return true;
+}
+
+bool CompressionSession::compress_message(const u8* data, size_t size, u8* output, size_t capacity, size_t& output_size) {
+    if (!cctx_) {
+        return false;
+    }
+
+    size_t compressed_size = ZSTD_compress2(cctx_, output, capacity, data, size);
+    if (ZSTD_isError(compressed_size)) {
+        return false;
+    }
+
+    output_size = compressed_size;
+    record_result(size, compressed_size);
+    return true;
+}
+
+bool CompressionSession::message_content_size(const u8* data, size_t size, size_t& content_size) {
+    unsigned long long frame_content_size = ZSTD_getFrameContentSize(data, size);
+    if (frame_content_size == ZSTD_CONTENTSIZE_ERROR || frame_content_size == ZSTD_CONTENTSIZE_UNKNOWN) {
+        return false;
+    }
+
+    content_size = static_cast<size_t>(frame_content_size);
+    return true;
+}
+
+bool CompressionSession::decompress_message(const u8* data, size_t size, Vector<u8>& output, size_t max_output) {
+    size_t content_size;
+    if (!message_content_size(data, size, content_size) || content_size > max_output) {
+        return false;
+    }
+
+    output.resize(content_size);
+    size_t decompressed_size = 0;
+    if (!decompress_message(data, size, output.data(), output.size(), decompressed_size)) {
+        return false;
+    }
+
+    output.resize(decompressed_size);
+    return true;
+}
+
+bool CompressionSession::decompress_message(const u8* data, size_t size, u8* output, size_t capacity, size_t& output_size) {
+    if (!ensure_decompressor(data, size)) {
+        return false;
+    }
+
+    size_t decompressed_size = ZSTD_decompressDCtx(dctx_, output, capacity, data, size);
+    if (ZSTD_isError(decompressed_size)) {
+        return false;
+    }
+
+    output_size = decompressed_size;
+    return true;
+}
+
+void CompressionLevelController::configure(int initial_level, int min_level, int max_level) {
+    min_level_ = std::min(min_level, max_level);
+    max_level_ = std::max(min_level, max_level);
+    level_.store(std::clamp(initial_level, min_level_, max_level_), std::memory_order_relaxed);
+}
+
+int CompressionLevelController::update(f64 link_utilization, f64 cpu_headroom) {
+    int level = level_.load(std::memory_order_relaxed);
+
+    // One step per update with a dead band between the thresholds, so the
+    // level settles instead of oscillating
+    if (cpu_headroom < 0.1 || link_utilization < 0.3) {
+        level--;
+    } else if (link_utilization > 0.8 && cpu_headroom > 0.3) {
+        level++;
+    }
+
+    level = std::clamp(level, min_level_, max_level_);
+    level_.store(level, std::memory_order_relaxed);
+    return level;
+}
+
+} // namespace S1U
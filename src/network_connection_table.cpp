@@ -0,0 +1,178 @@
+#include "s1u/network_connection_table.hpp"
+#include <algorithm>
+
+namespace S1U {
+
+void NetworkConnectionTable::reserve(u32 max_fds) {
+    live_fds_.reserve(max_fds);
+    grow(max_fds);
+}
+
+void NetworkConnectionTable::grow(size_t slots) {
+    if (slots <= hot_.size()) {
+        return;
+    }
+
+    size_t old_size = hot_.size();
+    hot_.resize(slots);
+    cold_.resize(slots);
+    live_index_.resize(slots, NOT_LIVE);
+
+    for (size_t fd = old_size; fd < slots; fd++) {
+        hot_[fd].socket_fd = static_cast<int>(fd);
+    }
+}
+
+void NetworkConnectionTable::clear() {
+    while (!live_fds_.empty()) {
+        remove(live_fds_.back());
+    }
+}
+
+ConnectionHandle NetworkConnectionTable::insert(const NetworkConnection& connection) {
+    int socket_fd = connection.socket_fd;
+    if (socket_fd < 0) {
+        return ConnectionHandle{};
+    }
+
+    if (static_cast<size_t>(socket_fd) >= hot_.size()) {
+        grow(std::max<size_t>(static_cast<size_t>(socket_fd) + 1, hot_.size() * 2));
+    }
+
+    if (is_live(socket_fd)) {
+        remove(socket_fd);
+    }
+
+    ConnectionHotState& hot = hot_[socket_fd];
+    u32 generation = hot.generation;
+    hot = ConnectionHotState();
+    hot.socket_fd = socket_fd;
+    hot.generation = generation;
+    hot.is_connected = connection.is_connected;
+    hot.congestion_window_size = connection.congestion_window_size;
+    hot.send_sequence = connection.send_sequence;
+    hot.receive_sequence = connection.receive_sequence;
+    hot.bytes_sent = connection.bytes_sent;
+    hot.bytes_received = connection.bytes_received;
+    hot.packets_sent = connection.packets_sent;
+    hot.packets_received = connection.packets_received;
+    hot.last_activity_time = connection.last_activity_time;
+
+    ConnectionColdState& cold = cold_[socket_fd];
+    cold.remote_address = connection.remote_address;
+    cold.remote_port = connection.remote_port;
+    cold.connection_time = connection.connection_time;
+    cold.current_rtt_ms = connection.current_rtt_ms;
+    cold.smoothed_rtt_ms = connection.smoothed_rtt_ms;
+    cold.rtt_variance_ms = connection.rtt_variance_ms;
+    cold.bandwidth_mbps = connection.bandwidth_mbps;
+    cold.slow_start_threshold = connection.slow_start_threshold;
+    cold.duplicate_ack_count = connection.duplicate_ack_count;
+    cold.retransmission_count = connection.retransmission_count;
+    cold.qos_class = connection.qos_class;
+    cold.priority = connection.priority;
+    cold.is_real_time = connection.is_real_time;
+    cold.send_buffer = connection.send_buffer;
+    cold.receive_buffer = connection.receive_buffer;
+
+    live_index_[socket_fd] = static_cast<u32>(live_fds_.size());
+    live_fds_.push_back(socket_fd);
+
+    return ConnectionHandle{socket_fd, generation};
+}
+
+bool NetworkConnectionTable::remove(int socket_fd) {
+    if (!is_live(socket_fd)) {
+        return false;
+    }
+
+    u32 index = live_index_[socket_fd];
+    int moved_fd = live_fds_.back();
+    live_fds_[index] = moved_fd;
+    live_index_[moved_fd] = index;
+    live_fds_.pop_back();
+    live_index_[socket_fd] = NOT_LIVE;
+
+    hot_[socket_fd].is_connected = false;
+    hot_[socket_fd].generation++;
+
+    ConnectionColdState& cold = cold_[socket_fd];
+    cold.remote_address.clear();
+    Vector<u8>().swap(cold.send_buffer);
+    Vector<u8>().swap(cold.receive_buffer);
+    cold.compression.reset();
+    cold.encryption.reset();
+    cold.zero_copy.reset();
+    cold.pacer.reset();
+    std::deque<DataPacket>().swap(cold.paced_packets);
+    cold.records.reset();
+    cold.receive_starved = false;
+    return true;
+}
+
+ConnectionHotState* NetworkConnectionTable::find(int socket_fd) {
+    return is_live(socket_fd) ? &hot_[socket_fd] : nullptr;
+}
+
+const ConnectionHotState* NetworkConnectionTable::find(int socket_fd) const {
+    return is_live(socket_fd) ? &hot_[socket_fd] : nullptr;
+}
+
+ConnectionHotState* NetworkConnectionTable::find(ConnectionHandle handle) {
+    ConnectionHotState* hot = find(handle.socket_fd);
+    return hot && hot->generation == handle.generation ? hot : nullptr;
+}
+
+ConnectionColdState* NetworkConnectionTable::cold(int socket_fd) {
+    return is_live(socket_fd) ? &cold_[socket_fd] : nullptr;
+}
+
+const ConnectionColdState* NetworkConnectionTable::cold(int socket_fd) const {
+    return is_live(socket_fd) ? &cold_[socket_fd] : nullptr;
+}
+
+ConnectionHandle NetworkConnectionTable::handle_for(int socket_fd) const {
+    if (!is_live(socket_fd)) {
+        return ConnectionHandle{};
+    }
+    return ConnectionHandle{socket_fd, hot_[socket_fd].generation};
+}
+
+NetworkConnection NetworkConnectionTable::snapshot(int socket_fd) const {
+    NetworkConnection connection;
+    if (!is_live(socket_fd)) {
+        return connection;
+    }
+
+    const ConnectionHotState& hot = hot_[socket_fd];
+    const ConnectionColdState& cold = cold_[socket_fd];
+
+    connection.socket_fd = socket_fd;
+    connection.remote_address = cold.remote_address;
+    connection.remote_port = cold.remote_port;
+    connection.is_connected = hot.is_connected;
+    connection.connection_time = cold.connection_time;
+    connection.last_activity_time = hot.last_activity_time;
+    connection.bytes_sent = hot.bytes_sent;
+    connection.bytes_received = hot.bytes_received;
+    connection.packets_sent = hot.packets_sent;
+    connection.packets_received = hot.packets_received;
+    connection.current_rtt_ms = cold.current_rtt_ms;
+    connection.smoothed_rtt_ms = cold.smoothed_rtt_ms;
+    connection.rtt_variance_ms = cold.rtt_variance_ms;
+    connection.bandwidth_mbps = cold.bandwidth_mbps;
+    connection.congestion_window_size = hot.congestion_window_size;
+    connection.slow_start_threshold = cold.slow_start_threshold;
+    connection.duplicate_ack_count = cold.duplicate_ack_count;
+    connection.retransmission_count = cold.retransmission_count;
+    connection.qos_class = cold.qos_class;
+    connection.priority = cold.priority;
+    connection.is_real_time = cold.is_real_time;
+    connection.send_buffer = cold.send_buffer;
+    connection.receive_buffer = cold.receive_buffer;
+    connection.send_sequence = hot.send_sequence;
+    connection.receive_sequence = hot.receive_sequence;
+    return connection;
+}
+
+} // namespace S1U
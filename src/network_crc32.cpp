@@ -0,0 +1,298 @@
+#include "s1u/network_crc32.hpp"
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <cstring>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define S1U_CRC_X86 1
+#endif
+
+namespace S1U {
+
+namespace {
+
+using CrcTables = std::array<std::array<u32, 256>, 8>;
+
+constexpr CrcTables make_crc_tables(u32 reflected_polynomial) {
+    CrcTables tables{};
+    for (u32 i = 0; i < 256; i++) {
+        u32 crc = i;
+        for (int bit = 0; bit < 8; bit++) {
+            crc = (crc >> 1) ^ (reflected_polynomial & (0U - (crc & 1U)));
+        }
+        tables[0][i] = crc;
+    }
+
+    // tables[k][i] is the CRC of byte i followed by k zero bytes
+    for (u32 i = 0; i < 256; i++) {
+        for (size_t k = 1; k < tables.size(); k++) {
+            u32 previous = tables[k - 1][i];
+            tables[k][i] = (previous >> 8) ^ tables[0][previous & 0xFF];
+        }
+    }
+    return tables;
+}
+
+constexpr CrcTables CRC32_TABLES = make_crc_tables(0xEDB88320);
+constexpr CrcTables CRC32C_TABLES = make_crc_tables(0x82F63B78);
+
+// The register-level helpers below take and return the inverted CRC state;
+// the public entry points apply the pre/post conditioning once per call.
+
+u32 crc_bytes(const CrcTables& tables, u32 crc, const u8* data, size_t size) {
+    while (size--) {
+        crc = tables[0][(crc ^ *data++) & 0xFF] ^ (crc >> 8);
+    }
+    return crc;
+}
+
+u32 crc_slicing8(const CrcTables& tables, u32 crc, const u8* data, size_t size) {
+    size_t misalignment = reinterpret_cast<uintptr_t>(data) & 7;
+    if (misalignment) {
+        size_t head = std::min<size_t>(8 - misalignment, size);
+        crc = crc_bytes(tables, crc, data, head);
+        data += head;
+        size -= head;
+    }
+
+    while (size >= 8) {
+        u64 word;
+        std::memcpy(&word, data, sizeof(word));
+        word ^= crc;
+
+        crc = tables[7][word & 0xFF] ^
+              tables[6][(word >> 8) & 0xFF] ^
+              tables[5][(word >> 16) & 0xFF] ^
+              tables[4][(word >> 24) & 0xFF] ^
+              tables[3][(word >> 32) & 0xFF] ^
+              tables[2][(word >> 40) & 0xFF] ^
+              tables[1][(word >> 48) & 0xFF] ^
+              tables[0][word >> 56];
+
+        data += 8;
+        size -= 8;
+    }
+
+    return crc_bytes(tables, crc, data, size);
+}
+
+u32 crc32_slicing8(u32 crc, const u8* data, size_t size) {
+    return crc_slicing8(CRC32_TABLES, crc, data, size);
+}
+
+u32 crc32c_slicing8(u32 crc, const u8* data, size_t size) {
+    return crc_slicing8(CRC32C_TABLES, crc, data, size);
+}
+
+#ifdef S1U_CRC_X86
+
+__attribute__((target("sse4.2")))
+u32 crc32c_sse42(u32 crc, const u8* data, size_t size) {
+    while (size && (reinterpret_cast<uintptr_t>(data) & 7)) {
+        crc = _mm_crc32_u8(crc, *data++);
+        size--;
+    }
+
+#if defined(__x86_64__)
+    u64 crc64 = crc;
+    while (size >= 8) {
+        u64 word;
+        std::memcpy(&word, data, sizeof(word));
+        crc64 = _mm_crc32_u64(crc64, word);
+        data += 8;
+        size -= 8;
+    }
+    crc = static_cast<u32>(crc64);
+#endif
+
+    while (size >= 4) {
+        u32 word;
+        std::memcpy(&word, data, sizeof(word));
+        crc = _mm_crc32_u32(crc, word);
+        data += 4;
+        size -= 4;
+    }
+
+    while (size--) {
+        crc = _mm_crc32_u8(crc, *data++);
+    }
+    return crc;
+}
+
+// Carry-less multiply folding for the IEEE polynomial, after Gopal et al.,
+// "Fast CRC Computation for Generic Polynomials Using PCLMULQDQ". Folds four
+// 128-bit lanes in parallel, then reduces to 32 bits with a Barrett step.
+// Requires size >= 64 and a multiple of 16.
+__attribute__((target("pclmul,sse4.1")))
+u32 crc32_pclmul_blocks(u32 crc, const u8* data, size_t size) {
+    alignas(16) static const u64 k1k2[] = {0x0154442bd4, 0x01c6e41596};
+    alignas(16) static const u64 k3k4[] = {0x01751997d0, 0x00ccaa009e};
+    alignas(16) static const u64 k5k0[] = {0x0163cd6124, 0x0000000000};
+    alignas(16) static const u64 poly[] = {0x01db710641, 0x01f7011641};
+
+    __m128i x0, x1, x2, x3, x4, x5, x6, x7, x8;
+
+    x1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + 0x00));
+    x2 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + 0x10));
+    x3 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + 0x20));
+    x4 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + 0x30));
+    x1 = _mm_xor_si128(x1, _mm_cvtsi32_si128(static_cast<int>(crc)));
+    x0 = _mm_load_si128(reinterpret_cast<const __m128i*>(k1k2));
+
+    data += 64;
+    size -= 64;
+
+    while (size >= 64) {
+        x5 = _mm_clmulepi64_si128(x1, x0, 0x00);
+        x6 = _mm_clmulepi64_si128(x2, x0, 0x00);
+        x7 = _mm_clmulepi64_si128(x3, x0, 0x00);
+        x8 = _mm_clmulepi64_si128(x4, x0, 0x00);
+
+        x1 = _mm_clmulepi64_si128(x1, x0, 0x11);
+        x2 = _mm_clmulepi64_si128(x2, x0, 0x11);
+        x3 = _mm_clmulepi64_si128(x3, x0, 0x11);
+        x4 = _mm_clmulepi64_si128(x4, x0, 0x11);
+
+        x1 = _mm_xor_si128(_mm_xor_si128(x1, x5), _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + 0x00)));
+        x2 = _mm_xor_si128(_mm_xor_si128(x2, x6), _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + 0x10)));
+        x3 = _mm_xor_si128(_mm_xor_si128(x3, x7), _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + 0x20)));
+        x4 = _mm_xor_si128(_mm_xor_si128(x4, x8), _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + 0x30)));
+
+        data += 64;
+        size -= 64;
+    }
+
+    // Fold the four lanes into one
+    x0 = _mm_load_si128(reinterpret_cast<const __m128i*>(k3k4));
+
+    x5 = _mm_clmulepi64_si128(x1, x0, 0x00);
+    x1 = _mm_clmulepi64_si128(x1, x0, 0x11);
+    x1 = _mm_xor_si128(_mm_xor_si128(x1, x2), x5);
+
+    x5 = _mm_clmulepi64_si128(x1, x0, 0x00);
+    x1 = _mm_clmulepi64_si128(x1, x0, 0x11);
+    x1 = _mm_xor_si128(_mm_xor_si128(x1, x3), x5);
+
+    x5 = _mm_clmulepi64_si128(x1, x0, 0x00);
+    x1 = _mm_clmulepi64_si128(x1, x0, 0x11);
+    x1 = _mm_xor_si128(_mm_xor_si128(x1, x4), x5);
+
+    while (size >= 16) {
+        x2 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data));
+
+        x5 = _mm_clmulepi64_si128(x1, x0, 0x00);
+        x1 = _mm_clmulepi64_si128(x1, x0, 0x11);
+        x1 = _mm_xor_si128(_mm_xor_si128(x1, x2), x5);
+
+        data += 16;
+        size -= 16;
+    }
+
+    // 128 -> 64 bits
+    x2 = _mm_clmulepi64_si128(x1, x0, 0x10);
+    x3 = _mm_setr_epi32(~0, 0, ~0, 0);
+    x1 = _mm_srli_si128(x1, 8);
+    x1 = _mm_xor_si128(x1, x2);
+
+    x0 = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(k5k0));
+
+    x2 = _mm_srli_si128(x1, 4);
+    x1 = _mm_and_si128(x1, x3);
+    x1 = _mm_clmulepi64_si128(x1, x0, 0x00);
+    x1 = _mm_xor_si128(x1, x2);
+
+    // Barrett reduction to 32 bits
+    x0 = _mm_load_si128(reinterpret_cast<const __m128i*>(poly));
+
+    x2 = _mm_and_si128(x1, x3);
+    x2 = _mm_clmulepi64_si128(x2, x0, 0x10);
+    x2 = _mm_and_si128(x2, x3);
+    x2 = _mm_clmulepi64_si128(x2, x0, 0x00);
+    x1 = _mm_xor_si128(x1, x2);
+
+    return static_cast<u32>(_mm_extract_epi32(x1, 1));
+}
+
+u32 crc32_pclmul(u32 crc, const u8* data, size_t size) {
+    if (size < 64) {
+        return crc32_slicing8(crc, data, size);
+    }
+
+    size_t blocks = size & ~static_cast<size_t>(15);
+    crc = crc32_pclmul_blocks(crc, data, blocks);
+    return crc32_slicing8(crc, data + blocks, size - blocks);
+}
+
+#endif // S1U_CRC_X86
+
+using CrcFunction = u32 (*)(u32, const u8*, size_t);
+
+struct CrcDispatch {
+    CrcFunction crc32 = crc32_slicing8;
+    CrcBackend crc32_backend = CrcBackend::Slicing8;
+    CrcFunction crc32c = crc32c_slicing8;
+    CrcBackend crc32c_backend = CrcBackend::Slicing8;
+};
+
+CrcDispatch select_crc_backends() {
+    CrcDispatch dispatch;
+
+#ifdef S1U_CRC_X86
+    __builtin_cpu_init();
+
+    if (__builtin_cpu_supports("pclmul") && __builtin_cpu_supports("sse4.1")) {
+        dispatch.crc32 = crc32_pclmul;
+        dispatch.crc32_backend = CrcBackend::Pclmul;
+    }
+
+    if (__builtin_cpu_supports("sse4.2")) {
+        dispatch.crc32c = crc32c_sse42;
+        dispatch.crc32c_backend = CrcBackend::Sse42;
+    }
+#endif
+
+    return dispatch;
+}
+
+const CrcDispatch& get_crc_dispatch() {
+    static const CrcDispatch dispatch = select_crc_backends();
+    return dispatch;
+}
+
+} // namespace
+
+u32 crc32_update(u32 crc, const u8* data, size_t size) {
+    if (!data || size == 0) {
+        return crc;
+    }
+    return ~get_crc_dispatch().crc32(~crc, data, size);
+}
+
+u32 crc32c_update(u32 crc, const u8* data, size_t size) {
+    if (!data || size == 0) {
+        return crc;
+    }
+    return ~get_crc_dispatch().crc32c(~crc, data, size);
+}
+
+u32 crc_update(CrcVariant variant, u32 crc, const u8* data, size_t size) {
+    return variant == CrcVariant::Crc32C ? crc32c_update(crc, data, size) : crc32_update(crc, data, size);
+}
+
+CrcBackend get_crc_backend(CrcVariant variant) {
+    const CrcDispatch& dispatch = get_crc_dispatch();
+    return variant == CrcVariant::Crc32C ? dispatch.crc32c_backend : dispatch.crc32_backend;
+}
+
+const char* crc_backend_name(CrcBackend backend) {
+    switch (backend) {
+        case CrcBackend::Slicing8: return "slicing-by-8";
+        case CrcBackend::Sse42: return "sse4.2";
+        case CrcBackend::Pclmul: return "pclmulqdq";
+    }
+    return "unknown";
+}
+
+} // namespace S1U
@@ -0,0 +1,148 @@
+#include "s1u/network_pacing.hpp"
+#include <sys/socket.h>
+#include <netinet/in.h>
+// linux/tcp.h rather than netinet/tcp.h: glibc's tcp_info lacks the ack
+// and unsent byte counters
+#include <linux/tcp.h>
+#include <algorithm>
+#include <cstring>
+
+namespace S1U {
+
+namespace {
+
+constexpr u64 NS_PER_MS = 1000000;
+constexpr u64 BASE_BUCKET_NS = 60000ULL * NS_PER_MS;
+
+// Credit for idle time is capped at one quantum, so a connection that goes
+// quiet cannot come back with a line-rate burst
+constexpr u64 PACING_QUANTUM_NS = NS_PER_MS;
+
+// TCP_INFO is a syscall; never sample more often than this, whatever the RTT
+constexpr u64 MIN_SAMPLE_INTERVAL_NS = NS_PER_MS;
+constexpr u64 MAX_SAMPLE_INTERVAL_NS = 100 * NS_PER_MS;
+
+// RFC 6817 GAIN and ALLOWED_INCREASE
+constexpr f64 WINDOW_GAIN = 1.0;
+constexpr f64 ALLOWED_INCREASE_SEGMENTS = 1.0;
+
+constexpr f64 NO_DELAY = 1e300;
+
+} // namespace
+
+bool read_transport_sample(int socket_fd, TransportSample& sample) {
+    struct tcp_info info;
+    std::memset(&info, 0, sizeof(info));
+    socklen_t length = sizeof(info);
+    if (getsockopt(socket_fd, IPPROTO_TCP, TCP_INFO, &info, &length) != 0) {
+        return false;
+    }
+
+    sample.rtt_ms = info.tcpi_rtt / 1000.0;
+    sample.rtt_variance_ms = info.tcpi_rttvar / 1000.0;
+    sample.bytes_acked = info.tcpi_bytes_acked;
+    sample.total_retransmits = info.tcpi_total_retrans;
+    sample.mss = info.tcpi_snd_mss;
+    sample.bytes_in_flight = static_cast<u64>(info.tcpi_unacked) * info.tcpi_snd_mss + info.tcpi_notsent_bytes;
+    return sample.rtt_ms > 0.0;
+}
+
+void ConnectionPacer::initialize(const PacingConfig& config, u64 now_ns) {
+    config_ = config;
+    config_.min_window_segments = std::max(1U, config_.min_window_segments);
+    config_.max_window_segments = std::max(config_.min_window_segments, config_.max_window_segments);
+    config_.max_rate_mbps = std::max(config_.max_rate_mbps, 1.0);
+
+    mss_ = 1448.0;
+    window_bytes_ = std::clamp(config_.initial_window_segments, config_.min_window_segments,
+                               config_.max_window_segments) * mss_;
+    rtt_ms_ = 0.0;
+    queuing_delay_ms_ = 0.0;
+    std::fill(std::begin(base_delays_ms_), std::end(base_delays_ms_), NO_DELAY);
+    base_index_ = 0;
+    base_bucket_start_ns_ = now_ns;
+
+    next_send_ns_ = now_ns;
+    next_sample_ns_ = now_ns;
+    last_bytes_acked_ = 0;
+    last_retransmits_ = 0;
+    last_reduction_ns_ = 0;
+    have_sample_ = false;
+
+    // Until the first RTT is known the pacer stays out of the way
+    rate_bytes_per_ns_ = config_.max_rate_mbps / 8000.0;
+}
+
+void ConnectionPacer::on_send(u64 bytes, u64 now_ns) {
+    u64 earliest = now_ns > PACING_QUANTUM_NS ? now_ns - PACING_QUANTUM_NS : 0;
+    next_send_ns_ = std::max(next_send_ns_, earliest) + static_cast<u64>(bytes / rate_bytes_per_ns_);
+}
+
+void ConnectionPacer::on_transport_sample(const TransportSample& sample, u64 now_ns) {
+    if (sample.mss > 0) {
+        mss_ = sample.mss;
+    }
+    rtt_ms_ = sample.rtt_ms;
+    record_base_delay(sample.rtt_ms, now_ns);
+
+    u64 interval_ns = static_cast<u64>(sample.rtt_ms * NS_PER_MS);
+    next_sample_ns_ = now_ns + std::clamp(interval_ns, MIN_SAMPLE_INTERVAL_NS, MAX_SAMPLE_INTERVAL_NS);
+
+    if (!have_sample_) {
+        have_sample_ = true;
+        last_bytes_acked_ = sample.bytes_acked;
+        last_retransmits_ = sample.total_retransmits;
+        update_rate();
+        return;
+    }
+
+    f64 min_window = config_.min_window_segments * mss_;
+    f64 max_window = config_.max_window_segments * mss_;
+    queuing_delay_ms_ = std::max(0.0, sample.rtt_ms - get_base_delay_ms());
+
+    if (sample.total_retransmits != last_retransmits_) {
+        // Loss: halve, at most once per RTT
+        if (now_ns - last_reduction_ns_ >= interval_ns) {
+            window_bytes_ = std::max(min_window, window_bytes_ / 2.0);
+            last_reduction_ns_ = now_ns;
+        }
+    } else {
+        u64 acked = sample.bytes_acked - last_bytes_acked_;
+        f64 target = std::max(config_.target_delay_ms, 0.001);
+        f64 off_target = std::clamp((target - queuing_delay_ms_) / target, -1.0, 1.0);
+        f64 window = window_bytes_ + WINDOW_GAIN * off_target * acked * mss_ / window_bytes_;
+
+        // Only grow a window the sender is actually filling
+        if (window > window_bytes_) {
+            window = std::min(window, static_cast<f64>(sample.bytes_in_flight) + ALLOWED_INCREASE_SEGMENTS * mss_);
+            window = std::max(window, window_bytes_);
+        }
+        window_bytes_ = std::clamp(window, min_window, max_window);
+    }
+
+    last_bytes_acked_ = sample.bytes_acked;
+    last_retransmits_ = sample.total_retransmits;
+    update_rate();
+}
+
+f64 ConnectionPacer::get_base_delay_ms() const {
+    f64 base = *std::min_element(std::begin(base_delays_ms_), std::end(base_delays_ms_));
+    return base == NO_DELAY ? rtt_ms_ : base;
+}
+
+void ConnectionPacer::update_rate() {
+    // One window per RTT
+    f64 rtt_ns = std::max(rtt_ms_, 0.001) * NS_PER_MS;
+    rate_bytes_per_ns_ = std::min(window_bytes_ / rtt_ns, config_.max_rate_mbps / 8000.0);
+}
+
+void ConnectionPacer::record_base_delay(f64 rtt_ms, u64 now_ns) {
+    if (now_ns - base_bucket_start_ns_ >= BASE_BUCKET_NS) {
+        base_bucket_start_ns_ = now_ns;
+        base_index_ = (base_index_ + 1) % BASE_HISTORY;
+        base_delays_ms_[base_index_] = NO_DELAY;
+    }
+    base_delays_ms_[base_index_] = std::min(base_delays_ms_[base_index_], rtt_ms);
+}
+
+} // namespace S1U
@@ -0,0 +1,264 @@
+#include "s1u/network_packet_buffer.hpp"
+#include "s1u/memory_huge_pages.hpp"
+#include <sys/mman.h>
+#include <algorithm>
+#include <cstring>
+#include <new>
+#include <utility>
+
+namespace S1U {
+
+namespace {
+
+constexpr size_t PAGE_SIZE_BYTES = 4096;
+
+} // namespace
+
+PacketBuffer::PacketBuffer(const PacketBuffer& other)
+    : header_(other.header_), offset_(other.offset_), size_(other.size_) {
+    if (header_) {
+        header_->references.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+PacketBuffer& PacketBuffer::operator=(const PacketBuffer& other) {
+    if (this != &other) {
+        PacketBuffer copy(other);
+        swap(copy);
+    }
+    return *this;
+}
+
+PacketBuffer::PacketBuffer(PacketBuffer&& other) noexcept
+    : header_(other.header_), offset_(other.offset_), size_(other.size_) {
+    other.header_ = nullptr;
+    other.offset_ = 0;
+    other.size_ = 0;
+}
+
+PacketBuffer& PacketBuffer::operator=(PacketBuffer&& other) noexcept {
+    if (this != &other) {
+        reset();
+        swap(other);
+    }
+    return *this;
+}
+
+void PacketBuffer::swap(PacketBuffer& other) noexcept {
+    std::swap(header_, other.header_);
+    std::swap(offset_, other.offset_);
+    std::swap(size_, other.size_);
+}
+
+void PacketBuffer::reset() {
+    if (header_) {
+        // acq_rel so every write through another reference is visible before
+        // the block goes back on a free list
+        if (header_->references.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+            header_->pool->release(header_);
+        }
+        header_ = nullptr;
+    }
+    offset_ = 0;
+    size_ = 0;
+}
+
+u8* PacketBuffer::push_front(size_t bytes) {
+    if (!header_ || bytes > offset_) {
+        return nullptr;
+    }
+    offset_ -= static_cast<u32>(bytes);
+    size_ += static_cast<u32>(bytes);
+    return data();
+}
+
+u8* PacketBuffer::push_back(size_t bytes) {
+    if (!header_ || bytes > tailroom()) {
+        return nullptr;
+    }
+    u8* tail = data() + size_;
+    size_ += static_cast<u32>(bytes);
+    return tail;
+}
+
+void PacketBuffer::trim_front(size_t bytes) {
+    bytes = std::min<size_t>(bytes, size_);
+    offset_ += static_cast<u32>(bytes);
+    size_ -= static_cast<u32>(bytes);
+}
+
+void PacketBuffer::trim_back(size_t bytes) {
+    size_ -= static_cast<u32>(std::min<size_t>(bytes, size_));
+}
+
+PacketBufferPool::~PacketBufferPool() {
+    for (void* slab : slabs_) {
+        unmap_huge_pages(slab, SLAB_SIZE);
+    }
+}
+
+void PacketBufferPool::bind_to_current_thread() {
+    owner_ = std::this_thread::get_id();
+}
+
+u32 PacketBufferPool::class_for(size_t block_size) {
+    if (block_size > SLAB_SIZE) {
+        return OVERSIZE_CLASS;
+    }
+
+    u32 shift = block_size <= 1 ? 0 : 64 - static_cast<u32>(__builtin_clzll(block_size - 1));
+    return std::max(shift, MIN_CLASS_SHIFT) - MIN_CLASS_SHIFT;
+}
+
+PacketBuffer PacketBufferPool::allocate(size_t size) {
+    return allocate_with_room(size, HEADROOM, TAILROOM);
+}
+
+PacketBuffer PacketBufferPool::allocate_with_room(size_t size, size_t headroom, size_t tailroom) {
+    PacketBuffer buffer;
+    size_t block_size = sizeof(PacketBufferHeader) + headroom + size + tailroom;
+    u32 size_class = class_for(block_size);
+
+    PacketBufferHeader* header;
+    if (size_class == OVERSIZE_CLASS) {
+        header = allocate_oversize(block_size);
+    } else {
+        if (!free_lists_[size_class]) {
+            take_remote_frees();
+        }
+        if (!free_lists_[size_class] && !carve_slab(size_class)) {
+            header = nullptr;
+        } else {
+            header = free_lists_[size_class];
+            free_lists_[size_class] = header->next;
+        }
+    }
+
+    if (!header) {
+        add(allocation_failures_, 1);
+        return buffer;
+    }
+
+    header->next = nullptr;
+    header->references.store(1, std::memory_order_relaxed);
+    buffer.header_ = header;
+    buffer.offset_ = static_cast<u32>(headroom);
+    buffer.size_ = static_cast<u32>(size);
+    add(allocations_, 1);
+    return buffer;
+}
+
+PacketBufferHeader* PacketBufferPool::allocate_oversize(size_t block_size) {
+    size_t mapping_size = (block_size + PAGE_SIZE_BYTES - 1) & ~(PAGE_SIZE_BYTES - 1);
+    void* mapping = mmap(nullptr, mapping_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (mapping == MAP_FAILED) {
+        return nullptr;
+    }
+
+    PacketBufferHeader* header = new (mapping) PacketBufferHeader();
+    header->size_class = OVERSIZE_CLASS;
+    header->capacity = static_cast<u32>(mapping_size - sizeof(PacketBufferHeader));
+    header->pool = this;
+    add(oversize_allocations_, 1);
+    return header;
+}
+
+bool PacketBufferPool::carve_slab(u32 size_class) {
+    static_assert(SLAB_SIZE == HUGE_PAGE_SIZE);
+    HugePageBacking backing;
+    void* slab = map_huge_pages(SLAB_SIZE, HugePageBacking::Explicit, false, &backing);
+    if (!slab) {
+        return false;
+    }
+    slabs_.push_back(slab);
+
+    // Pushed in reverse so blocks are handed out in address order, which
+    // keeps a burst of receives on neighbouring pages
+    size_t block_size = size_t(1) << (MIN_CLASS_SHIFT + size_class);
+    size_t block_count = SLAB_SIZE / block_size;
+    u8* base = static_cast<u8*>(slab);
+    for (size_t i = block_count; i-- > 0;) {
+        PacketBufferHeader* header = new (base + i * block_size) PacketBufferHeader();
+        header->size_class = size_class;
+        header->capacity = static_cast<u32>(block_size - sizeof(PacketBufferHeader));
+        header->pool = this;
+        header->next = free_lists_[size_class];
+        free_lists_[size_class] = header;
+    }
+
+    add(slab_count_, 1);
+    add(reserved_bytes_, SLAB_SIZE);
+    if (backing != HugePageBacking::Regular) {
+        add(huge_page_bytes_, SLAB_SIZE);
+    }
+    return true;
+}
+
+void PacketBufferPool::take_remote_frees() {
+    PacketBufferHeader* header = remote_frees_.exchange(nullptr, std::memory_order_acquire);
+    while (header) {
+        PacketBufferHeader* next = header->next;
+        header->next = free_lists_[header->size_class];
+        free_lists_[header->size_class] = header;
+        header = next;
+    }
+}
+
+void PacketBufferPool::release(PacketBufferHeader* header) {
+    bool local = std::this_thread::get_id() == owner_;
+
+    if (header->size_class == OVERSIZE_CLASS) {
+        munmap(header, header->capacity + sizeof(PacketBufferHeader));
+    } else if (local) {
+        header->next = free_lists_[header->size_class];
+        free_lists_[header->size_class] = header;
+    } else {
+        // Push only; the owner takes the whole stack at once, so there is no
+        // single-node pop for ABA to break
+        PacketBufferHeader* head = remote_frees_.load(std::memory_order_relaxed);
+        do {
+            header->next = head;
+        } while (!remote_frees_.compare_exchange_weak(head, header, std::memory_order_release, std::memory_order_relaxed));
+    }
+
+    if (local) {
+        add(local_frees_, 1);
+    } else {
+        remote_free_count_.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+bool PacketBufferPool::make_writable(PacketBuffer& buffer, size_t headroom, size_t tailroom) {
+    if (buffer.valid() && !buffer.is_shared() && buffer.headroom() >= headroom && buffer.tailroom() >= tailroom) {
+        return true;
+    }
+
+    PacketBuffer copy = allocate_with_room(buffer.size(), std::max<size_t>(headroom, HEADROOM),
+                                           std::max<size_t>(tailroom, TAILROOM));
+    if (!copy.valid()) {
+        return false;
+    }
+
+    if (buffer.size() > 0) {
+        std::memcpy(copy.data(), buffer.data(), buffer.size());
+    }
+    buffer = std::move(copy);
+    return true;
+}
+
+PacketBufferPoolStats PacketBufferPool::get_stats() const {
+    PacketBufferPoolStats stats;
+    stats.slabs = slab_count_.load(std::memory_order_relaxed);
+    stats.reserved_bytes = reserved_bytes_.load(std::memory_order_relaxed);
+    stats.huge_page_bytes = huge_page_bytes_.load(std::memory_order_relaxed);
+    stats.allocations = allocations_.load(std::memory_order_relaxed);
+    stats.remote_frees = remote_free_count_.load(std::memory_order_relaxed);
+    stats.oversize_allocations = oversize_allocations_.load(std::memory_order_relaxed);
+    stats.allocation_failures = allocation_failures_.load(std::memory_order_relaxed);
+
+    u64 frees = local_frees_.load(std::memory_order_relaxed) + stats.remote_frees;
+    stats.buffers_in_use = stats.allocations > frees ? stats.allocations - frees : 0;
+    return stats;
+}
+
+} // namespace S1U
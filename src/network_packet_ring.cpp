@@ -0,0 +1,53 @@
+#include "s1u/network_packet_ring.hpp"
+#include <utility>
+
+namespace S1U {
+
+void PacketRing::reset(u32 capacity) {
+    u64 slots = 1;
+    while (slots < capacity) {
+        slots <<= 1;
+    }
+
+    slots_.clear();
+    slots_.resize(slots);
+    mask_ = slots - 1;
+    head_ = 0;
+    tail_ = 0;
+    dropped_ = 0;
+}
+
+bool PacketRing::push(DataPacket& packet, bool drop_oldest) {
+    if (slots_.empty()) {
+        return false;
+    }
+
+    if (full()) {
+        dropped_++;
+        if (!drop_oldest) {
+            return false;
+        }
+        head_++;
+    }
+
+    DataPacket& slot = slots_[tail_ & mask_];
+    std::swap(slot, packet);
+    packet.data.reset();
+    tail_++;
+    return true;
+}
+
+void PacketRing::pop_front() {
+    if (empty()) {
+        return;
+    }
+
+    // The payload goes back to its pool now rather than when the slot is
+    // next overwritten
+    DataPacket& slot = slots_[head_ & mask_];
+    slot.data.reset();
+    slot.size = 0;
+    head_++;
+}
+
+} // namespace S1U
@@ -0,0 +1,123 @@
+#include "s1u/network_reactor.hpp"
+#include <sys/eventfd.h>
+#include <pthread.h>
+#include <sched.h>
+#include <unistd.h>
+#include <utility>
+
+namespace S1U {
+
+ShardMailbox::~ShardMailbox() {
+    if (wake_fd_ != -1) {
+        close(wake_fd_);
+    }
+}
+
+bool ShardMailbox::initialize(u32 capacity) {
+    u64 slots = 2;
+    while (slots < capacity) {
+        slots <<= 1;
+    }
+
+    cells_ = std::make_unique<Cell[]>(slots);
+    for (u64 i = 0; i < slots; i++) {
+        cells_[i].sequence.store(i, std::memory_order_relaxed);
+    }
+    mask_ = slots - 1;
+    enqueue_position_.store(0, std::memory_order_relaxed);
+    dequeue_position_ = 0;
+
+    if (wake_fd_ == -1) {
+        wake_fd_ = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    }
+    return wake_fd_ != -1;
+}
+
+bool ShardMailbox::post(DataPacket& packet) {
+    Cell* cell;
+    u64 position = enqueue_position_.load(std::memory_order_relaxed);
+
+    while (true) {
+        cell = &cells_[position & mask_];
+        u64 sequence = cell->sequence.load(std::memory_order_acquire);
+        i64 difference = static_cast<i64>(sequence) - static_cast<i64>(position);
+
+        if (difference == 0) {
+            if (enqueue_position_.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+                break;
+            }
+        } else if (difference < 0) {
+            rejected_.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        } else {
+            position = enqueue_position_.load(std::memory_order_relaxed);
+        }
+    }
+
+    std::swap(cell->packet, packet);
+    packet.data.reset();
+    cell->sequence.store(position + 1, std::memory_order_release);
+
+    // One eventfd write per drain, not per packet
+    if (!wake_pending_.exchange(true, std::memory_order_acq_rel)) {
+        u64 signal = 1;
+        ssize_t written = write(wake_fd_, &signal, sizeof(signal));
+        (void)written;
+    }
+    return true;
+}
+
+bool ShardMailbox::take(DataPacket& packet) {
+    Cell& cell = cells_[dequeue_position_ & mask_];
+    if (cell.sequence.load(std::memory_order_acquire) != dequeue_position_ + 1) {
+        return false;
+    }
+
+    std::swap(cell.packet, packet);
+    cell.packet.data.reset();
+    cell.sequence.store(dequeue_position_ + mask_ + 1, std::memory_order_release);
+    dequeue_position_++;
+    return true;
+}
+
+void ShardMailbox::acknowledge_wake() {
+    u64 signal;
+    ssize_t bytes_read = read(wake_fd_, &signal, sizeof(signal));
+    (void)bytes_read;
+    wake_pending_.store(false, std::memory_order_release);
+}
+
+Vector<u32> get_available_cpus() {
+    Vector<u32> cpus;
+    cpu_set_t set;
+    CPU_ZERO(&set);
+
+    if (sched_getaffinity(0, sizeof(set), &set) == 0) {
+        for (u32 cpu = 0; cpu < CPU_SETSIZE; cpu++) {
+            if (CPU_ISSET(cpu, &set)) {
+                cpus.push_back(cpu);
+            }
+        }
+    }
+
+    if (cpus.empty()) {
+        u32 count = std::thread::hardware_concurrency();
+        for (u32 cpu = 0; cpu < (count ? count : 1); cpu++) {
+            cpus.push_back(cpu);
+        }
+    }
+    return cpus;
+}
+
+bool pin_current_thread_to_cpu(u32 cpu) {
+    if (cpu >= CPU_SETSIZE) {
+        return false;
+    }
+
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+}
+
+} // namespace S1U
@@ -0,0 +1,613 @@
+#include "s1u/network_remote_display.hpp"
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+
+namespace S1U {
+
+namespace {
+
+constexpr u64 PRIME1 = 0x9E3779B185EBCA87ULL;
+constexpr u64 PRIME2 = 0xC2B2AE3D27D4EB4FULL;
+constexpr u64 PRIME3 = 0x165667B19E3779F9ULL;
+constexpr u64 PRIME4 = 0x85EBCA77C2B2AE63ULL;
+
+// Client memory the cache may claim, whatever the stream asks for
+constexpr u64 MAX_CACHE_BYTES = 512ULL << 20;
+
+inline u64 rotl64(u64 value, int bits) {
+    return (value << bits) | (value >> (64 - bits));
+}
+
+inline u64 hash_round(u64 accumulator, u64 input) {
+    accumulator += input * PRIME2;
+    accumulator = rotl64(accumulator, 31);
+    return accumulator * PRIME1;
+}
+
+inline u64 hash_merge(u64 hash, u64 lane) {
+    hash ^= hash_round(0, lane);
+    return hash * PRIME1 + PRIME4;
+}
+
+inline u64 load_u64(const u8* p) {
+    u64 value;
+    std::memcpy(&value, p, sizeof(value));
+    return value;
+}
+
+inline u32 load_u32(const u8* p) {
+    u32 value;
+    std::memcpy(&value, p, sizeof(value));
+    return value;
+}
+
+template <typename T>
+void append_struct(Vector<u8>& output, const T& value) {
+    size_t offset = output.size();
+    output.resize(offset + sizeof(T));
+    std::memcpy(output.data() + offset, &value, sizeof(T));
+}
+
+} // namespace
+
+u64 hash_tile(const u8* pixels, u32 stride, u32 row_bytes, u32 rows) {
+    // The tile's shape is part of the seed, so clipped edge tiles never
+    // match full tiles that happen to start with the same bytes
+    u64 seed = (static_cast<u64>(row_bytes) << 32) | rows;
+    u64 v1 = seed + PRIME1 + PRIME2;
+    u64 v2 = seed + PRIME2;
+    u64 v3 = seed;
+    u64 v4 = seed - PRIME1;
+
+    for (u32 row = 0; row < rows; row++) {
+        const u8* p = pixels + static_cast<size_t>(row) * stride;
+        u32 remaining = row_bytes;
+
+        while (remaining >= 32) {
+            v1 = hash_round(v1, load_u64(p));
+            v2 = hash_round(v2, load_u64(p + 8));
+            v3 = hash_round(v3, load_u64(p + 16));
+            v4 = hash_round(v4, load_u64(p + 24));
+            p += 32;
+            remaining -= 32;
+        }
+        while (remaining >= 8) {
+            v1 = hash_round(v1, load_u64(p));
+            p += 8;
+            remaining -= 8;
+        }
+        while (remaining >= 4) {
+            v2 = hash_round(v2, load_u32(p));
+            p += 4;
+            remaining -= 4;
+        }
+        while (remaining > 0) {
+            v3 = hash_round(v3, *p);
+            p++;
+            remaining--;
+        }
+    }
+
+    u64 hash = rotl64(v1, 1) + rotl64(v2, 7) + rotl64(v3, 12) + rotl64(v4, 18);
+    hash = hash_merge(hash, v1);
+    hash = hash_merge(hash, v2);
+    hash = hash_merge(hash, v3);
+    hash = hash_merge(hash, v4);
+    hash += static_cast<u64>(row_bytes) * rows;
+
+    hash ^= hash >> 33;
+    hash *= PRIME2;
+    hash ^= hash >> 29;
+    hash *= PRIME3;
+    hash ^= hash >> 32;
+    return hash;
+}
+
+void RemoteTileCache::reset(u32 capacity) {
+    order_.clear();
+    entries_.clear();
+    entries_.reserve(capacity);
+    capacity_ = capacity;
+    next_slot_ = 0;
+}
+
+bool RemoteTileCache::touch(u64 hash, u32& slot) {
+    auto it = entries_.find(hash);
+    if (it == entries_.end()) {
+        return false;
+    }
+
+    order_.splice(order_.begin(), order_, it->second);
+    slot = it->second->slot;
+    return true;
+}
+
+u32 RemoteTileCache::insert(u64 hash) {
+    u32 slot;
+    if (entries_.size() < capacity_) {
+        slot = next_slot_++;
+    } else {
+        const Entry& victim = order_.back();
+        slot = victim.slot;
+        entries_.erase(victim.hash);
+        order_.pop_back();
+    }
+
+    order_.push_front(Entry{hash, slot});
+    entries_[hash] = order_.begin();
+    return slot;
+}
+
+bool RemoteDisplayEncoder::initialize(const RemoteDisplayConfig& config) {
+    if (config.tile_size < REMOTE_MIN_TILE_SIZE || config.tile_size > REMOTE_MAX_TILE_SIZE ||
+        config.cache_capacity == 0 ||
+        static_cast<u64>(config.cache_capacity) * config.tile_size * config.tile_size * 4 > MAX_CACHE_BYTES) {
+        return false;
+    }
+
+    // Tiles are independent frames; no dictionary, small window
+    if (!zstd_.initialize(config.zstd_level, 17, nullptr)) {
+        return false;
+    }
+
+    config_ = config;
+    width_ = 0;
+    height_ = 0;
+    frame_number_ = 0;
+    reset_pending_ = true;
+    stats_ = RemoteDisplayStats();
+    return true;
+}
+
+void RemoteDisplayEncoder::collect_damaged_tiles(const s1u::DamageRegion& damage) {
+    if (++mark_generation_ == 0) {
+        std::fill(tile_marks_.begin(), tile_marks_.end(), 0);
+        mark_generation_ = 1;
+    }
+
+    u32 tile_size = config_.tile_size;
+    for (const s1u::DamageRect& rect : damage.rects()) {
+        i32 x1 = std::max(rect.x1, 0);
+        i32 y1 = std::max(rect.y1, 0);
+        i32 x2 = std::min(rect.x2, static_cast<i32>(width_));
+        i32 y2 = std::min(rect.y2, static_cast<i32>(height_));
+        if (x2 <= x1 || y2 <= y1) {
+            continue;
+        }
+
+        u32 first_column = static_cast<u32>(x1) / tile_size;
+        u32 last_column = static_cast<u32>(x2 - 1) / tile_size;
+        u32 first_row = static_cast<u32>(y1) / tile_size;
+        u32 last_row = static_cast<u32>(y2 - 1) / tile_size;
+
+        for (u32 row = first_row; row <= last_row; row++) {
+            for (u32 column = first_column; column <= last_column; column++) {
+                u32 index = row * tiles_x_ + column;
+                if (tile_marks_[index] != mark_generation_) {
+                    tile_marks_[index] = mark_generation_;
+                    damaged_tiles_.push_back(index);
+                }
+            }
+        }
+    }
+
+    // Row-major order keeps the client's blits walking memory forwards
+    std::sort(damaged_tiles_.begin(), damaged_tiles_.end());
+}
+
+bool RemoteDisplayEncoder::encode_frame(const u8* pixels, u32 width, u32 height, u32 stride,
+                                        const s1u::DamageRegion& damage, Vector<u8>& output) {
+    if (!pixels || width == 0 || height == 0 || width > REMOTE_MAX_DIMENSION || height > REMOTE_MAX_DIMENSION ||
+        stride < width * 4 || config_.tile_size == 0) {
+        return false;
+    }
+
+    auto start_time = std::chrono::steady_clock::now();
+
+    if (width != width_ || height != height_) {
+        width_ = width;
+        height_ = height;
+        tiles_x_ = (width + config_.tile_size - 1) / config_.tile_size;
+        tiles_y_ = (height + config_.tile_size - 1) / config_.tile_size;
+        shown_hashes_.assign(tiles_x_ * tiles_y_, 0);
+        tile_marks_.assign(tiles_x_ * tiles_y_, 0);
+        mark_generation_ = 0;
+        reset_pending_ = true;
+    }
+
+    bool reset = reset_pending_;
+    reset_pending_ = false;
+
+    damaged_tiles_.clear();
+    if (reset) {
+        cache_.reset(config_.cache_capacity);
+        for (u32 i = 0; i < tiles_x_ * tiles_y_; i++) {
+            damaged_tiles_.push_back(i);
+        }
+    } else {
+        collect_damaged_tiles(damage);
+    }
+
+    RemoteFrameHeader header;
+    header.frame_number = frame_number_++;
+    header.flags = reset ? REMOTE_FRAME_RESET : 0;
+    header.width = static_cast<u16>(width);
+    header.height = static_cast<u16>(height);
+    header.tile_size = static_cast<u16>(config_.tile_size);
+    header.cache_capacity = config_.cache_capacity;
+
+    output.clear();
+    append_struct(output, header);
+
+    u32 tile_count = 0;
+    for (u32 tile_index : damaged_tiles_) {
+        u32 x = (tile_index % tiles_x_) * config_.tile_size;
+        u32 y = (tile_index / tiles_x_) * config_.tile_size;
+        u32 w = std::min(config_.tile_size, width_ - x);
+        u32 h = std::min(config_.tile_size, height_ - y);
+        u64 hash = hash_tile(pixels + static_cast<size_t>(y) * stride + x * 4, stride, w * 4, h);
+
+        stats_.tiles_damaged++;
+
+        // Damage is a hint; a tile repainted with the same pixels costs
+        // nothing on the wire
+        if (!reset && shown_hashes_[tile_index] == hash) {
+            stats_.tiles_unchanged++;
+            continue;
+        }
+        shown_hashes_[tile_index] = hash;
+
+        RemoteTileHeader tile;
+        tile.tile_index = tile_index;
+        tile.hash = hash;
+
+        u32 slot;
+        if (cache_.touch(hash, slot)) {
+            tile.kind = static_cast<u8>(RemoteTileKind::Cached);
+            append_struct(output, tile);
+            stats_.tiles_cached++;
+            tile_count++;
+            continue;
+        }
+
+        cache_.insert(hash);
+        if (!append_tile(pixels, stride, tile_index, hash, output)) {
+            return false;
+        }
+        tile_count++;
+    }
+
+    std::memcpy(output.data() + offsetof(RemoteFrameHeader, tile_count), &tile_count, sizeof(tile_count));
+
+    stats_.frames++;
+    stats_.encoded_bytes += output.size();
+    stats_.encode_time_ms += std::chrono::duration<f64, std::milli>(std::chrono::steady_clock::now() - start_time).count();
+    return true;
+}
+
+bool RemoteDisplayEncoder::append_tile(const u8* pixels, u32 stride, u32 tile_index, u64 hash, Vector<u8>& output) {
+    u32 x = (tile_index % tiles_x_) * config_.tile_size;
+    u32 y = (tile_index / tiles_x_) * config_.tile_size;
+    u32 w = std::min(config_.tile_size, width_ - x);
+    u32 h = std::min(config_.tile_size, height_ - y);
+    u32 row_bytes = w * 4;
+
+    tile_pixels_.resize(static_cast<size_t>(row_bytes) * h);
+    const u8* source = pixels + static_cast<size_t>(y) * stride + x * 4;
+    for (u32 row = 0; row < h; row++) {
+        std::memcpy(tile_pixels_.data() + static_cast<size_t>(row) * row_bytes, source + static_cast<size_t>(row) * stride, row_bytes);
+    }
+
+    RemoteTileHeader tile;
+    tile.tile_index = tile_index;
+    tile.kind = static_cast<u8>(RemoteTileKind::Data);
+    tile.hash = hash;
+
+    const Vector<u8>* payload = &tile_pixels_;
+    CompressionType algorithm = select_compression_algorithm(config_.compression, config_.link_mbps);
+
+    if (tile_pixels_.size() >= config_.compression.min_size) {
+        bool compressed = false;
+        if (algorithm == CompressionType::LZ4) {
+            compressed = lz4_.compress(tile_pixels_.data(), tile_pixels_.size(), compressed_,
+                                       static_cast<int>(config_.lz4_acceleration));
+        } else if (algorithm == CompressionType::ZSTD) {
+            zstd_.set_level(config_.zstd_level);
+            compressed = zstd_.compress_message(tile_pixels_.data(), tile_pixels_.size(), compressed_);
+        }
+
+        if (compressed && compressed_.size() < tile_pixels_.size()) {
+            tile.compression = static_cast<u8>(algorithm);
+            payload = &compressed_;
+            stats_.tiles_compressed++;
+        }
+    }
+
+    tile.payload_size = static_cast<u32>(payload->size());
+    append_struct(output, tile);
+    output.insert(output.end(), payload->begin(), payload->end());
+
+    stats_.tiles_sent++;
+    stats_.raw_bytes += tile_pixels_.size();
+    return true;
+}
+
+RemoteDisplayStream::~RemoteDisplayStream() {
+    shutdown();
+}
+
+bool RemoteDisplayStream::initialize(const RemoteDisplayStreamConfig& config) {
+    shutdown();
+    if (config.max_queued_bytes == 0 || !encoder_.initialize(config.encoder)) {
+        return false;
+    }
+
+    int fd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (fd < 0) {
+        return false;
+    }
+
+    int reuse = 1;
+    setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+
+    struct sockaddr_in address {};
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(config.loopback_only ? INADDR_LOOPBACK : INADDR_ANY);
+    address.sin_port = htons(config.port);
+    socklen_t length = sizeof(address);
+
+    if (bind(fd, reinterpret_cast<struct sockaddr*>(&address), sizeof(address)) != 0 || listen(fd, 8) != 0 ||
+        getsockname(fd, reinterpret_cast<struct sockaddr*>(&address), &length) != 0) {
+        close(fd);
+        return false;
+    }
+
+    config_ = config;
+    listen_fd_ = fd;
+    port_ = ntohs(address.sin_port);
+    return true;
+}
+
+void RemoteDisplayStream::shutdown() {
+    for (Viewer& viewer : viewers_) {
+        close(viewer.socket_fd);
+    }
+    viewers_.clear();
+
+    if (listen_fd_ >= 0) {
+        close(listen_fd_);
+        listen_fd_ = -1;
+    }
+    port_ = 0;
+}
+
+bool RemoteDisplayStream::accept_viewers() {
+    bool accepted = false;
+    for (;;) {
+        int fd = accept4(listen_fd_, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (fd < 0) {
+            if (errno == EINTR || errno == ECONNABORTED) {
+                continue;
+            }
+            return accepted;
+        }
+
+        int nodelay = 1;
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &nodelay, sizeof(nodelay));
+
+        Viewer viewer;
+        viewer.socket_fd = fd;
+        viewers_.push_back(std::move(viewer));
+        accepted = true;
+    }
+}
+
+bool RemoteDisplayStream::flush_viewer(Viewer& viewer) {
+    while (viewer.sent < viewer.pending.size()) {
+        ssize_t written = send(viewer.socket_fd, viewer.pending.data() + viewer.sent,
+                               viewer.pending.size() - viewer.sent, MSG_DONTWAIT | MSG_NOSIGNAL);
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return errno == EAGAIN || errno == EWOULDBLOCK;
+        }
+        viewer.sent += static_cast<size_t>(written);
+    }
+
+    viewer.pending.clear();
+    viewer.sent = 0;
+    return true;
+}
+
+void RemoteDisplayStream::drop_viewer(size_t index) {
+    close(viewers_[index].socket_fd);
+    viewers_[index] = std::move(viewers_.back());
+    viewers_.pop_back();
+    viewers_dropped_++;
+}
+
+void RemoteDisplayStream::submit_frame(const u8* pixels, u32 width, u32 height, u32 stride,
+                                       const s1u::DamageRegion& damage) {
+    if (listen_fd_ < 0) {
+        return;
+    }
+
+    // Viewers share the encoder's tile cache, so a new one resets them all
+    bool joined = accept_viewers();
+    if (joined) {
+        encoder_.request_reset();
+    }
+
+    if (!viewers_.empty() && (joined || !damage.is_empty())) {
+        if (!encoder_.encode_frame(pixels, width, height, stride, damage, message_)) {
+            // Nobody can follow a screen the encoder rejects
+            while (!viewers_.empty()) {
+                drop_viewer(viewers_.size() - 1);
+            }
+            return;
+        }
+
+        u32 size = static_cast<u32>(message_.size());
+        for (size_t i = viewers_.size(); i-- > 0;) {
+            Viewer& viewer = viewers_[i];
+            viewer.pending.erase(viewer.pending.begin(), viewer.pending.begin() + viewer.sent);
+            viewer.sent = 0;
+
+            // One frame always fits, however large; a backlog does not
+            if (viewer.pending.size() > config_.max_queued_bytes) {
+                drop_viewer(i);
+                continue;
+            }
+            const u8* size_bytes = reinterpret_cast<const u8*>(&size);
+            viewer.pending.insert(viewer.pending.end(), size_bytes, size_bytes + sizeof(size));
+            viewer.pending.insert(viewer.pending.end(), message_.begin(), message_.end());
+        }
+    }
+
+    for (size_t i = viewers_.size(); i-- > 0;) {
+        if (!flush_viewer(viewers_[i])) {
+            drop_viewer(i);
+        }
+    }
+}
+
+bool RemoteDisplayDecoder::decode_frame(const u8* data, size_t size) {
+    RemoteFrameHeader header;
+    if (!data || size < sizeof(header)) {
+        return false;
+    }
+    std::memcpy(&header, data, sizeof(header));
+
+    if (header.magic != REMOTE_DISPLAY_MAGIC || header.width == 0 || header.height == 0 ||
+        header.width > REMOTE_MAX_DIMENSION || header.height > REMOTE_MAX_DIMENSION ||
+        header.tile_size < REMOTE_MIN_TILE_SIZE || header.tile_size > REMOTE_MAX_TILE_SIZE) {
+        return false;
+    }
+
+    if (header.flags & REMOTE_FRAME_RESET) {
+        u64 cache_bytes = static_cast<u64>(header.cache_capacity) * header.tile_size * header.tile_size * 4;
+        if (header.cache_capacity == 0 || cache_bytes > MAX_CACHE_BYTES) {
+            return false;
+        }
+
+        width_ = header.width;
+        height_ = header.height;
+        tile_size_ = header.tile_size;
+        tiles_x_ = (width_ + tile_size_ - 1) / tile_size_;
+        tiles_y_ = (height_ + tile_size_ - 1) / tile_size_;
+        framebuffer_.assign(static_cast<size_t>(width_) * height_ * 4, 0);
+
+        if (!zstd_.initialize(1, 17, nullptr)) {
+            return false;
+        }
+        cache_.reset(header.cache_capacity);
+        cache_slots_.clear();
+        cache_slots_.resize(header.cache_capacity);
+    } else if (header.width != width_ || header.height != height_ || header.tile_size != tile_size_ ||
+               header.cache_capacity != cache_.capacity()) {
+        // Geometry only changes together with a reset
+        return false;
+    }
+
+    size_t offset = sizeof(header);
+    for (u32 i = 0; i < header.tile_count; i++) {
+        RemoteTileHeader tile;
+        if (size - offset < sizeof(tile)) {
+            return false;
+        }
+        std::memcpy(&tile, data + offset, sizeof(tile));
+        offset += sizeof(tile);
+
+        if (size - offset < tile.payload_size) {
+            return false;
+        }
+        if (!apply_tile(tile, data + offset)) {
+            return false;
+        }
+        offset += tile.payload_size;
+    }
+
+    frame_number_ = header.frame_number;
+    return offset == size;
+}
+
+void RemoteDisplayDecoder::tile_rect(u32 tile_index, u32& x, u32& y, u32& w, u32& h) const {
+    x = (tile_index % tiles_x_) * tile_size_;
+    y = (tile_index / tiles_x_) * tile_size_;
+    w = std::min(tile_size_, width_ - x);
+    h = std::min(tile_size_, height_ - y);
+}
+
+void RemoteDisplayDecoder::blit_tile(const u8* tile_pixels, u32 tile_index) {
+    u32 x, y, w, h;
+    tile_rect(tile_index, x, y, w, h);
+
+    u32 row_bytes = w * 4;
+    u8* destination = framebuffer_.data() + (static_cast<size_t>(y) * width_ + x) * 4;
+    for (u32 row = 0; row < h; row++) {
+        std::memcpy(destination + static_cast<size_t>(row) * width_ * 4, tile_pixels + static_cast<size_t>(row) * row_bytes, row_bytes);
+    }
+}
+
+bool RemoteDisplayDecoder::apply_tile(const RemoteTileHeader& tile, const u8* payload) {
+    if (tile.tile_index >= tiles_x_ * tiles_y_) {
+        return false;
+    }
+
+    u32 x, y, w, h;
+    tile_rect(tile.tile_index, x, y, w, h);
+    size_t expected_size = static_cast<size_t>(w) * h * 4;
+
+    u32 slot;
+    if (tile.kind == static_cast<u8>(RemoteTileKind::Cached)) {
+        if (tile.payload_size != 0 || !cache_.touch(tile.hash, slot) || cache_slots_[slot].size() != expected_size) {
+            return false;
+        }
+        blit_tile(cache_slots_[slot].data(), tile.tile_index);
+        return true;
+    }
+
+    // The encoder only sends data for tiles the client lacks; anything else
+    // means the two caches have diverged
+    if (tile.kind != static_cast<u8>(RemoteTileKind::Data) || cache_.touch(tile.hash, slot)) {
+        return false;
+    }
+
+    CompressionType compression = static_cast<CompressionType>(tile.compression);
+    bool decoded;
+    switch (compression) {
+        case CompressionType::None:
+            tile_pixels_.assign(payload, payload + tile.payload_size);
+            decoded = true;
+            break;
+        case CompressionType::LZ4:
+            decoded = Lz4Compressor::decompress(payload, tile.payload_size, tile_pixels_, expected_size);
+            break;
+        case CompressionType::ZSTD:
+            decoded = zstd_.decompress_message(payload, tile.payload_size, tile_pixels_, expected_size);
+            break;
+        default:
+            decoded = false;
+            break;
+    }
+
+    if (!decoded || tile_pixels_.size() != expected_size ||
+        hash_tile(tile_pixels_.data(), w * 4, w * 4, h) != tile.hash) {
+        return false;
+    }
+
+    slot = cache_.insert(tile.hash);
+    cache_slots_[slot].assign(tile_pixels_.begin(), tile_pixels_.end());
+    blit_tile(tile_pixels_.data(), tile.tile_index);
+    return true;
+}
+
+} // namespace S1U
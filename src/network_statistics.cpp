@@ -0,0 +1,108 @@
+#include "s1u/network_statistics.hpp"
+#include <algorithm>
+#include <cmath>
+
+namespace S1U {
+
+u32 LatencyHistogram::bucket_for(u64 nanoseconds) {
+    if (nanoseconds < SUB_BUCKETS) {
+        return static_cast<u32>(nanoseconds);
+    }
+
+    u32 exponent = 63 - static_cast<u32>(__builtin_clzll(nanoseconds));
+    if (exponent > MAX_EXPONENT) {
+        return BUCKET_COUNT - 1;
+    }
+
+    // The top bit selects the octave and the next four the sub-bucket
+    u32 shift = exponent - 4;
+    return (exponent - 3) * SUB_BUCKETS + static_cast<u32>((nanoseconds >> shift) & (SUB_BUCKETS - 1));
+}
+
+u64 LatencyHistogram::bucket_value(u32 bucket) {
+    if (bucket < SUB_BUCKETS) {
+        return bucket;
+    }
+
+    // Midpoint of the bucket's range
+    u32 exponent = bucket / SUB_BUCKETS + 3;
+    u64 sub_bucket = bucket % SUB_BUCKETS;
+    u32 shift = exponent - 4;
+    return ((SUB_BUCKETS + sub_bucket) << shift) + ((1ULL << shift) >> 1);
+}
+
+void StatisticsTotals::add(const ShardStatistics& shard) {
+    packets_sent += shard.packets_sent.load();
+    bytes_sent += shard.bytes_sent.load();
+    packets_received += shard.packets_received.load();
+    bytes_received += shard.bytes_received.load();
+
+    encryption_operations += shard.encryption_operations.load();
+    encryption_time_ns += shard.encryption_time_ns.load();
+    authentication_failures += shard.authentication_failures.load();
+
+    compression_operations += shard.compression_operations.load();
+    compression_skipped += shard.compression_skipped.load();
+    compression_input_bytes += shard.compression_input_bytes.load();
+    compression_output_bytes += shard.compression_output_bytes.load();
+
+    for (u32 i = 0; i < COMPRESSION_CLASS_COUNT; i++) {
+        const ShardStatistics::CompressionClassCounters& counters = shard.compression_by_class[i];
+        CompressionClassTotals& totals = compression_by_class[i];
+        totals.messages += counters.messages.load();
+        totals.skipped += counters.skipped.load();
+        totals.lz4_messages += counters.lz4_messages.load();
+        totals.zstd_messages += counters.zstd_messages.load();
+        totals.input_bytes += counters.input_bytes.load();
+        totals.output_bytes += counters.output_bytes.load();
+        totals.time_ns += counters.time_ns.load();
+    }
+}
+
+void LatencySnapshot::add(const LatencyHistogram& histogram) {
+    for (u32 i = 0; i < LatencyHistogram::BUCKET_COUNT; i++) {
+        u64 count = histogram.bucket_count(i);
+        buckets[i] += count;
+        total += count;
+    }
+}
+
+void LatencySnapshot::subtract(const LatencySnapshot& earlier) {
+    // Counters only grow, so every bucket is at least its earlier value
+    for (u32 i = 0; i < LatencyHistogram::BUCKET_COUNT; i++) {
+        buckets[i] -= earlier.buckets[i];
+    }
+    total -= earlier.total;
+}
+
+u64 LatencySnapshot::percentile_ns(f64 quantile) const {
+    if (total == 0) {
+        return 0;
+    }
+
+    u64 rank = static_cast<u64>(std::ceil(std::clamp(quantile, 0.0, 1.0) * total));
+    rank = std::max<u64>(rank, 1);
+
+    u64 seen = 0;
+    for (u32 i = 0; i < LatencyHistogram::BUCKET_COUNT; i++) {
+        seen += buckets[i];
+        if (seen >= rank) {
+            return LatencyHistogram::bucket_value(i);
+        }
+    }
+    return LatencyHistogram::bucket_value(LatencyHistogram::BUCKET_COUNT - 1);
+}
+
+u64 LatencySnapshot::mean_ns() const {
+    if (total == 0) {
+        return 0;
+    }
+
+    f64 sum = 0.0;
+    for (u32 i = 0; i < LatencyHistogram::BUCKET_COUNT; i++) {
+        sum += static_cast<f64>(buckets[i]) * LatencyHistogram::bucket_value(i);
+    }
+    return static_cast<u64>(sum / total);
+}
+
+} // namespace S1U
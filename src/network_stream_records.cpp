@@ -0,0 +1,83 @@
+#include "s1u/network_stream_records.hpp"
+#include <algorithm>
+#include <cstring>
+
+namespace S1U {
+
+namespace {
+
+u32 read_stream_record_prefix(const u8* prefix) {
+    return static_cast<u32>(prefix[0]) | (static_cast<u32>(prefix[1]) << 8) |
+           (static_cast<u32>(prefix[2]) << 16) | (static_cast<u32>(prefix[3]) << 24);
+}
+
+bool is_valid_record_size(u32 record_size, u32 max_record_size) {
+    return record_size > 0 && record_size <= max_record_size;
+}
+
+} // namespace
+
+void write_stream_record_prefix(u8* prefix, u32 record_size) {
+    prefix[0] = static_cast<u8>(record_size);
+    prefix[1] = static_cast<u8>(record_size >> 8);
+    prefix[2] = static_cast<u8>(record_size >> 16);
+    prefix[3] = static_cast<u8>(record_size >> 24);
+}
+
+StreamRecordStatus StreamRecordAssembler::take(const u8*& input, size_t& remaining, u32 max_record_size,
+                                               PacketBufferPool& pool, PacketBuffer& record) {
+    while (remaining > 0) {
+        if (prefix_bytes_ < STREAM_RECORD_PREFIX_SIZE) {
+            size_t count = std::min(STREAM_RECORD_PREFIX_SIZE - prefix_bytes_, remaining);
+            std::memcpy(prefix_ + prefix_bytes_, input, count);
+            prefix_bytes_ += static_cast<u32>(count);
+            input += count;
+            remaining -= count;
+            if (prefix_bytes_ < STREAM_RECORD_PREFIX_SIZE) {
+                break;
+            }
+
+            // The length is checked before anything is allocated for it
+            record_size_ = read_stream_record_prefix(prefix_);
+            if (!is_valid_record_size(record_size_, max_record_size)) {
+                return StreamRecordStatus::Failed;
+            }
+            record_ = pool.allocate(record_size_);
+            if (!record_.valid()) {
+                return StreamRecordStatus::Failed;
+            }
+            record_bytes_ = 0;
+        }
+
+        size_t count = std::min<size_t>(record_size_ - record_bytes_, remaining);
+        std::memcpy(record_.data() + record_bytes_, input, count);
+        record_bytes_ += static_cast<u32>(count);
+        input += count;
+        remaining -= count;
+
+        if (record_bytes_ == record_size_) {
+            record = std::move(record_);
+            reset();
+            return StreamRecordStatus::Complete;
+        }
+    }
+
+    return StreamRecordStatus::NeedMore;
+}
+
+void StreamRecordAssembler::reset() {
+    prefix_bytes_ = 0;
+    record_size_ = 0;
+    record_bytes_ = 0;
+    record_.reset();
+}
+
+bool StreamRecordAssembler::is_single_record(const u8* data, size_t size, u32 max_record_size) {
+    if (size <= STREAM_RECORD_PREFIX_SIZE) {
+        return false;
+    }
+    u32 record_size = read_stream_record_prefix(data);
+    return is_valid_record_size(record_size, max_record_size) && record_size == size - STREAM_RECORD_PREFIX_SIZE;
+}
+
+} // namespace S1U
@@ -0,0 +1,169 @@
+#include "s1u/network_zerocopy.hpp"
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <linux/errqueue.h>
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+
+#ifndef SO_ZEROCOPY
+#define SO_ZEROCOPY 60
+#endif
+#ifndef MSG_ZEROCOPY
+#define MSG_ZEROCOPY 0x4000000
+#endif
+#ifndef SO_EE_ORIGIN_ZEROCOPY
+#define SO_EE_ORIGIN_ZEROCOPY 5
+#endif
+#ifndef SO_EE_CODE_ZEROCOPY_COPIED
+#define SO_EE_CODE_ZEROCOPY_COPIED 1
+#endif
+
+namespace S1U {
+
+namespace {
+
+// After the kernel reports it copied a zero-copy send (loopback, or a device
+// without scatter-gather), the socket pays for both the copy and the
+// notification; send this many by copy before trying again
+constexpr u32 COPIED_BACKOFF_SENDS = 1024;
+
+} // namespace
+
+bool enable_socket_zero_copy(int socket_fd) {
+    int opt = 1;
+    return setsockopt(socket_fd, SOL_SOCKET, SO_ZEROCOPY, &opt, sizeof(opt)) == 0;
+}
+
+void ZeroCopySender::initialize(u32 min_size, u64 max_pending_bytes) {
+    min_size_ = min_size;
+    max_pending_bytes_ = max_pending_bytes;
+}
+
+ssize_t ZeroCopySender::send(int socket_fd, ZeroCopySendQueue& queue, const PacketBuffer& payload, size_t offset) {
+    const u8* data = payload.data() + offset;
+    size_t size = payload.size() - offset;
+
+    bool zero_copy = size >= min_size_;
+    if (zero_copy && queue.copy_sends_remaining_ > 0) {
+        queue.copy_sends_remaining_--;
+        zero_copy = false;
+    }
+
+    if (zero_copy && queue.pending_bytes_ + size > max_pending_bytes_) {
+        drain_completions(socket_fd, queue);
+        zero_copy = queue.pending_bytes_ + size <= max_pending_bytes_;
+    }
+
+    if (zero_copy) {
+        ssize_t bytes_sent = ::send(socket_fd, data, size, MSG_NOSIGNAL | MSG_ZEROCOPY);
+        if (bytes_sent > 0) {
+            // The kernel numbered this send and pinned only the bytes it
+            // took; the rest goes out with the next send from the new offset
+            queue.pending_.emplace_back();
+            ZeroCopySendQueue::PendingSend& pending = queue.pending_.back();
+            pending.payload = payload;
+            pending.payload.trim_front(offset);
+            pending.payload.trim_back(size - static_cast<size_t>(bytes_sent));
+            queue.pending_bytes_ += pending.payload.size();
+            stats_.pending_bytes.add(pending.payload.size());
+            stats_.sends.increment();
+            return bytes_sent;
+        }
+
+        // ENOBUFS means the socket is out of option memory for
+        // notifications; reap what is there and copy this one
+        if (bytes_sent == 0 || errno != ENOBUFS) {
+            return bytes_sent;
+        }
+        drain_completions(socket_fd, queue);
+    }
+
+    stats_.copy_sends.increment();
+    return ::send(socket_fd, data, size, MSG_NOSIGNAL);
+}
+
+void ZeroCopySender::drain_completions(int socket_fd, ZeroCopySendQueue& queue) {
+    alignas(struct cmsghdr) char control[CMSG_SPACE(sizeof(struct sock_extended_err) + sizeof(struct sockaddr_in6))];
+
+    while (!queue.pending_.empty()) {
+        struct msghdr message = {};
+        message.msg_control = control;
+        message.msg_controllen = sizeof(control);
+
+        if (recvmsg(socket_fd, &message, MSG_ERRQUEUE) == -1) {
+            break;
+        }
+        stats_.notifications.increment();
+
+        for (struct cmsghdr* cmsg = CMSG_FIRSTHDR(&message); cmsg; cmsg = CMSG_NXTHDR(&message, cmsg)) {
+            bool is_error = (cmsg->cmsg_level == SOL_IP && cmsg->cmsg_type == IP_RECVERR) ||
+                            (cmsg->cmsg_level == SOL_IPV6 && cmsg->cmsg_type == IPV6_RECVERR);
+            if (!is_error) {
+                continue;
+            }
+
+            struct sock_extended_err error;
+            std::memcpy(&error, CMSG_DATA(cmsg), sizeof(error));
+            if (error.ee_errno != 0 || error.ee_origin != SO_EE_ORIGIN_ZEROCOPY) {
+                continue;
+            }
+
+            // ee_info..ee_data is an inclusive range of send ids
+            u32 completed = complete_range(queue, error.ee_info, error.ee_data);
+            if (error.ee_code & SO_EE_CODE_ZEROCOPY_COPIED) {
+                stats_.copied.add(completed);
+                queue.copy_sends_remaining_ = COPIED_BACKOFF_SENDS;
+            }
+        }
+    }
+}
+
+u32 ZeroCopySender::complete_range(ZeroCopySendQueue& queue, u32 first, u32 last) {
+    // Offsets from the front in u32 arithmetic, so the ids may wrap
+    u32 size = static_cast<u32>(queue.pending_.size());
+    u32 begin = first - queue.first_id_;
+    u32 end = last - queue.first_id_;
+    if (begin >= size || end < begin) {
+        return 0;
+    }
+    end = std::min(end, size - 1);
+
+    u32 completed = 0;
+    for (u32 i = begin; i <= end; i++) {
+        if (!queue.pending_[i].completed) {
+            queue.pending_[i].completed = true;
+            completed++;
+        }
+    }
+    stats_.completions.add(completed);
+
+    while (!queue.pending_.empty() && queue.pending_.front().completed) {
+        size_t payload_size = queue.pending_.front().payload.size();
+        queue.pending_bytes_ -= payload_size;
+        stats_.pending_bytes.subtract(payload_size);
+        queue.pending_.pop_front();
+        queue.first_id_++;
+    }
+
+    return completed;
+}
+
+void ZeroCopySender::discard(ZeroCopySendQueue& queue) {
+    stats_.pending_bytes.subtract(queue.pending_bytes_);
+    queue.pending_.clear();
+    queue.pending_bytes_ = 0;
+}
+
+ZeroCopyStats ZeroCopySender::get_stats() const {
+    ZeroCopyStats stats;
+    stats.sends = stats_.sends.load();
+    stats.completions = stats_.completions.load();
+    stats.copied = stats_.copied.load();
+    stats.copy_sends = stats_.copy_sends.load();
+    stats.notifications = stats_.notifications.load();
+    stats.pending_bytes = stats_.pending_bytes.load();
+    return stats;
+}
+
+} // namespace S1U
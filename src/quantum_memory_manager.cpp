@@ -1,40 +1,89 @@
 #include "s1u/quantum_memory_manager.hpp"
 #include "s1u/core.hpp"
-#include <vulkan/vulkan.h>
+#include "s1u/memory_huge_pages.hpp"
+#include "s1u/memory_page_map.hpp"
+#include "s1u/memory_size_classes.hpp"
+#include "s1u/memory_thread_cache.hpp"
 #include <immintrin.h>
 #include <numa.h>
+#include <numaif.h>
 #include <sys/mman.h>
 #include <sys/resource.h>
 #include <unistd.h>
 #include <fcntl.h>
 #include <cmath>
+#include <cstring>
 #include <algorithm>
 #include <thread>
 #include <chrono>
 #include <atomic>
 #include <mutex>
 #include <shared_mutex>
+#include <new>
 
 namespace S1U {
 
-class QuantumMemoryManager::Impl {
+namespace {
+
+constexpr u32 ALLOCATION_HEADER_MAGIC = 0x51A110C8;
+
+// Bytes a thread may hold per size class. Classes whose blocks are too big
+// to keep two of within this are not cached.
+constexpr size_t THREAD_CACHE_CLASS_BYTES = 262144;
+
+// Where a direct allocation's memory came from, so it is returned the same way
+enum class DirectBacking : u8 {
+    CacheAligned,
+    NumaNode,
+    HugePages
+};
+
+// Sits directly in front of every allocation that is not carved from a
+// registered region, so its record is found by pointer arithmetic alone.
+// The links keep direct allocations enumerable for emergency cleanup.
+struct AllocationHeader {
+    AllocationRecord record;
+    void* base = nullptr;
+    size_t mapping_size = 0;
+    AllocationHeader* prev = nullptr;
+    AllocationHeader* next = nullptr;
+    DirectBacking backing = DirectBacking::CacheAligned;
+    u32 magic = 0;
+};
+
+AllocationHeader* header_for(void* ptr) {
+    return reinterpret_cast<AllocationHeader*>(ptr) - 1;
+}
+
+u32 allocation_timestamp() {
+    return static_cast<u32>(std::chrono::duration_cast<std::chrono::seconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+// Set by set_numa_policy; overrides the node of the CPU the thread runs on
+thread_local u32 preferred_numa_node = NUMA_NODE_UNKNOWN;
+
+} // namespace
+
+class QuantumMemoryManager::Impl : public ThreadCacheOwner {
 public:
     MemoryConfig config_;
     
-    Vector<MemoryPool> memory_pools_;
     Vector<QuantumBlock> quantum_blocks_;
     Vector<CacheOptimizedRegion> cache_regions_;
     Vector<NUMANode> numa_nodes_;
     
-    std::shared_mutex allocation_mutex_;
     std::mutex quantum_mutex_;
     std::mutex cache_mutex_;
     std::mutex numa_mutex_;
     
-    Vector<void*> allocated_pointers_;
-    Vector<size_t> allocation_sizes_;
-    Vector<u64> allocation_timestamps_;
-    Vector<MemoryFlags> allocation_flags_;
+    // Allocation metadata: region-owned memory is found through the page map,
+    // everything else through the header in front of the pointer
+    MemoryPageMap page_map_;
+    Vector<std::unique_ptr<SizeClassAllocator>> node_classes_; // one per NUMA node
+    std::unique_ptr<MemoryRegion> quantum_region_;
+    std::mutex direct_mutex_;
+    AllocationHeader* direct_allocations_ = nullptr;
     
     std::atomic<size_t> total_allocated_{0};
     std::atomic<size_t> total_freed_{0};
@@ -67,6 +116,7 @@ public:
     bool memory_compression_enabled_ = false;
     bool quantum_effects_enabled_ = false;
     bool numa_optimization_enabled_ = false;
+    bool fake_numa_topology_ = false;
     bool cache_line_optimization_ = false;
     bool memory_encryption_enabled_ = false;
     
@@ -101,9 +151,88 @@ public:
     bool low_memory_mode_ = false;
     bool emergency_cleanup_mode_ = false;
     
-    u64 allocation_sequence_number_ = 0;
+    std::atomic<u64> allocation_sequence_number_{0};
     u64 garbage_collection_cycles_ = 0;
     u64 memory_defragmentation_cycles_ = 0;
+    
+    std::mutex thread_cache_mutex_;
+    ThreadCacheStats retired_cache_stats_; // threads that have exited
+    Vector<ThreadCacheStats> retired_node_stats_; // node counters of exited or moved caches
+    
+    u32 node_index(u32 numa_node) const {
+        return numa_node < node_classes_.size() ? numa_node : 0;
+    }
+    
+    SizeClassAllocator& classes_for_node(u32 numa_node) {
+        return *node_classes_[node_index(numa_node)];
+    }
+    
+    // Node whose pools serve the calling thread
+    u32 current_node() const {
+        if (preferred_numa_node != NUMA_NODE_UNKNOWN) {
+            return node_index(preferred_numa_node);
+        }
+        
+        int cpu = sched_getcpu();
+        if (cpu < 0 || node_classes_.size() <= 1) {
+            return 0;
+        }
+        
+        if (fake_numa_topology_) {
+            return static_cast<u32>(cpu) % node_classes_.size();
+        }
+        
+        int node = numa_node_of_cpu(cpu);
+        return node >= 0 ? node_index(static_cast<u32>(node)) : 0;
+    }
+    
+    void flush_thread_cache(ThreadAllocationCache& cache) {
+        void* batch[ThreadAllocationCache::MAX_MAGAZINE_CAPACITY];
+        SizeClassAllocator& classes = classes_for_node(cache.numa_node());
+        
+        for (u32 i = 0; i < cache.class_count(); i++) {
+            u32 count = cache.take(i, batch, ThreadAllocationCache::MAX_MAGAZINE_CAPACITY);
+            if (count > 0) {
+                classes.return_blocks(i, batch, count);
+            }
+        }
+    }
+    
+    // The thread now runs on another node: cached blocks go home and later
+    // refills come from the new node
+    void move_thread_cache(ThreadAllocationCache& cache, u32 numa_node) {
+        flush_thread_cache(cache);
+        
+        ThreadCacheStats node_stats = cache.take_node_stats();
+        {
+            std::lock_guard<std::mutex> lock(thread_cache_mutex_);
+            retired_cache_stats_.add(node_stats);
+            retired_node_stats_[node_index(cache.numa_node())].add(node_stats);
+        }
+        
+        cache.set_numa_node(numa_node);
+    }
+    
+    void configure_thread_cache(ThreadAllocationCache& cache) override {
+        for (u32 i = 0; i < SizeClassAllocator::CLASS_COUNT; i++) {
+            size_t block_size = SizeClassAllocator::class_size(i);
+            cache.configure(i, static_cast<u32>(THREAD_CACHE_CLASS_BYTES / block_size), block_size);
+        }
+        cache.set_numa_node(current_node());
+    }
+    
+    void release_thread_cache(ThreadAllocationCache& cache) override {
+        flush_thread_cache(cache);
+        
+        ThreadCacheStats stats = cache.get_stats();
+        stats.threads = 0;
+        
+        ThreadCacheStats node_stats = cache.take_node_stats();
+        
+        std::lock_guard<std::mutex> lock(thread_cache_mutex_);
+        retired_cache_stats_.add(stats);
+        retired_node_stats_[node_index(cache.numa_node())].add(node_stats);
+    }
 };
 
 QuantumMemoryManager::QuantumMemoryManager() : impl_(std::make_unique<Impl>()) {
@@ -149,6 +278,7 @@ bool QuantumMemoryManager::initialize(const MemoryConfig& config) {
 
 void QuantumMemoryManager::shutdown() {
     stop_background_threads();
+    ThreadAllocationCache::detach_all(impl_.get());
     cleanup_quantum_memory();
     cleanup_memory_pools();
     cleanup_numa_resources();
@@ -192,42 +322,32 @@ bool QuantumMemoryManager::detect_system_capabilities() {
 }
 
 bool QuantumMemoryManager::initialize_memory_pools() {
-    const Vector<size_t> pool_sizes = {
-        1024,        // 1KB
-        4096,        // 4KB (page size)
-        65536,       // 64KB
-        1048576,     // 1MB
-        16777216,    // 16MB
-        268435456,   // 256MB
-        1073741824   // 1GB
-    };
-    
-    for (size_t size : pool_sizes) {
-        MemoryPool pool;
-        pool.block_size = size;
-        pool.total_blocks = impl_->config_.initial_pool_size / size;
-        pool.free_blocks = pool.total_blocks;
-        pool.allocated_blocks = 0;
-        
-        pool.memory_start = aligned_alloc(impl_->cache_line_size_, pool.total_blocks * size);
-        if (!pool.memory_start) {
+    // Small requests are served from size-class slabs carved out of arenas
+    // of initial_pool_size; anything larger is allocated directly. Each NUMA
+    // node gets its own slabs, bound to the node's memory. A fake topology
+    // keeps the per-node pools and their routing but binds nothing, so it
+    // runs on single-node machines.
+    u32 node_count = 1;
+    bool bind_to_node = false;
+    impl_->fake_numa_topology_ = impl_->config_.fake_numa_node_count > 0;
+    
+    if (impl_->fake_numa_topology_) {
+        node_count = impl_->config_.fake_numa_node_count;
+    } else if (impl_->config_.enable_numa_optimization && impl_->numa_node_count_ > 1) {
+        node_count = impl_->numa_node_count_;
+        bind_to_node = true;
+    }
+    
+    impl_->retired_node_stats_.resize(node_count);
+    
+    for (u32 node = 0; node < node_count; node++) {
+        auto classes = std::make_unique<SizeClassAllocator>();
+        if (!classes->initialize(&impl_->page_map_, impl_->config_.initial_pool_size,
+                                 impl_->config_.enable_memory_locking, node, bind_to_node,
+                                 impl_->config_.enable_huge_pages)) {
             return false;
         }
-        
-        if (mlock(pool.memory_start, pool.total_blocks * size) != 0) {
-            pool.is_locked = false;
-        } else {
-            pool.is_locked = true;
-        }
-        
-        pool.free_list.resize(pool.total_blocks);
-        for (u32 i = 0; i < pool.total_blocks; i++) {
-            pool.free_list[i] = static_cast<u8*>(pool.memory_start) + i * size;
-        }
-        
-        pool.allocation_bitmap.resize((pool.total_blocks + 63) / 64, 0);
-        
-        impl_->memory_pools_.push_back(pool);
+        impl_->node_classes_.push_back(std::move(classes));
     }
     
     return true;
@@ -240,21 +360,27 @@ bool QuantumMemoryManager::setup_numa_optimization() {
     
     impl_->numa_optimization_enabled_ = true;
     
+    struct bitmask* allowed = numa_get_mems_allowed();
     for (u32 node = 0; node < impl_->numa_node_count_; node++) {
         NUMANode numa_node;
         numa_node.node_id = node;
-        numa_node.is_available = (numa_bitmask_isbitset(numa_get_mems_allowed(), node) != 0);
+        numa_node.is_available = (numa_bitmask_isbitset(allowed, node) != 0);
         
         if (numa_node.is_available) {
-            long long numa_size = numa_node_size64(node, &numa_node.free_memory);
-            numa_node.total_memory = static_cast<size_t>(numa_size);
+            long long free_memory = 0;
+            long long numa_size = numa_node_size64(node, &free_memory);
+            numa_node.total_memory = numa_size > 0 ? static_cast<size_t>(numa_size) : 0;
+            numa_node.free_memory = free_memory > 0 ? static_cast<size_t>(free_memory) : 0;
             numa_node.allocated_memory = 0;
-            numa_node.cpu_mask = *numa_allocate_cpumask();
-            numa_node_to_cpus(node, &numa_node.cpu_mask);
+            
+            struct bitmask* cpus = numa_allocate_cpumask();
+            numa_node_to_cpus(node, cpus);
+            numa_node.cpu_mask = cpus;
         }
         
         impl_->numa_nodes_.push_back(numa_node);
     }
+    numa_bitmask_free(allowed);
     
     return true;
 }
@@ -299,6 +425,18 @@ bool QuantumMemoryManager::initialize_quantum_memory() {
     
     impl_->quantum_state_buffer_.resize(impl_->quantum_memory_size_);
     
+    auto region = std::make_unique<MemoryRegion>();
+    region->kind = MemoryRegionKind::Quantum;
+    region->start = static_cast<u8*>(impl_->quantum_entangled_memory_);
+    region->size = static_cast<size_t>(block_count) * impl_->cache_line_size_;
+    region->granule = impl_->cache_line_size_;
+    region->records = std::make_unique<AllocationRecord[]>(block_count);
+    
+    if (!impl_->page_map_.insert(region.get())) {
+        return false;
+    }
+    impl_->quantum_region_ = std::move(region);
+    
     return true;
 }
 
@@ -391,8 +529,6 @@ void* QuantumMemoryManager::allocate(size_t size, size_t alignment, MemoryFlags
         return nullptr;
     }
     
-    std::unique_lock<std::shared_mutex> lock(impl_->allocation_mutex_);
-    
     if (alignment == 0) {
         alignment = impl_->cache_line_size_;
     }
@@ -403,12 +539,19 @@ void* QuantumMemoryManager::allocate(size_t size, size_t alignment, MemoryFlags
     
     if (flags & MEMORY_FLAG_QUANTUM_ENTANGLED) {
         ptr = allocate_quantum_memory(size, alignment);
-    } else if (flags & MEMORY_FLAG_NUMA_LOCAL) {
-        ptr = allocate_numa_memory(size, alignment, get_current_numa_node());
-    } else if (flags & MEMORY_FLAG_CACHE_ALIGNED) {
-        ptr = allocate_cache_aligned_memory(size, alignment);
+    } else if (flags & (MEMORY_FLAG_CACHE_ALIGNED | MEMORY_FLAG_HUGE_PAGE)) {
+        ptr = allocate_direct(size, alignment, flags);
     } else {
-        ptr = allocate_from_pool(size, alignment);
+        u32 size_class = SizeClassAllocator::class_for(size, alignment);
+        if (size_class != SizeClassAllocator::NO_CLASS) {
+            ptr = allocate_from_thread_cache(size_class);
+            if (!ptr) {
+                ptr = allocate_from_pool(size, alignment);
+            }
+        }
+        if (!ptr) {
+            ptr = allocate_direct(size, alignment, flags);
+        }
     }
     
     if (ptr) {
@@ -423,10 +566,10 @@ void* QuantumMemoryManager::allocate(size_t size, size_t alignment, MemoryFlags
         }
         
         impl_->allocation_count_++;
-        impl_->total_allocated_ += size;
+        size_t total = impl_->total_allocated_ += size;
         
-        if (impl_->total_allocated_ > impl_->peak_usage_) {
-            impl_->peak_usage_ = impl_->total_allocated_;
+        size_t peak = impl_->peak_usage_.load(std::memory_order_relaxed);
+        while (total > peak && !impl_->peak_usage_.compare_exchange_weak(peak, total, std::memory_order_relaxed)) {
         }
     }
     
@@ -438,32 +581,38 @@ void QuantumMemoryManager::deallocate(void* ptr) {
         return;
     }
     
-    std::unique_lock<std::shared_mutex> lock(impl_->allocation_mutex_);
+    AllocationRecord* record = find_allocation_record(ptr);
+    if (!record || record->size == 0) {
+        return;
+    }
     
-    auto it = std::find(impl_->allocated_pointers_.begin(), impl_->allocated_pointers_.end(), ptr);
-    if (it != impl_->allocated_pointers_.end()) {
-        size_t index = std::distance(impl_->allocated_pointers_.begin(), it);
-        size_t size = impl_->allocation_sizes_[index];
-        MemoryFlags flags = impl_->allocation_flags_[index];
-        
-        if (flags & MEMORY_FLAG_QUANTUM_ENTANGLED) {
+    size_t size = record->size;
+    
+    ThreadAllocationCache* cache = ThreadAllocationCache::for_current_thread(impl_.get());
+    if (record->owner_thread != ThreadAllocationCache::current_thread_tag()) {
+        cache->record_cross_thread_free();
+    }
+    
+    if (MemoryRegion* region = impl_->page_map_.find(ptr)) {
+        if (region->kind == MemoryRegionKind::Quantum) {
             deallocate_quantum_memory(ptr, size);
-        } else if (flags & MEMORY_FLAG_NUMA_LOCAL) {
-            deallocate_numa_memory(ptr, size);
-        } else if (flags & MEMORY_FLAG_CACHE_ALIGNED) {
-            deallocate_cache_aligned_memory(ptr, size);
         } else {
-            deallocate_from_pool(ptr, size);
+            record->size = 0;
+            SizeClassSlab* slab = SizeClassAllocator::slab_for(ptr);
+            if (slab->numa_node != cache->numa_node()) {
+                // Magazines only hold blocks of their own node
+                cache->record_remote_free();
+                deallocate_from_pool(ptr, size);
+            } else if (!deallocate_to_thread_cache(cache, ptr, slab->size_class)) {
+                deallocate_from_pool(ptr, size);
+            }
         }
-        
-        impl_->allocated_pointers_.erase(it);
-        impl_->allocation_sizes_.erase(impl_->allocation_sizes_.begin() + index);
-        impl_->allocation_timestamps_.erase(impl_->allocation_timestamps_.begin() + index);
-        impl_->allocation_flags_.erase(impl_->allocation_flags_.begin() + index);
-        
-        impl_->deallocation_count_++;
-        impl_->total_freed_ += size;
+    } else {
+        deallocate_direct(ptr);
     }
+    
+    impl_->deallocation_count_++;
+    impl_->total_freed_ += size;
 }
 
 void* QuantumMemoryManager::reallocate(void* ptr, size_t new_size, size_t alignment, MemoryFlags flags) {
@@ -476,14 +625,11 @@ void* QuantumMemoryManager::reallocate(void* ptr, size_t new_size, size_t alignm
         return nullptr;
     }
     
-    auto it = std::find(impl_->allocated_pointers_.begin(), impl_->allocated_pointers_.end(), ptr);
-    if (it == impl_->allocated_pointers_.end()) {
+    size_t old_size = get_allocation_size(ptr);
+    if (old_size == 0) {
         return nullptr;
     }
     
-    size_t index = std::distance(impl_->allocated_pointers_.begin(), it);
-    size_t old_size = impl_->allocation_sizes_[index];
-    
     if (new_size <= old_size) {
         return ptr;
     }
@@ -497,6 +643,75 @@ void* QuantumMemoryManager::reallocate(void* ptr, size_t new_size, size_t alignm
     return new_ptr;
 }
 
+void* QuantumMemoryManager::allocate_numa_local(size_t size, u32 node_id, size_t alignment) {
+    if (size == 0) {
+        return nullptr;
+    }
+    
+    if (alignment == 0) {
+        alignment = impl_->cache_line_size_;
+    }
+    
+    size = align_size(size, alignment);
+    
+    // The calling thread's own node goes through its cache as usual
+    u32 size_class = SizeClassAllocator::class_for(size, alignment);
+    if (size_class == SizeClassAllocator::NO_CLASS || node_id >= impl_->node_classes_.size() ||
+        node_id == impl_->current_node()) {
+        return allocate(size, alignment, MEMORY_FLAG_NUMA_LOCAL);
+    }
+    
+    void* ptr = nullptr;
+    if (impl_->node_classes_[node_id]->take_blocks(size_class, &ptr, 1) == 0) {
+        return nullptr;
+    }
+    
+    record_allocation(ptr, size, MEMORY_FLAG_NUMA_LOCAL);
+    impl_->allocation_count_++;
+    impl_->total_allocated_ += size;
+    
+    return ptr;
+}
+
+void* QuantumMemoryManager::allocate_huge_page(size_t size, size_t alignment) {
+    return allocate(size, alignment, MEMORY_FLAG_HUGE_PAGE);
+}
+
+AllocationRecord* QuantumMemoryManager::find_allocation_record(void* ptr) {
+    if (!ptr) {
+        return nullptr;
+    }
+    
+    if (MemoryRegion* region = impl_->page_map_.find(ptr)) {
+        if (region->kind == MemoryRegionKind::SizeClassArena) {
+            return SizeClassAllocator::record_for(ptr);
+        }
+        return region->is_granule_start(ptr) ? &region->record_for(ptr) : nullptr;
+    }
+    
+    // Pointers this manager never handed out are only caught by the magic
+    AllocationHeader* header = header_for(ptr);
+    return header->magic == ALLOCATION_HEADER_MAGIC ? &header->record : nullptr;
+}
+
+size_t QuantumMemoryManager::get_allocation_size(void* ptr) {
+    AllocationRecord* record = find_allocation_record(ptr);
+    return record ? record->size : 0;
+}
+
+u32 QuantumMemoryManager::get_numa_node(void* ptr) {
+    AllocationRecord* record = find_allocation_record(ptr);
+    if (!record || record->size == 0) {
+        return 0;
+    }
+    
+    if (record->numa_node != NUMA_NODE_UNKNOWN) {
+        return record->numa_node;
+    }
+    
+    return get_numa_node_for_address(ptr);
+}
+
 void* QuantumMemoryManager::allocate_quantum_memory(size_t size, size_t alignment) {
     if (!impl_->quantum_effects_enabled_) {
         return nullptr;
@@ -558,6 +773,10 @@ void QuantumMemoryManager::deallocate_quantum_memory(void* ptr, size_t size) {
                 restore_quantum_entanglement(block);
             }
         }
+        
+        if (impl_->quantum_region_) {
+            impl_->quantum_region_->record_for(ptr).size = 0;
+        }
     }
 }
 
@@ -601,12 +820,17 @@ void QuantumMemoryManager::restore_quantum_entanglement(QuantumBlock& block) {
 }
 
 void* QuantumMemoryManager::allocate_numa_memory(size_t size, size_t alignment, u32 node_id) {
-    if (!impl_->numa_optimization_enabled_ || node_id >= impl_->numa_nodes_.size()) {
+    if (!impl_->numa_optimization_enabled_) {
         return aligned_alloc(alignment, size);
     }
+    // deallocate_numa_memory hands anything to numa_free once NUMA is on
+    if (node_id >= impl_->numa_nodes_.size()) {
+        return nullptr;
+    }
     
     void* ptr = numa_alloc_onnode(size, node_id);
     if (ptr) {
+        std::lock_guard<std::mutex> lock(impl_->numa_mutex_);
         impl_->numa_nodes_[node_id].allocated_memory += size;
     }
     
@@ -615,9 +839,10 @@ void* QuantumMemoryManager::allocate_numa_memory(size_t size, size_t alignment,
 
 void QuantumMemoryManager::deallocate_numa_memory(void* ptr, size_t size) {
     if (impl_->numa_optimization_enabled_) {
+        u32 node_id = get_numa_node_for_address(ptr);
         numa_free(ptr, size);
         
-        u32 node_id = get_numa_node_for_address(ptr);
+        std::lock_guard<std::mutex> lock(impl_->numa_mutex_);
         if (node_id < impl_->numa_nodes_.size()) {
             impl_->numa_nodes_[node_id].allocated_memory -= size;
         }
@@ -632,49 +857,182 @@ void* QuantumMemoryManager::allocate_cache_aligned_memory(size_t size, size_t al
 }
 
 void QuantumMemoryManager::deallocate_cache_aligned_memory(void* ptr, size_t size) {
+    (void)size;
     free(ptr);
 }
 
+void* QuantumMemoryManager::allocate_from_thread_cache(u32 size_class) {
+    ThreadAllocationCache* cache = ThreadAllocationCache::for_current_thread(impl_.get());
+    if (!cache->is_cached(size_class)) {
+        return nullptr;
+    }
+    
+    if (void* ptr = cache->pop(size_class)) {
+        cache->record_node_allocation(true);
+        return ptr;
+    }
+    
+    // Checked on refills only, which is often enough to follow a thread
+    // that the scheduler has moved to another node
+    u32 node = impl_->current_node();
+    if (node != cache->numa_node()) {
+        impl_->move_thread_cache(*cache, node);
+    }
+    
+    void* batch[ThreadAllocationCache::MAX_MAGAZINE_CAPACITY];
+    u32 taken = impl_->classes_for_node(node).take_blocks(size_class, batch, cache->batch_size(size_class));
+    if (taken == 0) {
+        return nullptr;
+    }
+    
+    cache->record_refill();
+    cache->record_node_allocation(true);
+    cache->put(size_class, batch + 1, taken - 1);
+    return batch[0];
+}
+
+bool QuantumMemoryManager::deallocate_to_thread_cache(ThreadAllocationCache* cache, void* ptr, u32 size_class) {
+    if (!cache->is_cached(size_class)) {
+        return false;
+    }
+    
+    if (!cache->push(size_class, ptr)) {
+        void* batch[ThreadAllocationCache::MAX_MAGAZINE_CAPACITY];
+        u32 count = cache->take(size_class, batch, cache->batch_size(size_class));
+        impl_->classes_for_node(cache->numa_node()).return_blocks(size_class, batch, count);
+        cache->record_flush();
+        cache->push(size_class, ptr);
+    }
+    
+    return true;
+}
+
 void* QuantumMemoryManager::allocate_from_pool(size_t size, size_t alignment) {
-    for (auto& pool : impl_->memory_pools_) {
-        if (pool.block_size >= size && pool.free_blocks > 0) {
-            void* ptr = pool.free_list[pool.free_blocks - 1];
-            pool.free_blocks--;
-            pool.allocated_blocks++;
-            
-            u32 block_index = (static_cast<u8*>(ptr) - static_cast<u8*>(pool.memory_start)) / pool.block_size;
-            u32 bitmap_index = block_index / 64;
-            u32 bit_index = block_index % 64;
-            pool.allocation_bitmap[bitmap_index] |= (1ULL << bit_index);
-            
+    u32 size_class = SizeClassAllocator::class_for(size, alignment);
+    if (size_class == SizeClassAllocator::NO_CLASS) {
+        return nullptr;
+    }
+    
+    ThreadAllocationCache* cache = ThreadAllocationCache::for_current_thread(impl_.get());
+    u32 node = impl_->current_node();
+    void* ptr = nullptr;
+    
+    if (impl_->classes_for_node(node).take_blocks(size_class, &ptr, 1) > 0) {
+        cache->record_node_allocation(true);
+        return ptr;
+    }
+    
+    // The local node could not grow; memory of another node still beats
+    // falling back to a direct allocation
+    for (u32 other = 0; other < impl_->node_classes_.size(); other++) {
+        if (other != node && impl_->node_classes_[other]->take_blocks(size_class, &ptr, 1) > 0) {
+            cache->record_node_allocation(false);
             return ptr;
         }
     }
     
-    return aligned_alloc(alignment, size);
+    return nullptr;
 }
 
 void QuantumMemoryManager::deallocate_from_pool(void* ptr, size_t size) {
-    for (auto& pool : impl_->memory_pools_) {
-        u8* pool_start = static_cast<u8*>(pool.memory_start);
-        u8* pool_end = pool_start + pool.total_blocks * pool.block_size;
+    (void)size; // the slab knows the block's class
+    MemoryRegion* region = impl_->page_map_.find(ptr);
+    if (!region || region->kind != MemoryRegionKind::SizeClassArena) {
+        return;
+    }
+    
+    AllocationRecord* record = SizeClassAllocator::record_for(ptr);
+    if (!record) {
+        return;
+    }
+    
+    record->size = 0;
+    SizeClassSlab* slab = SizeClassAllocator::slab_for(ptr);
+    impl_->classes_for_node(slab->numa_node).return_blocks(slab->size_class, &ptr, 1);
+}
+
+void* QuantumMemoryManager::allocate_direct(size_t size, size_t alignment, MemoryFlags flags) {
+    alignment = std::max(alignment, alignof(AllocationHeader));
+    size_t prefix = align_size(sizeof(AllocationHeader), alignment);
+    size_t mapping_size = align_size(prefix + size, alignment);
+    
+    u32 numa_node = NUMA_NODE_UNKNOWN;
+    DirectBacking backing = DirectBacking::CacheAligned;
+    void* base = nullptr;
+    
+    if (flags & MEMORY_FLAG_NUMA_LOCAL) {
+        numa_node = get_current_numa_node();
+    }
+    
+    // Only a real, available node can be bound; the nodes of a fake topology
+    // exist for the pools alone. numa_alloc_onnode aligns to pages.
+    if (numa_node != NUMA_NODE_UNKNOWN && !impl_->fake_numa_topology_ && impl_->numa_optimization_enabled_ &&
+        numa_node < impl_->numa_nodes_.size() && impl_->numa_nodes_[numa_node].is_available &&
+        alignment <= impl_->page_size_) {
+        base = allocate_numa_memory(mapping_size, alignment, numa_node);
+        backing = DirectBacking::NumaNode;
+    } else if (flags & MEMORY_FLAG_HUGE_PAGE) {
+        base = map_huge_pages(mapping_size, impl_->config_.enable_huge_pages ? HugePageBacking::Explicit
+                                                                             : HugePageBacking::Regular);
+        backing = DirectBacking::HugePages;
+    } else {
+        base = allocate_cache_aligned_memory(mapping_size, alignment);
+    }
+    
+    if (!base) {
+        return nullptr;
+    }
+    
+    u8* ptr = static_cast<u8*>(base) + prefix;
+    AllocationHeader* header = new (header_for(ptr)) AllocationHeader();
+    header->record.flags = flags;
+    header->record.numa_node = numa_node;
+    header->base = base;
+    header->mapping_size = mapping_size;
+    header->backing = backing;
+    header->magic = ALLOCATION_HEADER_MAGIC;
+    
+    std::lock_guard<std::mutex> lock(impl_->direct_mutex_);
+    header->next = impl_->direct_allocations_;
+    if (header->next) {
+        header->next->prev = header;
+    }
+    impl_->direct_allocations_ = header;
+    
+    return ptr;
+}
+
+void QuantumMemoryManager::deallocate_direct(void* ptr) {
+    AllocationHeader* header = header_for(ptr);
+    
+    {
+        std::lock_guard<std::mutex> lock(impl_->direct_mutex_);
+        if (header->magic != ALLOCATION_HEADER_MAGIC) {
+            return;
+        }
+        header->magic = 0;
         
-        if (ptr >= pool_start && ptr < pool_end) {
-            u32 block_index = (static_cast<u8*>(ptr) - pool_start) / pool.block_size;
-            u32 bitmap_index = block_index / 64;
-            u32 bit_index = block_index % 64;
-            
-            if (pool.allocation_bitmap[bitmap_index] & (1ULL << bit_index)) {
-                pool.allocation_bitmap[bitmap_index] &= ~(1ULL << bit_index);
-                pool.free_list[pool.free_blocks] = ptr;
-                pool.free_blocks++;
-                pool.allocated_blocks--;
-                return;
-            }
+        if (header->prev) {
+            header->prev->next = header->next;
+        } else {
+            impl_->direct_allocations_ = header->next;
+        }
+        if (header->next) {
+            header->next->prev = header->prev;
         }
     }
     
-    free(ptr);
+    switch (header->backing) {
+        case DirectBacking::NumaNode:
+            deallocate_numa_memory(header->base, header->mapping_size);
+            break;
+        case DirectBacking::HugePages:
+            unmap_huge_pages(header->base, header->mapping_size);
+            break;
+        case DirectBacking::CacheAligned:
+            deallocate_cache_aligned_memory(header->base, header->mapping_size);
+            break;
+    }
 }
 
 size_t QuantumMemoryManager::align_size(size_t size, size_t alignment) {
@@ -682,12 +1040,7 @@ size_t QuantumMemoryManager::align_size(size_t size, size_t alignment) {
 }
 
 u32 QuantumMemoryManager::get_current_numa_node() {
-    if (!impl_->numa_optimization_enabled_) {
-        return 0;
-    }
-    
-    int current_node = numa_node_of_cpu(sched_getcpu());
-    return (current_node >= 0) ? static_cast<u32>(current_node) : 0;
+    return impl_->current_node();
 }
 
 u32 QuantumMemoryManager::get_numa_node_for_address(void* ptr) {
@@ -701,12 +1054,15 @@ u32 QuantumMemoryManager::get_numa_node_for_address(void* ptr) {
 }
 
 void QuantumMemoryManager::record_allocation(void* ptr, size_t size, MemoryFlags flags) {
-    impl_->allocated_pointers_.push_back(ptr);
-    impl_->allocation_sizes_.push_back(size);
-    impl_->allocation_flags_.push_back(flags);
+    AllocationRecord* record = find_allocation_record(ptr);
+    if (!record) {
+        return;
+    }
     
-    auto now = std::chrono::steady_clock::now();
-    impl_->allocation_timestamps_.push_back(now.time_since_epoch().count());
+    record->size = size;
+    record->flags = flags;
+    record->timestamp = allocation_timestamp();
+    record->owner_thread = ThreadAllocationCache::current_thread_tag();
     
     impl_->allocation_sequence_number_++;
 }
@@ -734,54 +1090,25 @@ void QuantumMemoryManager::memory_compaction_loop() {
 }
 
 void QuantumMemoryManager::perform_memory_compaction() {
-    std::lock_guard<std::shared_mutex> lock(impl_->allocation_mutex_);
-    
-    for (auto& pool : impl_->memory_pools_) {
-        compact_memory_pool(pool);
+    for (auto& classes : impl_->node_classes_) {
+        classes->release_empty_slabs();
     }
-    
     impl_->memory_defragmentation_cycles_++;
 }
 
-void QuantumMemoryManager::compact_memory_pool(MemoryPool& pool) {
-    Vector<void*> allocated_blocks;
-    Vector<void*> free_blocks;
-    
-    u8* pool_start = static_cast<u8*>(pool.memory_start);
-    
-    for (u32 i = 0; i < pool.total_blocks; i++) {
-        u32 bitmap_index = i / 64;
-        u32 bit_index = i % 64;
-        
-        void* block_ptr = pool_start + i * pool.block_size;
-        
-        if (pool.allocation_bitmap[bitmap_index] & (1ULL << bit_index)) {
-            allocated_blocks.push_back(block_ptr);
-        } else {
-            free_blocks.push_back(block_ptr);
-        }
-    }
-    
-    pool.free_list = free_blocks;
-    pool.free_blocks = free_blocks.size();
-    pool.allocated_blocks = allocated_blocks.size();
-}
-
 void QuantumMemoryManager::update_fragmentation_metrics() {
     size_t total_free_space = 0;
-    size_t largest_free_block = 0;
+    size_t total_slab_space = 0;
     
-    for (const auto& pool : impl_->memory_pools_) {
-        size_t pool_free_space = pool.free_blocks * pool.block_size;
-        total_free_space += pool_free_space;
-        
-        if (pool.block_size > largest_free_block && pool.free_blocks > 0) {
-            largest_free_block = pool.block_size;
+    for (const auto& classes : impl_->node_classes_) {
+        for (const auto& stats : classes->get_class_statistics()) {
+            total_free_space += stats.free_blocks * stats.block_size;
+            total_slab_space += stats.slabs * SizeClassAllocator::SLAB_SIZE;
         }
     }
     
-    if (total_free_space > 0) {
-        impl_->fragmentation_ratio_ = 1.0 - (static_cast<f64>(largest_free_block) / total_free_space);
+    if (total_slab_space > 0) {
+        impl_->fragmentation_ratio_ = static_cast<f64>(total_free_space) / total_slab_space;
     }
 }
 
@@ -790,18 +1117,46 @@ void QuantumMemoryManager::perform_emergency_cleanup() {
         return;
     }
     
-    auto current_time = std::chrono::steady_clock::now().time_since_epoch().count();
-    const u64 cleanup_threshold = 300000000000ULL; // 5 minutes in nanoseconds
+    u32 current_time = allocation_timestamp();
+    const u32 cleanup_threshold = 300; // 5 minutes in seconds
     
-    for (size_t i = 0; i < impl_->allocated_pointers_.size(); ) {
-        if (current_time - impl_->allocation_timestamps_[i] > cleanup_threshold) {
-            void* ptr = impl_->allocated_pointers_[i];
-            deallocate(ptr);
-        } else {
-            i++;
+    auto is_expired = [&](const AllocationRecord& record) {
+        return record.size != 0 && current_time - record.timestamp > cleanup_threshold;
+    };
+    
+    Vector<void*> expired;
+    
+    for (auto& classes : impl_->node_classes_) {
+        classes->for_each_allocation([&](void* block, const AllocationRecord& record) {
+            if (is_expired(record)) {
+                expired.push_back(block);
+            }
+        });
+    }
+    
+    if (impl_->quantum_region_) {
+        std::lock_guard<std::mutex> lock(impl_->quantum_mutex_);
+        MemoryRegion& region = *impl_->quantum_region_;
+        for (size_t i = 0; i < region.granule_count(); i++) {
+            if (is_expired(region.records[i])) {
+                expired.push_back(region.start + i * region.granule);
+            }
+        }
+    }
+    
+    {
+        std::lock_guard<std::mutex> lock(impl_->direct_mutex_);
+        for (AllocationHeader* header = impl_->direct_allocations_; header; header = header->next) {
+            if (is_expired(header->record)) {
+                expired.push_back(header + 1);
+            }
         }
     }
     
+    for (void* ptr : expired) {
+        deallocate(ptr);
+    }
+    
     impl_->garbage_collection_cycles_++;
 }
 
@@ -966,7 +1321,12 @@ void QuantumMemoryManager::migrate_hot_pages() {
             u32 target_node = find_optimal_numa_node();
             
             if (current_node != target_node) {
-                numa_migrate_pages(getpid(), 1, &current_node, &target_node);
+                // Moves the hotspot's page only, not the whole process
+                void* page = reinterpret_cast<void*>(reinterpret_cast<uintptr_t>(hotspot.address) &
+                                                     ~(static_cast<uintptr_t>(impl_->page_size_) - 1));
+                int node = static_cast<int>(target_node);
+                int status = 0;
+                numa_move_pages(0, 1, &page, &node, &status, MPOL_MF_MOVE);
             }
         }
     }
@@ -1017,11 +1377,8 @@ void QuantumMemoryManager::enable_low_memory_mode(bool enabled) {
     if (enabled) {
         impl_->emergency_cleanup_mode_ = true;
         
-        for (auto& pool : impl_->memory_pools_) {
-            if (pool.free_blocks > pool.total_blocks / 2) {
-                size_t blocks_to_release = pool.free_blocks / 2;
-                pool.free_blocks -= blocks_to_release;
-            }
+        for (auto& classes : impl_->node_classes_) {
+            classes->release_empty_slabs();
         }
     }
 }
@@ -1030,6 +1387,28 @@ void QuantumMemoryManager::set_memory_pressure_threshold(size_t threshold) {
     impl_->memory_pressure_threshold_ = threshold;
 }
 
+void QuantumMemoryManager::set_numa_policy(u32 preferred_node) {
+    // Applies to the calling thread only; NUMA_NODE_UNKNOWN goes back to the
+    // node of the CPU it runs on
+    preferred_numa_node = preferred_node;
+    
+    if (impl_->numa_optimization_enabled_) {
+        if (preferred_node < impl_->numa_nodes_.size()) {
+            numa_set_preferred(static_cast<int>(preferred_node));
+        } else {
+            numa_set_localalloc();
+        }
+    }
+    
+    if (!impl_->node_classes_.empty()) {
+        ThreadAllocationCache* cache = ThreadAllocationCache::for_current_thread(impl_.get());
+        u32 node = impl_->current_node();
+        if (node != cache->numa_node()) {
+            impl_->move_thread_cache(*cache, node);
+        }
+    }
+}
+
 MemoryStatistics QuantumMemoryManager::get_memory_statistics() const {
     MemoryStatistics stats;
     
@@ -1044,15 +1423,99 @@ MemoryStatistics QuantumMemoryManager::get_memory_statistics() const {
                           (impl_->cache_hits_ + impl_->cache_misses_ + 1);
     stats.page_fault_count = impl_->page_faults_;
     stats.quantum_coherence_ratio = impl_->quantum_effects_enabled_ ? 
-                                   impl_->entanglement_strength_ : 0.0f;
+                                   impl_->entanglement_strength_.load() : 0.0f;
     stats.numa_efficiency = calculate_numa_efficiency();
     stats.compression_ratio = impl_->compression_ratio_;
     stats.access_locality_score = impl_->access_locality_score_;
     stats.memory_bandwidth_utilization = impl_->memory_bandwidth_utilization_;
     
+    ThreadCacheStats cache_stats = ThreadAllocationCache::collect_stats(impl_.get());
+    {
+        std::lock_guard<std::mutex> lock(impl_->thread_cache_mutex_);
+        cache_stats.add(impl_->retired_cache_stats_);
+    }
+    
+    stats.thread_cache_hits = cache_stats.hits;
+    stats.thread_cache_misses = cache_stats.misses;
+    stats.thread_cache_hit_rate = cache_stats.hit_rate();
+    stats.thread_cache_refills = cache_stats.refills;
+    stats.thread_cache_flushes = cache_stats.flushes;
+    stats.thread_cached_bytes = cache_stats.cached_bytes;
+    stats.cross_thread_frees = cache_stats.cross_thread_frees;
+    
     return stats;
 }
 
+Vector<MemoryPoolStatistics> QuantumMemoryManager::get_pool_statistics() const {
+    Vector<MemoryPoolStatistics> pool_stats;
+    
+    // One entry per size class, summed over the NUMA nodes
+    Vector<SizeClassStatistics> class_stats(SizeClassAllocator::CLASS_COUNT);
+    for (const auto& classes : impl_->node_classes_) {
+        Vector<SizeClassStatistics> node_stats = classes->get_class_statistics();
+        for (u32 i = 0; i < SizeClassAllocator::CLASS_COUNT; i++) {
+            class_stats[i].block_size = node_stats[i].block_size;
+            class_stats[i].slabs += node_stats[i].slabs;
+            class_stats[i].total_blocks += node_stats[i].total_blocks;
+            class_stats[i].free_blocks += node_stats[i].free_blocks;
+            class_stats[i].blocks_taken += node_stats[i].blocks_taken;
+            class_stats[i].blocks_returned += node_stats[i].blocks_returned;
+        }
+    }
+    
+    for (auto& stats : class_stats) {
+        if (stats.slabs > 0) {
+            stats.fragmentation_ratio = static_cast<f64>(stats.free_blocks * stats.block_size) /
+                                        static_cast<f64>(stats.slabs * SizeClassAllocator::SLAB_SIZE);
+        }
+        
+        MemoryPoolStatistics pool;
+        pool.block_size = stats.block_size;
+        pool.slab_count = stats.slabs;
+        pool.total_size = stats.total_blocks * stats.block_size;
+        pool.free_size = stats.free_blocks * stats.block_size;
+        pool.allocated_size = pool.total_size - pool.free_size;
+        pool.utilization_ratio = pool.total_size > 0 ? static_cast<f64>(pool.allocated_size) / pool.total_size : 0.0;
+        pool.fragmentation_ratio = stats.fragmentation_ratio;
+        pool.allocation_count = stats.blocks_taken;
+        pool.deallocation_count = stats.blocks_returned;
+        pool.average_allocation_size = static_cast<f64>(stats.block_size);
+        pool_stats.push_back(pool);
+    }
+    
+    return pool_stats;
+}
+
+Vector<NUMANodeStatistics> QuantumMemoryManager::get_numa_node_statistics() const {
+    Vector<NUMANodeStatistics> node_stats;
+    
+    for (u32 node = 0; node < impl_->node_classes_.size(); node++) {
+        const SizeClassAllocator& classes = *impl_->node_classes_[node];
+        
+        NUMANodeStatistics stats;
+        stats.node_id = node;
+        stats.reserved_size = classes.get_reserved_bytes();
+        stats.bound_size = classes.get_bound_bytes();
+        for (const auto& class_stats : classes.get_class_statistics()) {
+            stats.slab_size += class_stats.slabs * SizeClassAllocator::SLAB_SIZE;
+        }
+        
+        ThreadCacheStats cache_stats = ThreadAllocationCache::collect_node_stats(impl_.get(), node);
+        {
+            std::lock_guard<std::mutex> lock(impl_->thread_cache_mutex_);
+            cache_stats.add(impl_->retired_node_stats_[node]);
+        }
+        
+        stats.local_allocations = cache_stats.local_allocations;
+        stats.remote_allocations = cache_stats.remote_allocations;
+        stats.remote_frees = cache_stats.remote_frees;
+        stats.hit_rate = cache_stats.node_hit_rate();
+        node_stats.push_back(stats);
+    }
+    
+    return node_stats;
+}
+
 f64 QuantumMemoryManager::calculate_numa_efficiency() const {
     if (!impl_->numa_optimization_enabled_ || impl_->numa_nodes_.size() <= 1) {
         return 1.0;
@@ -1089,6 +1552,11 @@ f64 QuantumMemoryManager::calculate_numa_efficiency() const {
 }
 
 void QuantumMemoryManager::cleanup_quantum_memory() {
+    if (impl_->quantum_region_) {
+        impl_->page_map_.erase(impl_->quantum_region_.get());
+        impl_->quantum_region_.reset();
+    }
+    
     if (impl_->quantum_entangled_memory_) {
         munlock(impl_->quantum_entangled_memory_, impl_->quantum_memory_size_);
         free(impl_->quantum_entangled_memory_);
@@ -1100,20 +1568,19 @@ void QuantumMemoryManager::cleanup_quantum_memory() {
 }
 
 void QuantumMemoryManager::cleanup_memory_pools() {
-    for (auto& pool : impl_->memory_pools_) {
-        if (pool.is_locked) {
-            munlock(pool.memory_start, pool.total_blocks * pool.block_size);
-        }
-        free(pool.memory_start);
-    }
+    impl_->node_classes_.clear();
+    impl_->retired_node_stats_.clear();
     
-    impl_->memory_pools_.clear();
+    for (auto& region : impl_->cache_regions_) {
+        free(region.memory);
+    }
+    impl_->cache_regions_.clear();
 }
 
 void QuantumMemoryManager::cleanup_numa_resources() {
     for (auto& node : impl_->numa_nodes_) {
-        if (node.is_available) {
-            numa_free_cpumask(&node.cpu_mask);
+        if (node.cpu_mask) {
+            numa_free_cpumask(static_cast<struct bitmask*>(node.cpu_mask));
         }
     }
     
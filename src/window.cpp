@@ -1,4 +1,5 @@
 #include "s1u/window.hpp"
+#include "s1u/memory_huge_pages.hpp"
 #include <cstring>
 #include <algorithm>
 #include <thread>
@@ -16,7 +17,14 @@ namespace s1u {
 
 WindowBuffer::WindowBuffer(u32 width, u32 height)
     : width_(width), height_(height), stride_(width * 4), size_(width * height * 4), damaged_(false) {
+#ifdef _WIN32
     data_ = aligned_alloc(64, size_);
+#else
+    // Every frame is read end to end by the compositor; on 2 MB pages a
+    // full-screen buffer needs a handful of TLB entries instead of thousands.
+    // Small buffers stay on the heap rather than round up to a huge page.
+    data_ = size_ >= S1U::HUGE_PAGE_SIZE ? S1U::map_huge_pages(size_) : aligned_alloc(64, size_);
+#endif
     if (data_) {
         memset(data_, 0, size_);
 #ifdef _WIN32
@@ -34,6 +42,10 @@ WindowBuffer::~WindowBuffer() {
         // No munlock equivalent needed for Windows stub
 #else
         munlock(data_, size_);
+        if (size_ >= S1U::HUGE_PAGE_SIZE) {
+            S1U::unmap_huge_pages(data_, size_);
+            return;
+        }
 #endif
         free_aligned(data_);
     }
@@ -0,0 +1,532 @@
+// Protocol loopback benchmark.
+//
+// Runs a protocol server in-process and drives it with N synthetic clients
+// over Unix socket pairs, measuring message rate, byte rate and round-trip
+// latency across payload sizes and client counts. With --fuzz every
+// configuration is run a second time with a share of malformed messages and
+// the tool fails if throughput drops below --min-fuzz-throughput of the
+// clean run.
+
+#include "s1u/core.hpp"
+#include "s1u/damage_region.hpp"
+#include "s1u/protocol_dispatch.hpp"
+#include "s1u/protocol_messages.hpp"
+#include "s1u/protocol_socket.hpp"
+#include <sys/socket.h>
+#include <poll.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <string>
+#include <thread>
+
+namespace s1u {
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+struct BenchmarkOptions {
+    std::vector<u32> client_counts{1, 4};
+    std::vector<u32> payload_sizes{64, 1024, 16384};
+    u32 messages_per_client = 20000;
+    u32 window = 16;
+    bool fuzz = false;
+    bool dispatch_only = false;
+    f64 malformed_ratio = 0.3;
+    f64 min_fuzz_throughput = 0.7;
+    u32 seed = 1;
+};
+
+struct ServerStats {
+    u64 messages = 0;
+    u64 bytes = 0;
+    u64 rejected = 0;
+    u64 checksum = 0;
+};
+
+struct RunResult {
+    u64 messages = 0;
+    u64 bytes = 0;
+    f64 seconds = 0.0;
+    f64 p50_us = 0.0;
+    f64 p99_us = 0.0;
+    u64 rejected = 0;
+    bool completed = true;
+};
+
+// In-process protocol server. Messages go through the same socket framing
+// and payload parsing as the real server; every message is acknowledged with
+// an empty reply carrying its sequence number so clients can time it.
+class LoopbackServer {
+public:
+    void add_client(int socket_fd) { sockets_.push_back(socket_fd); }
+
+    void run() {
+        std::vector<struct pollfd> pfds(sockets_.size());
+        size_t open_sockets = sockets_.size();
+        for (size_t i = 0; i < sockets_.size(); i++) {
+            pfds[i].fd = sockets_[i];
+            pfds[i].events = POLLIN;
+        }
+
+        std::vector<MessageReceiveBuffer> buffers(sockets_.size());
+        ReceivedMessage msg;
+        while (open_sockets > 0) {
+            if (poll(pfds.data(), pfds.size(), -1) < 0) {
+                if (errno == EINTR) continue;
+                break;
+            }
+
+            for (size_t i = 0; i < pfds.size(); i++) {
+                struct pollfd& pfd = pfds[i];
+                if (pfd.fd < 0 || !(pfd.revents & (POLLIN | POLLHUP | POLLERR))) continue;
+
+                bool open = buffers[i].read_available(pfd.fd);
+                while (buffers[i].next_message(msg)) {
+                    close_received_fds(msg);
+
+                    stats_.messages++;
+                    stats_.bytes += sizeof(MessageHeader) + msg.payload.size();
+                    if (MessageDispatcher<LoopbackServer>::dispatch(*this, MessageOrigin{}, msg.header.type, msg.payload.data(),
+                                                                     static_cast<u32>(msg.payload.size())) != DispatchResult::Handled) {
+                        stats_.rejected++;
+                    }
+
+                    send_message_with_fds(pfd.fd, static_cast<MessageType>(msg.header.type),
+                                          msg.header.sequence, nullptr, 0);
+                }
+
+                if (!open || buffers[i].is_broken()) {
+                    pfd.fd = -1;
+                    open_sockets--;
+                }
+            }
+        }
+    }
+
+    const ServerStats& get_statistics() const { return stats_; }
+
+private:
+    friend class MessageDispatcher<LoopbackServer>;
+
+    void handle_message(MessageTag<MessageType::WindowUpdate>, const MessageOrigin&, const RawPayload& payload) {
+        u64 sum = 0;
+        for (u32 i = 0; i < payload.size; i++) {
+            sum += payload.data[i];
+        }
+        stats_.checksum += sum;
+    }
+
+    void handle_message(MessageTag<MessageType::BufferDamage>, const MessageOrigin&, const BufferDamageView& damage) {
+        damage_.add(damage.region);
+        damage_.coalesce(16);
+        stats_.checksum += damage_.area();
+    }
+
+    void handle_message(MessageTag<MessageType::BufferSubmit>, const MessageOrigin&, const BufferSubmitPayload& submit) {
+        stats_.checksum += submit.buffer_id;
+    }
+
+    std::vector<int> sockets_;
+    DamageRegion damage_;
+    ServerStats stats_;
+};
+
+// Dispatch microbenchmark: the same in-memory message mix routed through the
+// dense table and through the map of std::function handlers it replaced.
+struct DispatchSink {
+    u64 checksum = 0;
+
+    void handle_message(MessageTag<MessageType::WindowUpdate>, const MessageOrigin&, const RawPayload& payload) {
+        checksum += payload.size;
+    }
+
+    void handle_message(MessageTag<MessageType::BufferSubmit>, const MessageOrigin&, const BufferSubmitPayload& submit) {
+        checksum += submit.buffer_id;
+    }
+
+    void handle_message(MessageTag<MessageType::FrameCallbackRequest>, const MessageOrigin&, const SurfaceCallbackRequestPayload& request) {
+        checksum += request.callback_id;
+    }
+};
+
+struct EncodedMessage {
+    u32 type;
+    std::vector<u8> payload;
+};
+
+void run_dispatch_benchmark(u32 iterations, u32 seed) {
+    std::mt19937 rng(seed);
+    std::vector<EncodedMessage> messages(4096);
+    for (auto& message : messages) {
+        switch (rng() % 4) {
+        case 0:
+            message.type = static_cast<u32>(MessageType::BufferSubmit);
+            message.payload.resize(sizeof(BufferSubmitPayload));
+            break;
+        case 1:
+            message.type = static_cast<u32>(MessageType::FrameCallbackRequest);
+            message.payload.resize(sizeof(SurfaceCallbackRequestPayload));
+            break;
+        case 2:
+            message.type = static_cast<u32>(MessageType::WindowUpdate);
+            message.payload.resize(64);
+            break;
+        default:
+            message.type = 64 + rng() % 64;
+            break;
+        }
+        for (auto& byte : message.payload) {
+            byte = static_cast<u8>(rng());
+        }
+    }
+
+    DispatchSink sink;
+    std::unordered_map<MessageType, std::function<void(const RawPayload&)>> handlers;
+    handlers[MessageType::WindowUpdate] = [&sink](const RawPayload& payload) {
+        sink.handle_message(MessageTag<MessageType::WindowUpdate>{}, MessageOrigin{}, payload);
+    };
+    handlers[MessageType::BufferSubmit] = [&sink](const RawPayload& payload) {
+        BufferSubmitPayload submit;
+        if (parse_payload(payload.data, payload.size, submit)) {
+            sink.handle_message(MessageTag<MessageType::BufferSubmit>{}, MessageOrigin{}, submit);
+        }
+    };
+    handlers[MessageType::FrameCallbackRequest] = [&sink](const RawPayload& payload) {
+        SurfaceCallbackRequestPayload request;
+        if (parse_payload(payload.data, payload.size, request)) {
+            sink.handle_message(MessageTag<MessageType::FrameCallbackRequest>{}, MessageOrigin{}, request);
+        }
+    };
+
+    const u64 total = u64(iterations) * messages.size();
+
+    auto start = Clock::now();
+    for (u32 i = 0; i < iterations; i++) {
+        for (const auto& message : messages) {
+            auto handler = handlers.find(static_cast<MessageType>(message.type));
+            if (handler != handlers.end()) {
+                handler->second(RawPayload{message.payload.data(), static_cast<u32>(message.payload.size())});
+            }
+        }
+    }
+    f64 map_ns = std::chrono::duration<f64, std::nano>(Clock::now() - start).count() / total;
+
+    start = Clock::now();
+    for (u32 i = 0; i < iterations; i++) {
+        for (const auto& message : messages) {
+            MessageDispatcher<DispatchSink>::dispatch(sink, MessageOrigin{}, message.type, message.payload.data(),
+                                                      static_cast<u32>(message.payload.size()));
+        }
+    }
+    f64 table_ns = std::chrono::duration<f64, std::nano>(Clock::now() - start).count() / total;
+
+    std::printf("dispatch: map+std::function %.2f ns/msg, table %.2f ns/msg (checksum %lu)\n",
+                map_ns, table_ns, static_cast<unsigned long>(sink.checksum));
+}
+
+// Synthetic client: keeps up to `window` messages in flight and records the
+// round trip of each one.
+class SyntheticClient {
+public:
+    SyntheticClient(int socket_fd, u32 payload_size, f64 malformed_ratio, u32 seed)
+        : socket_fd_(socket_fd), payload_size_(payload_size), malformed_ratio_(malformed_ratio), rng_(seed) {
+        update_payload_.resize(payload_size);
+        for (auto& byte : update_payload_) {
+            byte = static_cast<u8>(rng_());
+        }
+
+        DamageRegion damage;
+        for (i32 line = 0; line < 8; line++) {
+            damage.add(DamageRect{8, line * 16, 8 + 400 + line * 8, line * 16 + 14});
+        }
+        damage.encode(1, damage_payload_);
+
+        // Generated once so that producing garbage does not cost more than
+        // producing valid traffic; send_malformed() only perturbs a few bytes
+        malformed_payload_.resize(std::max<u32>(payload_size, 64));
+        for (auto& byte : malformed_payload_) {
+            byte = static_cast<u8>(rng_());
+        }
+    }
+
+    bool run(u32 message_count, u32 window) {
+        latencies_ns_.reserve(message_count);
+        send_times_.assign(window, Clock::time_point());
+
+        u32 sent = 0;
+        u32 acknowledged = 0;
+        ReceivedMessage reply;
+
+        while (acknowledged < message_count) {
+            while (sent < message_count && sent - acknowledged < window) {
+                send_times_[sent % window] = Clock::now();
+                if (!send_next(sent)) return false;
+                sent++;
+            }
+
+            if (!receive_message_with_fds(socket_fd_, reply)) return false;
+            close_received_fds(reply);
+
+            auto elapsed = Clock::now() - send_times_[reply.header.sequence % window];
+            latencies_ns_.push_back(static_cast<u64>(std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count()));
+            acknowledged++;
+        }
+
+        return true;
+    }
+
+    const std::vector<u64>& get_latencies() const { return latencies_ns_; }
+    u64 get_bytes_sent() const { return bytes_sent_; }
+
+private:
+    bool send_next(u32 sequence) {
+        std::uniform_real_distribution<f64> chance(0.0, 1.0);
+        if (malformed_ratio_ > 0.0 && chance(rng_) < malformed_ratio_) {
+            return send_malformed(sequence);
+        }
+
+        // Mostly bulk window updates with periodic damage and buffer submits
+        if (sequence % 8 == 3) {
+            return send(MessageType::BufferDamage, sequence, damage_payload_.data(), static_cast<u32>(damage_payload_.size()));
+        }
+        if (sequence % 8 == 7) {
+            BufferSubmitPayload submit;
+            submit.surface_id = 1;
+            submit.buffer_id = sequence;
+            return send(MessageType::BufferSubmit, sequence, &submit, sizeof(submit));
+        }
+        return send(MessageType::WindowUpdate, sequence, update_payload_.data(), payload_size_);
+    }
+
+    // Well-framed messages with hostile contents: unknown types, truncated
+    // fixed-size payloads and random bytes where a damage region is expected
+    bool send_malformed(u32 sequence) {
+        for (u32 i = 0; i < 8; i++) {
+            malformed_payload_[rng_() % malformed_payload_.size()] = static_cast<u8>(rng_());
+        }
+
+        switch (rng_() % 3) {
+        case 0:
+            return send(static_cast<MessageType>(64 + rng_() % 1024), sequence,
+                        malformed_payload_.data(), payload_size_);
+        case 1:
+            return send(MessageType::BufferSubmit, sequence, malformed_payload_.data(),
+                        static_cast<u32>(rng_() % sizeof(BufferSubmitPayload)));
+        default: {
+            // Claim a large band count so the decoder has to reject it mid-stream
+            BufferDamageHeader header;
+            header.surface_id = 1;
+            header.band_count = rng_() % (MAX_DAMAGE_RECTS * 2);
+            std::memcpy(malformed_payload_.data(), &header, sizeof(header));
+            return send(MessageType::BufferDamage, sequence, malformed_payload_.data(),
+                        static_cast<u32>(malformed_payload_.size()));
+        }
+        }
+    }
+
+    bool send(MessageType type, u32 sequence, const void* payload, u32 size) {
+        bytes_sent_ += sizeof(MessageHeader) + size;
+        return send_message_with_fds(socket_fd_, type, sequence, payload, size);
+    }
+
+    int socket_fd_;
+    u32 payload_size_;
+    f64 malformed_ratio_;
+    std::mt19937 rng_;
+    std::vector<u8> update_payload_;
+    std::vector<u8> damage_payload_;
+    std::vector<u8> malformed_payload_;
+    std::vector<Clock::time_point> send_times_;
+    std::vector<u64> latencies_ns_;
+    u64 bytes_sent_ = 0;
+};
+
+f64 percentile_us(std::vector<u64>& values, f64 percentile) {
+    if (values.empty()) return 0.0;
+    size_t index = std::min(values.size() - 1, static_cast<size_t>(percentile * values.size()));
+    std::nth_element(values.begin(), values.begin() + index, values.end());
+    return values[index] / 1000.0;
+}
+
+RunResult run_configuration(const BenchmarkOptions& options, u32 client_count, u32 payload_size, f64 malformed_ratio) {
+    LoopbackServer server;
+    std::vector<int> client_sockets;
+
+    for (u32 i = 0; i < client_count; i++) {
+        int pair[2];
+        if (socketpair(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0, pair) != 0) {
+            std::perror("socketpair");
+            std::exit(2);
+        }
+        server.add_client(pair[0]);
+        client_sockets.push_back(pair[1]);
+    }
+
+    std::vector<SyntheticClient> clients;
+    clients.reserve(client_count);
+    for (u32 i = 0; i < client_count; i++) {
+        clients.emplace_back(client_sockets[i], payload_size, malformed_ratio, options.seed + i);
+    }
+
+    RunResult result;
+    auto start = Clock::now();
+
+    std::thread server_thread([&server]() { server.run(); });
+
+    std::vector<std::thread> client_threads;
+    std::vector<u8> client_ok(client_count, 0);
+    for (u32 i = 0; i < client_count; i++) {
+        client_threads.emplace_back([&, i]() {
+            client_ok[i] = clients[i].run(options.messages_per_client, options.window);
+            shutdown(client_sockets[i], SHUT_WR);
+        });
+    }
+
+    for (auto& thread : client_threads) {
+        thread.join();
+    }
+    server_thread.join();
+
+    result.seconds = std::chrono::duration<f64>(Clock::now() - start).count();
+
+    std::vector<u64> latencies;
+    for (u32 i = 0; i < client_count; i++) {
+        result.completed = result.completed && client_ok[i];
+        result.bytes += clients[i].get_bytes_sent();
+        latencies.insert(latencies.end(), clients[i].get_latencies().begin(), clients[i].get_latencies().end());
+        close(client_sockets[i]);
+    }
+
+    result.messages = server.get_statistics().messages;
+    result.rejected = server.get_statistics().rejected;
+    result.p50_us = percentile_us(latencies, 0.50);
+    result.p99_us = percentile_us(latencies, 0.99);
+    return result;
+}
+
+void print_result(const char* mode, u32 client_count, u32 payload_size, const RunResult& result) {
+    std::printf("%-6s %7u %8u %12.0f %10.1f %9.1f %9.1f %9lu\n",
+                mode, client_count, payload_size,
+                result.messages / result.seconds,
+                result.bytes / result.seconds / (1024.0 * 1024.0),
+                result.p50_us, result.p99_us,
+                static_cast<unsigned long>(result.rejected));
+}
+
+std::vector<u32> parse_list(const char* text) {
+    std::vector<u32> values;
+    std::string item;
+    for (const char* p = text;; p++) {
+        if (*p == ',' || *p == '\0') {
+            if (!item.empty()) {
+                values.push_back(static_cast<u32>(std::strtoul(item.c_str(), nullptr, 10)));
+            }
+            item.clear();
+            if (*p == '\0') break;
+        } else {
+            item.push_back(*p);
+        }
+    }
+    return values;
+}
+
+void print_usage(const char* program) {
+    std::printf("Usage: %s [options]\n"
+                "  --clients N[,N...]           client counts (default 1,4)\n"
+                "  --sizes S[,S...]             payload sizes in bytes (default 64,1024,16384)\n"
+                "  --messages M                 messages per client (default 20000)\n"
+                "  --window W                   messages in flight per client (default 16)\n"
+                "  --fuzz                       also run with malformed input and compare\n"
+                "  --malformed-ratio R          share of malformed messages (default 0.3)\n"
+                "  --min-fuzz-throughput F      required fuzz/clean message rate (default 0.7)\n"
+                "  --seed N                     random seed (default 1)\n"
+                "  --dispatch                   only run the handler dispatch microbenchmark\n",
+                program);
+}
+
+bool parse_options(int argc, char** argv, BenchmarkOptions& options) {
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        bool has_value = i + 1 < argc;
+
+        if (arg == "--clients" && has_value) {
+            options.client_counts = parse_list(argv[++i]);
+        } else if (arg == "--sizes" && has_value) {
+            options.payload_sizes = parse_list(argv[++i]);
+        } else if (arg == "--messages" && has_value) {
+            options.messages_per_client = static_cast<u32>(std::strtoul(argv[++i], nullptr, 10));
+        } else if (arg == "--window" && has_value) {
+            options.window = std::max<u32>(1, static_cast<u32>(std::strtoul(argv[++i], nullptr, 10)));
+        } else if (arg == "--dispatch") {
+            options.dispatch_only = true;
+        } else if (arg == "--fuzz") {
+            options.fuzz = true;
+        } else if (arg == "--malformed-ratio" && has_value) {
+            options.malformed_ratio = std::strtod(argv[++i], nullptr);
+        } else if (arg == "--min-fuzz-throughput" && has_value) {
+            options.min_fuzz_throughput = std::strtod(argv[++i], nullptr);
+        } else if (arg == "--seed" && has_value) {
+            options.seed = static_cast<u32>(std::strtoul(argv[++i], nullptr, 10));
+        } else {
+            print_usage(argv[0]);
+            return false;
+        }
+    }
+
+    for (u32 size : options.payload_sizes) {
+        if (size > MAX_MESSAGE_PAYLOAD_SIZE) {
+            std::fprintf(stderr, "payload size %u exceeds the protocol limit of %u\n", size, MAX_MESSAGE_PAYLOAD_SIZE);
+            return false;
+        }
+    }
+
+    return !options.client_counts.empty() && !options.payload_sizes.empty() && options.messages_per_client > 0;
+}
+
+} // namespace
+} // namespace s1u
+
+int main(int argc, char** argv) {
+    using namespace s1u;
+
+    BenchmarkOptions options;
+    if (!parse_options(argc, argv, options)) {
+        return 2;
+    }
+
+    run_dispatch_benchmark(200, options.seed);
+    if (options.dispatch_only) {
+        return 0;
+    }
+
+    std::printf("%-6s %7s %8s %12s %10s %9s %9s %9s\n",
+                "mode", "clients", "size", "msgs/s", "MB/s", "p50 us", "p99 us", "rejected");
+
+    bool passed = true;
+    for (u32 client_count : options.client_counts) {
+        for (u32 payload_size : options.payload_sizes) {
+            RunResult clean = run_configuration(options, client_count, payload_size, 0.0);
+            print_result("clean", client_count, payload_size, clean);
+            passed = passed && clean.completed;
+
+            if (!options.fuzz) continue;
+
+            RunResult fuzzed = run_configuration(options, client_count, payload_size, options.malformed_ratio);
+            print_result("fuzz", client_count, payload_size, fuzzed);
+
+            f64 ratio = (fuzzed.messages / fuzzed.seconds) / (clean.messages / clean.seconds);
+            if (!fuzzed.completed || ratio < options.min_fuzz_throughput) {
+                std::printf("  FAIL: malformed input dropped throughput to %.2fx of clean\n", ratio);
+                passed = false;
+            }
+        }
+    }
+
+    return passed ? 0 : 1;
+}
@@ -0,0 +1,854 @@
+// Connection-storm load generator.
+//
+// Starts a QuantumNetworkProtocol server in-process and opens tens of
+// thousands of loopback TCP connections to it, either all at once (an
+// accept storm) or at a fixed connection rate. Once every connection has
+// been served, the clients send a weighted mix of message classes, closed
+// loop or at a fixed aggregate rate, and time each message until the server
+// has echoed all of its bytes back. Open-loop latency is measured from the
+// time a message was scheduled, not from when it got onto the socket, so a
+// stalled server shows up in the percentiles instead of hiding in them.
+//
+// Results are written as one JSON document for regression tracking; a
+// short summary goes to stderr.
+
+#include "s1u/core.hpp"
+#include "s1u/quantum_network_protocol.hpp"
+#include "s1u/network_statistics.hpp"
+#include "s1u/network_stream_records.hpp"
+#include <sys/epoll.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <memory>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#ifndef IP_BIND_ADDRESS_NO_PORT
+#define IP_BIND_ADDRESS_NO_PORT 24
+#endif
+
+namespace S1U {
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+constexpr u32 PROBE_SIZE = 16;
+constexpr u32 MAX_OUTSTANDING = 64;        // open loop: per connection
+constexpr u32 PORTS_PER_SOURCE = 16384;    // connections per 127.0.0.x source
+constexpr u32 MAX_MESSAGE_SIZE = 16 << 20;
+constexpr u32 IO_CHUNK = 256 << 10;
+
+u64 now_ns() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now().time_since_epoch()).count();
+}
+
+f64 thread_cpu_seconds(int who) {
+    struct rusage usage = {};
+    getrusage(who, &usage);
+    return usage.ru_utime.tv_sec + usage.ru_stime.tv_sec + (usage.ru_utime.tv_usec + usage.ru_stime.tv_usec) / 1e6;
+}
+
+struct MessageClass {
+    std::string name;
+    f64 weight = 1.0;
+    u32 min_size = 64;
+    u32 max_size = 64;
+};
+
+struct LoadOptions {
+    u32 connections = 10000;
+    u32 threads = 4;
+    f64 connect_rate = 0.0;   // connections per second; 0 opens them all at once
+    f64 message_rate = 0.0;   // messages per second; 0 runs closed loop
+    u32 window = 1;           // closed loop: messages in flight per connection
+    f64 duration = 10.0;
+    f64 connect_timeout = 30.0;
+    u32 port = 18080;
+    u32 shards = 0;
+    bool pacing = true;
+    bool zero_copy = true;
+    u32 seed = 1;
+    std::string output;
+    std::vector<MessageClass> mix;
+};
+
+// Phases are driven by the main thread; client threads only read these
+struct SharedState {
+    std::atomic<u32> resolved{0};
+    std::atomic<bool> start_messages{false};
+    std::atomic<bool> stop_sending{false};
+    std::atomic<bool> finish{false};
+};
+
+// Each message is one stream record: its length, then size bytes
+struct PendingMessage {
+    u64 scheduled_ns = 0;
+    u32 size = 0;
+    u32 unsent = 0;         // record bytes not yet written
+    u32 remaining = 0;      // record bytes not yet echoed
+    i32 message_class = -1; // -1: the connect probe
+};
+
+struct ClientConnection {
+    enum class State : u8 { Connecting, Probing, Ready, Failed };
+
+    int fd = -1;
+    State state = State::Connecting;
+    bool writing = false;
+    u64 connect_start_ns = 0;
+    u64 unsent = 0;
+    size_t next_unsent = 0; // first in_flight message not fully written
+    std::deque<PendingMessage> in_flight;
+};
+
+struct ClassResult {
+    u64 completed = 0;
+    u64 bytes = 0;
+    LatencyHistogram latency;
+};
+
+class LoadThread {
+public:
+    LoadThread(const LoadOptions& options, SharedState& shared, u32 first, u32 count, u32 seed)
+        : classes(options.mix.size()), options_(options), shared_(shared), first_(first),
+          connections_(count), rng_(seed) {
+        std::vector<f64> weights;
+        for (const auto& message_class : options.mix) {
+            weights.push_back(message_class.weight);
+        }
+        class_picker_ = std::discrete_distribution<u32>(weights.begin(), weights.end());
+    }
+
+    ~LoadThread() {
+        for (auto& connection : connections_) {
+            if (connection.fd != -1) {
+                close(connection.fd);
+            }
+        }
+        if (epoll_fd_ != -1) {
+            close(epoll_fd_);
+        }
+    }
+
+    void run();
+
+    u64 established = 0;
+    u64 failed = 0;
+    u64 sent = 0;
+    u64 backlogged = 0;
+    f64 cpu_seconds = 0.0;
+    LatencyHistogram handshake_latency;
+    LatencyHistogram ready_latency;
+    LatencyHistogram message_latency;
+    std::vector<ClassResult> classes;
+
+private:
+    void open_connection(u32 index);
+    void handle_event(u32 index, u32 events);
+    void fail(ClientConnection& connection);
+    void queue_message(u32 index, i32 message_class, u32 size, u64 scheduled_ns);
+    void flush(u32 index);
+    void receive(u32 index);
+    void set_writing(u32 index, bool writing);
+    u32 pick_message(u32& size);
+    void top_up(u32 index);
+    void send_scheduled(u64 now);
+    void poll_events(int timeout_ms);
+
+    const LoadOptions& options_;
+    SharedState& shared_;
+    u32 first_;
+    std::vector<ClientConnection> connections_;
+    std::vector<u32> ready_;
+    size_t next_ready_ = 0;
+    u64 next_send_ns_ = 0;
+    f64 message_interval_ns_ = 0.0;
+    int epoll_fd_ = -1;
+    std::mt19937 rng_;
+    std::discrete_distribution<u32> class_picker_;
+    std::vector<u8> payload_ = std::vector<u8>(IO_CHUNK, 0x5A);
+    std::vector<u8> scratch_ = std::vector<u8>(IO_CHUNK);
+};
+
+void LoadThread::run() {
+    epoll_fd_ = epoll_create1(EPOLL_CLOEXEC);
+    if (epoll_fd_ == -1) {
+        failed = connections_.size();
+        shared_.resolved += static_cast<u32>(connections_.size());
+        return;
+    }
+
+    // Connect phase: open at the requested rate, a bounded batch per pass so
+    // handshakes are timed promptly even in a storm
+    u64 phase_start = now_ns();
+    f64 rate = options_.connect_rate / options_.threads;
+    u32 opened = 0;
+    while (!shared_.start_messages.load(std::memory_order_acquire)) {
+        u32 due = static_cast<u32>(connections_.size());
+        if (rate > 0.0) {
+            due = std::min<u32>(due, static_cast<u32>((now_ns() - phase_start) / 1e9 * rate) + 1);
+        }
+        for (u32 batch = 0; opened < due && batch < 256; batch++) {
+            open_connection(opened++);
+        }
+        poll_events(opened < connections_.size() ? 0 : 1);
+    }
+
+    // Message phase
+    f64 cpu_start = thread_cpu_seconds(RUSAGE_THREAD);
+    bool open_loop = options_.message_rate > 0.0;
+    if (!open_loop) {
+        for (u32 index : ready_) {
+            top_up(index);
+        }
+    }
+    next_send_ns_ = now_ns();
+    message_interval_ns_ = open_loop ? 1e9 * options_.threads / options_.message_rate : 0.0;
+
+    while (!shared_.stop_sending.load(std::memory_order_acquire)) {
+        if (open_loop) {
+            send_scheduled(now_ns());
+        }
+        poll_events(open_loop ? 0 : 1);
+    }
+
+    // Drain what is still in flight; the main thread bounds how long
+    while (!shared_.finish.load(std::memory_order_acquire)) {
+        poll_events(1);
+    }
+    cpu_seconds = thread_cpu_seconds(RUSAGE_THREAD) - cpu_start;
+}
+
+void LoadThread::open_connection(u32 index) {
+    ClientConnection& connection = connections_[index];
+    connection.connect_start_ns = now_ns();
+    connection.fd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (connection.fd == -1) {
+        fail(connection);
+        return;
+    }
+
+    int opt = 1;
+    setsockopt(connection.fd, IPPROTO_TCP, TCP_NODELAY, &opt, sizeof(opt));
+
+    // One loopback source address per PORTS_PER_SOURCE connections, so the
+    // storm is not capped by the ephemeral port range of 127.0.0.1
+    u32 global_index = first_ + index;
+    struct sockaddr_in source = {};
+    source.sin_family = AF_INET;
+    source.sin_addr.s_addr = htonl(0x7F000001 + (global_index / PORTS_PER_SOURCE) % 254);
+    setsockopt(connection.fd, IPPROTO_IP, IP_BIND_ADDRESS_NO_PORT, &opt, sizeof(opt));
+    bind(connection.fd, reinterpret_cast<struct sockaddr*>(&source), sizeof(source));
+
+    struct sockaddr_in server = {};
+    server.sin_family = AF_INET;
+    server.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    server.sin_port = htons(options_.port);
+
+    if (connect(connection.fd, reinterpret_cast<struct sockaddr*>(&server), sizeof(server)) == -1 &&
+        errno != EINPROGRESS) {
+        fail(connection);
+        return;
+    }
+
+    struct epoll_event ev = {};
+    ev.events = EPOLLOUT;
+    ev.data.u32 = index;
+    if (epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, connection.fd, &ev) == -1) {
+        fail(connection);
+        return;
+    }
+    connection.writing = true;
+}
+
+void LoadThread::fail(ClientConnection& connection) {
+    if (connection.state == ClientConnection::State::Failed) {
+        return;
+    }
+    bool was_ready = connection.state == ClientConnection::State::Ready;
+    connection.state = ClientConnection::State::Failed;
+    if (connection.fd != -1) {
+        close(connection.fd);
+        connection.fd = -1;
+    }
+    connection.in_flight.clear();
+    connection.unsent = 0;
+    connection.next_unsent = 0;
+
+    if (was_ready) {
+        established--;
+    } else {
+        shared_.resolved++;
+    }
+    failed++;
+}
+
+void LoadThread::poll_events(int timeout_ms) {
+    struct epoll_event events[256];
+    int count = epoll_wait(epoll_fd_, events, 256, timeout_ms);
+    for (int i = 0; i < count; i++) {
+        handle_event(events[i].data.u32, events[i].events);
+    }
+}
+
+void LoadThread::handle_event(u32 index, u32 events) {
+    ClientConnection& connection = connections_[index];
+    if (connection.state == ClientConnection::State::Failed) {
+        return;
+    }
+
+    if (connection.state == ClientConnection::State::Connecting) {
+        int error = 0;
+        socklen_t length = sizeof(error);
+        if (getsockopt(connection.fd, SOL_SOCKET, SO_ERROR, &error, &length) == -1 || error != 0) {
+            fail(connection);
+            return;
+        }
+        handshake_latency.record(now_ns() - connection.connect_start_ns);
+        connection.state = ClientConnection::State::Probing;
+        set_writing(index, false);
+        queue_message(index, -1, PROBE_SIZE, now_ns());
+        return;
+    }
+
+    if (events & EPOLLIN) {
+        receive(index);
+    }
+    if (connection.state != ClientConnection::State::Failed && (events & (EPOLLHUP | EPOLLERR))) {
+        fail(connection);
+        return;
+    }
+    if (connection.state != ClientConnection::State::Failed && (events & EPOLLOUT)) {
+        flush(index);
+    }
+}
+
+void LoadThread::queue_message(u32 index, i32 message_class, u32 size, u64 scheduled_ns) {
+    ClientConnection& connection = connections_[index];
+    u32 record_bytes = size + static_cast<u32>(STREAM_RECORD_PREFIX_SIZE);
+    connection.in_flight.push_back(PendingMessage{scheduled_ns, size, record_bytes, record_bytes, message_class});
+    connection.unsent += record_bytes;
+    if (message_class >= 0) {
+        sent++;
+    }
+    flush(index);
+}
+
+void LoadThread::flush(u32 index) {
+    // Message contents are irrelevant to the echo; only byte counts are
+    // tracked, so one pattern buffer feeds every write behind the record's
+    // length prefix
+    ClientConnection& connection = connections_[index];
+    while (connection.next_unsent < connection.in_flight.size()) {
+        PendingMessage& message = connection.in_flight[connection.next_unsent];
+        u32 offset = message.size + static_cast<u32>(STREAM_RECORD_PREFIX_SIZE) - message.unsent;
+
+        u8 prefix[STREAM_RECORD_PREFIX_SIZE];
+        struct iovec iov[2];
+        u32 iov_count = 0;
+        u32 body_unsent = message.unsent;
+        if (offset < STREAM_RECORD_PREFIX_SIZE) {
+            write_stream_record_prefix(prefix, message.size);
+            iov[iov_count++] = {prefix + offset, STREAM_RECORD_PREFIX_SIZE - offset};
+            body_unsent = message.size;
+        }
+        iov[iov_count++] = {payload_.data(), std::min<size_t>(body_unsent, payload_.size())};
+
+        struct msghdr header = {};
+        header.msg_iov = iov;
+        header.msg_iovlen = iov_count;
+        ssize_t written = sendmsg(connection.fd, &header, MSG_NOSIGNAL);
+        if (written > 0) {
+            message.unsent -= static_cast<u32>(written);
+            connection.unsent -= written;
+            if (message.unsent == 0) {
+                connection.next_unsent++;
+            }
+            continue;
+        }
+        if (written == -1 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            set_writing(index, true);
+            return;
+        }
+        fail(connection);
+        return;
+    }
+    set_writing(index, false);
+}
+
+void LoadThread::set_writing(u32 index, bool writing) {
+    ClientConnection& connection = connections_[index];
+    if (connection.writing == writing) {
+        return;
+    }
+    struct epoll_event ev = {};
+    ev.events = writing ? EPOLLIN | EPOLLOUT : EPOLLIN;
+    ev.data.u32 = index;
+    epoll_ctl(epoll_fd_, EPOLL_CTL_MOD, connection.fd, &ev);
+    connection.writing = writing;
+}
+
+void LoadThread::receive(u32 index) {
+    ClientConnection& connection = connections_[index];
+    while (true) {
+        ssize_t received = recv(connection.fd, scratch_.data(), scratch_.size(), 0);
+        if (received == 0 || (received == -1 && errno != EAGAIN && errno != EWOULDBLOCK)) {
+            fail(connection);
+            return;
+        }
+        if (received == -1) {
+            return;
+        }
+
+        u64 bytes = received;
+        u64 now = now_ns();
+        while (bytes > 0 && !connection.in_flight.empty()) {
+            PendingMessage& message = connection.in_flight.front();
+            u32 take = static_cast<u32>(std::min<u64>(bytes, message.remaining));
+            message.remaining -= take;
+            bytes -= take;
+            if (message.remaining > 0) {
+                break;
+            }
+
+            u64 latency = now - message.scheduled_ns;
+            u32 size = message.size;
+            i32 message_class = message.message_class;
+            connection.in_flight.pop_front();
+            connection.next_unsent--;
+
+            if (message_class < 0) {
+                ready_latency.record(now - connection.connect_start_ns);
+                connection.state = ClientConnection::State::Ready;
+                ready_.push_back(index);
+                established++;
+                shared_.resolved++;
+                continue;
+            }
+
+            ClassResult& result = classes[message_class];
+            result.completed++;
+            result.bytes += size;
+            result.latency.record(latency);
+            message_latency.record(latency);
+
+            if (options_.message_rate <= 0.0 && !shared_.stop_sending.load(std::memory_order_relaxed)) {
+                top_up(index);
+            }
+        }
+    }
+}
+
+u32 LoadThread::pick_message(u32& size) {
+    u32 message_class = class_picker_(rng_);
+    const MessageClass& spec = options_.mix[message_class];
+    size = spec.min_size;
+    if (spec.max_size > spec.min_size) {
+        // Log-uniform: small sizes dominate, as in real traffic, while the
+        // top of the range still shows up
+        std::uniform_real_distribution<f64> exponent(std::log(spec.min_size), std::log(spec.max_size));
+        size = static_cast<u32>(std::exp(exponent(rng_)));
+    }
+    return message_class;
+}
+
+void LoadThread::top_up(u32 index) {
+    ClientConnection& connection = connections_[index];
+    while (connection.state == ClientConnection::State::Ready && connection.in_flight.size() < options_.window) {
+        u32 size = 0;
+        u32 message_class = pick_message(size);
+        queue_message(index, static_cast<i32>(message_class), size, now_ns());
+    }
+}
+
+void LoadThread::send_scheduled(u64 now) {
+    while (now >= next_send_ns_) {
+        u64 scheduled = next_send_ns_;
+        next_send_ns_ += static_cast<u64>(message_interval_ns_);
+
+        // Round-robin over ready connections, skipping any that are too far
+        // behind; a tick with nowhere to go is counted, not dropped silently
+        bool placed = false;
+        for (size_t tries = 0; tries < ready_.size() && !placed; tries++) {
+            u32 index = ready_[next_ready_++ % ready_.size()];
+            ClientConnection& connection = connections_[index];
+            if (connection.state != ClientConnection::State::Ready || connection.in_flight.size() >= MAX_OUTSTANDING) {
+                continue;
+            }
+
+            u32 size = 0;
+            u32 message_class = pick_message(size);
+            queue_message(index, static_cast<i32>(message_class), size, scheduled);
+            placed = true;
+        }
+        if (!placed) {
+            backlogged++;
+        }
+    }
+}
+
+bool parse_size(const char* text, u32& value) {
+    char* end = nullptr;
+    unsigned long long parsed = std::strtoull(text, &end, 10);
+    if (end == text) {
+        return false;
+    }
+    if (*end == 'k' || *end == 'K') {
+        parsed <<= 10;
+        end++;
+    } else if (*end == 'm' || *end == 'M') {
+        parsed <<= 20;
+        end++;
+    }
+    if (*end != '\0' || parsed == 0 || parsed > MAX_MESSAGE_SIZE) {
+        return false;
+    }
+    value = static_cast<u32>(parsed);
+    return true;
+}
+
+// name:weight:size or name:weight:min-max, comma separated
+bool parse_mix(const std::string& text, std::vector<MessageClass>& mix) {
+    mix.clear();
+    size_t start = 0;
+    while (start <= text.size()) {
+        size_t end = text.find(',', start);
+        std::string entry = text.substr(start, end == std::string::npos ? std::string::npos : end - start);
+
+        size_t first_colon = entry.find(':');
+        size_t second_colon = first_colon == std::string::npos ? std::string::npos : entry.find(':', first_colon + 1);
+        if (second_colon == std::string::npos) {
+            return false;
+        }
+
+        MessageClass message_class;
+        message_class.name = entry.substr(0, first_colon);
+        message_class.weight = std::strtod(entry.substr(first_colon + 1, second_colon - first_colon - 1).c_str(), nullptr);
+
+        std::string sizes = entry.substr(second_colon + 1);
+        size_t dash = sizes.find('-');
+        if (!parse_size(sizes.substr(0, dash).c_str(), message_class.min_size)) {
+            return false;
+        }
+        message_class.max_size = message_class.min_size;
+        if (dash != std::string::npos && !parse_size(sizes.substr(dash + 1).c_str(), message_class.max_size)) {
+            return false;
+        }
+        if (message_class.name.empty() || message_class.weight <= 0.0 || message_class.max_size < message_class.min_size) {
+            return false;
+        }
+        mix.push_back(message_class);
+
+        if (end == std::string::npos) {
+            break;
+        }
+        start = end + 1;
+    }
+    return !mix.empty();
+}
+
+void print_usage(const char* program) {
+    std::printf("Usage: %s [options]\n"
+                "  --connections N            loopback connections to open (default 10000)\n"
+                "  --threads N                client threads (default 4)\n"
+                "  --connect-rate R           connections per second, 0 = all at once (default 0)\n"
+                "  --rate R                   messages per second, 0 = closed loop (default 0)\n"
+                "  --window N                 closed loop: messages in flight per connection (default 1)\n"
+                "  --duration S               seconds of message traffic (default 10)\n"
+                "  --connect-timeout S        give up on unserved connections after S seconds (default 30)\n"
+                "  --mix SPEC                 name:weight:size[-max],... sizes take k/M suffixes and\n"
+                "                             ranges are drawn log-uniformly\n"
+                "                             (default input:70:32-256,update:25:1k-16k,frame:5:64k-256k)\n"
+                "  --port N                   server port (default 18080)\n"
+                "  --shards N                 server reactor shards, 0 = one per CPU (default 0)\n"
+                "  --no-pacing                disable the server's pacing and congestion control\n"
+                "  --no-zero-copy             disable the server's zero-copy send path\n"
+                "  --seed N                   random seed (default 1)\n"
+                "  --output FILE              write the JSON report to FILE instead of stdout\n",
+                program);
+}
+
+bool parse_options(int argc, char** argv, LoadOptions& options) {
+    std::string mix = "input:70:32-256,update:25:1k-16k,frame:5:64k-256k";
+
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        bool has_value = i + 1 < argc;
+
+        if (arg == "--connections" && has_value) {
+            options.connections = static_cast<u32>(std::strtoul(argv[++i], nullptr, 10));
+        } else if (arg == "--threads" && has_value) {
+            options.threads = std::max<u32>(1, static_cast<u32>(std::strtoul(argv[++i], nullptr, 10)));
+        } else if (arg == "--connect-rate" && has_value) {
+            options.connect_rate = std::strtod(argv[++i], nullptr);
+        } else if (arg == "--rate" && has_value) {
+            options.message_rate = std::strtod(argv[++i], nullptr);
+        } else if (arg == "--window" && has_value) {
+            options.window = std::clamp<u32>(static_cast<u32>(std::strtoul(argv[++i], nullptr, 10)), 1, MAX_OUTSTANDING);
+        } else if (arg == "--duration" && has_value) {
+            options.duration = std::strtod(argv[++i], nullptr);
+        } else if (arg == "--connect-timeout" && has_value) {
+            options.connect_timeout = std::strtod(argv[++i], nullptr);
+        } else if (arg == "--mix" && has_value) {
+            mix = argv[++i];
+        } else if (arg == "--port" && has_value) {
+            options.port = static_cast<u32>(std::strtoul(argv[++i], nullptr, 10));
+        } else if (arg == "--shards" && has_value) {
+            options.shards = static_cast<u32>(std::strtoul(argv[++i], nullptr, 10));
+        } else if (arg == "--no-pacing") {
+            options.pacing = false;
+        } else if (arg == "--no-zero-copy") {
+            options.zero_copy = false;
+        } else if (arg == "--seed" && has_value) {
+            options.seed = static_cast<u32>(std::strtoul(argv[++i], nullptr, 10));
+        } else if (arg == "--output" && has_value) {
+            options.output = argv[++i];
+        } else {
+            print_usage(argv[0]);
+            return false;
+        }
+    }
+
+    if (!parse_mix(mix, options.mix)) {
+        std::fprintf(stderr, "invalid --mix '%s'\n", mix.c_str());
+        return false;
+    }
+    if (options.connections == 0 || options.duration <= 0.0 || options.port == 0 || options.port > 65535) {
+        print_usage(argv[0]);
+        return false;
+    }
+    options.threads = std::min(options.threads, options.connections);
+    return true;
+}
+
+// Both ends of every connection live in this process
+bool raise_descriptor_limit(u32 connections) {
+    struct rlimit limit = {};
+    getrlimit(RLIMIT_NOFILE, &limit);
+    rlim_t needed = static_cast<rlim_t>(connections) * 2 + 1024;
+    if (limit.rlim_cur < needed) {
+        limit.rlim_cur = std::min(needed, limit.rlim_max);
+        setrlimit(RLIMIT_NOFILE, &limit);
+        getrlimit(RLIMIT_NOFILE, &limit);
+    }
+    if (limit.rlim_cur < needed) {
+        std::fprintf(stderr, "need %llu file descriptors, limit is %llu\n",
+                     static_cast<unsigned long long>(needed), static_cast<unsigned long long>(limit.rlim_cur));
+        return false;
+    }
+    return true;
+}
+
+void write_latency(FILE* out, const char* name, const LatencySnapshot& latency) {
+    std::fprintf(out, "\"%s\": {\"samples\": %llu, \"mean\": %.1f, \"p50\": %.1f, \"p90\": %.1f, "
+                      "\"p99\": %.1f, \"p999\": %.1f}",
+                 name, static_cast<unsigned long long>(latency.total), latency.mean_ns() / 1e3,
+                 latency.percentile_ns(0.50) / 1e3, latency.percentile_ns(0.90) / 1e3,
+                 latency.percentile_ns(0.99) / 1e3, latency.percentile_ns(0.999) / 1e3);
+}
+
+} // namespace
+} // namespace S1U
+
+int main(int argc, char** argv) {
+    using namespace S1U;
+
+    LoadOptions options;
+    if (!parse_options(argc, argv, options)) {
+        return 2;
+    }
+    if (!raise_descriptor_limit(options.connections)) {
+        return 2;
+    }
+
+    // Plain echo server: the protocol sends every received chunk back to
+    // its connection. Compression and encryption stay off because their
+    // framing is not carried on the stream, so an echoed byte count could
+    // not be matched to the messages sent.
+    NetworkConfig config;
+    config.port = options.port;
+    config.reactor_shards = options.shards;
+    config.max_connections = options.connections + 1024;
+    config.enable_rdma = false;
+    config.enable_quantum_entanglement = false;
+    config.enable_neural_compression = false;
+    config.enable_compression = false;
+    config.enable_encryption = false;
+    config.max_stream_record_size = MAX_MESSAGE_SIZE;
+    config.enable_congestion_control = options.pacing;
+    config.enable_zero_copy = options.zero_copy;
+
+    QuantumNetworkProtocol server;
+    if (!server.initialize(config)) {
+        std::fprintf(stderr, "server failed to start on port %u\n", options.port);
+        return 2;
+    }
+
+    SharedState shared;
+    std::vector<std::unique_ptr<LoadThread>> load_threads;
+    std::vector<std::thread> threads;
+    u32 first = 0;
+    for (u32 t = 0; t < options.threads; t++) {
+        u32 count = options.connections / options.threads + (t < options.connections % options.threads ? 1 : 0);
+        load_threads.push_back(std::make_unique<LoadThread>(options, shared, first, count, options.seed * 7919 + t));
+        first += count;
+    }
+
+    f64 cpu_start = thread_cpu_seconds(RUSAGE_SELF);
+    auto connect_start = Clock::now();
+    for (auto& load_thread : load_threads) {
+        LoadThread* worker = load_thread.get();
+        threads.emplace_back([worker]() { worker->run(); });
+    }
+
+    while (shared.resolved.load() < options.connections &&
+           std::chrono::duration<f64>(Clock::now() - connect_start).count() < options.connect_timeout) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    f64 connect_seconds = std::chrono::duration<f64>(Clock::now() - connect_start).count();
+
+    // Message phase. Server CPU is the process total minus what the client
+    // threads report for themselves over the same phase.
+    f64 message_cpu_start = thread_cpu_seconds(RUSAGE_SELF);
+    auto message_start = Clock::now();
+    shared.start_messages.store(true, std::memory_order_release);
+    std::this_thread::sleep_for(std::chrono::duration<f64>(options.duration));
+    shared.stop_sending.store(true, std::memory_order_release);
+    f64 message_seconds = std::chrono::duration<f64>(Clock::now() - message_start).count();
+
+    std::this_thread::sleep_for(std::chrono::seconds(2));
+    shared.finish.store(true, std::memory_order_release);
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    f64 message_cpu = thread_cpu_seconds(RUSAGE_SELF) - message_cpu_start;
+    f64 total_cpu = thread_cpu_seconds(RUSAGE_SELF) - cpu_start;
+
+    NetworkProtocolStats server_stats = server.get_performance_stats();
+
+    u64 established = 0;
+    u64 failed = 0;
+    u64 sent = 0;
+    u64 backlogged = 0;
+    f64 client_cpu = 0.0;
+    LatencySnapshot handshake;
+    LatencySnapshot ready;
+    LatencySnapshot messages;
+    std::vector<LatencySnapshot> class_latency(options.mix.size());
+    std::vector<u64> class_completed(options.mix.size());
+    std::vector<u64> class_bytes(options.mix.size());
+    for (auto& load_thread : load_threads) {
+        established += load_thread->established;
+        failed += load_thread->failed;
+        sent += load_thread->sent;
+        backlogged += load_thread->backlogged;
+        client_cpu += load_thread->cpu_seconds;
+        handshake.add(load_thread->handshake_latency);
+        ready.add(load_thread->ready_latency);
+        messages.add(load_thread->message_latency);
+        for (size_t c = 0; c < options.mix.size(); c++) {
+            class_latency[c].add(load_thread->classes[c].latency);
+            class_completed[c] += load_thread->classes[c].completed;
+            class_bytes[c] += load_thread->classes[c].bytes;
+        }
+    }
+    u64 unserved = options.connections - std::min<u64>(options.connections, established + failed);
+    u64 completed = messages.total;
+    u64 message_bytes = 0;
+    for (u64 bytes : class_bytes) {
+        message_bytes += bytes;
+    }
+    f64 server_cpu = std::max(0.0, message_cpu - client_cpu);
+
+    FILE* out = stdout;
+    if (!options.output.empty()) {
+        out = std::fopen(options.output.c_str(), "w");
+        if (!out) {
+            std::perror(options.output.c_str());
+            server.shutdown();
+            return 2;
+        }
+    }
+
+    // Latencies in microseconds, sizes in bytes
+    std::fprintf(out, "{\n  \"tool\": \"s1u_loadgen\",\n  \"format\": 1,\n");
+    std::fprintf(out, "  \"config\": {\"connections\": %u, \"threads\": %u, \"connect_rate\": %.1f, "
+                      "\"message_rate\": %.1f, \"window\": %u, \"duration\": %.2f, \"shards\": %u, "
+                      "\"pacing\": %s, \"zero_copy\": %s, \"seed\": %u, \"mix\": [",
+                 options.connections, options.threads, options.connect_rate, options.message_rate, options.window,
+                 options.duration, options.shards, options.pacing ? "true" : "false",
+                 options.zero_copy ? "true" : "false", options.seed);
+    for (size_t c = 0; c < options.mix.size(); c++) {
+        const MessageClass& spec = options.mix[c];
+        std::fprintf(out, "%s{\"name\": \"%s\", \"weight\": %g, \"min_size\": %u, \"max_size\": %u}",
+                     c ? ", " : "", spec.name.c_str(), spec.weight, spec.min_size, spec.max_size);
+    }
+    std::fprintf(out, "]},\n");
+
+    std::fprintf(out, "  \"connect\": {\"established\": %llu, \"failed\": %llu, \"unserved\": %llu, \"seconds\": %.3f, "
+                      "\"per_second\": %.1f, ",
+                 static_cast<unsigned long long>(established), static_cast<unsigned long long>(failed),
+                 static_cast<unsigned long long>(unserved), connect_seconds,
+                 connect_seconds > 0.0 ? (established + failed) / connect_seconds : 0.0);
+    write_latency(out, "handshake_us", handshake);
+    std::fprintf(out, ", ");
+    write_latency(out, "accept_us", ready);
+    std::fprintf(out, "},\n");
+
+    std::fprintf(out, "  \"messages\": {\"sent\": %llu, \"completed\": %llu, \"backlogged\": %llu, \"bytes\": %llu, "
+                      "\"seconds\": %.3f, \"per_second\": %.1f, \"mbps\": %.2f, ",
+                 static_cast<unsigned long long>(sent), static_cast<unsigned long long>(completed),
+                 static_cast<unsigned long long>(backlogged), static_cast<unsigned long long>(message_bytes),
+                 message_seconds, completed / message_seconds, message_bytes * 8.0 / message_seconds / 1e6);
+    write_latency(out, "latency_us", messages);
+    std::fprintf(out, ", \"classes\": [");
+    for (size_t c = 0; c < options.mix.size(); c++) {
+        std::fprintf(out, "%s{\"name\": \"%s\", \"completed\": %llu, \"bytes\": %llu, ", c ? ", " : "",
+                     options.mix[c].name.c_str(), static_cast<unsigned long long>(class_completed[c]),
+                     static_cast<unsigned long long>(class_bytes[c]));
+        write_latency(out, "latency_us", class_latency[c]);
+        std::fprintf(out, "}");
+    }
+    std::fprintf(out, "]},\n");
+
+    std::fprintf(out, "  \"server\": {\"cpu_seconds\": %.3f, \"cpu_us_per_message\": %.3f, \"total_cpu_seconds\": %.3f, "
+                      "\"peak_connections\": %u, \"packets_received\": %llu, \"packets_sent\": %llu, "
+                      "\"receive_syscalls_per_packet\": %.3f, \"send_syscalls_per_packet\": %.3f, "
+                      "\"processing_p99_us\": %.1f}\n}\n",
+                 server_cpu, completed ? server_cpu * 1e6 / completed : 0.0, total_cpu - client_cpu,
+                 server_stats.peak_connections,
+                 static_cast<unsigned long long>(server_stats.packets_received),
+                 static_cast<unsigned long long>(server_stats.packets_sent),
+                 server_stats.receive_syscalls_per_packet, server_stats.send_syscalls_per_packet,
+                 server_stats.latency_p99_ms * 1e3);
+    if (out != stdout) {
+        std::fclose(out);
+    }
+
+    std::fprintf(stderr, "%llu/%u connections in %.2f s (accept p99 %.0f us), %llu messages at %.0f/s, "
+                         "p50 %.0f us p99 %.0f us, server %.2f us CPU per message\n",
+                 static_cast<unsigned long long>(established), options.connections, connect_seconds,
+                 ready.percentile_ns(0.99) / 1e3, static_cast<unsigned long long>(completed),
+                 completed / message_seconds, messages.percentile_ns(0.50) / 1e3,
+                 messages.percentile_ns(0.99) / 1e3, completed ? server_cpu * 1e6 / completed : 0.0);
+
+    server.shutdown();
+    return established == options.connections && completed > 0 ? 0 : 1;
+}
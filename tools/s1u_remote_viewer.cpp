@@ -0,0 +1,429 @@
+// Remote display reference viewer.
+//
+// Streams a synthetic kiosk screen (static backdrop, rotating slideshow
+// panel, clock, scrolling ticker and a moving cursor) through
+// RemoteDisplayStream, the same path the compositor's readback feeds, to a
+// viewer connected over loopback TCP. The viewer rebuilds the screen from
+// tiles and compares it with the source after every frame; the tool fails
+// on the first mismatch. At the end it reports
+// what the stream would need on the wire at the given frame rate.
+
+#include "s1u/core.hpp"
+#include "s1u/damage_region.hpp"
+#include "s1u/network_remote_display.hpp"
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+#include <unistd.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <string>
+#include <thread>
+
+namespace s1u {
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+struct ViewerOptions {
+    u32 width = 1280;
+    u32 height = 720;
+    u32 frames = 600;
+    u32 fps = 30;
+    u32 tile_size = 64;
+    u32 cache_capacity = 4096;
+    f64 link_mbps = 10.0;
+    std::string dump_path;
+};
+
+// Deterministic kiosk content. Every draw call reports what it touched.
+class KioskScene {
+public:
+    KioskScene(u32 width, u32 height) : width_(width), height_(height), pixels_(size_t(width) * height * 4) {
+        std::mt19937 rng(7);
+        for (auto& slide : slides_) {
+            slide.resize(size_t(SLIDE_WIDTH) * SLIDE_HEIGHT * 4);
+            u32 base = rng();
+            for (u32 y = 0; y < SLIDE_HEIGHT; y++) {
+                for (u32 x = 0; x < SLIDE_WIDTH; x++) {
+                    // Smooth colour field with a little grain, like a photo
+                    u8* p = &slide[(size_t(y) * SLIDE_WIDTH + x) * 4];
+                    p[0] = static_cast<u8>((base & 0xFF) + x / 3 + (rng() & 7));
+                    p[1] = static_cast<u8>(((base >> 8) & 0xFF) + y / 2 + (rng() & 7));
+                    p[2] = static_cast<u8>(((base >> 16) & 0xFF) + (x + y) / 5);
+                    p[3] = 0xFF;
+                }
+            }
+        }
+    }
+
+    // Frame 0 paints everything; later frames only what changed
+    void render(u32 frame, DamageRegion& damage) {
+        damage.clear();
+
+        if (frame == 0) {
+            draw_backdrop();
+            damage.add(DamageRect{0, 0, i32(width_), i32(height_)});
+        } else {
+            restore_cursor(damage);
+        }
+
+        if (frame % 90 == 0) {
+            draw_slide((frame / 90) % SLIDE_COUNT, damage);
+        }
+        if (frame % 30 == 0) {
+            draw_clock(frame / 30, damage);
+        }
+        draw_ticker(frame, damage);
+        draw_cursor(frame, damage);
+    }
+
+    const u8* pixels() const { return pixels_.data(); }
+    u32 stride() const { return width_ * 4; }
+
+private:
+    static constexpr u32 SLIDE_COUNT = 4;
+    static constexpr u32 SLIDE_WIDTH = 512;
+    static constexpr u32 SLIDE_HEIGHT = 288;
+    static constexpr u32 TICKER_HEIGHT = 48;
+    static constexpr u32 TICKER_PERIOD = 256;
+    static constexpr u32 CURSOR_SIZE = 16;
+
+    void fill(i32 x1, i32 y1, i32 x2, i32 y2, u32 bgra) {
+        x1 = std::max(x1, 0);
+        y1 = std::max(y1, 0);
+        x2 = std::min(x2, i32(width_));
+        y2 = std::min(y2, i32(height_));
+        for (i32 y = y1; y < y2; y++) {
+            for (i32 x = x1; x < x2; x++) {
+                std::memcpy(&pixels_[(size_t(y) * width_ + x) * 4], &bgra, 4);
+            }
+        }
+    }
+
+    void draw_backdrop() {
+        for (u32 y = 0; y < height_; y++) {
+            for (u32 x = 0; x < width_; x++) {
+                u8* p = &pixels_[(size_t(y) * width_ + x) * 4];
+                p[0] = static_cast<u8>(40 + y * 60 / height_);
+                p[1] = static_cast<u8>(30 + x * 40 / width_);
+                p[2] = 24;
+                p[3] = 0xFF;
+            }
+        }
+    }
+
+    void draw_slide(u32 index, DamageRegion& damage) {
+        u32 x0 = 64;
+        u32 y0 = 64;
+        u32 w = std::min(SLIDE_WIDTH, width_ > x0 ? width_ - x0 : 0);
+        u32 h = std::min(SLIDE_HEIGHT, height_ > y0 ? height_ - y0 : 0);
+        for (u32 y = 0; y < h; y++) {
+            std::memcpy(&pixels_[(size_t(y0 + y) * width_ + x0) * 4], &slides_[index][size_t(y) * SLIDE_WIDTH * 4], size_t(w) * 4);
+        }
+        damage.add(DamageRect{i32(x0), i32(y0), i32(x0 + w), i32(y0 + h)});
+    }
+
+    // Seven-segment-ish digits; the same few states keep coming back
+    void draw_clock(u32 tick, DamageRegion& damage) {
+        i32 x0 = i32(width_) - 320;
+        i32 y0 = 64;
+        fill(x0, y0, x0 + 256, y0 + 96, 0xFF101010);
+
+        u32 value = tick % 100;
+        for (u32 digit = 0; digit < 2; digit++) {
+            u32 d = digit == 0 ? value / 10 : value % 10;
+            i32 dx = x0 + 32 + i32(digit) * 112;
+            static const u8 segments[10] = {0x3F, 0x06, 0x5B, 0x4F, 0x66, 0x6D, 0x7D, 0x07, 0x7F, 0x6F};
+            u8 s = segments[d];
+            if (s & 0x01) fill(dx, y0 + 8, dx + 64, y0 + 16, 0xFF30E0F0);
+            if (s & 0x02) fill(dx + 56, y0 + 8, dx + 64, y0 + 48, 0xFF30E0F0);
+            if (s & 0x04) fill(dx + 56, y0 + 48, dx + 64, y0 + 88, 0xFF30E0F0);
+            if (s & 0x08) fill(dx, y0 + 80, dx + 64, y0 + 88, 0xFF30E0F0);
+            if (s & 0x10) fill(dx, y0 + 48, dx + 8, y0 + 88, 0xFF30E0F0);
+            if (s & 0x20) fill(dx, y0 + 8, dx + 8, y0 + 48, 0xFF30E0F0);
+            if (s & 0x40) fill(dx, y0 + 44, dx + 64, y0 + 52, 0xFF30E0F0);
+        }
+        damage.add(DamageRect{x0, y0, x0 + 256, y0 + 96});
+    }
+
+    // Scrolls 4 px a frame over a 256 px pattern, so it repeats every 64 frames
+    void draw_ticker(u32 frame, DamageRegion& damage) {
+        u32 y0 = height_ > TICKER_HEIGHT ? height_ - TICKER_HEIGHT : 0;
+        u32 offset = (frame * 4) % TICKER_PERIOD;
+        for (u32 y = y0; y < height_; y++) {
+            for (u32 x = 0; x < width_; x++) {
+                u32 u = (x + offset) % TICKER_PERIOD;
+                bool ink = ((u / 6) % 3 != 0) && (((y - y0) / 4 + u / 12) % 5 < 3) && (y - y0) > 8 && (y - y0) < 40;
+                u32 bgra = ink ? 0xFFF0F0F0 : 0xFF202060;
+                std::memcpy(&pixels_[(size_t(y) * width_ + x) * 4], &bgra, 4);
+            }
+        }
+        damage.add(DamageRect{0, i32(y0), i32(width_), i32(height_)});
+    }
+
+    // The cursor is drawn last and lifted first, so the other layers never
+    // see it and what it covered is always current
+    void restore_cursor(DamageRegion& damage) {
+        for (u32 y = 0; y < CURSOR_SIZE; y++) {
+            std::memcpy(&pixels_[(size_t(cursor_y_ + y) * width_ + cursor_x_) * 4],
+                        &saved_cursor_[size_t(y) * CURSOR_SIZE * 4], CURSOR_SIZE * 4);
+        }
+        damage.add(DamageRect{cursor_x_, cursor_y_, cursor_x_ + i32(CURSOR_SIZE), cursor_y_ + i32(CURSOR_SIZE)});
+    }
+
+    void draw_cursor(u32 frame, DamageRegion& damage) {
+        i32 span_x = i32(width_ - CURSOR_SIZE);
+        i32 span_y = i32(height_ - CURSOR_SIZE);
+        cursor_x_ = i32((frame * 7) % u32(2 * span_x));
+        cursor_y_ = i32((frame * 5) % u32(2 * span_y));
+        if (cursor_x_ >= span_x) cursor_x_ = 2 * span_x - cursor_x_ - 1;
+        if (cursor_y_ >= span_y) cursor_y_ = 2 * span_y - cursor_y_ - 1;
+
+        saved_cursor_.resize(size_t(CURSOR_SIZE) * CURSOR_SIZE * 4);
+        for (u32 y = 0; y < CURSOR_SIZE; y++) {
+            std::memcpy(&saved_cursor_[size_t(y) * CURSOR_SIZE * 4],
+                        &pixels_[(size_t(cursor_y_ + y) * width_ + cursor_x_) * 4], CURSOR_SIZE * 4);
+        }
+
+        fill(cursor_x_, cursor_y_, cursor_x_ + i32(CURSOR_SIZE), cursor_y_ + i32(CURSOR_SIZE), 0xFFFFFFFF);
+        damage.add(DamageRect{cursor_x_, cursor_y_, cursor_x_ + i32(CURSOR_SIZE), cursor_y_ + i32(CURSOR_SIZE)});
+    }
+
+    u32 width_;
+    u32 height_;
+    std::vector<u8> pixels_;
+    std::vector<u8> slides_[SLIDE_COUNT];
+    std::vector<u8> saved_cursor_;
+    i32 cursor_x_ = 0;
+    i32 cursor_y_ = 0;
+};
+
+bool read_all(int socket_fd, void* data, size_t size) {
+    u8* p = static_cast<u8*>(data);
+    while (size > 0) {
+        ssize_t received = recv(socket_fd, p, size, 0);
+        if (received <= 0) {
+            if (received < 0 && errno == EINTR) continue;
+            return false;
+        }
+        p += received;
+        size -= size_t(received);
+    }
+    return true;
+}
+
+int connect_viewer(u16 port) {
+    int viewer = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (viewer < 0) return -1;
+
+    struct sockaddr_in address {};
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    address.sin_port = htons(port);
+    if (connect(viewer, reinterpret_cast<struct sockaddr*>(&address), sizeof(address)) != 0) {
+        close(viewer);
+        return -1;
+    }
+    return viewer;
+}
+
+bool write_ppm(const std::string& path, const S1U::RemoteDisplayDecoder& decoder) {
+    FILE* file = std::fopen(path.c_str(), "wb");
+    if (!file) return false;
+
+    std::fprintf(file, "P6\n%u %u\n255\n", decoder.get_width(), decoder.get_height());
+    const std::vector<u8>& pixels = decoder.get_framebuffer();
+    std::vector<u8> row(size_t(decoder.get_width()) * 3);
+    for (u32 y = 0; y < decoder.get_height(); y++) {
+        for (u32 x = 0; x < decoder.get_width(); x++) {
+            const u8* p = &pixels[(size_t(y) * decoder.get_width() + x) * 4];
+            row[x * 3 + 0] = p[2];
+            row[x * 3 + 1] = p[1];
+            row[x * 3 + 2] = p[0];
+        }
+        std::fwrite(row.data(), 1, row.size(), file);
+    }
+    return std::fclose(file) == 0;
+}
+
+void print_usage(const char* program) {
+    std::printf("Usage: %s [options]\n"
+                "  --size WxH                 screen size (default 1280x720)\n"
+                "  --frames N                 frames to stream (default 600)\n"
+                "  --fps N                    frame rate for the bandwidth estimate (default 30)\n"
+                "  --tile N                   tile size in pixels (default 64)\n"
+                "  --cache N                  client tile cache entries (default 4096)\n"
+                "  --link-mbps M              link speed the compression tier plans for (default 10)\n"
+                "  --dump FILE                write the last received frame as a PPM image\n",
+                program);
+}
+
+bool parse_options(int argc, char** argv, ViewerOptions& options) {
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        bool has_value = i + 1 < argc;
+
+        if (arg == "--size" && has_value) {
+            if (std::sscanf(argv[++i], "%ux%u", &options.width, &options.height) != 2) {
+                print_usage(argv[0]);
+                return false;
+            }
+        } else if (arg == "--frames" && has_value) {
+            options.frames = static_cast<u32>(std::strtoul(argv[++i], nullptr, 10));
+        } else if (arg == "--fps" && has_value) {
+            options.fps = std::max<u32>(1, static_cast<u32>(std::strtoul(argv[++i], nullptr, 10)));
+        } else if (arg == "--tile" && has_value) {
+            options.tile_size = static_cast<u32>(std::strtoul(argv[++i], nullptr, 10));
+        } else if (arg == "--cache" && has_value) {
+            options.cache_capacity = static_cast<u32>(std::strtoul(argv[++i], nullptr, 10));
+        } else if (arg == "--link-mbps" && has_value) {
+            options.link_mbps = std::strtod(argv[++i], nullptr);
+        } else if (arg == "--dump" && has_value) {
+            options.dump_path = argv[++i];
+        } else {
+            print_usage(argv[0]);
+            return false;
+        }
+    }
+
+    if (options.width < 640 || options.height < 480 ||
+        options.width > S1U::REMOTE_MAX_DIMENSION || options.height > S1U::REMOTE_MAX_DIMENSION) {
+        std::fprintf(stderr, "screen size must be between 640x480 and %ux%u\n",
+                     S1U::REMOTE_MAX_DIMENSION, S1U::REMOTE_MAX_DIMENSION);
+        return false;
+    }
+    return options.frames > 0;
+}
+
+} // namespace
+} // namespace s1u
+
+int main(int argc, char** argv) {
+    using namespace s1u;
+
+    ViewerOptions options;
+    if (!parse_options(argc, argv, options)) {
+        return 2;
+    }
+
+    S1U::RemoteDisplayStreamConfig config;
+    config.encoder.tile_size = options.tile_size;
+    config.encoder.cache_capacity = options.cache_capacity;
+    config.encoder.link_mbps = options.link_mbps;
+
+    S1U::RemoteDisplayStream stream;
+    if (!stream.initialize(config)) {
+        std::fprintf(stderr, "invalid stream configuration or no loopback port\n");
+        return 2;
+    }
+
+    int viewer_socket = connect_viewer(stream.get_port());
+    if (viewer_socket < 0) {
+        std::perror("connect");
+        return 2;
+    }
+
+    KioskScene scene(options.width, options.height);
+
+    // The source waits for the viewer to check each frame, so the frame it
+    // compares against cannot move underneath it
+    std::atomic<bool> mismatch{false};
+    std::atomic<bool> viewer_done{false};
+    std::atomic<u32> verified{0};
+    f64 decode_ms = 0.0;
+    S1U::RemoteDisplayDecoder decoder;
+
+    std::thread viewer([&]() {
+        S1U::Vector<u8> message;
+        for (u32 frame = 0; frame < options.frames; frame++) {
+            u32 size;
+            if (!read_all(viewer_socket, &size, sizeof(size))) break;
+            message.resize(size);
+            if (!read_all(viewer_socket, message.data(), size)) break;
+
+            auto start = Clock::now();
+            bool decoded = decoder.decode_frame(message.data(), message.size());
+            decode_ms += std::chrono::duration<f64, std::milli>(Clock::now() - start).count();
+
+            bool matches = decoded && std::memcmp(decoder.get_framebuffer().data(), scene.pixels(),
+                                                  decoder.get_framebuffer().size()) == 0;
+            if (!matches) {
+                std::fprintf(stderr, "frame %u: %s\n", frame, decoded ? "screen differs from source" : "decode failed");
+                mismatch = true;
+                break;
+            }
+            verified++;
+        }
+        viewer_done = true;
+    });
+
+    DamageRegion damage;
+    DamageRegion idle;
+    u64 peak_frame_bytes = 0;
+    u64 first_frame_bytes = 0;
+    u64 encoded_bytes = 0;
+
+    for (u32 frame = 0; frame < options.frames && !mismatch && !viewer_done; frame++) {
+        scene.render(frame, damage);
+        stream.submit_frame(scene.pixels(), options.width, options.height, scene.stride(), damage);
+        if (stream.get_viewer_count() == 0) {
+            std::fprintf(stderr, "frame %u: viewer dropped\n", frame);
+            mismatch = true;
+            break;
+        }
+
+        u64 frame_bytes = stream.get_statistics().encoded_bytes - encoded_bytes;
+        encoded_bytes += frame_bytes;
+        peak_frame_bytes = std::max(peak_frame_bytes, frame_bytes);
+        if (frame == 0) {
+            first_frame_bytes = frame_bytes;
+        }
+
+        // Idle frames push out whatever the socket did not take at once,
+        // as the compositor's next frames would
+        while (verified.load() <= frame && !mismatch && !viewer_done) {
+            std::this_thread::sleep_for(std::chrono::microseconds(100));
+            stream.submit_frame(scene.pixels(), options.width, options.height, scene.stride(), idle);
+        }
+    }
+
+    stream.shutdown();
+    shutdown(viewer_socket, SHUT_RDWR);
+    viewer.join();
+    close(viewer_socket);
+
+    const S1U::RemoteDisplayStats& stats = stream.get_statistics();
+    u64 full_frame_bytes = u64(options.width) * options.height * 4;
+    f64 average_frame_bytes = stats.frames ? f64(stats.encoded_bytes) / stats.frames : 0.0;
+    // The first frame is a full repaint; steady state is what the link sees
+    f64 steady_frame_bytes = stats.frames > 1 ? f64(stats.encoded_bytes - first_frame_bytes) / (stats.frames - 1) : 0.0;
+
+    std::printf("frames            %u verified of %u\n", verified.load(), options.frames);
+    std::printf("tiles             %lu damaged, %lu unchanged, %lu cached, %lu sent (%lu compressed)\n",
+                static_cast<unsigned long>(stats.tiles_damaged), static_cast<unsigned long>(stats.tiles_unchanged),
+                static_cast<unsigned long>(stats.tiles_cached), static_cast<unsigned long>(stats.tiles_sent),
+                static_cast<unsigned long>(stats.tiles_compressed));
+    std::printf("bytes per frame   %.0f average, %lu peak, %lu uncompressed screen\n",
+                average_frame_bytes, static_cast<unsigned long>(peak_frame_bytes), static_cast<unsigned long>(full_frame_bytes));
+    std::printf("tile data         %.3f of raw size after compression\n",
+                stats.raw_bytes ? f64(stats.encoded_bytes) / stats.raw_bytes : 0.0);
+    std::printf("steady state      %.2f Mbit/s at %u fps (link planned at %.1f Mbit/s)\n",
+                steady_frame_bytes * 8.0 * options.fps / 1e6, options.fps, options.link_mbps);
+    std::printf("time per frame    %.3f ms encode, %.3f ms decode\n",
+                stats.frames ? stats.encode_time_ms / stats.frames : 0.0,
+                verified ? decode_ms / verified : 0.0);
+
+    if (!options.dump_path.empty() && !write_ppm(options.dump_path, decoder)) {
+        std::perror(options.dump_path.c_str());
+        return 1;
+    }
+
+    return !mismatch && verified == options.frames ? 0 : 1;
+}